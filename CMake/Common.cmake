@@ -20,6 +20,8 @@ endif ()
 option(CI_BUILD "Build on CI System" OFF)
 mark_as_advanced(CI_BUILD)
 
+option(PBD_HEADLESS "Build only the demos without visualization (PBDRunner, PBDBenchmarks), glfw and imgui are not required" OFF)
+
 if (NOT WIN32)
 	if (NOT EXISTS ${CMAKE_BINARY_DIR}/CMakeCache.txt)
 	  if (NOT CMAKE_BUILD_TYPE)
@@ -86,3 +88,8 @@ OPTION(USE_DOUBLE_PRECISION "Use double precision"	ON)
 if (USE_DOUBLE_PRECISION)
 	add_definitions( -DUSE_DOUBLE)	
 endif (USE_DOUBLE_PRECISION)
+
+OPTION(USE_ALLOCATION_COUNTER "Count the heap allocations in the timing report"	OFF)
+if (USE_ALLOCATION_COUNTER)
+	add_definitions( -DUSE_ALLOCATION_COUNTER)	
+endif (USE_ALLOCATION_COUNTER)
@@ -6,6 +6,12 @@
 
 //#define USE_DOUBLE
 #define MIN_PARALLEL_SIZE 64
+// Islands of constraints with a higher cost are solved in parallel by graph coloring
+// instead of being solved as a single task
+#define MAX_ISLAND_TASK_COST 1024
+// Maximal number of colors of the cloth contacts. Contacts which cannot be colored 
+// are put into an additional group which is solved sequentially.
+#define MAX_CLOTH_CONTACT_COLORS 64
 
 #ifdef USE_DOUBLE
 typedef double Real;
@@ -12,6 +12,7 @@
 #include "Utils/FileSystem.h"
 #include "Demos/Common/DemoBase.h"
 #include "Simulation/Simulation.h"
+#include "../Common/imguiParameters.h"
 
 
 // Enable memory leak detection
@@ -35,6 +36,8 @@ DemoBase *base;
 const unsigned int width = 30;
 const unsigned int depth = 5;
 const unsigned int height = 5; 
+bool useLatticeShapeMatching = false;
+unsigned int regionWidth = 1;
 
 
 // main 
@@ -53,6 +56,23 @@ int main( int argc, char **argv )
 
 	base->createParameterGUI();
 
+	// add additional parameter just for this demo
+	imguiParameters::imguiBoolParameter* param = new imguiParameters::imguiBoolParameter();
+	param->description = "Use fast lattice shape matching (FastLSM) if the solid simulation method is shape matching.";
+	param->label = "Lattice shape matching";
+	param->readOnly = false;
+	param->getFct = []() -> bool { return useLatticeShapeMatching; };
+	param->setFct = [](bool b) -> void { if (b != useLatticeShapeMatching) { useLatticeShapeMatching = b; reset(); } };
+	imguiParameters::addParam("Simulation", "Solid", param);
+
+	imguiParameters::imguiNumericParameter<unsigned int>* uparam = new imguiParameters::imguiNumericParameter<unsigned int>();
+	uparam->description = "Half width of the cubic shape matching regions of the lattice shape matching.";
+	uparam->label = "Region half width";
+	uparam->minValue = 1;
+	uparam->getFct = []() -> unsigned int { return regionWidth; };
+	uparam->setFct = [](unsigned int v) -> void { if (v != regionWidth) { regionWidth = v; reset(); } };
+	imguiParameters::addParam("Simulation", "Solid", uparam);
+
 	// reset simulation when solid simulation method has changed
 	model->setSolidSimulationMethodChangedCallback([&]() { reset(); });
 
@@ -155,8 +175,18 @@ void createMesh()
 		model->setSolidVolumeStiffness(100000);
 	for (unsigned int cm = 0; cm < model->getTetModels().size(); cm++)
 	{
-		model->addSolidConstraints(model->getTetModels()[cm], model->getSolidSimulationMethod(), model->getSolidStiffness(),
-			model->getSolidPoissonRatio(), model->getSolidVolumeStiffness(), model->getSolidNormalizeStretch(), model->getSolidNormalizeShear());
+		if (useLatticeShapeMatching && (model->getSolidSimulationMethod() == SimulationModel::ENUM_SOLIDSIM_SHAPE_MATCHING))
+		{
+			// the particles of the regular tet model are ordered like the lattice cells
+			const unsigned int offset = model->getTetModels()[cm]->getIndexOffset();
+			std::vector<unsigned int> cellParticles(width * height * depth);
+			for (unsigned int i = 0; i < cellParticles.size(); i++)
+				cellParticles[i] = offset + i;
+			model->addFastLatticeShapeMatchingConstraint(width, height, depth, cellParticles.data(), regionWidth, model->getSolidStiffness());
+		}
+		else
+			model->addSolidConstraints(model->getTetModels()[cm], model->getSolidSimulationMethod(), model->getSolidStiffness(),
+				model->getSolidPoissonRatio(), model->getSolidVolumeStiffness(), model->getSolidNormalizeStretch(), model->getSolidNormalizeShear());
 
 		model->getTetModels()[cm]->updateMeshNormals(pd);
 
@@ -12,8 +12,7 @@
 #include "Utils/SystemInfo.h"
 #include "../Visualization/Visualization.h"
 #include "Simulation/DistanceFieldCollisionDetection.h"
-#include "Utils/OBJLoader.h"
-#include "Utils/PLYLoader.h"
+#include "MeshIO.h"
 
 
 INIT_LOGGING
@@ -36,7 +35,9 @@ int DemoBase::RENDER_BVH = -1;
 int DemoBase::RENDER_BVH_TETS = -1;
 int DemoBase::EXPORT_OBJ = -1;
 int DemoBase::EXPORT_PLY = -1;
+int DemoBase::EXPORT_CACHE = -1;
 int DemoBase::EXPORT_FPS = -1;
+int DemoBase::EXPORT_STATISTICS = -1;
 
  
 DemoBase::DemoBase()
@@ -61,9 +62,11 @@ DemoBase::DemoBase()
 	m_oldMousePos.setZero();
 	m_enableExportOBJ = false;
 	m_enableExportPLY = false;
+	m_enableExportCache = false;
 	m_exportFPS = 25;
 	m_nextFrameTime = 0.0;
 	m_frameCounter = 1;
+	m_enableExportStatistics = false;
 
 	m_gui = new Simulator_GUI_imgui(this);
 }
@@ -130,10 +133,18 @@ void DemoBase::initParameters()
 	setGroup(EXPORT_PLY, "Simulation|Export");
 	setDescription(EXPORT_PLY, "Export meshes in PLY files.");
 
+	EXPORT_CACHE = createBoolParameter("exportCache", "Export cache", &m_enableExportCache);
+	setGroup(EXPORT_CACHE, "Simulation|Export");
+	setDescription(EXPORT_CACHE, "Export the meshes of all frames to a single cache file (export/simulation.pbdcache).");
+
 	EXPORT_FPS = createNumericParameter("exportFPS", "Export FPS", &m_exportFPS);
 	setGroup(EXPORT_FPS, "Simulation|Export");
 	setDescription(EXPORT_FPS, "Frame rate for export.");
 	static_cast<NumericParameter<int>*>(getParameter(EXPORT_FPS))->setMinValue(0);
+
+	EXPORT_STATISTICS = createBoolParameter("exportStatistics", "Export statistics", &m_enableExportStatistics);
+	setGroup(EXPORT_STATISTICS, "Simulation|Export");
+	setDescription(EXPORT_STATISTICS, "Write the solver statistics of each time step to a CSV file.");
 }
 
 void DemoBase::createParameterGUI()
@@ -878,7 +889,10 @@ void DemoBase::mouseMove(int x, int y, void *clientData)
 	{
 		const Real mass = rb[base->m_selectedBodies[j]]->getMass();
 		if (mass != 0.0)
+		{
 			rb[base->m_selectedBodies[j]]->getVelocity() += 3.0 / h * diff;
+			rb[base->m_selectedBodies[j]]->wakeUp();
+		}
 	}
 	ParticleData &pd = model->getParticles();
 	for (unsigned int j = 0; j < base->m_selectedParticles.size(); j++)
@@ -925,130 +939,21 @@ void DemoBase::reset()
 {
 	m_nextFrameTime = 0.0;
 	m_frameCounter = 1;
+	m_cacheWriter.close();
 }
 
 void DemoBase::loadMesh(const std::string& filename, VertexData& vd, Utilities::IndexedFaceMesh& mesh, const Vector3r& translation,
 	const Matrix3r& rotation, const Vector3r& scale)
 {
-	string ext = FileSystem::getFileExt(filename);
-	transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
-
-	std::vector<std::array<float, 3>> x;
-	if (ext == "OBJ")
-	{
-		std::vector<OBJLoader::Vec3f> normals;
-		std::vector<OBJLoader::Vec2f> texCoords;
-		std::vector<MeshFaceIndices> faces;
-		OBJLoader::Vec3f s = { (float)scale[0], (float)scale[1], (float)scale[2] };
-		OBJLoader::loadObj(filename, &x, &faces, &normals, &texCoords, s);
-
-		mesh.release();
-		const unsigned int nPoints = (unsigned int)x.size();
-		const unsigned int nFaces = (unsigned int)faces.size();
-		const unsigned int nTexCoords = (unsigned int)texCoords.size();
-		mesh.initMesh(nPoints, nFaces * 2, nFaces);
-		vd.reserve(nPoints);
-		for (unsigned int i = 0; i < nPoints; i++)
-		{
-			vd.addVertex(Vector3r(x[i][0], x[i][1], x[i][2]));
-		}
-		for (unsigned int i = 0; i < nTexCoords; i++)
-		{
-			mesh.addUV(texCoords[i][0], texCoords[i][1]);
-		}
-		for (unsigned int i = 0; i < nFaces; i++)
-		{
-			int posIndices[3];
-			int texIndices[3];
-			for (int j = 0; j < 3; j++)
-			{
-				posIndices[j] = faces[i].posIndices[j];
-				if (nTexCoords > 0)
-				{
-					texIndices[j] = faces[i].texIndices[j];
-					mesh.addUVIndex(texIndices[j]);
-				}
-			}
-
-			mesh.addFace(&posIndices[0]);
-		}
-		mesh.buildNeighbors();
-
-		mesh.updateNormals(vd, 0);
-		mesh.updateVertexNormals(vd);
-
-		LOG_INFO << "Number of triangles: " << nFaces;
-		LOG_INFO << "Number of vertices: " << nPoints;
-	}
-	else if (ext == "PLY")
-	{
-		std::vector<std::array<int, 3>> faces;
-		OBJLoader::Vec3f s = { (float)scale[0], (float)scale[1], (float)scale[2] };
-		PLYLoader::loadPly(filename, x, faces, s);
-
-		mesh.release();
-		const unsigned int nPoints = (unsigned int)x.size();
-		const unsigned int nFaces = (unsigned int)faces.size();
-		mesh.initMesh(nPoints, nFaces * 2, nFaces);
-		vd.reserve(nPoints);
-		for (unsigned int i = 0; i < nPoints; i++)
-		{
-			vd.addVertex(Vector3r(x[i][0], x[i][1], x[i][2]));
-		}
-		for (unsigned int i = 0; i < nFaces; i++)
-		{
-			int posIndices[3];
-			for (int j = 0; j < 3; j++)
-				posIndices[j] = faces[i][j];
-
-			mesh.addFace(&posIndices[0]);
-		}
-
-		LOG_INFO << "Number of triangles: " << nFaces;
-		LOG_INFO << "Number of vertices: " << nPoints;
-
-	}
-	else
-		LOG_ERR << "File " << filename << " has a unknown file type.";
+	MeshIO::loadMesh(filename, vd, mesh, translation, rotation, scale);
 }
 
-void DemoBase::exportMeshOBJ(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces)
+void DemoBase::exportMeshes()
 {
-	// Open the file
-	std::ofstream outfile(exportFileName);
-	if (!outfile)
-	{
-		LOG_WARN << "Cannot open a file to save OBJ mesh.";
-		return;
-	}
-
-	// Header
-	outfile << "# Created by the PositionBasedDynamics library\n";
-	outfile << "g default\n";
-
-	// Vertices
-	{
-		for (auto j = 0u; j < nVert; j++)
-		{
-			const Vector3r& x = pos[j];
-			outfile << "v " << x[0] << " " << x[1] << " " << x[2] << "\n";
-		}
-	}
-
-	// faces
-	{
-		for (auto j = 0u; j < nTri; j++)
-		{
-			outfile << "f " << faces[3 * j + 0] + 1 << " " << faces[3 * j + 1] + 1 << " " << faces[3 * j + 2] + 1 << "\n";
-		}
-	}
-	outfile.close();
-}
+	if (!m_enableExportCache)
+		m_cacheWriter.close();
 
-
-void DemoBase::exportOBJ()
-{
-	if (!m_enableExportOBJ)
+	if (!m_enableExportOBJ && !m_enableExportPLY && !m_enableExportCache)
 		return;
 
 	if (TimeManager::getCurrent()->getTime() < m_nextFrameTime)
@@ -1056,183 +961,56 @@ void DemoBase::exportOBJ()
 
 	m_nextFrameTime += 1.0 / (Real)m_exportFPS;
 
-	//////////////////////////////////////////////////////////////////////////
-	// rigid bodies
-	//////////////////////////////////////////////////////////////////////////
-
-	std::string exportPath = getOutputPath() + "/export";
-	FileSystem::makeDirs(exportPath);
-
-	SimulationModel* model = Simulation::getCurrent()->getModel();
-	const ParticleData& pd = model->getParticles();
-	for (unsigned int i = 0; i < model->getTriangleModels().size(); i++)
-	{
-		const IndexedFaceMesh& mesh = model->getTriangleModels()[i]->getParticleMesh();
-		const unsigned int offset = model->getTriangleModels()[i]->getIndexOffset();
-		const Vector3r* x = model->getParticles().getVertices().data();
-
-		std::string fileName = "triangle_model";
-		fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".obj";
-		std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
+	SimulationModel *model = Simulation::getCurrent()->getModel();
+	const std::string exportPath = FileSystem::normalizePath(getOutputPath() + "/export");
 
-		exportMeshOBJ(exportFileName, mesh.numVertices(), &x[offset], mesh.numFaces(), mesh.getFaces().data());
-	}
+	// the meshes are copied and written by a background thread
+	if (m_enableExportOBJ || m_enableExportPLY)
+		m_meshExporter.exportFrame(model, exportPath, m_frameCounter, m_enableExportOBJ, m_enableExportPLY);
 
-	for (unsigned int i = 0; i < model->getTetModels().size(); i++)
+	if (m_enableExportCache)
 	{
-		const IndexedFaceMesh& mesh = model->getTetModels()[i]->getVisMesh();
-		// has a vis mesh
-		if (mesh.numVertices() > 0)
-		{
-			const Vector3r* x = model->getTetModels()[i]->getVisVertices().getVertices().data();
-
-			std::string fileName = "tet_model";
-			fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".obj";
-			std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-			exportMeshOBJ(exportFileName, mesh.numVertices(), x, mesh.numFaces(), mesh.getFaces().data());
-		}
-		else
+		if (!m_cacheWriter.isOpen())
 		{
-			const IndexedFaceMesh& mesh = model->getTetModels()[i]->getSurfaceMesh();
-			const unsigned int offset = model->getTetModels()[i]->getIndexOffset();
-			const Vector3r* x = model->getParticles().getVertices().data();
-
-			std::string fileName = "tet_model";
-			fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".obj";
-			std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-			exportMeshOBJ(exportFileName, mesh.numVertices(), &x[offset], mesh.numFaces(), mesh.getFaces().data());
+			FileSystem::makeDirs(exportPath);
+			if (!m_cacheWriter.open(exportPath + "/simulation.pbdcache"))
+				m_enableExportCache = false;
 		}
+		if (m_cacheWriter.isOpen())
+			MeshIO::exportCacheFrame(m_cacheWriter, model, TimeManager::getCurrent()->getTime());
 	}
-
-	for (unsigned int i = 0; i < model->getRigidBodies().size(); i++)
-	{
-		const IndexedFaceMesh& mesh = model->getRigidBodies()[i]->getGeometry().getMesh();
-		const Vector3r* x = model->getRigidBodies()[i]->getGeometry().getVertexData().getVertices().data();
-
-		std::string fileName = "rigid_body";
-		fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".obj";
-		std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-		exportMeshOBJ(exportFileName, mesh.numVertices(), x, mesh.numFaces(), mesh.getFaces().data());
-	}
-
-
 	m_frameCounter++;
 }
 
-void DemoBase::exportMeshPLY(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces)
-{
-	// Suppose these hold your data
-	std::vector<std::array<double, 3>> meshVertexPositions;
-	std::vector<std::vector<size_t>> meshFaceIndices;
-
-	// vertices
-	meshVertexPositions.resize(nVert);
-	for (auto j = 0u; j < nVert; j++)
-		meshVertexPositions[j] = { pos[j][0], pos[j][1], pos[j][2] };
-
-	// faces
-	meshFaceIndices.resize(nTri);
-	for (auto j = 0u; j < nTri; j++)
-	{
-		meshFaceIndices[j].resize(3);
-		meshFaceIndices[j] = { faces[3 * j], faces[3 * j + 1], faces[3 * j + 2] };
-	}
-
-	// Create an empty object
-	happly::PLYData plyOut;
-
-	// Add mesh data (elements are created automatically)
-	plyOut.addVertexPositions(meshVertexPositions);
-	plyOut.addFaceIndices(meshFaceIndices);
 
-
-	// Write the object to file
-	plyOut.write(exportFileName, happly::DataFormat::Binary);
+void DemoBase::step()
+{
+	exportMeshes();
+	exportStatistics();
 }
 
-void DemoBase::exportPLY()
+void DemoBase::exportStatistics()
 {
-	if (!m_enableExportPLY)
-		return;
-
-	if (TimeManager::getCurrent()->getTime() < m_nextFrameTime)
-		return;
-
-	m_nextFrameTime += 1.0 / (Real)m_exportFPS;
-
-	//////////////////////////////////////////////////////////////////////////
-	// rigid bodies
-	//////////////////////////////////////////////////////////////////////////
-
-	std::string exportPath = getOutputPath() + "/export";
-	FileSystem::makeDirs(exportPath);
-
-	SimulationModel* model = Simulation::getCurrent()->getModel();
-	const ParticleData& pd = model->getParticles();
-	for (unsigned int i = 0; i < model->getTriangleModels().size(); i++)
+	if (!m_enableExportStatistics)
 	{
-		const IndexedFaceMesh& mesh = model->getTriangleModels()[i]->getParticleMesh();
-		const unsigned int offset = model->getTriangleModels()[i]->getIndexOffset();
-		const Vector3r* x = model->getParticles().getVertices().data();
-
-		std::string fileName = "triangle_model";
-		fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".ply";
-		std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-		exportMeshPLY(exportFileName, mesh.numVertices(), &x[offset], mesh.numFaces(), mesh.getFaces().data());
+		m_statisticsWriter.close();
+		return;
 	}
 
-	for (unsigned int i = 0; i < model->getTetModels().size(); i++)
-	{
-		const IndexedFaceMesh& mesh = model->getTetModels()[i]->getVisMesh();
-		// has a vis mesh
-		if (mesh.numVertices() > 0)
-		{
-			const Vector3r* x = model->getTetModels()[i]->getVisVertices().getVertices().data();
-
-			std::string fileName = "tet_model";
-			fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".ply";
-			std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-			exportMeshPLY(exportFileName, mesh.numVertices(), x, mesh.numFaces(), mesh.getFaces().data());
-		}
-		else
-		{
-			const IndexedFaceMesh& mesh = model->getTetModels()[i]->getSurfaceMesh();
-			const unsigned int offset = model->getTetModels()[i]->getIndexOffset();
-			const Vector3r* x = model->getParticles().getVertices().data();
-
-			std::string fileName = "tet_model";
-			fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".ply";
-			std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-			exportMeshPLY(exportFileName, mesh.numVertices(), &x[offset], mesh.numFaces(), mesh.getFaces().data());
-		}
-	}
+	TimeStep *timeStep = Simulation::getCurrent()->getTimeStep();
+	if (timeStep == nullptr)
+		return;
 
-	for (unsigned int i = 0; i < model->getRigidBodies().size(); i++)
+	if (!m_statisticsWriter.isOpen())
 	{
-		const IndexedFaceMesh& mesh = model->getRigidBodies()[i]->getGeometry().getMesh();
-		const Vector3r* x = model->getRigidBodies()[i]->getGeometry().getVertexData().getVertices().data();
-
-		std::string fileName = "rigid_body";
-		fileName = fileName + std::to_string(i) + "_" + std::to_string(m_frameCounter) + ".ply";
-		std::string exportFileName = FileSystem::normalizePath(exportPath + "/" + fileName);
-
-		exportMeshPLY(exportFileName, mesh.numVertices(), x, mesh.numFaces(), mesh.getFaces().data());
+		// the residuals are measured from the next step on
+		timeStep->setCollectStatistics(true);
+		const std::string statisticsPath = FileSystem::normalizePath(getOutputPath() + "/statistics");
+		FileSystem::makeDirs(statisticsPath);
+		if (!m_statisticsWriter.open(statisticsPath + "/statistics.csv", false))
+			m_enableExportStatistics = false;
+		return;
 	}
-
-
-	m_frameCounter++;
-}
-
-
-void DemoBase::step()
-{
-	exportOBJ();
-	exportPLY();
+	m_statisticsWriter.write(timeStep->getStatistics());
 }
 
@@ -5,9 +5,12 @@
 #include "Utils/SceneLoader.h"
 #include "Demos/Visualization/Shader.h"
 #include "Simulation/TimeStep.h"
+#include "Simulation/TimeStepStatistics.h"
 #include "Simulation/SimulationModel.h"
 #include "ParameterObject.h"
 #include "Simulator_GUI_imgui.h"
+#include "MeshExporter.h"
+#include "Utils/SimulationCache.h"
 
 namespace PBD
 {
@@ -43,9 +46,14 @@ namespace PBD
 		Simulator_GUI_imgui *m_gui;
 		bool m_enableExportOBJ;
 		bool m_enableExportPLY;
+		bool m_enableExportCache;
 		unsigned int m_exportFPS;
 		Real m_nextFrameTime;
 		unsigned int m_frameCounter;
+		MeshExporter m_meshExporter;
+		Utilities::SimulationCacheWriter m_cacheWriter;
+		bool m_enableExportStatistics;
+		TimeStepStatisticsWriter m_statisticsWriter;
 
 
 		virtual void initParameters();
@@ -75,10 +83,8 @@ namespace PBD
 		void renderDistanceJoint(DistanceJoint &j);
 		void renderDamperJoint(DamperJoint &j);
 
-		void exportMeshOBJ(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces);
-		void exportMeshPLY(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces);
-		void exportOBJ();
-		void exportPLY();
+		void exportMeshes();
+		void exportStatistics();
 
 	public:
 		static int PAUSE;
@@ -93,7 +99,9 @@ namespace PBD
 		static int RENDER_BVH_TETS;
 		static int EXPORT_OBJ;
 		static int EXPORT_PLY;
+		static int EXPORT_CACHE;
 		static int EXPORT_FPS;
+		static int EXPORT_STATISTICS;
 
 		DemoBase();
 		virtual ~DemoBase();
@@ -0,0 +1,122 @@
+#include "MeshExporter.h"
+#include "MeshIO.h"
+#include "Utils/FileSystem.h"
+#include "Utils/Timing.h"
+
+using namespace PBD;
+using namespace std;
+using namespace Utilities;
+
+MeshExporter::MeshExporter(const unsigned int maxFrames)
+{
+	m_maxFrames = std::max(maxFrames, 1u);
+	m_stop = false;
+}
+
+MeshExporter::~MeshExporter()
+{
+	if (m_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_all();
+		// the writer finishes all queued frames before it stops
+		m_thread.join();
+	}
+}
+
+MeshExporter::Frame *MeshExporter::acquireFrame()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_freeFrames.empty() && (m_frames.size() < m_maxFrames))
+	{
+		m_frames.push_back(std::unique_ptr<Frame>(new Frame()));
+		return m_frames.back().get();
+	}
+	m_condition.wait(lock, [this] { return !m_freeFrames.empty(); });
+	Frame *frame = m_freeFrames.back();
+	m_freeFrames.pop_back();
+	return frame;
+}
+
+void MeshExporter::exportFrame(SimulationModel *model, const std::string &exportPath, const unsigned int frameIndex, const bool exportOBJ, const bool exportPLY)
+{
+	if (!exportOBJ && !exportPLY)
+		return;
+
+	if (!m_thread.joinable())
+		m_thread = std::thread(&MeshExporter::run, this);
+
+	Frame *frame = acquireFrame();
+
+	START_TIMING("copy export meshes");
+	frame->m_exportPath = exportPath;
+	frame->m_exportOBJ = exportOBJ;
+	frame->m_exportPLY = exportPLY;
+	frame->m_numMeshes = 0;
+	// the buffers of the previous frames are reused
+	MeshIO::visitMeshes(model, [&](const std::string &name, const unsigned int nVert, const Vector3r *x, const unsigned int nTri, const unsigned int *faces)
+	{
+		if (frame->m_numMeshes >= frame->m_meshes.size())
+			frame->m_meshes.resize(frame->m_numMeshes + 1);
+		MeshSnapshot &mesh = frame->m_meshes[frame->m_numMeshes++];
+		mesh.m_fileName = name + "_" + std::to_string(frameIndex);
+		mesh.m_x.assign(x, x + nVert);
+		mesh.m_faces.assign(faces, faces + 3 * nTri);
+	});
+	STOP_TIMING_AVG;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(frame);
+	}
+	m_condition.notify_all();
+}
+
+void MeshExporter::writeFrame(Frame *frame)
+{
+	FileSystem::makeDirs(frame->m_exportPath);
+	for (unsigned int i = 0; i < frame->m_numMeshes; i++)
+	{
+		const MeshSnapshot &mesh = frame->m_meshes[i];
+		const std::string fileName = FileSystem::normalizePath(frame->m_exportPath + "/" + mesh.m_fileName);
+		const unsigned int nVert = (unsigned int)mesh.m_x.size();
+		const unsigned int nTri = (unsigned int)mesh.m_faces.size() / 3;
+		if (frame->m_exportOBJ)
+			MeshIO::exportMeshOBJ(fileName + ".obj", nVert, mesh.m_x.data(), nTri, mesh.m_faces.data());
+		if (frame->m_exportPLY)
+			MeshIO::exportMeshPLY(fileName + ".ply", nVert, mesh.m_x.data(), nTri, mesh.m_faces.data());
+	}
+}
+
+void MeshExporter::run()
+{
+	while (true)
+	{
+		Frame *frame = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty())
+				return;
+			frame = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		writeFrame(frame);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_freeFrames.push_back(frame);
+		}
+		m_condition.notify_all();
+	}
+}
+
+void MeshExporter::flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this] { return m_freeFrames.size() == m_frames.size(); });
+}
@@ -0,0 +1,68 @@
+#ifndef __MeshExporter_h__
+#define __MeshExporter_h__
+
+#include "Common/Common.h"
+#include "Simulation/SimulationModel.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+
+namespace PBD
+{
+	/** \brief Asynchronous export of the meshes of a simulation model.
+	*
+	* exportFrame() copies the vertices and faces of all meshes into a frame
+	* buffer and appends the frame to a queue. A background thread writes the
+	* queued frames as OBJ and/or PLY files using MeshIO. The frame buffers are
+	* reused, so after the first frames the simulation thread only copies the
+	* data. The number of frame buffers is bounded (two by default, i.e. one
+	* frame is written while the next one is filled). If all buffers are in use,
+	* exportFrame() waits until the writer has finished a frame.
+	*/
+	class MeshExporter
+	{
+	protected:
+		struct MeshSnapshot
+		{
+			std::string m_fileName;
+			std::vector<Vector3r> m_x;
+			std::vector<unsigned int> m_faces;
+		};
+
+		struct Frame
+		{
+			std::string m_exportPath;
+			bool m_exportOBJ;
+			bool m_exportPLY;
+			unsigned int m_numMeshes;
+			std::vector<MeshSnapshot> m_meshes;
+		};
+
+		unsigned int m_maxFrames;
+		std::vector<std::unique_ptr<Frame>> m_frames;
+		std::vector<Frame*> m_freeFrames;
+		std::deque<Frame*> m_queue;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::thread m_thread;
+		bool m_stop;
+
+		Frame *acquireFrame();
+		void writeFrame(Frame *frame);
+		void run();
+
+	public:
+		MeshExporter(const unsigned int maxFrames = 2);
+		~MeshExporter();
+
+		/** Copy the meshes of the model and write them in the background to the
+		* given directory. The frame index is appended to the file names. */
+		void exportFrame(SimulationModel *model, const std::string &exportPath, const unsigned int frame, const bool exportOBJ, const bool exportPLY);
+		/** Wait until all queued frames are written. */
+		void flush();
+	};
+}
+
+#endif
@@ -0,0 +1,330 @@
+#include "MeshIO.h"
+#include "Utils/FileSystem.h"
+#include "Utils/Logger.h"
+#include "Utils/OBJLoader.h"
+#include "Utils/PLYLoader.h"
+#include "Utils/FileCache.h"
+#include "Utils/BinaryReaderWriter.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace PBD;
+using namespace std;
+using namespace Utilities;
+
+/** Read the vertices, triangles and texture coordinates of a mesh file from the cache. */
+static bool readMeshCache(const std::string &cacheFileName, const std::string &md5, std::vector<std::array<float, 3>> &x,
+	std::vector<int> &faces, std::vector<std::array<float, 2>> &texCoords, std::vector<int> &uvIndices)
+{
+	std::vector<char> data;
+	if (!FileCache::read(cacheFileName, md5, data))
+		return false;
+	BinaryReader reader(data.data(), data.size());
+	return reader.readVector(x) && reader.readVector(faces) && reader.readVector(texCoords) && reader.readVector(uvIndices);
+}
+
+static void writeMeshCache(const std::string &cacheFileName, const std::string &md5, const std::vector<std::array<float, 3>> &x,
+	const std::vector<int> &faces, const std::vector<std::array<float, 2>> &texCoords, const std::vector<int> &uvIndices)
+{
+	BinaryWriter writer;
+	writer.writeVector(x);
+	writer.writeVector(faces);
+	writer.writeVector(texCoords);
+	writer.writeVector(uvIndices);
+	if (FileCache::write(cacheFileName, md5, writer.getBuffer()))
+		LOG_INFO << "Save mesh cache: " << cacheFileName;
+}
+
+void MeshIO::loadMesh(const std::string& filename, VertexData& vd, Utilities::IndexedFaceMesh& mesh, const Vector3r& translation,
+	const Matrix3r& rotation, const Vector3r& scale, const std::string& cachePath)
+{
+	string ext = FileSystem::getFileExt(filename);
+	transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
+	const bool isOBJ = (ext == "OBJ");
+	if (!isOBJ && (ext != "PLY"))
+	{
+		LOG_ERR << "File " << filename << " has a unknown file type.";
+		return;
+	}
+
+	// unscaled vertices, three vertex indices per triangle and (OBJ only) texture coordinates
+	std::vector<std::array<float, 3>> x;
+	std::vector<int> faceIndices;
+	std::vector<std::array<float, 2>> texCoords;
+	std::vector<int> uvIndices;
+
+	std::string md5;
+	std::string cacheFileName;
+	bool cached = false;
+	if (cachePath != "")
+	{
+		md5 = FileSystem::getFileMD5(filename);
+		cacheFileName = FileCache::getCacheFileName(cachePath, filename);
+		cached = readMeshCache(cacheFileName, md5, x, faceIndices, texCoords, uvIndices);
+		if (cached)
+			LOG_INFO << "Load cached mesh: " << cacheFileName;
+		else
+		{
+			x.clear();
+			faceIndices.clear();
+			texCoords.clear();
+			uvIndices.clear();
+		}
+	}
+
+	if (!cached)
+	{
+		const OBJLoader::Vec3f s = { 1.0f, 1.0f, 1.0f };
+		if (isOBJ)
+		{
+			std::vector<MeshFaceIndices> faces;
+			OBJLoader::loadObj(filename, &x, &faces, nullptr, &texCoords, s);
+			faceIndices.resize(3 * faces.size());
+			if (!texCoords.empty())
+				uvIndices.resize(3 * faces.size());
+			for (size_t i = 0; i < faces.size(); i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					faceIndices[3 * i + j] = faces[i].posIndices[j];
+					if (!texCoords.empty())
+						uvIndices[3 * i + j] = faces[i].texIndices[j];
+				}
+			}
+		}
+		else
+		{
+			std::vector<std::array<int, 3>> faces;
+			PLYLoader::loadPly(filename, x, faces, s);
+			faceIndices.resize(3 * faces.size());
+			for (size_t i = 0; i < faces.size(); i++)
+				for (int j = 0; j < 3; j++)
+					faceIndices[3 * i + j] = faces[i][j];
+		}
+		if (cachePath != "")
+			writeMeshCache(cacheFileName, md5, x, faceIndices, texCoords, uvIndices);
+	}
+
+	const float s[3] = { (float)scale[0], (float)scale[1], (float)scale[2] };
+	mesh.release();
+	const unsigned int nPoints = (unsigned int)x.size();
+	const unsigned int nFaces = (unsigned int)faceIndices.size() / 3;
+	const unsigned int nTexCoords = (unsigned int)texCoords.size();
+	mesh.initMesh(nPoints, nFaces * 2, nFaces);
+	vd.reserve(nPoints);
+	for (unsigned int i = 0; i < nPoints; i++)
+	{
+		vd.addVertex(Vector3r(s[0] * x[i][0], s[1] * x[i][1], s[2] * x[i][2]));
+	}
+	for (unsigned int i = 0; i < nTexCoords; i++)
+	{
+		mesh.addUV(texCoords[i][0], texCoords[i][1]);
+	}
+	for (unsigned int i = 0; i < nFaces; i++)
+	{
+		if (nTexCoords > 0)
+		{
+			for (int j = 0; j < 3; j++)
+				mesh.addUVIndex(uvIndices[3 * i + j]);
+		}
+		mesh.addFace(&faceIndices[3 * i]);
+	}
+	if (isOBJ)
+	{
+		mesh.buildNeighbors();
+
+		mesh.updateNormals(vd, 0);
+		mesh.updateVertexNormals(vd);
+	}
+
+	LOG_INFO << "Number of triangles: " << nFaces;
+	LOG_INFO << "Number of vertices: " << nPoints;
+}
+
+/** Append the decimal representation of an unsigned integer. */
+static char *writeUInt(char *p, unsigned int v)
+{
+	char tmp[10];
+	int n = 0;
+	do
+	{
+		tmp[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+	while (n > 0)
+		*p++ = tmp[--n];
+	return p;
+}
+
+void MeshIO::exportMeshOBJ(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces)
+{
+	// Open the file
+	FILE *outfile = fopen(exportFileName.c_str(), "wb");
+	if (outfile == nullptr)
+	{
+		LOG_WARN << "Cannot open a file to save OBJ mesh.";
+		return;
+	}
+
+	// The lines are formatted into a buffer which is written in large blocks.
+	// The format %g matches the default precision of std::ostream.
+	const size_t bufferSize = 1 << 16;
+	const size_t maxLineLength = 128;
+	std::vector<char> buffer(bufferSize + maxLineLength);
+	char *p = buffer.data();
+	auto flush = [&](const bool force)
+	{
+		if (force || (p - buffer.data() >= (std::ptrdiff_t) bufferSize))
+		{
+			fwrite(buffer.data(), 1, p - buffer.data(), outfile);
+			p = buffer.data();
+		}
+	};
+
+	// Header
+	p += snprintf(p, maxLineLength, "# Created by the PositionBasedDynamics library\ng default\n");
+
+	// Vertices
+	for (auto j = 0u; j < nVert; j++)
+	{
+		const Vector3r& x = pos[j];
+		p += snprintf(p, maxLineLength, "v %g %g %g\n", (double)x[0], (double)x[1], (double)x[2]);
+		flush(false);
+	}
+
+	// faces
+	for (auto j = 0u; j < nTri; j++)
+	{
+		*p++ = 'f';
+		for (int k = 0; k < 3; k++)
+		{
+			*p++ = ' ';
+			p = writeUInt(p, faces[3 * j + k] + 1);
+		}
+		*p++ = '\n';
+		flush(false);
+	}
+	flush(true);
+	fclose(outfile);
+}
+
+void MeshIO::visitMeshes(SimulationModel *model, const MeshVisitor &visitor)
+{
+	const ParticleData& pd = model->getParticles();
+	const Vector3r* particles = pd.getVertices().data();
+	for (unsigned int i = 0; i < model->getTriangleModels().size(); i++)
+	{
+		const IndexedFaceMesh& mesh = model->getTriangleModels()[i]->getParticleMesh();
+		const unsigned int offset = model->getTriangleModels()[i]->getIndexOffset();
+
+		const std::string name = "triangle_model" + std::to_string(i);
+		visitor(name, mesh.numVertices(), &particles[offset], mesh.numFaces(), mesh.getFaces().data());
+	}
+
+	for (unsigned int i = 0; i < model->getTetModels().size(); i++)
+	{
+		const std::string name = "tet_model" + std::to_string(i);
+		const IndexedFaceMesh& mesh = model->getTetModels()[i]->getVisMesh();
+		// has a vis mesh
+		if (mesh.numVertices() > 0)
+		{
+			const Vector3r* x = model->getTetModels()[i]->getVisVertices().getVertices().data();
+			visitor(name, mesh.numVertices(), x, mesh.numFaces(), mesh.getFaces().data());
+		}
+		else
+		{
+			const IndexedFaceMesh& mesh = model->getTetModels()[i]->getSurfaceMesh();
+			const unsigned int offset = model->getTetModels()[i]->getIndexOffset();
+			visitor(name, mesh.numVertices(), &particles[offset], mesh.numFaces(), mesh.getFaces().data());
+		}
+	}
+
+	for (unsigned int i = 0; i < model->getRigidBodies().size(); i++)
+	{
+		const IndexedFaceMesh& mesh = model->getRigidBodies()[i]->getGeometry().getMesh();
+		const Vector3r* x = model->getRigidBodies()[i]->getGeometry().getVertexData().getVertices().data();
+
+		const std::string name = "rigid_body" + std::to_string(i);
+		visitor(name, mesh.numVertices(), x, mesh.numFaces(), mesh.getFaces().data());
+	}
+}
+
+void MeshIO::exportOBJ(SimulationModel *model, const std::string &exportPath, const unsigned int frame)
+{
+	FileSystem::makeDirs(exportPath);
+	visitMeshes(model, [&](const std::string &name, const unsigned int nVert, const Vector3r *x, const unsigned int nTri, const unsigned int *faces)
+	{
+		exportMeshOBJ(FileSystem::normalizePath(exportPath + "/" + name + "_" + std::to_string(frame) + ".obj"), nVert, x, nTri, faces);
+	});
+}
+
+void MeshIO::exportMeshPLY(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces)
+{
+	FILE *outfile = fopen(exportFileName.c_str(), "wb");
+	if (outfile == nullptr)
+	{
+		LOG_WARN << "Cannot open a file to save PLY mesh.";
+		return;
+	}
+
+	// Binary little endian PLY with the same layout as written by happly:
+	// double vertex coordinates and faces as list of uint with uchar count.
+	const std::string header = "ply\nformat binary_little_endian 1.0\n"
+		"comment Created by the PositionBasedDynamics library\n"
+		"element vertex " + std::to_string(nVert) + "\n"
+		"property double x\nproperty double y\nproperty double z\n"
+		"element face " + std::to_string(nTri) + "\n"
+		"property list uchar uint vertex_indices\n"
+		"end_header\n";
+
+	const size_t vertexSize = 3 * sizeof(double);
+	const size_t faceSize = 1 + 3 * sizeof(unsigned int);
+	std::vector<char> buffer(header.size() + nVert * vertexSize + nTri * faceSize);
+	char *p = buffer.data();
+	memcpy(p, header.c_str(), header.size());
+	p += header.size();
+	for (auto j = 0u; j < nVert; j++)
+	{
+		const double x[3] = { (double)pos[j][0], (double)pos[j][1], (double)pos[j][2] };
+		memcpy(p, x, vertexSize);
+		p += vertexSize;
+	}
+	for (auto j = 0u; j < nTri; j++)
+	{
+		*p++ = (char) 3;
+		memcpy(p, &faces[3 * j], 3 * sizeof(unsigned int));
+		p += 3 * sizeof(unsigned int);
+	}
+	fwrite(buffer.data(), 1, buffer.size(), outfile);
+	fclose(outfile);
+}
+
+void MeshIO::exportPLY(SimulationModel *model, const std::string &exportPath, const unsigned int frame)
+{
+	FileSystem::makeDirs(exportPath);
+	visitMeshes(model, [&](const std::string &name, const unsigned int nVert, const Vector3r *x, const unsigned int nTri, const unsigned int *faces)
+	{
+		exportMeshPLY(FileSystem::normalizePath(exportPath + "/" + name + "_" + std::to_string(frame) + ".ply"), nVert, x, nTri, faces);
+	});
+}
+
+void MeshIO::exportCacheFrame(SimulationCacheWriter &writer, SimulationModel *model, const Real time)
+{
+	// the topology is written with the first frame
+	if (writer.numMeshes() == 0)
+	{
+		visitMeshes(model, [&](const std::string &name, const unsigned int nVert, const Vector3r *, const unsigned int nTri, const unsigned int *faces)
+		{
+			writer.addMesh(name, nVert, nTri, faces);
+		});
+	}
+
+	std::vector<const Vector3r*> positions;
+	positions.reserve(writer.numMeshes());
+	visitMeshes(model, [&](const std::string &, const unsigned int, const Vector3r *x, const unsigned int, const unsigned int *)
+	{
+		positions.push_back(x);
+	});
+	writer.writeFrame(time, positions);
+}
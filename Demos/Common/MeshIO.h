@@ -0,0 +1,43 @@
+#ifndef __MeshIO_h__
+#define __MeshIO_h__
+
+#include "Common/Common.h"
+#include "Simulation/SimulationModel.h"
+#include "Utils/SimulationCache.h"
+#include <functional>
+
+namespace PBD
+{
+	/** \brief Import of OBJ and PLY meshes and export of the meshes of the
+	* triangle models, tet models and rigid bodies of a simulation model.
+	* The class does not depend on the visualization.
+	*/
+	class MeshIO
+	{
+	public:
+		/** Function which is called for each mesh of a model with the name,
+		* the vertices and the triangles of the mesh. */
+		typedef std::function<void(const std::string &name, const unsigned int nVert, const Vector3r *x, const unsigned int nTri, const unsigned int *faces)> MeshVisitor;
+
+		/** Load an OBJ or PLY mesh. If a cache path is given, the mesh data is read from
+		* a binary cache file in this directory as long as the MD5 hash of the mesh file
+		* matches. Otherwise the cache file is (re)built. */
+		static void loadMesh(const std::string& filename, VertexData& vd, Utilities::IndexedFaceMesh& mesh, const Vector3r& translation = Vector3r::Zero(),
+			const Matrix3r& rotation = Matrix3r::Identity(), const Vector3r& scale = Vector3r::Ones(), const std::string& cachePath = "");
+
+		static void exportMeshOBJ(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces);
+		static void exportMeshPLY(const std::string& exportFileName, const unsigned int nVert, const Vector3r* pos, const unsigned int nTri, const unsigned int* faces);
+
+		/** Call the visitor for the meshes of all triangle models, tet models and rigid bodies
+		* of the model in the order of the export. */
+		static void visitMeshes(SimulationModel *model, const MeshVisitor &visitor);
+
+		/** Export all meshes of the model to the given directory. The frame index is appended to the file names. */
+		static void exportOBJ(SimulationModel *model, const std::string &exportPath, const unsigned int frame);
+		static void exportPLY(SimulationModel *model, const std::string &exportPath, const unsigned int frame);
+		/** Append the meshes of the model as frame to a simulation cache. */
+		static void exportCacheFrame(Utilities::SimulationCacheWriter &writer, SimulationModel *model, const Real time);
+	};
+}
+
+#endif
@@ -0,0 +1,742 @@
+#include "SceneBuilder.h"
+#include "MeshIO.h"
+#include "Simulation/TimeManager.h"
+#include "Simulation/DistanceFieldCollisionDetection.h"
+#include "Utils/TetGenLoader.h"
+#include "Utils/FileSystem.h"
+#include "Utils/FileCache.h"
+#include "Utils/BinaryReaderWriter.h"
+#include "Utils/Logger.h"
+#include "omp.h"
+#include <algorithm>
+
+using namespace PBD;
+using namespace Eigen;
+using namespace std;
+using namespace Utilities;
+
+void SceneBuilder::initTriangleModelConstraints(SimulationModel *model)
+{
+	// init constraints
+	for (unsigned int cm = 0; cm < model->getTriangleModels().size(); cm++)
+	{
+		model->setClothStiffness(1.0);
+		if (model->getClothSimulationMethod() == 4)
+			model->setClothStiffness(100000);
+		model->addClothConstraints(model->getTriangleModels()[cm], model->getClothSimulationMethod(), model->getClothStiffness(), model->getClothStiffnessXX(),
+			model->getClothStiffnessYY(), model->getClothStiffnessXY(), model->getClothPoissonRatioXY(), model->getClothPoissonRatioYX(),
+			model->getClothNormalizeStretch(), model->getClothNormalizeShear());
+
+		model->setClothBendingStiffness(0.01);
+		if (model->getClothBendingMethod() == 3)
+			model->setClothBendingStiffness(100.0);
+		model->addBendingConstraints(model->getTriangleModels()[cm], model->getClothBendingMethod(), model->getClothBendingStiffness());
+	}
+}
+
+void SceneBuilder::initTetModelConstraints(SimulationModel *model)
+{
+	// init constraints
+	model->setSolidStiffness(1.0);
+	if (model->getSolidSimulationMethod() == 3)
+		model->setSolidStiffness(1000000);
+	if (model->getSolidSimulationMethod() == 6)
+		model->setSolidStiffness(100000);
+
+	model->setSolidVolumeStiffness(1.0);
+	if (model->getSolidSimulationMethod() == 6)
+		model->setSolidVolumeStiffness(100000);
+	for (unsigned int cm = 0; cm < model->getTetModels().size(); cm++)
+	{
+		model->addSolidConstraints(model->getTetModels()[cm], model->getSolidSimulationMethod(), model->getSolidStiffness(),
+			model->getSolidPoissonRatio(), model->getSolidVolumeStiffness(), model->getSolidNormalizeStretch(), model->getSolidNormalizeShear());
+	}
+}
+
+/** Name of a generated signed distance field in the cache directory (without extension). 
+* The SDF is stored in the file with the extension csdf and the MD5 hash of the model in 
+* the file with the extension md5. */
+static std::string getSDFCacheName(const std::string &cachePath, const std::string &modelFile, const Eigen::Matrix<unsigned int, 3, 1> &resolutionSDF)
+{
+	const string resStr = to_string(resolutionSDF[0]) + "_" + to_string(resolutionSDF[1]) + "_" + to_string(resolutionSDF[2]);
+	return FileSystem::normalizePath(cachePath + "/" + FileCache::getCacheKey(modelFile) + "_" + resStr);
+}
+
+CubicSDFCollisionDetection::GridPtr SceneBuilder::generateSDF(const std::string &sceneFile, const std::string &modelFile, const std::string &collisionObjectFileName, const Eigen::Matrix<unsigned int, 3, 1> &resolutionSDF, 
+	VertexData &vd, IndexedFaceMesh &mesh)
+{
+	const std::string basePath = FileSystem::getFilePath(sceneFile);
+	const string cachePath = basePath + "/Cache";
+	CubicSDFCollisionDetection::GridPtr distanceField;
+	
+	if (collisionObjectFileName == "")
+	{
+		// each SDF has its own MD5 file, so that SDFs of the same model with
+		// different resolutions can be generated in parallel
+		const string cacheName = getSDFCacheName(cachePath, modelFile, resolutionSDF);
+		const string md5FileName = cacheName + ".md5";
+		string md5Str = FileSystem::getFileMD5(modelFile);
+		bool md5 = false;
+		if (FileSystem::fileExists(md5FileName))
+			md5 = FileSystem::checkMD5(md5Str, md5FileName);
+
+		// check MD5 if cache file is available
+		const string sdfFileName = cacheName + ".csdf";
+		bool foundCacheFile = FileSystem::fileExists(sdfFileName);
+
+		if (foundCacheFile && md5)
+		{
+			LOG_INFO << "Load cached SDF: " << sdfFileName;
+			distanceField = std::make_shared<CubicSDFCollisionDetection::Grid>(sdfFileName);
+		}
+		else
+		{
+			std::vector<unsigned int> &faces = mesh.getFaces();
+			const unsigned int nFaces = mesh.numFaces();
+
+#ifdef USE_DOUBLE
+			Discregrid::TriangleMesh sdfMesh(&vd.getPosition(0)[0], faces.data(), vd.size(), nFaces);
+#else
+			// if type is float, copy vector to double vector
+			std::vector<double> doubleVec;
+			doubleVec.resize(3 * vd.size());
+			for (unsigned int i = 0; i < vd.size(); i++)
+				for (unsigned int j = 0; j < 3; j++)
+					doubleVec[3 * i + j] = vd.getPosition(i)[j];
+			Discregrid::TriangleMesh sdfMesh(&doubleVec[0], faces.data(), vd.size(), nFaces);
+#endif
+			Discregrid::TriangleMeshDistance md(sdfMesh);
+			Eigen::AlignedBox3d domain;
+			for (auto const& x : sdfMesh.vertices())
+			{
+				domain.extend(x);
+			}
+			domain.max() += 0.1 * Eigen::Vector3d::Ones();
+			domain.min() -= 0.1 * Eigen::Vector3d::Ones();
+
+			LOG_INFO << "Set SDF resolution: " << resolutionSDF[0] << ", " << resolutionSDF[1] << ", " << resolutionSDF[2];
+			distanceField = std::make_shared<CubicSDFCollisionDetection::Grid>(domain, std::array<unsigned int, 3>({ resolutionSDF[0], resolutionSDF[1], resolutionSDF[2] }));
+			auto func = Discregrid::DiscreteGrid::ContinuousFunction{};
+			func = [&md](Eigen::Vector3d const& xi) {return md.signed_distance(xi).distance; };
+			LOG_INFO << "Generate SDF for " << modelFile;
+			distanceField->addFunction(func, true);
+			if (FileSystem::makeDir(cachePath) == 0)
+			{
+				// write temporary files first, so that other processes never load a 
+				// partially written SDF, the MD5 file is replaced after the SDF
+				LOG_INFO << "Save SDF: " << sdfFileName;
+				const string tmpSDFFileName = FileSystem::getTempFileName(sdfFileName);
+				const string tmpMD5FileName = FileSystem::getTempFileName(md5FileName);
+				distanceField->save(tmpSDFFileName);
+				if (FileSystem::replaceFile(tmpSDFFileName, sdfFileName) && FileSystem::writeMD5File(modelFile, tmpMD5FileName))
+					FileSystem::replaceFile(tmpMD5FileName, md5FileName);
+			}
+		}
+	}
+	else
+	{
+		std::string fileName = collisionObjectFileName;
+		if (FileSystem::isRelativePath(fileName))
+		{
+			fileName = FileSystem::normalizePath(basePath + "/" + fileName);
+		}
+		LOG_INFO << "Load SDF: " << fileName;
+		distanceField = std::make_shared<CubicSDFCollisionDetection::Grid>(fileName);
+	}
+	return distanceField;
+}
+
+
+/** Signed distance field which is used by one or more bodies. */
+struct SDFTask
+{
+	std::string m_key;
+	std::string m_modelFile;
+	std::string m_collisionObjectFileName;
+	Eigen::Matrix<unsigned int, 3, 1> m_resolution;
+	pair<VertexData, IndexedFaceMesh> *m_geometry;
+	CubicSDFCollisionDetection::GridPtr m_distanceField;
+};
+
+/** Mass properties which are used by all rigid bodies with the same mesh, scale and density. */
+struct MassPropertiesTask
+{
+	std::string m_modelFile;
+	Vector3r m_scale;
+	Real m_density;
+	RigidBody::MassProperties m_massProperties;
+
+	/** A mesh which could not be loaded yields a static body (zero mass). */
+	MassPropertiesTask()
+	{
+		m_massProperties.m_mass = 0.0;
+		m_massProperties.m_inertiaTensor.setOnes();
+		m_massProperties.m_principalAxes.setIdentity();
+		m_massProperties.m_centerOfMass.setZero();
+	}
+};
+
+/** Key of a signed distance field: the given SDF file or the file in the cache directory. */
+static std::string getSDFKey(const std::string &sceneFile, const std::string &modelFile, const std::string &collisionObjectFileName, const Eigen::Matrix<unsigned int, 3, 1> &resolutionSDF)
+{
+	if (collisionObjectFileName != "")
+		return collisionObjectFileName;
+	const string cachePath = FileSystem::getFilePath(sceneFile) + "/Cache";
+	return getSDFCacheName(cachePath, modelFile, resolutionSDF) + ".csdf";
+}
+
+static void addSDFTask(const std::string &sceneFile, const std::string &modelFile, const std::string &collisionObjectFileName, const Eigen::Matrix<unsigned int, 3, 1> &resolutionSDF,
+	pair<VertexData, IndexedFaceMesh> &geometry, std::vector<SDFTask> &tasks)
+{
+	const std::string key = getSDFKey(sceneFile, modelFile, collisionObjectFileName, resolutionSDF);
+	for (unsigned int i = 0; i < tasks.size(); i++)
+	{
+		if (tasks[i].m_key == key)
+			return;
+	}
+	SDFTask task;
+	task.m_key = key;
+	task.m_modelFile = modelFile;
+	task.m_collisionObjectFileName = collisionObjectFileName;
+	task.m_resolution = resolutionSDF;
+	task.m_geometry = &geometry;
+	tasks.push_back(task);
+}
+
+/** Load the meshes in parallel. The file names are used as keys of the map. */
+static void loadMeshes(const std::vector<std::string> &fileNames, const std::string &cachePath, std::map<std::string, pair<VertexData, IndexedFaceMesh>> &meshes)
+{
+	std::vector<pair<VertexData, IndexedFaceMesh>> geometry(fileNames.size());
+	#pragma omp parallel if(fileNames.size() > 1) default(shared)
+	{
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < (int)fileNames.size(); i++)
+		{
+			MeshIO::loadMesh(FileSystem::normalizePath(fileNames[i]), geometry[i].first, geometry[i].second, Vector3r::Zero(), Matrix3r::Identity(), Vector3r::Ones(), cachePath);
+		}
+	}
+	for (unsigned int i = 0; i < fileNames.size(); i++)
+		meshes[fileNames[i]] = geometry[i];
+}
+
+/** Load a TetGen model. The vertices and tets are stored in a binary cache file
+* which is used as long as the MD5 hashes of the node and the element file match. */
+static void loadTetModel(const std::string &nodeFileName, const std::string &eleFileName, const std::string &cachePath, vector<Vector3r> &vertices, vector<unsigned int> &tets)
+{
+	const string md5 = FileSystem::getFileMD5(nodeFileName) + FileSystem::getFileMD5(eleFileName);
+	const string cacheFileName = FileCache::getCacheFileName(cachePath, nodeFileName);
+	std::vector<char> data;
+	if (FileCache::read(cacheFileName, md5, data))
+	{
+		BinaryReader reader(data.data(), data.size());
+		if (reader.readVector(vertices) && reader.readVector(tets))
+		{
+			LOG_INFO << "Load cached tet model: " << cacheFileName;
+			return;
+		}
+	}
+
+	TetGenLoader::loadTetgenModel(nodeFileName, eleFileName, vertices, tets);
+
+	BinaryWriter writer;
+	writer.writeVector(vertices);
+	writer.writeVector(tets);
+	if (FileCache::write(cacheFileName, md5, writer.getBuffer()))
+		LOG_INFO << "Save tet model cache: " << cacheFileName;
+}
+
+void SceneBuilder::createModel(SimulationModel *model, CubicSDFCollisionDetection *cd, SceneLoader::SceneData &data, const std::string &sceneFile)
+{
+	// imported meshes are cached in binary form next to the SDFs
+	const string meshCachePath = FileSystem::getFilePath(sceneFile) + "/Cache";
+
+	SimulationModel::RigidBodyVector &rb = model->getRigidBodies();
+	SimulationModel::TriangleModelVector &triModels = model->getTriangleModels();
+	SimulationModel::TetModelVector &tetModels = model->getTetModels();
+	SimulationModel::ConstraintVector &constraints = model->getConstraints();
+
+	model->getTimeManager().setTimeStepSize(data.m_timeStepSize);
+
+	//////////////////////////////////////////////////////////////////////////
+	// rigid bodies
+	//////////////////////////////////////////////////////////////////////////
+
+	// The geometry is shared by all bodies which use the same files. First the
+	// unique meshes, SDFs and mass properties are determined and computed in
+	// parallel, then the bodies are created.
+
+	// map file names to loaded geometry to prevent multiple imports of same files
+	std::map<std::string, pair<VertexData, IndexedFaceMesh>> objFiles;
+	std::vector<std::string> meshFiles;
+	for (unsigned int i = 0; i < data.m_rigidBodyData.size(); i++)
+	{
+		SceneLoader::RigidBodyData &rbd = data.m_rigidBodyData[i];
+		rbd.m_modelFile = FileSystem::normalizePath(rbd.m_modelFile);
+		if (std::find(meshFiles.begin(), meshFiles.end(), rbd.m_modelFile) == meshFiles.end())
+			meshFiles.push_back(rbd.m_modelFile);
+	}
+	for (unsigned int i = 0; i < data.m_tetModelData.size(); i++)
+	{
+		const SceneLoader::TetModelData &tmd = data.m_tetModelData[i];
+		if ((tmd.m_modelFileVis != "") &&
+			(std::find(meshFiles.begin(), meshFiles.end(), tmd.m_modelFileVis) == meshFiles.end()))
+			meshFiles.push_back(tmd.m_modelFileVis);
+	}
+	loadMeshes(meshFiles, meshCachePath, objFiles);
+
+	// signed distance fields
+	std::vector<SDFTask> sdfTasks;
+	for (unsigned int i = 0; i < data.m_rigidBodyData.size(); i++)
+	{
+		const SceneLoader::RigidBodyData &rbd = data.m_rigidBodyData[i];
+		if (rbd.m_collisionObjectType == SceneLoader::SDF)
+			addSDFTask(sceneFile, rbd.m_modelFile, rbd.m_collisionObjectFileName, rbd.m_resolutionSDF, objFiles[rbd.m_modelFile], sdfTasks);
+	}
+	for (unsigned int i = 0; i < data.m_tetModelData.size(); i++)
+	{
+		const SceneLoader::TetModelData &tmd = data.m_tetModelData[i];
+		if (tmd.m_collisionObjectType == SceneLoader::SDF)
+			addSDFTask(sceneFile, tmd.m_modelFileVis, tmd.m_collisionObjectFileName, tmd.m_resolutionSDF, objFiles[tmd.m_modelFileVis], sdfTasks);
+	}
+	// Discregrid parallelizes the generation of a single SDF, so the SDFs are
+	// only processed in parallel if there are enough of them.
+	#pragma omp parallel if(sdfTasks.size() >= (size_t) omp_get_max_threads()) default(shared)
+	{
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < (int)sdfTasks.size(); i++)
+		{
+			SDFTask &task = sdfTasks[i];
+			task.m_distanceField = generateSDF(sceneFile, task.m_modelFile, task.m_collisionObjectFileName, task.m_resolution, task.m_geometry->first, task.m_geometry->second);
+		}
+	}
+	std::map<std::string, CubicSDFCollisionDetection::GridPtr> distanceFields;
+	for (unsigned int i = 0; i < sdfTasks.size(); i++)
+		distanceFields[sdfTasks[i].m_key] = sdfTasks[i].m_distanceField;
+
+	// mass properties of each combination of mesh, scale and density
+	std::vector<MassPropertiesTask> massTasks;
+	std::vector<unsigned int> massIndices(data.m_rigidBodyData.size());
+	for (unsigned int i = 0; i < data.m_rigidBodyData.size(); i++)
+	{
+		const SceneLoader::RigidBodyData &rbd = data.m_rigidBodyData[i];
+		unsigned int j = 0;
+		while ((j < massTasks.size()) &&
+			((massTasks[j].m_modelFile != rbd.m_modelFile) || (massTasks[j].m_scale != rbd.m_scale) || (massTasks[j].m_density != rbd.m_density)))
+			j++;
+		if (j == massTasks.size())
+		{
+			MassPropertiesTask task;
+			task.m_modelFile = rbd.m_modelFile;
+			task.m_scale = rbd.m_scale;
+			task.m_density = rbd.m_density;
+			massTasks.push_back(task);
+		}
+		massIndices[i] = j;
+	}
+	#pragma omp parallel if(massTasks.size() > 1) default(shared)
+	{
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < (int)massTasks.size(); i++)
+		{
+			MassPropertiesTask &task = massTasks[i];
+			const VertexData &vd = objFiles.find(task.m_modelFile)->second.first;
+			const IndexedFaceMesh &mesh = objFiles.find(task.m_modelFile)->second.second;
+			if (vd.size() == 0)
+			{
+				LOG_WARN << "Mesh " << task.m_modelFile << " is empty, the rigid bodies which use it are static.";
+				continue;
+			}
+			// same scaling as in RigidBodyGeometry::initMesh
+			std::vector<Vector3r> x(vd.size());
+			for (unsigned int j = 0; j < vd.size(); j++)
+				x[j] = vd.getPosition(j).cwiseProduct(task.m_scale);
+			RigidBody::computeMassProperties(vd.size(), x.data(), mesh.numFaces(), mesh.getFaces().data(), task.m_density, task.m_massProperties);
+		}
+	}
+	LOG_INFO << "Rigid bodies: " << data.m_rigidBodyData.size() << " (unique meshes: " << meshFiles.size() << ", SDFs: " << sdfTasks.size() << ", mass properties: " << massTasks.size() << ")";
+
+	// create the bodies
+	rb.resize(data.m_rigidBodyData.size());
+	#pragma omp parallel default(shared)
+	{
+		#pragma omp for schedule(dynamic, 16)
+		for (int i = 0; i < (int)data.m_rigidBodyData.size(); i++)
+		{
+			const SceneLoader::RigidBodyData &rbd = data.m_rigidBodyData[i];
+			const VertexData &vd = objFiles.find(rbd.m_modelFile)->second.first;
+			const IndexedFaceMesh &mesh = objFiles.find(rbd.m_modelFile)->second.second;
+
+			rb[i] = new RigidBody();
+			rb[i]->initBody(massTasks[massIndices[i]].m_massProperties,
+				rbd.m_x,
+				rbd.m_q,
+				vd, mesh,
+				rbd.m_scale);
+			rb[i]->getGeometry().getMesh().setFlatShading(rbd.m_flatShading);
+
+			if (!rbd.m_isDynamic)
+				rb[i]->setMass(0.0);
+			else
+			{
+				rb[i]->setVelocity(rbd.m_v);
+				rb[i]->setAngularVelocity(rbd.m_omega);
+			}
+			rb[i]->setRestitutionCoeff(rbd.m_restitutionCoeff);
+			rb[i]->setFrictionCoeff(rbd.m_frictionCoeff);
+			rb[i]->setSleepLinearVelocity(rbd.m_sleepLinearVelocity);
+			rb[i]->setSleepAngularVelocity(rbd.m_sleepAngularVelocity);
+			rb[i]->setSleepTime(rbd.m_sleepTime);
+		}
+	}
+
+	// the hierarchies of the collision objects are constructed in parallel when all objects are added
+	cd->setDeferBVHConstruction(true);
+	std::map<unsigned int, unsigned int> id_index;
+	for (unsigned int i = 0; i < data.m_rigidBodyData.size(); i++)
+	{
+		const SceneLoader::RigidBodyData &rbd = data.m_rigidBodyData[i];
+
+		id_index[rbd.m_id] = i;
+
+		// the shared mesh keeps the shading of the last body (used by the visualization meshes of tet models)
+		objFiles[rbd.m_modelFile].second.setFlatShading(rbd.m_flatShading);
+
+		const std::vector<Vector3r> &vertices = rb[i]->getGeometry().getVertexDataLocal().getVertices();
+		const unsigned int nVert = static_cast<unsigned int>(vertices.size());
+
+		switch (rbd.m_collisionObjectType)
+		{
+			case SceneLoader::No_Collision_Object: break;
+			case SceneLoader::Sphere: 
+				cd->addCollisionSphere(i, CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, rbd.m_collisionObjectScale[0], rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			case SceneLoader::Box:
+				cd->addCollisionBox(i, CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, rbd.m_collisionObjectScale, rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			case SceneLoader::Cylinder:
+				cd->addCollisionCylinder(i, CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, rbd.m_collisionObjectScale.head<2>(), rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			case SceneLoader::Torus:
+				cd->addCollisionTorus(i, CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, rbd.m_collisionObjectScale.head<2>(), rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			case SceneLoader::HollowSphere:
+				cd->addCollisionHollowSphere(i, PBD::CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, rbd.m_collisionObjectScale[0], rbd.m_thicknessSDF, rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			case SceneLoader::HollowBox:
+				cd->addCollisionHollowBox(i, CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, rbd.m_collisionObjectScale, rbd.m_thicknessSDF, rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			case SceneLoader::SDF:
+			{	
+				const std::string sdfKey = getSDFKey(sceneFile, rbd.m_modelFile, rbd.m_collisionObjectFileName, rbd.m_resolutionSDF);
+				cd->addCubicSDFCollisionObject(i, CollisionDetection::CollisionObject::RigidBodyCollisionObjectType, vertices.data(), nVert, distanceFields[sdfKey], rbd.m_collisionObjectScale, rbd.m_testMesh, rbd.m_invertSDF);
+				break;
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// triangle models
+	//////////////////////////////////////////////////////////////////////////
+
+	// map file names to loaded geometry to prevent multiple imports of same files
+	std::map<std::string, pair<VertexData, IndexedFaceMesh>> triFiles;
+	std::vector<std::string> triMeshFiles;
+	for (unsigned int i = 0; i < data.m_triangleModelData.size(); i++)
+	{
+		const SceneLoader::TriangleModelData &tmd = data.m_triangleModelData[i];
+		if (std::find(triMeshFiles.begin(), triMeshFiles.end(), tmd.m_modelFile) == triMeshFiles.end())
+			triMeshFiles.push_back(tmd.m_modelFile);
+	}
+	loadMeshes(triMeshFiles, meshCachePath, triFiles);
+
+	triModels.reserve(data.m_triangleModelData.size());
+	std::map<unsigned int, unsigned int> tm_id_index;
+	for (unsigned int i = 0; i < data.m_triangleModelData.size(); i++)
+	{
+		const SceneLoader::TriangleModelData &tmd = data.m_triangleModelData[i];
+
+		if (triFiles.find(tmd.m_modelFile) == triFiles.end())
+			continue;
+
+		tm_id_index[tmd.m_id] = i;
+
+		VertexData vd = triFiles[tmd.m_modelFile].first;
+		IndexedFaceMesh &mesh = triFiles[tmd.m_modelFile].second;
+
+		const Matrix3r R = tmd.m_q.matrix();
+		for (unsigned int j = 0; j < vd.size(); j++)
+		{
+			vd.getPosition(j) = R * (vd.getPosition(j).cwiseProduct(tmd.m_scale)) + tmd.m_x;
+		}
+
+		model->addTriangleModel(vd.size(), mesh.numFaces(), &vd.getPosition(0), mesh.getFaces().data(), mesh.getUVIndices(), mesh.getUVs());
+
+		TriangleModel *tm = triModels[triModels.size() - 1];
+		ParticleData &pd = model->getParticles();
+		unsigned int offset = tm->getIndexOffset();
+
+		for (unsigned int j = 0; j < tmd.m_staticParticles.size(); j++)
+		{
+			const unsigned int index = tmd.m_staticParticles[j] + offset;
+			pd.setMass(index, 0.0);
+		}
+
+		tm->setRestitutionCoeff(tmd.m_restitutionCoeff);
+		tm->setFrictionCoeff(tmd.m_frictionCoeff);
+	}
+
+	initTriangleModelConstraints(model);
+
+	//////////////////////////////////////////////////////////////////////////
+	// tet models
+	//////////////////////////////////////////////////////////////////////////
+
+	// map file names to loaded geometry to prevent multiple imports of same files
+	std::map<pair<string, string>, pair<vector<Vector3r>, vector<unsigned int>>> tetFiles;
+	std::vector<pair<string, string>> tetModelFiles;
+	for (unsigned int i = 0; i < data.m_tetModelData.size(); i++)
+	{
+		const SceneLoader::TetModelData &tmd = data.m_tetModelData[i];
+		pair<string, string> fileNames = { tmd.m_modelFileNodes, tmd.m_modelFileElements };
+		if (std::find(tetModelFiles.begin(), tetModelFiles.end(), fileNames) == tetModelFiles.end())
+			tetModelFiles.push_back(fileNames);
+	}
+	std::vector<pair<vector<Vector3r>, vector<unsigned int>>> tetGeometry(tetModelFiles.size());
+	#pragma omp parallel if(tetModelFiles.size() > 1) default(shared)
+	{
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < (int)tetModelFiles.size(); i++)
+		{
+			loadTetModel(FileSystem::normalizePath(tetModelFiles[i].first), FileSystem::normalizePath(tetModelFiles[i].second), meshCachePath, tetGeometry[i].first, tetGeometry[i].second);
+		}
+	}
+	for (unsigned int i = 0; i < tetModelFiles.size(); i++)
+		tetFiles[tetModelFiles[i]].swap(tetGeometry[i]);
+
+	tetModels.reserve(data.m_tetModelData.size());
+	std::map<unsigned int, unsigned int> tm_id_index2;
+	for (unsigned int i = 0; i < data.m_tetModelData.size(); i++)
+	{
+		const SceneLoader::TetModelData &tmd = data.m_tetModelData[i];
+
+		pair<string, string> fileNames = { tmd.m_modelFileNodes, tmd.m_modelFileElements };
+		auto geo = tetFiles.find(fileNames);
+		if (geo == tetFiles.end())
+			continue;
+
+		tm_id_index2[tmd.m_id] = i;
+
+		vector<Vector3r> vertices = geo->second.first;
+		vector<unsigned int> &tets = geo->second.second;
+
+		const Matrix3r R = tmd.m_q.matrix();
+		for (unsigned int j = 0; j < vertices.size(); j++)
+		{
+			vertices[j] = R * (vertices[j].cwiseProduct(tmd.m_scale)) + tmd.m_x;
+		}
+
+		model->addTetModel((unsigned int)vertices.size(), (unsigned int)tets.size() / 4, vertices.data(), tets.data());
+
+		TetModel *tm = tetModels[tetModels.size() - 1];
+		ParticleData &pd = model->getParticles();
+		unsigned int offset = tm->getIndexOffset();
+
+		tm->setInitialX(tmd.m_x);
+		tm->setInitialR(R);
+		tm->setInitialScale(tmd.m_scale);
+	
+		for (unsigned int j = 0; j < tmd.m_staticParticles.size(); j++)
+		{
+			const unsigned int index = tmd.m_staticParticles[j] + offset;
+			pd.setMass(index, 0.0);
+		}
+
+		// read visualization mesh
+		if (tmd.m_modelFileVis != "")
+		{ 
+			if (objFiles.find(tmd.m_modelFileVis) != objFiles.end())
+			{
+				IndexedFaceMesh &visMesh = tm->getVisMesh();
+				VertexData &vdVis = tm->getVisVertices();
+				vdVis = objFiles[tmd.m_modelFileVis].first;
+				visMesh = objFiles[tmd.m_modelFileVis].second;
+
+				for (unsigned int j = 0; j < vdVis.size(); j++)
+					vdVis.getPosition(j) = R * (vdVis.getPosition(j).cwiseProduct(tmd.m_scale)) + tmd.m_x;
+
+				tm->updateMeshNormals(pd);
+				tm->attachVisMesh(pd);
+				tm->updateVisMesh(pd);
+			}
+		}
+
+		tm->setRestitutionCoeff(tmd.m_restitutionCoeff);
+		tm->setFrictionCoeff(tmd.m_frictionCoeff);
+
+		tm->updateMeshNormals(pd);
+	}
+
+	initTetModelConstraints(model);
+
+	// init collision objects for deformable models
+	ParticleData &pd = model->getParticles();
+	for (unsigned int i = 0; i < data.m_triangleModelData.size(); i++)
+	{
+		TriangleModel *tm = triModels[i];
+		unsigned int offset = tm->getIndexOffset();
+		const unsigned int nVert = tm->getParticleMesh().numVertices();
+		cd->addCollisionObjectWithoutGeometry(i, CollisionDetection::CollisionObject::TriangleModelCollisionObjectType, &pd.getPosition(offset), nVert, true);
+
+	}
+	for (unsigned int i = 0; i < data.m_tetModelData.size(); i++)
+	{
+		TetModel *tm = tetModels[i];
+		unsigned int offset = tm->getIndexOffset();
+		const unsigned int nVert = tm->getParticleMesh().numVertices();
+
+		const SceneLoader::TetModelData &tmd = data.m_tetModelData[i];
+
+		switch (tmd.m_collisionObjectType)
+		{
+		case SceneLoader::No_Collision_Object: 
+			cd->addCollisionObjectWithoutGeometry(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, true);
+			break;
+		case SceneLoader::Sphere:
+			cd->addCollisionSphere(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, tmd.m_collisionObjectScale[0], tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		case SceneLoader::Box:
+			cd->addCollisionBox(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, tmd.m_collisionObjectScale, tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		case SceneLoader::Cylinder:
+			cd->addCollisionCylinder(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, tmd.m_collisionObjectScale.head<2>(), tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		case SceneLoader::Torus:
+			cd->addCollisionTorus(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, tmd.m_collisionObjectScale.head<2>(), tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		case SceneLoader::HollowSphere:
+			cd->addCollisionHollowSphere(i, PBD::CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, tmd.m_collisionObjectScale[0], tmd.m_thicknessSDF, tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		case SceneLoader::HollowBox:
+			cd->addCollisionHollowBox(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, tmd.m_collisionObjectScale, tmd.m_thicknessSDF, tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		case SceneLoader::SDF:
+		{
+			const std::string sdfKey = getSDFKey(sceneFile, tmd.m_modelFileVis, tmd.m_collisionObjectFileName, tmd.m_resolutionSDF);
+			cd->addCubicSDFCollisionObject(i, CollisionDetection::CollisionObject::TetModelCollisionObjectType, &pd.getPosition(offset), nVert, distanceFields[sdfKey], tmd.m_collisionObjectScale, tmd.m_testMesh, tmd.m_invertSDF);
+			break;
+		}
+		}
+	}
+
+	cd->setDeferBVHConstruction(false);
+
+	// init tet BVH
+	std::vector<CollisionDetection::CollisionObject*> &collisionObjects = cd->getCollisionObjects();
+	for (unsigned int k = 0; k < collisionObjects.size(); k++)
+	{
+		if (cd->isDistanceFieldCollisionObject(collisionObjects[k]) &&
+			(collisionObjects[k]->m_bodyType == CollisionDetection::CollisionObject::TetModelCollisionObjectType))
+		{
+			const unsigned int modelIndex = collisionObjects[k]->m_bodyIndex;
+			TetModel *tm = tetModels[modelIndex];
+			const unsigned int offset = tm->getIndexOffset();
+			const IndexedTetMesh &mesh = tm->getParticleMesh();
+
+			((DistanceFieldCollisionDetection::DistanceFieldCollisionObject*) collisionObjects[k])->initTetBVH(&pd.getPosition(offset), mesh.numVertices(), mesh.getTets().data(), mesh.numTets(), cd->getTolerance());
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// joints
+	//////////////////////////////////////////////////////////////////////////
+
+	for (unsigned int i = 0; i < data.m_ballJointData.size(); i++)
+	{
+		const SceneLoader::BallJointData &jd = data.m_ballJointData[i];
+		model->addBallJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position);
+	}
+
+	for (unsigned int i = 0; i < data.m_ballOnLineJointData.size(); i++)
+	{
+		const SceneLoader::BallOnLineJointData &jd = data.m_ballOnLineJointData[i];
+		model->addBallOnLineJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position, jd.m_axis);
+	}
+
+	for (unsigned int i = 0; i < data.m_hingeJointData.size(); i++)
+	{
+		const SceneLoader::HingeJointData &jd = data.m_hingeJointData[i];
+		model->addHingeJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position, jd.m_axis);
+	}
+
+	for (unsigned int i = 0; i < data.m_universalJointData.size(); i++)
+	{
+		const SceneLoader::UniversalJointData &jd = data.m_universalJointData[i];
+		model->addUniversalJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position, jd.m_axis[0], jd.m_axis[1]);
+	}
+
+	for (unsigned int i = 0; i < data.m_sliderJointData.size(); i++)
+	{
+		const SceneLoader::SliderJointData &jd = data.m_sliderJointData[i];
+		model->addSliderJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_axis);
+	}
+
+	for (unsigned int i = 0; i < data.m_rigidBodyParticleBallJointData.size(); i++)
+	{
+		const SceneLoader::RigidBodyParticleBallJointData &jd = data.m_rigidBodyParticleBallJointData[i];
+		model->addRigidBodyParticleBallJoint(id_index[jd.m_bodyID[0]], jd.m_bodyID[1]);
+	}
+
+	for (unsigned int i = 0; i < data.m_targetAngleMotorHingeJointData.size(); i++)
+	{
+		const SceneLoader::TargetAngleMotorHingeJointData &jd = data.m_targetAngleMotorHingeJointData[i];
+		model->addTargetAngleMotorHingeJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position, jd.m_axis);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTarget(jd.m_target);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTargetSequence(jd.m_targetSequence);
+		((MotorJoint*)constraints[constraints.size() - 1])->setRepeatSequence(jd.m_repeat);
+	}
+
+	for (unsigned int i = 0; i < data.m_targetVelocityMotorHingeJointData.size(); i++)
+	{
+		const SceneLoader::TargetVelocityMotorHingeJointData &jd = data.m_targetVelocityMotorHingeJointData[i];
+		model->addTargetVelocityMotorHingeJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position, jd.m_axis);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTarget(jd.m_target);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTargetSequence(jd.m_targetSequence);
+		((MotorJoint*)constraints[constraints.size() - 1])->setRepeatSequence(jd.m_repeat);
+	}
+
+	for (unsigned int i = 0; i < data.m_targetPositionMotorSliderJointData.size(); i++)
+	{
+		const SceneLoader::TargetPositionMotorSliderJointData &jd = data.m_targetPositionMotorSliderJointData[i];
+		model->addTargetPositionMotorSliderJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_axis);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTarget(jd.m_target);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTargetSequence(jd.m_targetSequence);
+		((MotorJoint*)constraints[constraints.size() - 1])->setRepeatSequence(jd.m_repeat);
+	}
+
+	for (unsigned int i = 0; i < data.m_targetVelocityMotorSliderJointData.size(); i++)
+	{
+		const SceneLoader::TargetVelocityMotorSliderJointData &jd = data.m_targetVelocityMotorSliderJointData[i];
+		model->addTargetVelocityMotorSliderJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_axis);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTarget(jd.m_target);
+		((MotorJoint*)constraints[constraints.size() - 1])->setTargetSequence(jd.m_targetSequence);
+		((MotorJoint*)constraints[constraints.size() - 1])->setRepeatSequence(jd.m_repeat);
+	}
+
+	for (unsigned int i = 0; i < data.m_damperJointData.size(); i++)
+	{
+		const SceneLoader::DamperJointData &jd = data.m_damperJointData[i];
+		model->addDamperJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_axis, jd.m_stiffness);
+	}
+
+	for (unsigned int i = 0; i < data.m_rigidBodySpringData.size(); i++)
+	{
+		const SceneLoader::RigidBodySpringData &jd = data.m_rigidBodySpringData[i];
+		model->addRigidBodySpring(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position1, jd.m_position2, jd.m_stiffness);
+	}
+
+	for (unsigned int i = 0; i < data.m_distanceJointData.size(); i++)
+	{
+		const SceneLoader::DistanceJointData &jd = data.m_distanceJointData[i];
+		model->addDistanceJoint(id_index[jd.m_bodyID[0]], id_index[jd.m_bodyID[1]], jd.m_position1, jd.m_position2);
+	}
+}
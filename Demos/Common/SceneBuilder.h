@@ -0,0 +1,36 @@
+#ifndef __SceneBuilder_h__
+#define __SceneBuilder_h__
+
+#include "Common/Common.h"
+#include "Utils/SceneLoader.h"
+#include "Simulation/SimulationModel.h"
+#include "Simulation/CubicSDFCollisionDetection.h"
+
+namespace PBD
+{
+	/** \brief Creates the simulation model of a scene which was read by the SceneLoader.
+	* The class does not depend on the visualization, so that it is used by the demos
+	* as well as by the headless PBDRunner.
+	*/
+	class SceneBuilder
+	{
+	protected:
+		/** Generate the signed distance field of a mesh or load it from the cache
+		* directory next to the scene file. */
+		static CubicSDFCollisionDetection::GridPtr generateSDF(const std::string &sceneFile, const std::string &modelFile, const std::string &collisionObjectFileName,
+			const Eigen::Matrix<unsigned int, 3, 1> &resolutionSDF, VertexData &vd, Utilities::IndexedFaceMesh &mesh);
+
+	public:
+		static void initTriangleModelConstraints(SimulationModel *model);
+		static void initTetModelConstraints(SimulationModel *model);
+
+		/** Create the bodies, collision objects and joints of the scene. The signed
+		* distance fields are cached in the directory of the scene file.
+		* Meshes, SDFs and mass properties are computed once per unique file (and
+		* scale and density) in parallel before the bodies are created in bulk.
+		*/
+		static void createModel(SimulationModel *model, CubicSDFCollisionDetection *cd, Utilities::SceneLoader::SceneData &data, const std::string &sceneFile);
+	};
+}
+
+#endif
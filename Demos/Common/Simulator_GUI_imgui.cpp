@@ -23,6 +23,7 @@ Simulator_GUI_imgui::Simulator_GUI_imgui(DemoBase *base)
 	m_vsync = false;
 	m_iniFound = false;
 	m_showLogWindow = true;
+	m_showStatisticsWindow = false;
 }
 
 Simulator_GUI_imgui::~Simulator_GUI_imgui(void)
@@ -92,6 +93,7 @@ void Simulator_GUI_imgui::readIni(ImGuiContext* ctx, ImGuiSettingsHandler* handl
 	else if (sscanf(line, "maximized=%d", &i) == 1) { settings->maximized = (i != 0); }
 	else if (sscanf(line, "vsync=%d", &i) == 1) { settings->vsync = (i != 0); }
 	else if (sscanf(line, "show_log_window=%d", &i) == 1) { settings->show_log_window = (i != 0); }
+	else if (sscanf(line, "show_statistics_window=%d", &i) == 1) { settings->show_statistics_window = (i != 0); }
 	else if (sscanf(line, "log_filter=%d", &i) == 1) { settings->log_filter = i; }
 }
 
@@ -113,6 +115,7 @@ void Simulator_GUI_imgui::writeIni(ImGuiContext* ctx, ImGuiSettingsHandler* hand
 
 	out_buf->appendf("vsync=%d\n", gui->m_vsync);
 	out_buf->appendf("show_log_window=%d\n", gui->m_showLogWindow);
+	out_buf->appendf("show_statistics_window=%d\n", gui->m_showStatisticsWindow);
 	out_buf->appendf("log_filter=%d\n", gui->m_logWindow->getSelectedFilter());
 }
 
@@ -123,6 +126,7 @@ void Simulator_GUI_imgui::applySettings(ImGuiContext* ctx, ImGuiSettingsHandler*
 	gui->m_currentScaleIndex = settings->scaleIndex;
 	gui->m_vsync = settings->vsync;
 	gui->m_showLogWindow = settings->show_log_window;
+	gui->m_showStatisticsWindow = settings->show_statistics_window;
 	gui->m_iniFound = true;
 	gui->m_logWindow->setSelectedFilter(settings->log_filter);
 }
@@ -267,6 +271,10 @@ void Simulator_GUI_imgui::createMenuBar()
 			{
 				m_showLogWindow = !m_showLogWindow;
 			}
+			if (ImGui::MenuItem("Show statistics window", "", m_showStatisticsWindow))
+			{
+				m_showStatisticsWindow = !m_showStatisticsWindow;
+			}
 			ImGui::EndMenu();
 		}
 		ImGui::EndMainMenuBar();
@@ -319,6 +327,80 @@ void Simulator_GUI_imgui::createSimulationParameterGUI()
 
 	if (m_showLogWindow)
 		m_logWindow->drawWindow(m_fonts2[m_currentScaleIndex]);
+	if (m_showStatisticsWindow)
+		createStatisticsWindow();
+}
+
+void Simulator_GUI_imgui::createStatisticsWindow()
+{
+	TimeStep *timeStep = Simulation::getCurrent()->getTimeStep();
+	if (timeStep == nullptr)
+		return;
+	const TimeStepStatistics &stats = timeStep->getStatistics();
+
+	float alpha = 0.8f;
+	if (ImGui::IsWindowDocked())
+		alpha = 1.0f;
+	ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.15f, 0.15f, 0.15f, alpha));
+	ImGui::Begin("Statistics", &m_showStatisticsWindow);
+
+	if (ImGui::CollapsingHeader("Solver", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		ImGui::Text("Step: %u (t = %g)", stats.m_step, (double)stats.m_time);
+		ImGui::Text("Substeps: %u", stats.m_subSteps);
+		ImGui::Text("Iterations: %u / velocity: %u", stats.m_iterations, stats.m_iterationsV);
+		ImGui::Text("Constraints: %u", stats.m_numConstraints);
+		ImGui::Text("Islands: %u, groups: %u", stats.m_numIslands, stats.m_numConstraintGroups);
+		ImGui::Text("Sleeping bodies: %u", stats.m_numSleepingBodies);
+	}
+	if (ImGui::CollapsingHeader("Residuals", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		bool collect = timeStep->getCollectStatistics();
+		if (ImGui::Checkbox("Measure residuals", &collect))
+			timeStep->setCollectStatistics(collect);
+		if (ImGui::BeginTable("residuals", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Type");
+			ImGui::TableSetupColumn("#");
+			ImGui::TableSetupColumn("Residual");
+			ImGui::TableSetupColumn("Max.");
+			ImGui::TableHeadersRow();
+			for (const TimeStepStatistics::ConstraintResidual &r : stats.m_residuals)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::TextUnformatted(r.m_typeName.c_str());
+				ImGui::TableNextColumn(); ImGui::Text("%u", r.m_numConstraints);
+				ImGui::TableNextColumn(); ImGui::Text("%.3e", (double)r.m_residual);
+				ImGui::TableNextColumn(); ImGui::Text("%.3e", (double)r.m_maxCorrection);
+			}
+			ImGui::EndTable();
+		}
+	}
+	if (ImGui::CollapsingHeader("Contacts", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		ImGui::Text("Rigid body: %u", stats.m_numRigidBodyContacts);
+		ImGui::Text("Particle-rigid body: %u", stats.m_numParticleRigidBodyContacts);
+		ImGui::Text("Particle-solid: %u", stats.m_numParticleSolidContacts);
+		ImGui::Text("Cloth: %u (color groups: %u)", stats.m_numClothContacts, stats.m_numClothContactGroups);
+	}
+	if (ImGui::CollapsingHeader("Collision detection", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		ImGui::Text("Broad phase pairs: %u", stats.m_collision.m_numBroadPhasePairs);
+		ImGui::Text("Narrow phase tests: %u", stats.m_collision.m_numNarrowPhaseTests);
+		ImGui::Text("BVH nodes visited: %zu", stats.m_collision.m_numBVHNodesVisited);
+		ImGui::Text("Cloth primitive tests: %zu", stats.m_collision.m_numClothPrimitiveTests);
+	}
+	if (ImGui::CollapsingHeader("Times", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		ImGui::Text("Time step: %.3f ms", stats.m_timeStep);
+		ImGui::Text("Position projection: %.3f ms", stats.m_timePositionProjection);
+		ImGui::Text("Velocity projection: %.3f ms", stats.m_timeVelocityProjection);
+		ImGui::Text("Collision detection: %.3f ms", stats.m_timeCollisionDetection);
+		ImGui::Text("Continuous collision detection: %.3f ms", stats.m_timeContinuousCollisionDetection);
+	}
+
+	ImGui::End();
+	ImGui::PopStyleColor(1);
 }
 
 void Simulator_GUI_imgui::initSimulationParameterGUI()
@@ -18,10 +18,11 @@ namespace PBD
 		int win_width, win_height;
 		bool vsync;
 		bool show_log_window;
+		bool show_statistics_window;
 		bool maximized;
 		int log_filter;
 
-		UserSettings() { win_x = 0; win_y = 0; win_width = 1280; win_height = 960; scaleIndex = 0; vsync = false; maximized = false; log_filter = 1; }
+		UserSettings() { win_x = 0; win_y = 0; win_width = 1280; win_height = 960; scaleIndex = 0; vsync = false; maximized = false; log_filter = 1; show_log_window = true; show_statistics_window = false; }
 	};
 
 	class LogWindow;
@@ -41,6 +42,7 @@ namespace PBD
 			unsigned int m_currentScaleIndex;
 			bool m_vsync;
 			bool m_showLogWindow;
+			bool m_showStatisticsWindow;
 			ImGuiContext* m_context;
 			UserSettings m_userSettings;
 			bool m_iniFound;
@@ -61,6 +63,8 @@ namespace PBD
 			static void applySettings(ImGuiContext* ctx, ImGuiSettingsHandler* handler);
 			bool alignedButton(const char* label, float alignment = 0.5f);
 			void createMenuBar();
+			/** Show the statistics of the last time step (see TimeStep::getStatistics()). */
+			void createStatisticsWindow();
 
 		public:
 			void init();
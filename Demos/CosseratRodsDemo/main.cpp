@@ -37,6 +37,9 @@ const Real helixHeight = -5.0;
 const Real helixTotalAngle = static_cast<Real>(10.0*M_PI);
 const Matrix3r helixOrientation = AngleAxisr(-static_cast<Real>(0.5 * M_PI), Vector3r(0,1,0)).toRotationMatrix();
 bool drawFrames = false;
+unsigned int nRods = 1;
+bool useBatchSolver = false;
+bool useDirectSolver = false;
 
 
 // main 
@@ -64,6 +67,34 @@ int main( int argc, char **argv )
 	param->setFct = [](bool b) -> void { drawFrames = b; };
 	imguiParameters::addParam("Visualization", "Elastic rods", param);
 
+	param = new imguiParameters::imguiBoolParameter();
+	param->description = "Solve the constraints of all rods in one batch constraint.";
+	param->label = "Batch solver";
+	param->readOnly = false;
+	param->getFct = []() -> bool { return useBatchSolver; };
+	param->setFct = [](bool b) -> void { if (b != useBatchSolver) { useBatchSolver = b; reset(); } };
+	imguiParameters::addParam("Simulation", "Elastic rods", param);
+
+	param = new imguiParameters::imguiBoolParameter();
+	param->description = "Solve each rod of the batch solver by a direct block-tridiagonal solver.";
+	param->label = "Direct solver";
+	param->readOnly = false;
+	param->getFct = []() -> bool { return useDirectSolver; };
+	param->setFct = [](bool b) -> void 
+	{ 
+		useDirectSolver = b; 
+		Simulation::getCurrent()->getModel()->setConstraintValue<CosseratRodsConstraint, bool, &CosseratRodsConstraint::m_directSolver>(b);
+	};
+	imguiParameters::addParam("Simulation", "Elastic rods", param);
+
+	imguiParameters::imguiNumericParameter<unsigned int>* uparam = new imguiParameters::imguiNumericParameter<unsigned int>();
+	uparam->description = "Number of simulated helices.";
+	uparam->label = "Number of rods";
+	uparam->minValue = 1;
+	uparam->getFct = []() -> unsigned int { return nRods; };
+	uparam->setFct = [](unsigned int v) -> void { if (v != nRods) { nRods = v; reset(); } };
+	imguiParameters::addParam("Simulation", "Elastic rods", uparam);
+
 
 	// OpenGL
 	MiniGL::setClientIdleFunc (timeStep);		
@@ -122,7 +153,19 @@ void buildModel ()
 {
 	TimeManager::getCurrent ()->setTimeStepSize (static_cast<Real>(0.005));
 	
-	createHelix(Vector3r(0, 0, 0), helixOrientation, helixRadius, helixHeight, helixTotalAngle, nParticles);
+	for (unsigned int i = 0; i < nRods; i++)
+		createHelix(Vector3r(0, 0, -static_cast<Real>(1.5) * (Real)i), helixOrientation, helixRadius, helixHeight, helixTotalAngle, nParticles);
+
+	if (useBatchSolver)
+	{
+		SimulationModel *model = Simulation::getCurrent()->getModel();
+		std::vector<unsigned int> lineModelIndices(model->getLineModels().size());
+		for (unsigned int i = 0; i < lineModelIndices.size(); i++)
+			lineModelIndices[i] = i;
+		model->addCosseratRodsConstraint(lineModelIndices, model->getRodStretchingStiffness(), model->getRodShearingStiffnessX(), model->getRodShearingStiffnessY(),
+			model->getRodTwistingStiffness(), model->getRodBendingStiffnessX(), model->getRodBendingStiffnessY());
+		model->setConstraintValue<CosseratRodsConstraint, bool, &CosseratRodsConstraint::m_directSolver>(useDirectSolver);
+	}
 }
 
 void renderLineModels()
@@ -244,6 +287,10 @@ void createHelix(const Vector3r &position, const Matrix3r &orientation, Real rad
 	// Set mass of quaternions to zero => make it static
 	od.setMass(nQuaternionsTotal - nQuaternions, 0.0);
 
+	// the constraints of all rods are created in buildModel()
+	if (useBatchSolver)
+		return;
+
 	// init constraints
 	const size_t rodNumber = model->getLineModels().size() - 1;
 	const unsigned int offset = model->getLineModels()[rodNumber]->getIndexOffset();
@@ -11,6 +11,14 @@ using namespace std;
 
 TimeStepFluidModel::TimeStepFluidModel()
 {
+	m_velocityUpdateMethod = 0;
+	m_maxError = static_cast<Real>(0.1);
+	m_maxErrorPeak = static_cast<Real>(5.0);
+	m_minIterations = 2;
+	m_maxIterations = 100;
+	m_iterations = 0;
+	m_avgDensityError = 0.0;
+	m_maxDensityError = 0.0;
 }
 
 TimeStepFluidModel::~TimeStepFluidModel(void)
@@ -187,36 +195,60 @@ void TimeStepFluidModel::computeXSPHViscosity(FluidModel &model)
 
 void TimeStepFluidModel::reset()
 {
-
+	m_iterations = 0;
+	m_avgDensityError = 0.0;
+	m_maxDensityError = 0.0;
 }
 
 
-/** Solve density constraint.
+/** Solve density constraint. 
+* The solver iterates until the average and the max. density error are below 
+* the user-defined tolerances (but at least m_minIterations and at most m_maxIterations times).
 */
 void TimeStepFluidModel::constraintProjection(FluidModel &model)
 {
-	const unsigned int maxIter = 5;
-	unsigned int iter = 0;
+	m_iterations = 0;
 
 	ParticleData &pd = model.getParticles();
 	const unsigned int nParticles = pd.size();
 	unsigned int **neighbors = model.getNeighborhoodSearch()->getNeighbors();
 	unsigned int *numNeighbors = model.getNeighborhoodSearch()->getNumNeighbors();
+	const Real density0 = model.getDensity0();
+	if (nParticles == 0)
+		return;
 
-	while (iter < maxIter)
+	while (m_iterations < m_maxIterations)
 	{
-		Real avg_density_err = 0.0;
+		Real sum_density_err = 0.0;
+		Real max_density_err = 0.0;
 
 		#pragma omp parallel default(shared)
 		{
-			#pragma omp for schedule(static)  
+			Real max_density_err_local = 0.0;
+
+			#pragma omp for schedule(static) reduction(+:sum_density_err)
 			for (int i = 0; i < (int)nParticles; i++)
 			{
 				Real density_err;
-				PositionBasedFluids::computePBFDensity(i, nParticles, &pd.getPosition(0), &pd.getMass(0), &model.getBoundaryX(0), &model.getBoundaryPsi(0), numNeighbors[i], neighbors[i], model.getDensity0(), true, density_err, model.getDensity(i));
-				PositionBasedFluids::computePBFLagrangeMultiplier(i, nParticles, &pd.getPosition(0), &pd.getMass(0), &model.getBoundaryX(0), &model.getBoundaryPsi(0), model.getDensity(i), numNeighbors[i], neighbors[i], model.getDensity0(), true, model.getLambda(i));
+				PositionBasedFluids::computePBFDensity(i, nParticles, &pd.getPosition(0), &pd.getMass(0), &model.getBoundaryX(0), &model.getBoundaryPsi(0), numNeighbors[i], neighbors[i], density0, true, density_err, model.getDensity(i));
+				PositionBasedFluids::computePBFLagrangeMultiplier(i, nParticles, &pd.getPosition(0), &pd.getMass(0), &model.getBoundaryX(0), &model.getBoundaryPsi(0), model.getDensity(i), numNeighbors[i], neighbors[i], density0, true, model.getLambda(i));
+				sum_density_err += density_err;
+				max_density_err_local = std::max(max_density_err_local, density_err);
+			}
+
+			// max reduction is not available in OpenMP 2.0 (MSVC)
+			#pragma omp critical
+			{
+				max_density_err = std::max(max_density_err, max_density_err_local);
 			}
 		}
+
+		// density errors in percent
+		m_avgDensityError = static_cast<Real>(100.0) * sum_density_err / (density0 * (Real)nParticles);
+		m_maxDensityError = static_cast<Real>(100.0) * max_density_err / density0;
+
+		if ((m_iterations >= m_minIterations) && (m_avgDensityError <= m_maxError) && (m_maxDensityError <= m_maxErrorPeak))
+			break;
 		
 		#pragma omp parallel default(shared)
 		{
@@ -224,7 +256,7 @@ void TimeStepFluidModel::constraintProjection(FluidModel &model)
 			for (int i = 0; i < (int)nParticles; i++)
 			{
 				Vector3r corr;
-				PositionBasedFluids::solveDensityConstraint(i, nParticles, &pd.getPosition(0), &pd.getMass(0), &model.getBoundaryX(0), &model.getBoundaryPsi(0), numNeighbors[i], neighbors[i], model.getDensity0(), true, &model.getLambda(0), corr);
+				PositionBasedFluids::solveDensityConstraint(i, nParticles, &pd.getPosition(0), &pd.getMass(0), &model.getBoundaryX(0), &model.getBoundaryPsi(0), numNeighbors[i], neighbors[i], density0, true, &model.getLambda(0), corr);
 				model.getDeltaX(i) = corr;
 			}
 		}
@@ -238,7 +270,7 @@ void TimeStepFluidModel::constraintProjection(FluidModel &model)
 			}
 		}
 
-		iter++;
+		m_iterations++;
 	}
+	INCREASE_COUNTER("PBF iterations", static_cast<double>(m_iterations));
 }
-
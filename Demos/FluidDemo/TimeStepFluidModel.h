@@ -9,6 +9,18 @@ namespace PBD
 	{
 	protected:
 		int m_velocityUpdateMethod;
+		/** Max. allowed average density error in percent */
+		Real m_maxError;
+		/** Max. allowed density error of a single particle in percent */
+		Real m_maxErrorPeak;
+		unsigned int m_minIterations;
+		unsigned int m_maxIterations;
+		/** Number of solver iterations of the last step */
+		unsigned int m_iterations;
+		/** Average density error of the last step in percent */
+		Real m_avgDensityError;
+		/** Max. density error of the last step in percent */
+		Real m_maxDensityError;
 
 		void clearAccelerations(FluidModel &model);
 		void computeXSPHViscosity(FluidModel &model);
@@ -25,6 +37,19 @@ namespace PBD
 
 		int getVelocityUpdateMethod() const { return m_velocityUpdateMethod; }
 		void setVelocityUpdateMethod(int val) { m_velocityUpdateMethod = val; }
+
+		Real getMaxError() const { return m_maxError; }
+		void setMaxError(Real val) { m_maxError = val; }
+		Real getMaxErrorPeak() const { return m_maxErrorPeak; }
+		void setMaxErrorPeak(Real val) { m_maxErrorPeak = val; }
+		unsigned int getMinIterations() const { return m_minIterations; }
+		void setMinIterations(unsigned int val) { m_minIterations = val; }
+		unsigned int getMaxIterations() const { return m_maxIterations; }
+		void setMaxIterations(unsigned int val) { m_maxIterations = val; }
+
+		unsigned int getIterations() const { return m_iterations; }
+		Real getAvgDensityError() const { return m_avgDensityError; }
+		Real getMaxDensityError() const { return m_maxDensityError; }
 	};
 }
 
@@ -93,7 +93,44 @@ int main( int argc, char **argv )
 	param->setFct = [&](Real v) -> void { model.setViscosity(v); };
 	imguiParameters::addParam("Simulation", "PBD", param);
 
-	MiniGL::mainLoop();	
+	param = new imguiParameters::imguiNumericParameter<Real>();
+	param->description = "Max. allowed average density error in percent.";
+	param->label = "Max. density error (avg) [%]";
+	param->getFct = [&]() -> Real { return simulation.getMaxError(); };
+	param->setFct = [&](Real v) -> void { simulation.setMaxError(v); };
+	imguiParameters::addParam("Simulation", "PBD", param);
+
+	param = new imguiParameters::imguiNumericParameter<Real>();
+	param->description = "Max. allowed density error of a single particle in percent.";
+	param->label = "Max. density error (peak) [%]";
+	param->getFct = [&]() -> Real { return simulation.getMaxErrorPeak(); };
+	param->setFct = [&](Real v) -> void { simulation.setMaxErrorPeak(v); };
+	imguiParameters::addParam("Simulation", "PBD", param);
+
+	imguiParameters::imguiNumericParameter<unsigned int>* uparam = new imguiParameters::imguiNumericParameter<unsigned int>();
+	uparam->description = "Minimal number of iterations of the density solver.";
+	uparam->label = "Min. iterations";
+	uparam->getFct = [&]() -> unsigned int { return simulation.getMinIterations(); };
+	uparam->setFct = [&](unsigned int v) -> void { simulation.setMinIterations(v); };
+	imguiParameters::addParam("Simulation", "PBD", uparam);
+
+	uparam = new imguiParameters::imguiNumericParameter<unsigned int>();
+	uparam->description = "Maximal number of iterations of the density solver.";
+	uparam->label = "Max. iterations";
+	uparam->minValue = 1;
+	uparam->getFct = [&]() -> unsigned int { return simulation.getMaxIterations(); };
+	uparam->setFct = [&](unsigned int v) -> void { simulation.setMaxIterations(v); };
+	imguiParameters::addParam("Simulation", "PBD", uparam);
+
+	uparam = new imguiParameters::imguiNumericParameter<unsigned int>();
+	uparam->description = "Iterations required by the density solver in the last step.";
+	uparam->label = "Iterations";
+	uparam->readOnly = true;
+	uparam->getFct = [&]() -> unsigned int { return simulation.getIterations(); };
+	uparam->setFct = [&](unsigned int v) -> void {};
+	imguiParameters::addParam("Simulation", "PBD", uparam);
+
+	MiniGL::mainLoop();
 
 	cleanup ();
 	base->cleanup();
@@ -32,6 +32,7 @@ namespace PBD
 
 		GenericDistanceConstraint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "GenericDistanceConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2, const Real stiffness);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
@@ -53,6 +54,7 @@ namespace PBD
 
 		GenericIsometricBendingConstraint() : Constraint(4) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "GenericIsometricBendingConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 								const unsigned int particle3, const unsigned int particle4, const Real stiffness);
@@ -86,6 +88,8 @@ namespace PBD
 
 		GenericHingeJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "GenericHingeJoint"; }
+		virtual unsigned int numberOfParticles() const { return 0; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &axis);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -109,6 +113,8 @@ namespace PBD
 
 		GenericBallJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "GenericBallJoint"; }
+		virtual unsigned int numberOfParticles() const { return 0; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
@@ -131,6 +137,8 @@ namespace PBD
 
 		GenericSliderJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "GenericSliderJoint"; }
+		virtual unsigned int numberOfParticles() const { return 0; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &axis);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
@@ -0,0 +1,206 @@
+#include "Benchmark.h"
+#include "Utils/Logger.h"
+#include "Utils/Version.h"
+#include "Utils/SystemInfo.h"
+#include "extern/json/json.hpp"
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <ctime>
+#include "omp.h"
+
+using namespace PBD;
+using namespace std;
+
+BenchmarkSuite::BenchmarkSuite()
+{
+	m_minTime = 0.2;
+	m_repetitions = 5;
+}
+
+BenchmarkSuite::Benchmark &BenchmarkSuite::add(const std::string &group, const std::string &name, SetupFct setup, const double itemsPerIteration)
+{
+	Benchmark b;
+	b.m_group = group;
+	b.m_name = name;
+	b.m_setup = setup;
+	b.m_itemsPerIteration = itemsPerIteration;
+	b.m_numThreads = 1;
+	b.m_iterations = 0;
+	b.m_repetitions = 0;
+	m_benchmarks.push_back(b);
+	return m_benchmarks.back();
+}
+
+double BenchmarkSuite::runTimed(const RunFct &run, const std::size_t iterations)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	run(iterations);
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+std::size_t BenchmarkSuite::determineIterations(const SetupFct &setup) const
+{
+	const std::size_t maxIterations = 1000000000u;
+	RunFct run = setup();
+	std::size_t n = 1;
+	while (n < maxIterations)
+	{
+		const double t = runTimed(run, n);
+		if (t >= m_minTime)
+			break;
+		// extrapolate with a safety factor, but grow by at most a factor of 10 per trial
+		std::size_t next = n * 10;
+		if (t > 0.0)
+			next = std::min(next, (std::size_t) std::ceil(1.2 * m_minTime / t * (double)n));
+		n = std::max(n + 1, std::min(next, maxIterations));
+	}
+	return n;
+}
+
+void BenchmarkSuite::computeStatistics(BenchmarkResult &result)
+{
+	std::vector<double> times = result.m_times;
+	std::sort(times.begin(), times.end());
+	const size_t n = times.size();
+	result.m_min = times.front();
+	result.m_max = times.back();
+	result.m_median = (n % 2 == 1) ? times[n / 2] : 0.5 * (times[n / 2 - 1] + times[n / 2]);
+	double sum = 0.0;
+	for (size_t i = 0; i < n; i++)
+		sum += times[i];
+	result.m_mean = sum / (double)n;
+	double var = 0.0;
+	for (size_t i = 0; i < n; i++)
+		var += (times[i] - result.m_mean) * (times[i] - result.m_mean);
+	result.m_stdDev = (n > 1) ? sqrt(var / (double)(n - 1)) : 0.0;
+}
+
+static std::string formatTime(const double ns)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(2);
+	if (ns < 1.0e3)
+		out << ns << " ns";
+	else if (ns < 1.0e6)
+		out << ns * 1.0e-3 << " us";
+	else if (ns < 1.0e9)
+		out << ns * 1.0e-6 << " ms";
+	else
+		out << ns * 1.0e-9 << " s";
+	return out.str();
+}
+
+void BenchmarkSuite::run(const std::string &filter)
+{
+	const int maxThreads = omp_get_max_threads();
+	for (unsigned int i = 0; i < m_benchmarks.size(); i++)
+	{
+		const Benchmark &b = m_benchmarks[i];
+		BenchmarkResult result;
+		result.m_group = b.m_group;
+		result.m_name = b.m_name;
+		if ((filter != "") && (result.getFullName().find(filter) == std::string::npos))
+			continue;
+
+		if (b.m_numThreads > 0)
+			omp_set_num_threads(b.m_numThreads);
+		result.m_numThreads = omp_get_max_threads();
+
+		result.m_iterations = b.m_iterations;
+		if (result.m_iterations == 0)
+			result.m_iterations = determineIterations(b.m_setup);
+		const unsigned int repetitions = (b.m_repetitions > 0) ? b.m_repetitions : m_repetitions;
+		for (unsigned int r = 0; r < repetitions; r++)
+		{
+			RunFct run = b.m_setup();
+			const double t = runTimed(run, result.m_iterations);
+			result.m_times.push_back(1.0e9 * t / (double)result.m_iterations);
+		}
+		computeStatistics(result);
+		result.m_itemsPerSecond = 0.0;
+		if (result.m_median > 0.0)
+			result.m_itemsPerSecond = b.m_itemsPerIteration * 1.0e9 / result.m_median;
+		if (b.m_finish)
+			b.m_finish(result);
+		omp_set_num_threads(maxThreads);
+
+		LOG_INFO << std::left << std::setw(60) << result.getFullName() << " threads: " << std::setw(3) << result.m_numThreads
+			<< " median: " << std::setw(12) << formatTime(result.m_median)
+			<< " min: " << std::setw(12) << formatTime(result.m_min)
+			<< " iterations: " << result.m_iterations;
+		m_results.push_back(result);
+	}
+}
+
+bool BenchmarkSuite::writeJSON(const std::string &fileName) const
+{
+	nlohmann::json context;
+	const std::time_t now = std::time(nullptr);
+	char date[64];
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+	context["date"] = date;
+	context["host_name"] = Utilities::SystemInfo::getHostName();
+	context["version"] = PBD_VERSION;
+	context["git_sha1"] = GIT_SHA1;
+	context["git_refspec"] = GIT_REFSPEC;
+	context["git_local_status"] = GIT_LOCAL_STATUS;
+#if defined(__clang__)
+	context["compiler"] = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	context["compiler"] = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	context["compiler"] = "msvc " STRINGIZE(_MSC_FULL_VER);
+#else
+	context["compiler"] = "unknown";
+#endif
+#ifdef NDEBUG
+	context["build_type"] = "release";
+#else
+	context["build_type"] = "debug";
+#endif
+	context["real"] = (sizeof(Real) == sizeof(double)) ? "double" : "float";
+	context["num_processors"] = omp_get_num_procs();
+	context["min_time"] = m_minTime;
+	context["repetitions"] = m_repetitions;
+
+	nlohmann::json benchmarks = nlohmann::json::array();
+	for (unsigned int i = 0; i < m_results.size(); i++)
+	{
+		const BenchmarkResult &r = m_results[i];
+		nlohmann::json b;
+		b["group"] = r.m_group;
+		b["name"] = r.m_name;
+		b["threads"] = r.m_numThreads;
+		b["iterations"] = r.m_iterations;
+		b["repetitions"] = r.m_times.size();
+		b["times_ns"] = r.m_times;
+		b["mean_ns"] = r.m_mean;
+		b["median_ns"] = r.m_median;
+		b["min_ns"] = r.m_min;
+		b["max_ns"] = r.m_max;
+		b["stddev_ns"] = r.m_stdDev;
+		if (r.m_itemsPerSecond > 0.0)
+			b["items_per_second"] = r.m_itemsPerSecond;
+		if (!r.m_counters.empty())
+			b["counters"] = r.m_counters;
+		benchmarks.push_back(b);
+	}
+
+	nlohmann::json j;
+	j["context"] = context;
+	j["benchmarks"] = benchmarks;
+
+	std::ofstream output(fileName);
+	if (!output.is_open())
+	{
+		LOG_ERR << "Cannot write the benchmark results to " << fileName;
+		return false;
+	}
+	output << std::setw(4) << j << std::endl;
+	return true;
+}
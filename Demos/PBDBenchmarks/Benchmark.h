@@ -0,0 +1,117 @@
+#ifndef __Benchmark_h__
+#define __Benchmark_h__
+
+#include "Common/Common.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace PBD
+{
+	/** Prevent that the compiler removes the computation of the value. */
+	template <typename T>
+	FORCE_INLINE void doNotOptimize(T const &value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const volatile void *sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#endif
+	}
+
+	/** \brief Result of one benchmark. The times are given per iteration.
+	*/
+	struct BenchmarkResult
+	{
+		std::string m_group;
+		std::string m_name;
+		unsigned int m_numThreads;
+		/** Iterations of each repetition */
+		std::size_t m_iterations;
+		/** Time per iteration in ns of each repetition */
+		std::vector<double> m_times;
+		double m_mean;
+		double m_median;
+		double m_min;
+		double m_max;
+		double m_stdDev;
+		/** Processed items per second based on the median (0 if not set) */
+		double m_itemsPerSecond;
+		/** Additional values of the benchmark, e.g. the speedup of a scene */
+		std::map<std::string, double> m_counters;
+
+		std::string getFullName() const { return m_group + "/" + m_name; }
+	};
+
+	/** \brief Small benchmark harness which measures the time of registered
+	* benchmarks and writes the results to a JSON file.
+	*
+	* A benchmark is defined by a setup function which prepares the data and
+	* returns the function which runs n iterations. Only the run function is
+	* timed. For each repetition the setup is called again, so that all
+	* repetitions start from the same state. If the number of iterations is not
+	* fixed, it is determined in advance such that a repetition takes at least
+	* the minimum time.
+	*/
+	class BenchmarkSuite
+	{
+	public:
+		/** Runs the given number of iterations */
+		using RunFct = std::function<void(const std::size_t)>;
+		using SetupFct = std::function<RunFct()>;
+
+		struct Benchmark
+		{
+			std::string m_group;
+			std::string m_name;
+			SetupFct m_setup;
+			/** Number of processed items per iteration (e.g. solved constraints) */
+			double m_itemsPerIteration;
+			/** Number of OpenMP threads (0: do not change the number of threads) */
+			unsigned int m_numThreads;
+			/** Fixed number of iterations per repetition (0: determined by the minimum time) */
+			std::size_t m_iterations;
+			/** Number of repetitions (0: use the default of the suite) */
+			unsigned int m_repetitions;
+			/** Called after all repetitions to add counters to the result */
+			std::function<void(BenchmarkResult&)> m_finish;
+		};
+
+	protected:
+		std::vector<Benchmark> m_benchmarks;
+		std::vector<BenchmarkResult> m_results;
+		/** Minimum time of a repetition in seconds */
+		double m_minTime;
+		unsigned int m_repetitions;
+
+		static double runTimed(const RunFct &run, const std::size_t iterations);
+		std::size_t determineIterations(const SetupFct &setup) const;
+		static void computeStatistics(BenchmarkResult &result);
+
+	public:
+		BenchmarkSuite();
+
+		/** Add a benchmark which is executed single-threaded. */
+		Benchmark &add(const std::string &group, const std::string &name, SetupFct setup, const double itemsPerIteration = 1.0);
+		std::vector<Benchmark> &getBenchmarks() { return m_benchmarks; }
+		const std::vector<BenchmarkResult> &getResults() const { return m_results; }
+
+		double getMinTime() const { return m_minTime; }
+		void setMinTime(const double val) { m_minTime = val; }
+		unsigned int getRepetitions() const { return m_repetitions; }
+		void setRepetitions(const unsigned int val) { m_repetitions = val; }
+
+		/** Run all benchmarks whose full name (group/name) contains the filter string. */
+		void run(const std::string &filter);
+		/** Write the results and information about the system and the build. */
+		bool writeJSON(const std::string &fileName) const;
+	};
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "MacroBenchmarks.h"
+#include "Simulation/TimeManager.h"
+#include "Simulation/SimulationModel.h"
+#include "Simulation/CubicSDFCollisionDetection.h"
+#include "Simulation/Simulation.h"
+#include "Utils/SceneLoader.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing.h"
+#include "Utils/FileSystem.h"
+#include "Demos/Common/SceneBuilder.h"
+#include <algorithm>
+#include <memory>
+
+using namespace PBD;
+using namespace std;
+using namespace Utilities;
+
+/** Simulation of a scene file which is created like in PBDRunner. The
+* simulation singleton is deleted together with the scene, so that each
+* repetition starts at time 0. */
+struct SceneRun
+{
+	SimulationModel *m_model;
+	CubicSDFCollisionDetection *m_cd;
+	SceneLoader::SceneData m_data;
+	bool m_updateVertexData;
+
+	SceneRun(const std::string &sceneFileName)
+	{
+		m_model = new SimulationModel();
+		m_model->init();
+		Simulation::getCurrent()->setModel(m_model);
+
+		m_cd = new CubicSDFCollisionDetection();
+		m_cd->init();
+		Simulation::getCurrent()->getTimeStep()->setCollisionDetection(*m_model, m_cd);
+
+		SceneLoader sceneLoader;
+		sceneLoader.readScene(sceneFileName.c_str(), m_data);
+		SceneBuilder::createModel(m_model, m_cd, m_data, sceneFileName);
+
+		// rebuild the model when the simulation method was changed by the parameters of the scene
+		auto reset = [this, sceneFileName]()
+		{
+			const Real h = m_model->getTimeManager().getTimeStepSize();
+			Simulation::getCurrent()->reset();
+			m_model->cleanup();
+			m_cd->cleanup();
+			SceneBuilder::createModel(m_model, m_cd, m_data, sceneFileName);
+			m_model->getTimeManager().setTimeStepSize(h);
+		};
+		m_model->setClothSimulationMethodChangedCallback(reset);
+		m_model->setClothBendingMethodChangedCallback(reset);
+		m_model->setSolidSimulationMethodChangedCallback(reset);
+
+		Simulation *sim = Simulation::getCurrent();
+		sceneLoader.readParameterObject(sim);
+		sceneLoader.readParameterObject(sim->getModel());
+		sceneLoader.readParameterObject(sim->getTimeStep());
+		sceneLoader.readParameterObject(sim->getTimeStep()->getCollisionDetection());
+
+		// nothing is exported, the previous value is restored by the destructor
+		m_updateVertexData = RigidBodyGeometry::getUpdateVertexData();
+		RigidBodyGeometry::setUpdateVertexData(false);
+	}
+
+	~SceneRun()
+	{
+		RigidBodyGeometry::setUpdateVertexData(m_updateVertexData);
+		delete Simulation::getCurrent();
+		delete m_model;
+		delete m_cd;
+	}
+
+	void step(const std::size_t numSteps)
+	{
+		TimeStep *timeStep = Simulation::getCurrent()->getTimeStep();
+		for (std::size_t i = 0; i < numSteps; i++)
+		{
+			START_TIMING("SimStep");
+			timeStep->step(*m_model);
+			STOP_TIMING_AVG;
+		}
+	}
+};
+
+std::vector<std::string> MacroBenchmarks::findScenes(const std::string &path)
+{
+	std::vector<std::string> files;
+	std::vector<std::string> sceneFiles;
+	if (!FileSystem::getFilesInDirectory(path, files))
+	{
+		LOG_ERR << "Cannot read the scene directory " << path;
+		return sceneFiles;
+	}
+	for (unsigned int i = 0; i < files.size(); i++)
+	{
+		std::string ext = FileSystem::getFileExt(files[i]);
+		transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
+		if (ext == "JSON")
+			sceneFiles.push_back(FileSystem::normalizePath(path + "/" + files[i]));
+	}
+	std::sort(sceneFiles.begin(), sceneFiles.end());
+	return sceneFiles;
+}
+
+void MacroBenchmarks::registerBenchmarks(BenchmarkSuite &suite, const std::vector<std::string> &sceneFiles,
+	const std::vector<unsigned int> &threadCounts, const unsigned int numSteps, const unsigned int repetitions)
+{
+	// median time per step of the single-threaded runs
+	std::shared_ptr<std::map<std::string, double>> serialTimes = std::make_shared<std::map<std::string, double>>();
+
+	for (unsigned int i = 0; i < sceneFiles.size(); i++)
+	{
+		const std::string sceneFileName = sceneFiles[i];
+		const std::string sceneName = FileSystem::getFileName(sceneFileName);
+		for (unsigned int t = 0; t < threadCounts.size(); t++)
+		{
+			BenchmarkSuite::Benchmark &b = suite.add("Scenes", sceneName, [sceneFileName]()
+			{
+				std::shared_ptr<SceneRun> scene = std::make_shared<SceneRun>(sceneFileName);
+				Timing::reset();
+				return BenchmarkSuite::RunFct([scene](const std::size_t n) { scene->step(n); });
+			});
+			b.m_numThreads = threadCounts[t];
+			b.m_iterations = numSteps;
+			b.m_repetitions = repetitions;
+			b.m_finish = [sceneName, serialTimes](BenchmarkResult &result)
+			{
+				result.m_counters["steps_per_second"] = 1.0e9 / result.m_median;
+				if (result.m_numThreads == 1)
+					(*serialTimes)[sceneName] = result.m_median;
+				auto iter = serialTimes->find(sceneName);
+				if (iter != serialTimes->end())
+				{
+					const double speedup = iter->second / result.m_median;
+					result.m_counters["speedup"] = speedup;
+					result.m_counters["efficiency"] = speedup / (double)result.m_numThreads;
+				}
+
+				// average times of the timing zones in the last repetition
+				const std::unordered_map<int, AverageTime> averageTimes = Timing::getAverageTimes();
+				for (auto &at : averageTimes)
+					result.m_counters["time_" + at.second.name + "_ms"] = at.second.totalTime / at.second.counter;
+			};
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef __MacroBenchmarks_h__
+#define __MacroBenchmarks_h__
+
+#include "Common/Common.h"
+#include "Benchmark.h"
+
+namespace PBD
+{
+	/** \brief Benchmarks of complete simulations. Each scene is loaded like in
+	* PBDRunner and simulated for a fixed number of time steps without export.
+	*
+	* A scene is registered once for each number of threads. An iteration is
+	* one time step. The results contain the steps per second, the speedup and
+	* the parallel efficiency with respect to the single-threaded run and the
+	* average times of the timing zones.
+	*/
+	class MacroBenchmarks
+	{
+	public:
+		/** Return all scene files (*.json) in the directory in alphabetical order. */
+		static std::vector<std::string> findScenes(const std::string &path);
+
+		static void registerBenchmarks(BenchmarkSuite &suite, const std::vector<std::string> &sceneFiles,
+			const std::vector<unsigned int> &threadCounts, const unsigned int numSteps, const unsigned int repetitions);
+	};
+}
+
+#endif
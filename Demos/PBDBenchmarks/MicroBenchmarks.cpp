@@ -0,0 +1,1325 @@
+#include "MicroBenchmarks.h"
+#include "PositionBasedDynamics/PositionBasedDynamics.h"
+#include "PositionBasedDynamics/XPBD.h"
+#include "PositionBasedDynamics/PositionBasedRigidBodyDynamics.h"
+#include "PositionBasedDynamics/MathFunctions.h"
+#include "Simulation/BoundingSphereHierarchy.h"
+#include "Simulation/DistanceFieldCollisionDetection.h"
+#include "Simulation/CubicSDFCollisionDetection.h"
+#include "Simulation/NeighborhoodSearchSpatialHashing.h"
+#include "Simulation/SimulationModel.h"
+#include "Simulation/TimeStepController.h"
+#include <random>
+#include <memory>
+
+using namespace PBD;
+using namespace std;
+
+const unsigned int MicroBenchmarks::NUM_ELEMENTS = 1024;
+
+/** Uniformly distributed random numbers in [-1,1] with a fixed seed */
+class RandomGenerator
+{
+protected:
+	std::mt19937 m_generator;
+	std::uniform_real_distribution<double> m_distribution;
+
+public:
+	RandomGenerator() : m_generator(42u), m_distribution(-1.0, 1.0) {}
+
+	Real value() { return static_cast<Real>(m_distribution(m_generator)); }
+	Vector3r vector() { return Vector3r(value(), value(), value()); }
+	Quaternionr rotation(const Real maxAngle)
+	{
+		Vector3r axis = vector();
+		if (axis.norm() < static_cast<Real>(1.0e-6))
+			axis = Vector3r(1.0, 0.0, 0.0);
+		return Quaternionr(AngleAxisr(maxAngle * value(), axis.normalized()));
+	}
+};
+
+/** Rest position of vertex j of an element. Elements with up to four vertices
+* use the vertices of a tetrahedron, the fifth vertex is the center of this
+* tetrahedron and larger elements are 3x3x3 grids. */
+static Vector3r restPosition(const unsigned int j, const unsigned int numPoints)
+{
+	if (numPoints > 5)
+		return static_cast<Real>(0.5) * Vector3r((Real)(j % 3), (Real)((j / 3) % 3), (Real)(j / 9));
+	if (j == 4)
+		return Vector3r(0.25, 0.25, 0.25);
+	const Real tet[4][3] = { { 0.0, 0.0, 0.0 }, { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	return Vector3r(tet[j][0], tet[j][1], tet[j][2]);
+}
+
+/** Particles of NUM_ELEMENTS elements with numPoints vertices each. The
+* positions x are randomly perturbed rest positions x0. */
+struct Elements
+{
+	unsigned int m_numPoints;
+	std::vector<Vector3r> m_x0;
+	std::vector<Vector3r> m_x;
+	std::vector<Vector3r> m_v;
+	std::vector<Real> m_invMass;
+	std::vector<Vector3r> m_corr;
+
+	Elements(const unsigned int numPoints)
+	{
+		RandomGenerator rnd;
+		m_numPoints = numPoints;
+		const unsigned int n = MicroBenchmarks::NUM_ELEMENTS * numPoints;
+		m_x0.resize(n);
+		m_x.resize(n);
+		m_v.resize(n);
+		m_invMass.resize(n);
+		m_corr.resize(n, Vector3r::Zero());
+		for (unsigned int e = 0; e < MicroBenchmarks::NUM_ELEMENTS; e++)
+		{
+			const Vector3r offset(static_cast<Real>(2.0) * Vector3r((Real)(e % 16), (Real)((e / 16) % 16), (Real)(e / 256)));
+			for (unsigned int j = 0; j < numPoints; j++)
+			{
+				const unsigned int i = e * numPoints + j;
+				m_x0[i] = offset + restPosition(j, numPoints) + static_cast<Real>(0.05) * rnd.vector();
+				m_x[i] = m_x0[i] + static_cast<Real>(0.1) * rnd.vector();
+				m_v[i] = rnd.vector();
+				m_invMass[i] = static_cast<Real>(1.0) + static_cast<Real>(0.5) * rnd.value();
+			}
+		}
+	}
+
+	const Vector3r *x0(const unsigned int e) const { return &m_x0[e * m_numPoints]; }
+	const Vector3r *x(const unsigned int e) const { return &m_x[e * m_numPoints]; }
+	const Vector3r *v(const unsigned int e) const { return &m_v[e * m_numPoints]; }
+	const Real *w(const unsigned int e) const { return &m_invMass[e * m_numPoints]; }
+	Vector3r *corr(const unsigned int e) { return &m_corr[e * m_numPoints]; }
+};
+
+/** Benchmark of a kernel which is called for all elements. fct(e, i) is
+* called for element i. */
+template <typename Fct>
+static BenchmarkSuite::SetupFct elementBenchmark(const unsigned int numPoints, Fct fct)
+{
+	return [numPoints, fct]()
+	{
+		std::shared_ptr<Elements> e = std::make_shared<Elements>(numPoints);
+		return BenchmarkSuite::RunFct([e, fct](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+				for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+					fct(*e, i);
+		});
+	};
+}
+
+/** Benchmark of a kernel with precomputed data. init(e, i, data) is called
+* once for each element in the setup and fct(e, i, data) in each iteration. */
+template <typename Data, typename InitFct, typename Fct>
+static BenchmarkSuite::SetupFct elementBenchmark(const unsigned int numPoints, InitFct init, Fct fct)
+{
+	return [numPoints, init, fct]()
+	{
+		std::shared_ptr<Elements> e = std::make_shared<Elements>(numPoints);
+		std::shared_ptr<std::vector<Data>> data = std::make_shared<std::vector<Data>>(MicroBenchmarks::NUM_ELEMENTS);
+		for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+			init(*e, i, (*data)[i]);
+		return BenchmarkSuite::RunFct([e, data, fct](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+				for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+					fct(*e, i, (*data)[i]);
+		});
+	};
+}
+
+struct FEMTriangleData
+{
+	Real m_area;
+	Matrix2r m_invRestMat;
+};
+
+struct FEMTetraData
+{
+	Real m_volume;
+	Matrix3r m_invRestMat;
+	Real m_lambda;
+};
+
+struct IsometricBendingData
+{
+	Matrix4r m_Q;
+	Real m_lambda;
+};
+
+struct ParticleTetContactData
+{
+	Eigen::Matrix<Real, 3, 3, Eigen::DontAlign> m_constraintInfo;
+	Real m_lambda;
+};
+
+void MicroBenchmarks::registerBenchmarks(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts)
+{
+	registerPBDKernels(suite);
+	registerXPBDKernels(suite);
+	registerRigidBodyKernels(suite);
+	registerMathFunctions(suite);
+	registerBVH(suite, threadCounts);
+	registerSDF(suite);
+	registerNeighborhoodSearch(suite, threadCounts);
+	registerCosseratRods(suite, threadCounts);
+}
+
+void MicroBenchmarks::registerPBDKernels(BenchmarkSuite &suite)
+{
+	const std::string group = "PositionBasedDynamics";
+	const Real stiffness = 1.0;
+
+	suite.add(group, "solve_DistanceConstraint", elementBenchmark(2, [stiffness](Elements &e, const unsigned int i)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_DistanceConstraint(x[0], w[0], x[1], w[1], 1.0, stiffness, c[0], c[1]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_DihedralConstraint", elementBenchmark(4, [stiffness](Elements &e, const unsigned int i)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_DihedralConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			static_cast<Real>(0.5*M_PI), stiffness, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_VolumeConstraint", elementBenchmark(4, [stiffness](Elements &e, const unsigned int i)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_VolumeConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			static_cast<Real>(1.0 / 6.0), stiffness, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_EdgePointDistanceConstraint", elementBenchmark(3, [stiffness](Elements &e, const unsigned int i)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_EdgePointDistanceConstraint(x[2], w[2], x[0], w[0], x[1], w[1],
+			0.1, stiffness, stiffness, c[2], c[0], c[1]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_TrianglePointDistanceConstraint", elementBenchmark(4, [stiffness](Elements &e, const unsigned int i)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_TrianglePointDistanceConstraint(x[3], w[3], x[0], w[0], x[1], w[1], x[2], w[2],
+			0.1, stiffness, stiffness, c[3], c[0], c[1], c[2]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_EdgeEdgeDistanceConstraint", elementBenchmark(4, [stiffness](Elements &e, const unsigned int i)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_EdgeEdgeDistanceConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			0.1, stiffness, stiffness, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_IsometricBendingConstraint", elementBenchmark<Matrix4r>(4,
+		[](Elements &e, const unsigned int i, Matrix4r &Q) {},
+		[](Elements &e, const unsigned int i, Matrix4r &Q)
+	{
+		const Vector3r *x0 = e.x0(i);
+		doNotOptimize(PositionBasedDynamics::init_IsometricBendingConstraint(x0[0], x0[1], x0[2], x0[3], Q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_IsometricBendingConstraint", elementBenchmark<Matrix4r>(4,
+		[](Elements &e, const unsigned int i, Matrix4r &Q)
+	{
+		const Vector3r *x0 = e.x0(i);
+		PositionBasedDynamics::init_IsometricBendingConstraint(x0[0], x0[1], x0[2], x0[3], Q);
+	},
+		[stiffness](Elements &e, const unsigned int i, Matrix4r &Q)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_IsometricBendingConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			Q, stiffness, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_ShapeMatchingConstraint", elementBenchmark<Vector3r>(27,
+		[](Elements &e, const unsigned int i, Vector3r &restCm) {},
+		[](Elements &e, const unsigned int i, Vector3r &restCm)
+	{
+		doNotOptimize(PositionBasedDynamics::init_ShapeMatchingConstraint(e.x0(i), e.w(i), 27, restCm));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_ShapeMatchingConstraint", elementBenchmark<Vector3r>(27,
+		[](Elements &e, const unsigned int i, Vector3r &restCm)
+	{
+		PositionBasedDynamics::init_ShapeMatchingConstraint(e.x0(i), e.w(i), 27, restCm);
+	},
+		[stiffness](Elements &e, const unsigned int i, Vector3r &restCm)
+	{
+		doNotOptimize(PositionBasedDynamics::solve_ShapeMatchingConstraint(e.x0(i), e.x(i), e.w(i), 27, restCm, stiffness, false, e.corr(i)));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_StrainTriangleConstraint", elementBenchmark<Matrix2r>(3,
+		[](Elements &e, const unsigned int i, Matrix2r &invRestMat) {},
+		[](Elements &e, const unsigned int i, Matrix2r &invRestMat)
+	{
+		const Vector3r *x0 = e.x0(i);
+		doNotOptimize(PositionBasedDynamics::init_StrainTriangleConstraint(x0[0], x0[1], x0[2], invRestMat));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_StrainTriangleConstraint", elementBenchmark<Matrix2r>(3,
+		[](Elements &e, const unsigned int i, Matrix2r &invRestMat)
+	{
+		const Vector3r *x0 = e.x0(i);
+		PositionBasedDynamics::init_StrainTriangleConstraint(x0[0], x0[1], x0[2], invRestMat);
+	},
+		[stiffness](Elements &e, const unsigned int i, Matrix2r &invRestMat)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_StrainTriangleConstraint(x[0], w[0], x[1], w[1], x[2], w[2],
+			invRestMat, stiffness, stiffness, stiffness, false, false, c[0], c[1], c[2]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_StrainTetraConstraint", elementBenchmark<Matrix3r>(4,
+		[](Elements &e, const unsigned int i, Matrix3r &invRestMat) {},
+		[](Elements &e, const unsigned int i, Matrix3r &invRestMat)
+	{
+		const Vector3r *x0 = e.x0(i);
+		doNotOptimize(PositionBasedDynamics::init_StrainTetraConstraint(x0[0], x0[1], x0[2], x0[3], invRestMat));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_StrainTetraConstraint", elementBenchmark<Matrix3r>(4,
+		[](Elements &e, const unsigned int i, Matrix3r &invRestMat)
+	{
+		const Vector3r *x0 = e.x0(i);
+		PositionBasedDynamics::init_StrainTetraConstraint(x0[0], x0[1], x0[2], x0[3], invRestMat);
+	},
+		[stiffness](Elements &e, const unsigned int i, Matrix3r &invRestMat)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		const Vector3r s(stiffness, stiffness, stiffness);
+		doNotOptimize(PositionBasedDynamics::solve_StrainTetraConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			invRestMat, s, s, false, false, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_FEMTriangleConstraint", elementBenchmark<FEMTriangleData>(3,
+		[](Elements &e, const unsigned int i, FEMTriangleData &data) {},
+		[](Elements &e, const unsigned int i, FEMTriangleData &data)
+	{
+		const Vector3r *x0 = e.x0(i);
+		doNotOptimize(PositionBasedDynamics::init_FEMTriangleConstraint(x0[0], x0[1], x0[2], data.m_area, data.m_invRestMat));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_FEMTriangleConstraint", elementBenchmark<FEMTriangleData>(3,
+		[](Elements &e, const unsigned int i, FEMTriangleData &data)
+	{
+		const Vector3r *x0 = e.x0(i);
+		PositionBasedDynamics::init_FEMTriangleConstraint(x0[0], x0[1], x0[2], data.m_area, data.m_invRestMat);
+	},
+		[](Elements &e, const unsigned int i, FEMTriangleData &data)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_FEMTriangleConstraint(x[0], w[0], x[1], w[1], x[2], w[2],
+			data.m_area, data.m_invRestMat, 1.0, 1.0, 1.0, 0.3, 0.3, c[0], c[1], c[2]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_FEMTetraConstraint", elementBenchmark<FEMTetraData>(4,
+		[](Elements &e, const unsigned int i, FEMTetraData &data) {},
+		[](Elements &e, const unsigned int i, FEMTetraData &data)
+	{
+		const Vector3r *x0 = e.x0(i);
+		doNotOptimize(PositionBasedDynamics::init_FEMTetraConstraint(x0[0], x0[1], x0[2], x0[3], data.m_volume, data.m_invRestMat));
+	}), NUM_ELEMENTS);
+
+	for (unsigned int inversion = 0; inversion < 2; inversion++)
+	{
+		const bool handleInversion = (inversion == 1);
+		suite.add(group, handleInversion ? "solve_FEMTetraConstraint_inversion" : "solve_FEMTetraConstraint", elementBenchmark<FEMTetraData>(4,
+			[](Elements &e, const unsigned int i, FEMTetraData &data)
+		{
+			const Vector3r *x0 = e.x0(i);
+			PositionBasedDynamics::init_FEMTetraConstraint(x0[0], x0[1], x0[2], x0[3], data.m_volume, data.m_invRestMat);
+		},
+			[handleInversion](Elements &e, const unsigned int i, FEMTetraData &data)
+		{
+			const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+			doNotOptimize(PositionBasedDynamics::solve_FEMTetraConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+				data.m_volume, data.m_invRestMat, 1.0, 0.3, handleInversion, c[0], c[1], c[2], c[3]));
+		}), NUM_ELEMENTS);
+	}
+
+	// particle (vertex 4) in contact with a tetrahedron (vertices 0-3)
+	const Vector3r bary(0.25, 0.25, 0.25);
+	const Vector3r normal(0.0, 1.0, 0.0);
+	auto initContact = [bary, normal](Elements &e, const unsigned int i, ParticleTetContactData &data)
+	{
+		const Vector3r *x = e.x(i); const Vector3r *v = e.v(i); const Real *w = e.w(i);
+		PositionBasedDynamics::init_ParticleTetContactConstraint(w[4], x[4], v[4], w, x, v, bary, normal, data.m_constraintInfo);
+		data.m_lambda = 0.0;
+	};
+
+	suite.add(group, "init_ParticleTetContactConstraint", elementBenchmark<ParticleTetContactData>(5,
+		[](Elements &e, const unsigned int i, ParticleTetContactData &data) {},
+		[bary, normal](Elements &e, const unsigned int i, ParticleTetContactData &data)
+	{
+		const Vector3r *x = e.x(i); const Vector3r *v = e.v(i); const Real *w = e.w(i);
+		doNotOptimize(PositionBasedDynamics::init_ParticleTetContactConstraint(w[4], x[4], v[4], w, x, v, bary, normal, data.m_constraintInfo));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_ParticleTetContactConstraint", elementBenchmark<ParticleTetContactData>(5, initContact,
+		[bary](Elements &e, const unsigned int i, ParticleTetContactData &data)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::solve_ParticleTetContactConstraint(w[4], x[4], w, x, bary, data.m_constraintInfo, data.m_lambda, c[4], c));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "velocitySolve_ParticleTetContactConstraint", elementBenchmark<ParticleTetContactData>(5, initContact,
+		[bary](Elements &e, const unsigned int i, ParticleTetContactData &data)
+	{
+		const Vector3r *x = e.x(i); const Vector3r *v = e.v(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(PositionBasedDynamics::velocitySolve_ParticleTetContactConstraint(w[4], x[4], v[4], w, x, v, bary,
+			data.m_lambda, 0.1, data.m_constraintInfo, c[4], c));
+	}), NUM_ELEMENTS);
+}
+
+void MicroBenchmarks::registerXPBDKernels(BenchmarkSuite &suite)
+{
+	const std::string group = "XPBD";
+	const Real stiffness = 1.0e5;
+	const Real dt = 0.005;
+
+	auto initLambda = [](Elements &e, const unsigned int i, Real &lambda) { lambda = 0.0; };
+
+	suite.add(group, "solve_DistanceConstraint", elementBenchmark<Real>(2, initLambda,
+		[stiffness, dt](Elements &e, const unsigned int i, Real &lambda)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(XPBD::solve_DistanceConstraint(x[0], w[0], x[1], w[1], 1.0, stiffness, dt, lambda, c[0], c[1]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_VolumeConstraint", elementBenchmark<Real>(4, initLambda,
+		[stiffness, dt](Elements &e, const unsigned int i, Real &lambda)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(XPBD::solve_VolumeConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			static_cast<Real>(1.0 / 6.0), stiffness, dt, lambda, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "init_IsometricBendingConstraint", elementBenchmark<Matrix4r>(4,
+		[](Elements &e, const unsigned int i, Matrix4r &Q) {},
+		[](Elements &e, const unsigned int i, Matrix4r &Q)
+	{
+		const Vector3r *x0 = e.x0(i);
+		doNotOptimize(XPBD::init_IsometricBendingConstraint(x0[0], x0[1], x0[2], x0[3], Q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_IsometricBendingConstraint", elementBenchmark<IsometricBendingData>(4,
+		[](Elements &e, const unsigned int i, IsometricBendingData &data)
+	{
+		const Vector3r *x0 = e.x0(i);
+		XPBD::init_IsometricBendingConstraint(x0[0], x0[1], x0[2], x0[3], data.m_Q);
+		data.m_lambda = 0.0;
+	},
+		[stiffness, dt](Elements &e, const unsigned int i, IsometricBendingData &data)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(XPBD::solve_IsometricBendingConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			data.m_Q, stiffness, dt, data.m_lambda, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "solve_FEMTetraConstraint", elementBenchmark<FEMTetraData>(4,
+		[](Elements &e, const unsigned int i, FEMTetraData &data)
+	{
+		const Vector3r *x0 = e.x0(i);
+		PositionBasedDynamics::init_FEMTetraConstraint(x0[0], x0[1], x0[2], x0[3], data.m_volume, data.m_invRestMat);
+		data.m_lambda = 0.0;
+	},
+		[dt](Elements &e, const unsigned int i, FEMTetraData &data)
+	{
+		const Vector3r *x = e.x(i); const Real *w = e.w(i); Vector3r *c = e.corr(i);
+		doNotOptimize(XPBD::solve_FEMTetraConstraint(x[0], w[0], x[1], w[1], x[2], w[2], x[3], w[3],
+			data.m_volume, data.m_invRestMat, 1.0, 0.3, false, dt, data.m_lambda, c[0], c[1], c[2], c[3]));
+	}), NUM_ELEMENTS);
+}
+
+struct RigidBodyState
+{
+	Real m_invMass;
+	Vector3r m_x;
+	Quaternionr m_q;
+	Matrix3r m_inertiaInverseW;
+	Vector3r m_v;
+	Vector3r m_omega;
+	Vector3r m_corr_x;
+	Quaternionr m_corr_q;
+};
+
+/** NUM_ELEMENTS pairs of rigid bodies. Body 1 is placed next to body 0 in x
+* direction, so that the joints are initialized at the point between them. */
+struct RigidBodyPairs
+{
+	std::vector<RigidBodyState> m_bodies;
+
+	RigidBodyPairs()
+	{
+		RandomGenerator rnd;
+		m_bodies.resize(2 * MicroBenchmarks::NUM_ELEMENTS);
+		for (unsigned int e = 0; e < MicroBenchmarks::NUM_ELEMENTS; e++)
+		{
+			const Vector3r offset(static_cast<Real>(3.0) * Vector3r((Real)(e % 16), (Real)((e / 16) % 16), (Real)(e / 256)));
+			for (unsigned int j = 0; j < 2; j++)
+			{
+				RigidBodyState &b = m_bodies[2 * e + j];
+				b.m_invMass = static_cast<Real>(1.0) + static_cast<Real>(0.5) * rnd.value();
+				b.m_x = offset + Vector3r((Real)j, 0.0, 0.0);
+				b.m_q = rnd.rotation(0.1);
+				const Matrix3r R = b.m_q.toRotationMatrix();
+				const Vector3r inertiaInverse = Vector3r(1.0, 1.0, 1.0) + static_cast<Real>(0.5) * rnd.vector();
+				b.m_inertiaInverseW = R * inertiaInverse.asDiagonal() * R.transpose();
+				b.m_v = rnd.vector();
+				b.m_omega = rnd.vector();
+				b.m_corr_x.setZero();
+				b.m_corr_q = Quaternionr(0.0, 0.0, 0.0, 0.0);
+			}
+		}
+	}
+
+	RigidBodyState &body0(const unsigned int e) { return m_bodies[2 * e]; }
+	RigidBodyState &body1(const unsigned int e) { return m_bodies[2 * e + 1]; }
+	Vector3r jointPosition(const unsigned int e) { return static_cast<Real>(0.5) * (body0(e).m_x + body1(e).m_x); }
+
+	/** Move the second bodies after the initialization of the joints, so that the joints are violated. */
+	void perturb()
+	{
+		RandomGenerator rnd;
+		for (unsigned int e = 0; e < MicroBenchmarks::NUM_ELEMENTS; e++)
+		{
+			RigidBodyState &b = body1(e);
+			b.m_x += static_cast<Real>(0.05) * rnd.vector();
+			b.m_q = rnd.rotation(0.05) * b.m_q;
+		}
+	}
+};
+
+/** Benchmark of a joint. init(p, i, info) initializes the joint of pair i
+* before the bodies are perturbed and fct(p, i, info) is called in each iteration. */
+template <typename Info, typename InitFct, typename Fct>
+static BenchmarkSuite::SetupFct jointBenchmark(InitFct init, Fct fct)
+{
+	return [init, fct]()
+	{
+		std::shared_ptr<RigidBodyPairs> p = std::make_shared<RigidBodyPairs>();
+		std::shared_ptr<std::vector<Info>> info = std::make_shared<std::vector<Info>>(MicroBenchmarks::NUM_ELEMENTS);
+		for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+			init(*p, i, (*info)[i]);
+		p->perturb();
+		return BenchmarkSuite::RunFct([p, info, fct](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+				for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+					fct(*p, i, (*info)[i]);
+		});
+	};
+}
+
+template <typename Matrix>
+struct JointInfoWithLambda
+{
+	Matrix m_jointInfo;
+	Real m_lambda;
+};
+
+struct ContactInfo
+{
+	Eigen::Matrix<Real, 3, 5, Eigen::DontAlign> m_constraintInfo;
+	Real m_sumImpulses;
+};
+
+void MicroBenchmarks::registerRigidBodyKernels(BenchmarkSuite &suite)
+{
+	using RBD = PositionBasedRigidBodyDynamics;
+	using BallJointInfo = Eigen::Matrix<Real, 3, 4, Eigen::DontAlign>;
+	using BallOnLineJointInfo = Eigen::Matrix<Real, 3, 10, Eigen::DontAlign>;
+	using HingeJointInfo = Eigen::Matrix<Real, 4, 7, Eigen::DontAlign>;
+	using UniversalJointInfo = Eigen::Matrix<Real, 3, 8, Eigen::DontAlign>;
+	using SliderJointInfo = Eigen::Matrix<Real, 4, 6, Eigen::DontAlign>;
+	using MotorHingeJointInfo = Eigen::Matrix<Real, 4, 8, Eigen::DontAlign>;
+	using RigidBodyParticleBallJointInfo = Eigen::Matrix<Real, 3, 2, Eigen::DontAlign>;
+	const std::string group = "PositionBasedRigidBodyDynamics";
+	const Vector3r axis = Vector3r(0.1, 1.0, 0.2).normalized();
+	const Vector3r axis2 = Vector3r(0.0, -0.2, 1.0).normalized();
+	const Real dt = 0.005;
+
+	// Each iteration updates the joint info and solves the joint like the time step does.
+	suite.add(group, "update_solve_BallJoint", jointBenchmark<BallJointInfo>(
+		[](RigidBodyPairs &p, const unsigned int i, BallJointInfo &info)
+	{
+		RBD::init_BallJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.jointPosition(i), info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, BallJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_BallJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_BallJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_BallOnLineJoint", jointBenchmark<BallOnLineJointInfo>(
+		[axis](RigidBodyPairs &p, const unsigned int i, BallOnLineJointInfo &info)
+	{
+		RBD::init_BallOnLineJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.jointPosition(i), axis, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, BallOnLineJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_BallOnLineJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_BallOnLineJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_HingeJoint", jointBenchmark<HingeJointInfo>(
+		[axis](RigidBodyPairs &p, const unsigned int i, HingeJointInfo &info)
+	{
+		RBD::init_HingeJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.jointPosition(i), axis, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, HingeJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_HingeJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_HingeJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_UniversalJoint", jointBenchmark<UniversalJointInfo>(
+		[axis, axis2](RigidBodyPairs &p, const unsigned int i, UniversalJointInfo &info)
+	{
+		RBD::init_UniversalJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.jointPosition(i), axis, axis2, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, UniversalJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_UniversalJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_UniversalJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_SliderJoint", jointBenchmark<SliderJointInfo>(
+		[axis](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RBD::init_SliderJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, axis, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_SliderJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_SliderJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_TargetPositionMotorSliderJoint", jointBenchmark<SliderJointInfo>(
+		[axis](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RBD::init_TargetPositionMotorSliderJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, axis, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_TargetPositionMotorSliderJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_TargetPositionMotorSliderJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			0.1, info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	auto initVelocityMotorSlider = [axis](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RBD::init_TargetVelocityMotorSliderJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, axis, info);
+	};
+
+	suite.add(group, "update_solve_TargetVelocityMotorSliderJoint", jointBenchmark<SliderJointInfo>(initVelocityMotorSlider,
+		[](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_TargetVelocityMotorSliderJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_TargetVelocityMotorSliderJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "velocitySolve_TargetVelocityMotorSliderJoint", jointBenchmark<SliderJointInfo>(initVelocityMotorSlider,
+		[](RigidBodyPairs &p, const unsigned int i, SliderJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		Vector3r corr_v0, corr_omega0, corr_v1, corr_omega1;
+		doNotOptimize(RBD::velocitySolve_TargetVelocityMotorSliderJoint(b0.m_invMass, b0.m_x, b0.m_v, b0.m_inertiaInverseW, b0.m_q, b0.m_omega,
+			b1.m_invMass, b1.m_x, b1.m_v, b1.m_inertiaInverseW, b1.m_q, b1.m_omega,
+			1.0, info, corr_v0, corr_omega0, corr_v1, corr_omega1));
+		doNotOptimize(corr_v1);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_TargetAngleMotorHingeJoint", jointBenchmark<MotorHingeJointInfo>(
+		[axis](RigidBodyPairs &p, const unsigned int i, MotorHingeJointInfo &info)
+	{
+		RBD::init_TargetAngleMotorHingeJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.jointPosition(i), axis, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, MotorHingeJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_TargetAngleMotorHingeJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_TargetAngleMotorHingeJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			0.5, info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	auto initVelocityMotorHinge = [axis](RigidBodyPairs &p, const unsigned int i, MotorHingeJointInfo &info)
+	{
+		RBD::init_TargetVelocityMotorHingeJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.jointPosition(i), axis, info);
+	};
+
+	suite.add(group, "update_solve_TargetVelocityMotorHingeJoint", jointBenchmark<MotorHingeJointInfo>(initVelocityMotorHinge,
+		[](RigidBodyPairs &p, const unsigned int i, MotorHingeJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_TargetVelocityMotorHingeJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info);
+		doNotOptimize(RBD::solve_TargetVelocityMotorHingeJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "velocitySolve_TargetVelocityMotorHingeJoint", jointBenchmark<MotorHingeJointInfo>(initVelocityMotorHinge,
+		[](RigidBodyPairs &p, const unsigned int i, MotorHingeJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		Vector3r corr_v0, corr_omega0, corr_v1, corr_omega1;
+		doNotOptimize(RBD::velocitySolve_TargetVelocityMotorHingeJoint(b0.m_invMass, b0.m_x, b0.m_v, b0.m_inertiaInverseW, b0.m_omega,
+			b1.m_invMass, b1.m_x, b1.m_v, b1.m_inertiaInverseW, b1.m_omega,
+			1.0, info, corr_v0, corr_omega0, corr_v1, corr_omega1));
+		doNotOptimize(corr_omega1);
+	}), NUM_ELEMENTS);
+
+	// body 1 is treated as particle
+	suite.add(group, "update_solve_RigidBodyParticleBallJoint", jointBenchmark<RigidBodyParticleBallJointInfo>(
+		[](RigidBodyPairs &p, const unsigned int i, RigidBodyParticleBallJointInfo &info)
+	{
+		RBD::init_RigidBodyParticleBallJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, info);
+	},
+		[](RigidBodyPairs &p, const unsigned int i, RigidBodyParticleBallJointInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_RigidBodyParticleBallJoint(b0.m_x, b0.m_q, b1.m_x, info);
+		doNotOptimize(RBD::solve_RigidBodyParticleBallJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x,
+			info, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_DistanceJoint", jointBenchmark<JointInfoWithLambda<BallJointInfo>>(
+		[](RigidBodyPairs &p, const unsigned int i, JointInfoWithLambda<BallJointInfo> &info)
+	{
+		RBD::init_DistanceJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, p.body0(i).m_x, p.body1(i).m_x, info.m_jointInfo);
+		info.m_lambda = 0.0;
+	},
+		[dt](RigidBodyPairs &p, const unsigned int i, JointInfoWithLambda<BallJointInfo> &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_DistanceJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info.m_jointInfo);
+		doNotOptimize(RBD::solve_DistanceJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			0.0, 1.0, dt, info.m_jointInfo, info.m_lambda, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "update_solve_DamperJoint", jointBenchmark<JointInfoWithLambda<SliderJointInfo>>(
+		[axis](RigidBodyPairs &p, const unsigned int i, JointInfoWithLambda<SliderJointInfo> &info)
+	{
+		RBD::init_DamperJoint(p.body0(i).m_x, p.body0(i).m_q, p.body1(i).m_x, p.body1(i).m_q, axis, info.m_jointInfo);
+		info.m_lambda = 0.0;
+	},
+		[dt](RigidBodyPairs &p, const unsigned int i, JointInfoWithLambda<SliderJointInfo> &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		RBD::update_DamperJoint(b0.m_x, b0.m_q, b1.m_x, b1.m_q, info.m_jointInfo);
+		doNotOptimize(RBD::solve_DamperJoint(b0.m_invMass, b0.m_x, b0.m_inertiaInverseW, b0.m_q, b1.m_invMass, b1.m_x, b1.m_inertiaInverseW, b1.m_q,
+			1.0e5, dt, info.m_jointInfo, info.m_lambda, b0.m_corr_x, b0.m_corr_q, b1.m_corr_x, b1.m_corr_q));
+	}), NUM_ELEMENTS);
+
+	// contact between the bodies at the point between them
+	const Vector3r normal(1.0, 0.0, 0.0);
+	auto initRigidBodyContact = [normal](RigidBodyPairs &p, const unsigned int i, ContactInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		const Vector3r cp = p.jointPosition(i);
+		RBD::init_RigidBodyContactConstraint(b0.m_invMass, b0.m_x, b0.m_v, b0.m_inertiaInverseW, b0.m_q, b0.m_omega,
+			b1.m_invMass, b1.m_x, b1.m_v, b1.m_inertiaInverseW, b1.m_q, b1.m_omega,
+			cp, cp, normal, 0.6, info.m_constraintInfo);
+		info.m_sumImpulses = 0.0;
+	};
+
+	suite.add(group, "init_RigidBodyContactConstraint", jointBenchmark<ContactInfo>(
+		[](RigidBodyPairs &p, const unsigned int i, ContactInfo &info) {},
+		[initRigidBodyContact](RigidBodyPairs &p, const unsigned int i, ContactInfo &info)
+	{
+		initRigidBodyContact(p, i, info);
+		doNotOptimize(info.m_constraintInfo);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "velocitySolve_RigidBodyContactConstraint", jointBenchmark<ContactInfo>(initRigidBodyContact,
+		[](RigidBodyPairs &p, const unsigned int i, ContactInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		Vector3r corr_v0, corr_omega0, corr_v1, corr_omega1;
+		doNotOptimize(RBD::velocitySolve_RigidBodyContactConstraint(b0.m_invMass, b0.m_x, b0.m_v, b0.m_inertiaInverseW, b0.m_omega,
+			b1.m_invMass, b1.m_x, b1.m_v, b1.m_inertiaInverseW, b1.m_omega,
+			0.0, 0.3, info.m_sumImpulses, info.m_constraintInfo, corr_v0, corr_omega0, corr_v1, corr_omega1));
+		doNotOptimize(corr_omega1);
+	}), NUM_ELEMENTS);
+
+	// body 0 is treated as particle
+	auto initParticleRigidBodyContact = [normal](RigidBodyPairs &p, const unsigned int i, ContactInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		const Vector3r cp = p.jointPosition(i);
+		RBD::init_ParticleRigidBodyContactConstraint(b0.m_invMass, b0.m_x, b0.m_v,
+			b1.m_invMass, b1.m_x, b1.m_v, b1.m_inertiaInverseW, b1.m_q, b1.m_omega,
+			cp, cp, normal, 0.6, info.m_constraintInfo);
+		info.m_sumImpulses = 0.0;
+	};
+
+	suite.add(group, "init_ParticleRigidBodyContactConstraint", jointBenchmark<ContactInfo>(
+		[](RigidBodyPairs &p, const unsigned int i, ContactInfo &info) {},
+		[initParticleRigidBodyContact](RigidBodyPairs &p, const unsigned int i, ContactInfo &info)
+	{
+		initParticleRigidBodyContact(p, i, info);
+		doNotOptimize(info.m_constraintInfo);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "velocitySolve_ParticleRigidBodyContactConstraint", jointBenchmark<ContactInfo>(initParticleRigidBodyContact,
+		[](RigidBodyPairs &p, const unsigned int i, ContactInfo &info)
+	{
+		RigidBodyState &b0 = p.body0(i); RigidBodyState &b1 = p.body1(i);
+		Vector3r corr_v0, corr_v1, corr_omega1;
+		doNotOptimize(RBD::velocitySolve_ParticleRigidBodyContactConstraint(b0.m_invMass, b0.m_x, b0.m_v,
+			b1.m_invMass, b1.m_x, b1.m_v, b1.m_inertiaInverseW, b1.m_omega,
+			0.0, 0.3, info.m_sumImpulses, info.m_constraintInfo, corr_v0, corr_v1, corr_omega1));
+		doNotOptimize(corr_omega1);
+	}), NUM_ELEMENTS);
+}
+
+/** NUM_ELEMENTS random deformation gradients (rotations with random stretch)
+* and buffers for the results */
+struct Matrices
+{
+	std::vector<Matrix3r> m_A;
+	std::vector<Matrix3r> m_S;
+	std::vector<Matrix3r> m_R;
+	std::vector<Matrix3r> m_U;
+	std::vector<Matrix3r> m_D;
+	std::vector<Matrix3r> m_VT;
+	std::vector<Vector3r> m_sigma;
+	std::vector<Quaternionr> m_q;
+
+	Matrices()
+	{
+		RandomGenerator rnd;
+		const unsigned int n = MicroBenchmarks::NUM_ELEMENTS;
+		m_A.resize(n);
+		m_S.resize(n);
+		m_R.resize(n);
+		m_U.resize(n);
+		m_D.resize(n);
+		m_VT.resize(n);
+		m_sigma.resize(n);
+		m_q.resize(n, Quaternionr::Identity());
+		for (unsigned int i = 0; i < n; i++)
+		{
+			Matrix3r stretch = Matrix3r::Identity();
+			for (unsigned int j = 0; j < 3; j++)
+				stretch.col(j) += static_cast<Real>(0.3) * rnd.vector();
+			m_A[i] = rnd.rotation(static_cast<Real>(M_PI)).toRotationMatrix() * stretch;
+			m_S[i] = m_A[i].transpose() * m_A[i];
+		}
+	}
+};
+
+/** Benchmark of a routine which is called for all matrices. */
+template <typename Fct>
+static BenchmarkSuite::SetupFct matrixBenchmark(Fct fct)
+{
+	return [fct]()
+	{
+		std::shared_ptr<Matrices> m = std::make_shared<Matrices>();
+		return BenchmarkSuite::RunFct([m, fct](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+				for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+					fct(*m, i);
+		});
+	};
+}
+
+void MicroBenchmarks::registerMathFunctions(BenchmarkSuite &suite)
+{
+	const std::string group = "MathFunctions";
+
+	suite.add(group, "infNorm", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		doNotOptimize(MathFunctions::infNorm(m.m_A[i]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "oneNorm", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		doNotOptimize(MathFunctions::oneNorm(m.m_A[i]));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "eigenDecomposition", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::eigenDecomposition(m.m_S[i], m.m_U[i], m.m_sigma[i]);
+		doNotOptimize(m.m_sigma[i]);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "polarDecomposition", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::polarDecomposition(m.m_A[i], m.m_R[i], m.m_U[i], m.m_D[i]);
+		doNotOptimize(m.m_R[i]);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "polarDecompositionStable", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::polarDecompositionStable(m.m_A[i], static_cast<Real>(1.0e-6), m.m_R[i]);
+		doNotOptimize(m.m_R[i]);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "svdWithInversionHandling", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::svdWithInversionHandling(m.m_A[i], m.m_sigma[i], m.m_U[i], m.m_VT[i]);
+		doNotOptimize(m.m_sigma[i]);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "cotTheta", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		doNotOptimize(MathFunctions::cotTheta(m.m_A[i].col(0), m.m_A[i].col(1)));
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "crossProductMatrix", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::crossProductMatrix(m.m_A[i].col(0), m.m_R[i]);
+		doNotOptimize(m.m_R[i]);
+	}), NUM_ELEMENTS);
+
+	// the rotation of the last iteration is used as initial guess like in the shape matching
+	suite.add(group, "extractRotation", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::extractRotation(m.m_A[i], m.m_q[i], 10);
+		doNotOptimize(m.m_q[i]);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "svd3x3", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::svd3x3(m.m_A[i], m.m_sigma[i], m.m_U[i], m.m_VT[i]);
+		doNotOptimize(m.m_sigma[i]);
+	}), NUM_ELEMENTS);
+
+	suite.add(group, "polarDecomposition3x3", matrixBenchmark([](Matrices &m, const unsigned int i)
+	{
+		MathFunctions::polarDecomposition3x3(m.m_A[i], m.m_R[i]);
+		doNotOptimize(m.m_R[i]);
+	}), NUM_ELEMENTS);
+
+#ifndef USE_DOUBLE
+	suite.add(group, "svd3x3Batch", []()
+	{
+		std::shared_ptr<Matrices> m = std::make_shared<Matrices>();
+		return BenchmarkSuite::RunFct([m](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+			{
+				MathFunctions::svd3x3Batch(NUM_ELEMENTS, m->m_A.data(), m->m_sigma.data(), m->m_U.data(), m->m_VT.data());
+				doNotOptimize(m->m_sigma[0]);
+			}
+		});
+	}, NUM_ELEMENTS);
+
+	suite.add(group, "polarDecompositionBatch", []()
+	{
+		std::shared_ptr<Matrices> m = std::make_shared<Matrices>();
+		return BenchmarkSuite::RunFct([m](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+			{
+				MathFunctions::polarDecompositionBatch(NUM_ELEMENTS, m->m_A.data(), m->m_R.data());
+				doNotOptimize(m->m_R[0]);
+			}
+		});
+	}, NUM_ELEMENTS);
+#endif
+}
+
+/** Random point cloud and a tetrahedral grid in the unit cube with their
+* bounding sphere hierarchies */
+struct BVHData
+{
+	std::vector<Vector3r> m_points;
+	std::vector<Vector3r> m_vertices;
+	std::vector<unsigned int> m_tets;
+	PointCloudBSH m_pointBVH;
+	TetMeshBSH m_tetBVH;
+
+	BVHData(const unsigned int numPoints, const unsigned int resolution)
+	{
+		RandomGenerator rnd;
+		m_points.resize(numPoints);
+		for (unsigned int i = 0; i < numPoints; i++)
+			m_points[i] = static_cast<Real>(0.5) * (rnd.vector() + Vector3r(1.0, 1.0, 1.0));
+
+		// each grid cell is split into six tetrahedra
+		const unsigned int n = resolution + 1;
+		const Real h = static_cast<Real>(1.0) / (Real)resolution;
+		m_vertices.resize(n * n * n);
+		for (unsigned int k = 0; k < n; k++)
+			for (unsigned int j = 0; j < n; j++)
+				for (unsigned int i = 0; i < n; i++)
+					m_vertices[i + n * (j + n * k)] = h * Vector3r((Real)i, (Real)j, (Real)k);
+		const unsigned int cellTets[6][4] = { { 0, 1, 3, 7 }, { 0, 1, 5, 7 }, { 0, 2, 3, 7 }, { 0, 2, 6, 7 }, { 0, 4, 5, 7 }, { 0, 4, 6, 7 } };
+		m_tets.reserve(resolution * resolution * resolution * 24);
+		for (unsigned int k = 0; k < resolution; k++)
+			for (unsigned int j = 0; j < resolution; j++)
+				for (unsigned int i = 0; i < resolution; i++)
+				{
+					unsigned int corners[8];
+					for (unsigned int c = 0; c < 8; c++)
+						corners[c] = (i + (c & 1)) + n * ((j + ((c >> 1) & 1)) + n * (k + ((c >> 2) & 1)));
+					for (unsigned int t = 0; t < 6; t++)
+						for (unsigned int l = 0; l < 4; l++)
+							m_tets.push_back(corners[cellTets[t][l]]);
+				}
+	}
+
+	unsigned int numTets() const { return (unsigned int) m_tets.size() / 4; }
+
+	void constructPointBVH()
+	{
+		m_pointBVH.init(m_points.data(), (unsigned int)m_points.size());
+		m_pointBVH.construct();
+	}
+
+	void constructTetBVH()
+	{
+		m_tetBVH.init(m_vertices.data(), (unsigned int)m_vertices.size(), m_tets.data(), numTets(), 0.0);
+		m_tetBVH.construct();
+	}
+};
+
+void MicroBenchmarks::registerBVH(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts)
+{
+	const std::string group = "BoundingSphereHierarchy";
+	const unsigned int numPoints = 65536;
+	const unsigned int resolution = 16;
+	const unsigned int numQueries = NUM_ELEMENTS;
+
+	suite.add(group, "PointCloudBSH_construct", [numPoints]()
+	{
+		std::shared_ptr<BVHData> data = std::make_shared<BVHData>(numPoints, 1);
+		return BenchmarkSuite::RunFct([data](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+			{
+				data->constructPointBVH();
+				doNotOptimize(data->m_pointBVH.hull(0));
+			}
+		});
+	}, numPoints);
+
+	// sphere queries like in the collision detection of the demos
+	suite.add(group, "PointCloudBSH_traverse_depth_first", [numPoints, numQueries]()
+	{
+		std::shared_ptr<BVHData> data = std::make_shared<BVHData>(numPoints, 1);
+		data->constructPointBVH();
+		std::shared_ptr<std::vector<BoundingSphere>> queries = std::make_shared<std::vector<BoundingSphere>>();
+		RandomGenerator rnd;
+		for (unsigned int i = 0; i < numQueries; i++)
+			queries->push_back(BoundingSphere(static_cast<Real>(0.5) * (rnd.vector() + Vector3r(1.0, 1.0, 1.0)), 0.05));
+		return BenchmarkSuite::RunFct([data, queries](const std::size_t n)
+		{
+			const PointCloudBSH &bvh = data->m_pointBVH;
+			for (std::size_t iter = 0; iter < n; iter++)
+			{
+				unsigned int numFound = 0;
+				for (unsigned int i = 0; i < queries->size(); i++)
+				{
+					const BoundingSphere &query = (*queries)[i];
+					auto predicate = [&](unsigned int node_index, unsigned int depth)
+					{
+						return bvh.hull(node_index).overlaps(query);
+					};
+					auto cb = [&](unsigned int node_index, unsigned int depth)
+					{
+						auto const& node = bvh.node(node_index);
+						if (!node.is_leaf())
+							return;
+						for (auto j = node.begin; j < node.begin + node.n; ++j)
+						{
+							if (query.contains(data->m_points[bvh.entity(j)]))
+								numFound++;
+						}
+					};
+					bvh.traverse_depth_first(predicate, cb);
+				}
+				doNotOptimize(numFound);
+			}
+		});
+	}, numQueries);
+
+	suite.add(group, "TetMeshBSH_construct", [resolution]()
+	{
+		std::shared_ptr<BVHData> data = std::make_shared<BVHData>(1, resolution);
+		return BenchmarkSuite::RunFct([data](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+			{
+				data->constructTetBVH();
+				doNotOptimize(data->m_tetBVH.hull(0));
+			}
+		});
+	}, resolution * resolution * resolution * 6);
+
+	// the refit of the hierarchy is parallelized
+	for (unsigned int t = 0; t < threadCounts.size(); t++)
+	{
+		BenchmarkSuite::Benchmark &b = suite.add(group, "TetMeshBSH_update", [resolution]()
+		{
+			std::shared_ptr<BVHData> data = std::make_shared<BVHData>(1, resolution);
+			data->constructTetBVH();
+			return BenchmarkSuite::RunFct([data](const std::size_t n)
+			{
+				for (std::size_t iter = 0; iter < n; iter++)
+				{
+					data->m_tetBVH.update();
+					doNotOptimize(data->m_tetBVH.hull(0));
+				}
+			});
+		}, resolution * resolution * resolution * 6);
+		b.m_numThreads = threadCounts[t];
+	}
+
+	suite.add(group, "BVHTest_traverse", [resolution]()
+	{
+		std::shared_ptr<BVHData> data = std::make_shared<BVHData>(16384, resolution);
+		data->constructPointBVH();
+		data->constructTetBVH();
+		return BenchmarkSuite::RunFct([data](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+			{
+				std::size_t numPairs = 0;
+				BVHTest::traverse(data->m_pointBVH, data->m_tetBVH, [&](unsigned int node_index1, unsigned int node_index2) { numPairs++; });
+				doNotOptimize(numPairs);
+			}
+		});
+	});
+}
+
+/** Distance queries of a collision object at NUM_ELEMENTS random points */
+template <typename Fct>
+static BenchmarkSuite::SetupFct sdfBenchmark(std::shared_ptr<DistanceFieldCollisionDetection::DistanceFieldCollisionObject> co, Fct fct)
+{
+	return [co, fct]()
+	{
+		RandomGenerator rnd;
+		std::shared_ptr<std::vector<Vector3r>> points = std::make_shared<std::vector<Vector3r>>(MicroBenchmarks::NUM_ELEMENTS);
+		for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+			(*points)[i] = static_cast<Real>(1.5) * rnd.vector();
+		return BenchmarkSuite::RunFct([co, points, fct](const std::size_t n)
+		{
+			for (std::size_t iter = 0; iter < n; iter++)
+				for (unsigned int i = 0; i < MicroBenchmarks::NUM_ELEMENTS; i++)
+					fct(*co, (*points)[i]);
+		});
+	};
+}
+
+void MicroBenchmarks::registerSDF(BenchmarkSuite &suite)
+{
+	using DFCD = DistanceFieldCollisionDetection;
+	const std::string group = "SDF";
+	const Real tolerance = 0.01;
+
+	std::vector<std::pair<std::string, std::shared_ptr<DFCD::DistanceFieldCollisionObject>>> objects;
+
+	std::shared_ptr<DFCD::DistanceFieldCollisionBox> box = std::make_shared<DFCD::DistanceFieldCollisionBox>();
+	box->m_box = Vector3r(0.5, 0.7, 0.9);
+	objects.push_back({ "Box", box });
+
+	std::shared_ptr<DFCD::DistanceFieldCollisionSphere> sphere = std::make_shared<DFCD::DistanceFieldCollisionSphere>();
+	sphere->m_radius = 1.0;
+	objects.push_back({ "Sphere", sphere });
+
+	std::shared_ptr<DFCD::DistanceFieldCollisionTorus> torus = std::make_shared<DFCD::DistanceFieldCollisionTorus>();
+	torus->m_radii = Vector2r(1.0, 0.2);
+	objects.push_back({ "Torus", torus });
+
+	std::shared_ptr<DFCD::DistanceFieldCollisionCylinder> cylinder = std::make_shared<DFCD::DistanceFieldCollisionCylinder>();
+	cylinder->m_dim = Vector2r(0.5, 1.0);
+	objects.push_back({ "Cylinder", cylinder });
+
+	std::shared_ptr<DFCD::DistanceFieldCollisionHollowSphere> hollowSphere = std::make_shared<DFCD::DistanceFieldCollisionHollowSphere>();
+	hollowSphere->m_radius = 1.0;
+	hollowSphere->m_thickness = 0.1;
+	objects.push_back({ "HollowSphere", hollowSphere });
+
+	std::shared_ptr<DFCD::DistanceFieldCollisionHollowBox> hollowBox = std::make_shared<DFCD::DistanceFieldCollisionHollowBox>();
+	hollowBox->m_box = Vector3r(0.5, 0.7, 0.9);
+	hollowBox->m_thickness = 0.1;
+	objects.push_back({ "HollowBox", hollowBox });
+
+	// cubic signed distance field of a sphere on a 20^3 grid
+	std::shared_ptr<CubicSDFCollisionDetection::CubicSDFCollisionObject> cubicSDF = std::make_shared<CubicSDFCollisionDetection::CubicSDFCollisionObject>();
+	Eigen::AlignedBox3d domain;
+	domain.extend(Eigen::Vector3d(-1.5, -1.5, -1.5));
+	domain.extend(Eigen::Vector3d(1.5, 1.5, 1.5));
+	cubicSDF->m_sdf = std::make_shared<CubicSDFCollisionDetection::Grid>(domain, std::array<unsigned int, 3>({ 20, 20, 20 }));
+	cubicSDF->m_sdf->addFunction([](Eigen::Vector3d const& x) { return x.norm() - 1.0; });
+	cubicSDF->m_scale = Vector3r(1.0, 1.0, 1.0);
+	objects.push_back({ "CubicSDF", cubicSDF });
+
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		suite.add(group, objects[i].first + "_distance", sdfBenchmark(objects[i].second,
+			[tolerance](DFCD::DistanceFieldCollisionObject &co, const Vector3r &x)
+		{
+			doNotOptimize(co.distance(x.template cast<double>(), tolerance));
+		}), NUM_ELEMENTS);
+
+		suite.add(group, objects[i].first + "_collisionTest", sdfBenchmark(objects[i].second,
+			[tolerance](DFCD::DistanceFieldCollisionObject &co, const Vector3r &x)
+		{
+			Vector3r cp, n;
+			Real dist;
+			doNotOptimize(co.collisionTest(x, tolerance, cp, n, dist, 0.1));
+			doNotOptimize(cp);
+		}), NUM_ELEMENTS);
+	}
+}
+
+void MicroBenchmarks::registerNeighborhoodSearch(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts)
+{
+	// fluid block with particle radius 0.025 and support radius 0.1 like in the fluid demo
+	const unsigned int resolution = 32;
+	const unsigned int numParticles = resolution * resolution * resolution;
+	for (unsigned int t = 0; t < threadCounts.size(); t++)
+	{
+		BenchmarkSuite::Benchmark &b = suite.add("NeighborhoodSearch", "SpatialHashing", [resolution, numParticles]()
+		{
+			RandomGenerator rnd;
+			std::shared_ptr<std::vector<Vector3r>> x = std::make_shared<std::vector<Vector3r>>(numParticles);
+			const Real diam = 0.05;
+			for (unsigned int i = 0; i < numParticles; i++)
+			{
+				const Vector3r gridPos((Real)(i % resolution), (Real)((i / resolution) % resolution), (Real)(i / (resolution*resolution)));
+				(*x)[i] = diam * gridPos + static_cast<Real>(0.1) * diam * rnd.vector();
+			}
+			std::shared_ptr<NeighborhoodSearchSpatialHashing> search = std::make_shared<NeighborhoodSearchSpatialHashing>(numParticles, static_cast<Real>(2.0) * diam);
+			return BenchmarkSuite::RunFct([x, search](const std::size_t n)
+			{
+				for (std::size_t iter = 0; iter < n; iter++)
+				{
+					search->neighborhoodSearch(x->data());
+					search->update();
+					doNotOptimize(search->n_neighbors(0));
+				}
+			});
+		}, numParticles);
+		b.m_numThreads = threadCounts[t];
+	}
+}
+
+/** Hanging helices like in the CosseratRodsDemo. The constraints are either 
+* created per segment or the constraints of all rods are solved by a single 
+* CosseratRodsConstraint, optionally with the direct solver. */
+struct RodsData
+{
+	SimulationModel m_model;
+	TimeStepController m_timeStep;
+
+	RodsData(const unsigned int numRods, const unsigned int numPoints, const bool batch, const bool directSolver)
+	{
+		m_model.init();
+		m_timeStep.init();
+		m_model.getTimeManager().setTimeStepSize(static_cast<Real>(0.005));
+
+		const Real radius = 0.5;
+		const Real height = -5.0;
+		const Real totalAngle = static_cast<Real>(10.0*M_PI);
+		const Matrix3r orientation = AngleAxisr(-static_cast<Real>(0.5 * M_PI), Vector3r(0, 1, 0)).toRotationMatrix();
+		const unsigned int numQuaternions = numPoints - 1;
+		std::vector<Vector3r> points(numPoints);
+		std::vector<Quaternionr> quaternions(numQuaternions);
+		std::vector<unsigned int> indices(2 * numQuaternions);
+		std::vector<unsigned int> indicesQuaternions(numQuaternions);
+		for (unsigned int i = 0; i < numQuaternions; i++)
+		{
+			indices[2 * i] = i;
+			indices[2 * i + 1] = i + 1;
+			indicesQuaternions[i] = i;
+		}
+
+		ParticleData &pd = m_model.getParticles();
+		OrientationData &od = m_model.getOrientations();
+		for (unsigned int r = 0; r < numRods; r++)
+		{
+			const Vector3r position(0, 0, -static_cast<Real>(1.5) * (Real)r);
+			for (unsigned int i = 0; i < numPoints; i++)
+			{
+				const Real angle = totalAngle / ((Real)numPoints) * (Real)i;
+				points[i] = orientation * Vector3r(radius * std::cos(angle), radius * std::sin(angle), height / ((Real)numPoints) * (Real)i) + position;
+			}
+			Vector3r from(0, 0, 1);
+			for (unsigned int i = 0; i < numQuaternions; i++)
+			{
+				const Vector3r to = (points[i + 1] - points[i]).normalized();
+				const Quaternionr dq = Quaternionr::FromTwoVectors(from, to);
+				if (i == 0)
+					quaternions[i] = dq;
+				else
+					quaternions[i] = dq * quaternions[i - 1];
+				from = to;
+			}
+			m_model.addLineModel(numPoints, numQuaternions, &points[0], &quaternions[0], &indices[0], &indicesQuaternions[0]);
+
+			// the first particle and quaternion of each rod are static
+			LineModel *lineModel = m_model.getLineModels().back();
+			const unsigned int offset = lineModel->getIndexOffset();
+			const unsigned int offsetQuaternions = lineModel->getIndexOffsetQuaternions();
+			pd.setMass(offset, 0.0);
+			od.setMass(offsetQuaternions, 0.0);
+			if (batch)
+				continue;
+
+			const LineModel::Edges &edges = lineModel->getEdges();
+			for (unsigned int i = 0; i < edges.size(); i++)
+				m_model.addStretchShearConstraint(edges[i].m_vert[0] + offset, edges[i].m_vert[1] + offset, edges[i].m_quat + offsetQuaternions, 
+					m_model.getRodStretchingStiffness(), m_model.getRodShearingStiffnessX(), m_model.getRodShearingStiffnessY());
+			for (unsigned int i = 0; i + 1 < edges.size(); i++)
+				m_model.addBendTwistConstraint(edges[i].m_quat + offsetQuaternions, edges[i + 1].m_quat + offsetQuaternions, 
+					m_model.getRodTwistingStiffness(), m_model.getRodBendingStiffnessX(), m_model.getRodBendingStiffnessY());
+		}
+
+		if (batch)
+		{
+			std::vector<unsigned int> lineModelIndices(numRods);
+			for (unsigned int i = 0; i < numRods; i++)
+				lineModelIndices[i] = i;
+			m_model.addCosseratRodsConstraint(lineModelIndices, m_model.getRodStretchingStiffness(), m_model.getRodShearingStiffnessX(), m_model.getRodShearingStiffnessY(),
+				m_model.getRodTwistingStiffness(), m_model.getRodBendingStiffnessX(), m_model.getRodBendingStiffnessY());
+			m_model.setConstraintValue<CosseratRodsConstraint, bool, &CosseratRodsConstraint::m_directSolver>(directSolver);
+		}
+	}
+};
+
+void MicroBenchmarks::registerCosseratRods(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts)
+{
+	// 2000 helices with 50 particles, i.e. about 100k segments like a hair simulation.
+	// An iteration is one time step, the items are the segments.
+	const unsigned int numRods = 2000;
+	const unsigned int numPoints = 50;
+	const char *names[3] = { "step_per_segment_constraints", "step_batch", "step_batch_direct" };
+	for (unsigned int solver = 0; solver < 3; solver++)
+	{
+		for (unsigned int t = 0; t < threadCounts.size(); t++)
+		{
+			BenchmarkSuite::Benchmark &b = suite.add("CosseratRods", names[solver], [numRods, numPoints, solver]()
+			{
+				std::shared_ptr<RodsData> data = std::make_shared<RodsData>(numRods, numPoints, solver > 0, solver == 2);
+				return BenchmarkSuite::RunFct([data, numPoints](const std::size_t n)
+				{
+					for (std::size_t iter = 0; iter < n; iter++)
+						data->m_timeStep.step(data->m_model);
+					doNotOptimize(data->m_model.getParticles().getPosition(numPoints - 1));
+				});
+			}, numRods * (numPoints - 1));
+			b.m_numThreads = threadCounts[t];
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef __MicroBenchmarks_h__
+#define __MicroBenchmarks_h__
+
+#include "Common/Common.h"
+#include "Benchmark.h"
+
+namespace PBD
+{
+	/** \brief Benchmarks of single routines: the constraint kernels of
+	* PositionBasedDynamics, XPBD and PositionBasedRigidBodyDynamics, the
+	* routines of MathFunctions, the bounding sphere hierarchies, the distance
+	* queries of the collision objects, the neighborhood search and the 
+	* solvers of Cosserat rods.
+	*
+	* The kernels are called for NUM_ELEMENTS randomly perturbed elements per
+	* iteration, so that the throughput is reported in elements per second.
+	* The random numbers use a fixed seed, so that the runs are reproducible.
+	*/
+	class MicroBenchmarks
+	{
+	protected:
+		static void registerPBDKernels(BenchmarkSuite &suite);
+		static void registerXPBDKernels(BenchmarkSuite &suite);
+		static void registerRigidBodyKernels(BenchmarkSuite &suite);
+		static void registerMathFunctions(BenchmarkSuite &suite);
+		static void registerBVH(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts);
+		static void registerSDF(BenchmarkSuite &suite);
+		static void registerNeighborhoodSearch(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts);
+		static void registerCosseratRods(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts);
+
+	public:
+		static const unsigned int NUM_ELEMENTS;
+
+		/** Register all micro benchmarks. The routines which are parallelized
+		* with OpenMP are registered for each of the given numbers of threads. */
+		static void registerBenchmarks(BenchmarkSuite &suite, const std::vector<unsigned int> &threadCounts);
+	};
+}
+
+#endif
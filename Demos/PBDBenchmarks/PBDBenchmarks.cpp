@@ -0,0 +1,130 @@
+#include "Common/Common.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing.h"
+#include "Utils/FileSystem.h"
+#include "Utils/Version.h"
+#include "Benchmark.h"
+#include "MicroBenchmarks.h"
+#include "MacroBenchmarks.h"
+#include <iostream>
+#include "omp.h"
+
+// Enable memory leak detection
+#if defined(_DEBUG) && !defined(EIGEN_ALIGN)
+	#define new DEBUG_NEW
+#endif
+
+INIT_LOGGING
+INIT_TIMING
+
+using namespace PBD;
+using namespace std;
+using namespace Utilities;
+
+void printUsage()
+{
+	std::cerr << "Usage: PBDBenchmarks [options]\n"
+		<< "Options:\n"
+		<< "  --filter <str>           Run only the benchmarks whose name (group/name) contains the string.\n"
+		<< "  --json <file>            Write the results to a JSON file.\n"
+		<< "  --micro                  Run only the micro benchmarks.\n"
+		<< "  --macro                  Run only the scene benchmarks.\n"
+		<< "  --min-time <t>           Minimum time of a repetition of a micro benchmark in seconds (default: 0.2).\n"
+		<< "  --repetitions <n>        Repetitions of each micro benchmark (default: 5).\n"
+		<< "  --scenes <dir>           Directory of the scene files (default: resources/scenes next to the executable).\n"
+		<< "  --steps <n>              Number of time steps of a scene benchmark (default: 100).\n"
+		<< "  --macro-repetitions <n>  Repetitions of each scene benchmark (default: 1).\n"
+		<< "  --max-threads <n>        Maximum number of threads (default: number of processors).\n"
+		<< "The multi-threaded benchmarks are run with 1, 2, 4, ... threads up to the maximum.\n";
+}
+
+// main
+int main( int argc, char **argv )
+{
+	REPORT_MEMORY_LEAKS
+
+	logger.addSink(unique_ptr<ConsoleSink>(new ConsoleSink(LogLevel::INFO)));
+
+	std::string exePath = FileSystem::getProgramPath();
+	std::string filter;
+	std::string jsonFileName;
+	std::string scenePath = FileSystem::normalizePath(exePath + "/resources/scenes");
+	bool runMicro = true;
+	bool runMacro = true;
+	double minTime = -1.0;
+	int repetitions = -1;
+	unsigned int numSteps = 100;
+	unsigned int macroRepetitions = 1;
+	int maxThreads = omp_get_num_procs();
+	for (int i = 1; i < argc; i++)
+	{
+		const string argStr = argv[i];
+		const bool hasValue = (i + 1 < argc);
+		if ((argStr == "--filter") && hasValue)
+			filter = argv[++i];
+		else if ((argStr == "--json") && hasValue)
+			jsonFileName = argv[++i];
+		else if (argStr == "--micro")
+			runMacro = false;
+		else if (argStr == "--macro")
+			runMicro = false;
+		else if ((argStr == "--min-time") && hasValue)
+			minTime = stod(argv[++i]);
+		else if ((argStr == "--repetitions") && hasValue)
+			repetitions = stoi(argv[++i]);
+		else if ((argStr == "--scenes") && hasValue)
+			scenePath = argv[++i];
+		else if ((argStr == "--steps") && hasValue)
+			numSteps = (unsigned int) stoul(argv[++i]);
+		else if ((argStr == "--macro-repetitions") && hasValue)
+			macroRepetitions = (unsigned int) stoul(argv[++i]);
+		else if ((argStr == "--max-threads") && hasValue)
+			maxThreads = stoi(argv[++i]);
+		else if (argStr == "--help")
+		{
+			printUsage();
+			exit(0);
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << argStr << "\n";
+			printUsage();
+			exit(1);
+		}
+	}
+	if (FileSystem::isRelativePath(scenePath))
+		scenePath = FileSystem::normalizePath(exePath + "/" + scenePath);
+
+	LOG_INFO << "PositionBasedDynamics " << PBD_VERSION;
+	LOG_INFO << "Git SHA1: " << GIT_SHA1;
+
+	std::vector<unsigned int> threadCounts;
+	for (int n = 1; n < maxThreads; n *= 2)
+		threadCounts.push_back(n);
+	threadCounts.push_back(std::max(maxThreads, 1));
+
+	BenchmarkSuite suite;
+	if (minTime > 0.0)
+		suite.setMinTime(minTime);
+	if (repetitions > 0)
+		suite.setRepetitions(repetitions);
+	if (runMicro)
+		MicroBenchmarks::registerBenchmarks(suite, threadCounts);
+	if (runMacro)
+	{
+		const std::vector<std::string> sceneFiles = MacroBenchmarks::findScenes(scenePath);
+		MacroBenchmarks::registerBenchmarks(suite, sceneFiles, threadCounts, std::max(numSteps, 1u), std::max(macroRepetitions, 1u));
+	}
+
+	suite.run(filter);
+
+	if (jsonFileName != "")
+	{
+		if (suite.writeJSON(jsonFileName))
+			LOG_INFO << "Results written to " << jsonFileName;
+		else
+			return 1;
+	}
+
+	return 0;
+}
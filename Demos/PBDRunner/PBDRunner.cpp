@@ -0,0 +1,405 @@
+#include "Common/Common.h"
+#include "Simulation/TimeManager.h"
+#include "Simulation/SimulationModel.h"
+#include "Simulation/TimeStepController.h"
+#include "Simulation/CubicSDFCollisionDetection.h"
+#include "Simulation/Simulation.h"
+#include "Simulation/Checkpoint.h"
+#include "Utils/SceneLoader.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing.h"
+#include "Utils/FileSystem.h"
+#include "Utils/Version.h"
+#include "Utils/SystemInfo.h"
+#include "Demos/Common/SceneBuilder.h"
+#include "Demos/Common/MeshExporter.h"
+#include "Demos/Common/MeshIO.h"
+#include "ParameterObject.h"
+#include "NumericParameter.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "omp.h"
+
+// Enable memory leak detection
+#if defined(_DEBUG) && !defined(EIGEN_ALIGN)
+	#define new DEBUG_NEW
+#endif
+
+INIT_LOGGING
+INIT_TIMING
+
+using namespace PBD;
+using namespace Eigen;
+using namespace std;
+using namespace Utilities;
+using namespace GenParam;
+
+/** \brief Parameters of the batch run which can be set in the scene file.
+* The names match the corresponding parameters of the demos.
+*/
+class RunnerParameters : public ParameterObject
+{
+public:
+	Real m_stopAt;
+	bool m_enableExportOBJ;
+	bool m_enableExportPLY;
+	bool m_enableExportCache;
+	unsigned int m_exportFPS;
+
+	static int STOP_AT;
+	static int EXPORT_OBJ;
+	static int EXPORT_PLY;
+	static int EXPORT_CACHE;
+	static int EXPORT_FPS;
+
+	RunnerParameters()
+	{
+		m_stopAt = -1.0;
+		m_enableExportOBJ = false;
+		m_enableExportPLY = false;
+		m_enableExportCache = false;
+		m_exportFPS = 25;
+	}
+
+	virtual void initParameters()
+	{
+		ParameterObject::initParameters();
+
+		STOP_AT = createNumericParameter("pauseAt", "Stop simulation at", &m_stopAt);
+		setGroup(STOP_AT, "Simulation|General");
+		setDescription(STOP_AT, "Stop the simulation at the given time. When the value is negative, the number of steps is used.");
+
+		EXPORT_OBJ = createBoolParameter("exportOBJ", "Export OBJ", &m_enableExportOBJ);
+		setGroup(EXPORT_OBJ, "Simulation|Export");
+		setDescription(EXPORT_OBJ, "Export meshes in OBJ files.");
+
+		EXPORT_PLY = createBoolParameter("exportPLY", "Export PLY", &m_enableExportPLY);
+		setGroup(EXPORT_PLY, "Simulation|Export");
+		setDescription(EXPORT_PLY, "Export meshes in PLY files.");
+
+		EXPORT_CACHE = createBoolParameter("exportCache", "Export cache", &m_enableExportCache);
+		setGroup(EXPORT_CACHE, "Simulation|Export");
+		setDescription(EXPORT_CACHE, "Export the meshes of all frames to a single cache file (export/simulation.pbdcache).");
+
+		EXPORT_FPS = createNumericParameter("exportFPS", "Export FPS", &m_exportFPS);
+		setGroup(EXPORT_FPS, "Simulation|Export");
+		setDescription(EXPORT_FPS, "Frame rate for export.");
+		static_cast<NumericParameter<unsigned int>*>(getParameter(EXPORT_FPS))->setMinValue(1);
+	}
+};
+
+int RunnerParameters::STOP_AT = -1;
+int RunnerParameters::EXPORT_OBJ = -1;
+int RunnerParameters::EXPORT_PLY = -1;
+int RunnerParameters::EXPORT_CACHE = -1;
+int RunnerParameters::EXPORT_FPS = -1;
+
+void printUsage()
+{
+	std::cerr << "Usage: PBDRunner [options] scene_file\n"
+		<< "Options:\n"
+		<< "  --steps <n>        Number of time steps (after --restore: additional steps).\n"
+		<< "  --time <t>         Simulate until the given time (overrides pauseAt of the scene).\n"
+		<< "  --threads <n>      Number of threads.\n"
+		<< "  --output <dir>     Output directory (default: output/<scene name> next to the executable).\n"
+		<< "  --export-obj       Export OBJ files.\n"
+		<< "  --export-ply       Export PLY files.\n"
+		<< "  --export-cache     Export all frames to a single cache file.\n"
+		<< "  --export-fps <n>   Frame rate of the export.\n"
+		<< "  --trace <file>     Write the timing zones of all threads as Chrome trace (JSON).\n"
+		<< "  --statistics <file> Write the solver statistics of each step (binary if the extension is .bin, otherwise CSV).\n"
+		<< "  --checkpoint-interval <n> Write a checkpoint every n steps to <output>/checkpoints.\n"
+		<< "  --compress-checkpoints Compress the checkpoints.\n"
+		<< "  --restore <file>   Restore the simulation state from a checkpoint of the same scene.\n"
+		<< "                     Frames and checkpoints are numbered from the restored time on, an\n"
+		<< "                     existing cache or statistics file is renamed to <file>.1, <file>.2, ...\n"
+		<< "If neither the number of steps nor a time is given, 1000 steps are simulated.\n";
+}
+
+/** Rename an existing output file to the first free name fileName.1, fileName.2, ...
+* so that a restored run does not overwrite the output of the previous run. */
+void rotateFile(const std::string &fileName)
+{
+	if (!FileSystem::fileExists(fileName))
+		return;
+	unsigned int i = 1;
+	while (FileSystem::fileExists(fileName + "." + std::to_string(i)))
+		i++;
+	const std::string newFileName = fileName + "." + std::to_string(i);
+	if (FileSystem::replaceFile(fileName, newFileName))
+		LOG_INFO << "Renamed " << fileName << " to " << newFileName;
+}
+
+void updateVisMeshes(SimulationModel *model)
+{
+	const ParticleData &pd = model->getParticles();
+	for (unsigned int i = 0; i < model->getTetModels().size(); i++)
+	{
+		model->getTetModels()[i]->updateMeshNormals(pd);
+		model->getTetModels()[i]->updateVisMesh(pd);
+	}
+}
+
+// main
+int main( int argc, char **argv )
+{
+	REPORT_MEMORY_LEAKS
+
+	logger.addSink(unique_ptr<ConsoleSink>(new ConsoleSink(LogLevel::INFO)));
+
+	std::string exePath = FileSystem::getProgramPath();
+	std::string sceneFileName;
+	std::string outputPath;
+	unsigned int numSteps = 0;
+	Real stopAt = -1.0;
+	int numThreads = -1;
+	bool exportOBJ = false;
+	bool exportPLY = false;
+	bool exportCache = false;
+	int exportFPS = -1;
+	std::string traceFileName;
+	std::string statisticsFileName;
+	unsigned int checkpointInterval = 0;
+	bool compressCheckpoints = false;
+	std::string restoreFileName;
+	for (int i = 1; i < argc; i++)
+	{
+		const string argStr = argv[i];
+		const bool hasValue = (i + 1 < argc);
+		if ((argStr == "--steps") && hasValue)
+			numSteps = (unsigned int) stoul(argv[++i]);
+		else if ((argStr == "--time") && hasValue)
+			stopAt = static_cast<Real>(stod(argv[++i]));
+		else if ((argStr == "--threads") && hasValue)
+			numThreads = stoi(argv[++i]);
+		else if ((argStr == "--output") && hasValue)
+			outputPath = argv[++i];
+		else if (argStr == "--export-obj")
+			exportOBJ = true;
+		else if (argStr == "--export-ply")
+			exportPLY = true;
+		else if (argStr == "--export-cache")
+			exportCache = true;
+		else if ((argStr == "--export-fps") && hasValue)
+			exportFPS = stoi(argv[++i]);
+		else if ((argStr == "--trace") && hasValue)
+			traceFileName = argv[++i];
+		else if ((argStr == "--statistics") && hasValue)
+			statisticsFileName = argv[++i];
+		else if ((argStr == "--checkpoint-interval") && hasValue)
+			checkpointInterval = (unsigned int) stoul(argv[++i]);
+		else if (argStr == "--compress-checkpoints")
+			compressCheckpoints = true;
+		else if ((argStr == "--restore") && hasValue)
+			restoreFileName = argv[++i];
+		else if ((argStr.size() > 1) && (argStr[0] == '-'))
+		{
+			std::cerr << "Unknown option: " << argStr << "\n";
+			printUsage();
+			exit(1);
+		}
+		else
+			sceneFileName = argStr;
+	}
+	if (sceneFileName == "")
+	{
+		printUsage();
+		exit(1);
+	}
+
+	if (FileSystem::isRelativePath(sceneFileName))
+		sceneFileName = FileSystem::normalizePath(exePath + "/" + sceneFileName);
+	if (!FileSystem::fileExists(sceneFileName))
+	{
+		LOG_ERR << "Scene file not found: " << sceneFileName;
+		exit(1);
+	}
+	if (outputPath == "")
+		outputPath = FileSystem::normalizePath(exePath + "/output/" + FileSystem::getFileName(sceneFileName));
+	if ((traceFileName != "") && FileSystem::isRelativePath(traceFileName))
+		traceFileName = FileSystem::normalizePath(outputPath + "/" + traceFileName);
+	Timing::enableTrace(traceFileName != "");
+	if ((statisticsFileName != "") && FileSystem::isRelativePath(statisticsFileName))
+		statisticsFileName = FileSystem::normalizePath(outputPath + "/" + statisticsFileName);
+	if ((restoreFileName != "") && FileSystem::isRelativePath(restoreFileName))
+		restoreFileName = FileSystem::normalizePath(exePath + "/" + restoreFileName);
+	const std::string checkpointPath = FileSystem::normalizePath(outputPath + "/checkpoints");
+	if (checkpointInterval > 0)
+		FileSystem::makeDirs(checkpointPath);
+
+	std::string logPath = FileSystem::normalizePath(outputPath + "/log");
+	FileSystem::makeDirs(logPath);
+	logger.addSink(unique_ptr<FileSink>(new FileSink(LogLevel::DEBUG, logPath + "/PBD_log.txt")));
+
+	LOG_DEBUG << "Git refspec: " << GIT_REFSPEC;
+	LOG_DEBUG << "Git SHA1:    " << GIT_SHA1;
+	LOG_DEBUG << "Git status:  " << GIT_LOCAL_STATUS;
+	LOG_DEBUG << "Host name:   " << SystemInfo::getHostName();
+	LOG_INFO << "PositionBasedDynamics " << PBD_VERSION;
+
+	if (numThreads > 0)
+		omp_set_num_threads(numThreads);
+	LOG_INFO << "Number of threads: " << omp_get_max_threads();
+
+	SimulationModel *model = new SimulationModel();
+	model->init();
+	Simulation::getCurrent()->setModel(model);
+
+	CubicSDFCollisionDetection *cd = new CubicSDFCollisionDetection();
+	cd->init();
+	Simulation::getCurrent()->getTimeStep()->setCollisionDetection(*model, cd);
+
+	SceneLoader sceneLoader;
+	SceneLoader::SceneData data;
+	sceneLoader.readScene(sceneFileName.c_str(), data);
+	SceneBuilder::createModel(model, cd, data, sceneFileName);
+
+	// rebuild the model when the simulation method was changed by the parameters of the scene
+	auto reset = [&]()
+	{
+		const Real h = model->getTimeManager().getTimeStepSize();
+		Simulation::getCurrent()->reset();
+		model->cleanup();
+		cd->cleanup();
+		SceneBuilder::createModel(model, cd, data, sceneFileName);
+		model->getTimeManager().setTimeStepSize(h);
+	};
+	model->setClothSimulationMethodChangedCallback(reset);
+	model->setClothBendingMethodChangedCallback(reset);
+	model->setSolidSimulationMethodChangedCallback(reset);
+
+	RunnerParameters params;
+	params.initParameters();
+	Simulation *sim = Simulation::getCurrent();
+	sceneLoader.readParameterObject(&params);
+	sceneLoader.readParameterObject(sim);
+	sceneLoader.readParameterObject(sim->getModel());
+	sceneLoader.readParameterObject(sim->getTimeStep());
+	sceneLoader.readParameterObject(sim->getTimeStep()->getCollisionDetection());
+
+	if (restoreFileName != "")
+	{
+		if (!Checkpoint::load(restoreFileName, *model))
+			exit(1);
+		LOG_INFO << "Restored checkpoint " << restoreFileName << " at t = " << model->getTimeManager().getTime();
+	}
+
+	// command line options override the scene file
+	if (stopAt >= 0.0)
+		params.m_stopAt = stopAt;
+	else if (numSteps > 0)
+		params.m_stopAt = -1.0;
+	if ((params.m_stopAt < 0.0) && (numSteps == 0))
+		numSteps = 1000;
+	params.m_enableExportOBJ = params.m_enableExportOBJ || exportOBJ;
+	params.m_enableExportPLY = params.m_enableExportPLY || exportPLY;
+	params.m_enableExportCache = params.m_enableExportCache || exportCache;
+	if (exportFPS > 0)
+		params.m_exportFPS = exportFPS;
+
+	const bool doExport = params.m_enableExportOBJ || params.m_enableExportPLY || params.m_enableExportCache;
+	const std::string exportPath = FileSystem::normalizePath(outputPath + "/export");
+	// without export the world space geometry of the rigid bodies is never needed
+	RigidBodyGeometry::setUpdateVertexData(doExport);
+
+	if (params.m_stopAt >= 0.0)
+		LOG_INFO << "Simulate until t = " << params.m_stopAt;
+	else
+		LOG_INFO << "Simulate " << numSteps << " steps";
+
+	// After a restore the frames and the steps continue at the restored time, so that 
+	// the frames and checkpoints of the previous run are not overwritten.
+	Real nextFrameTime = model->getTimeManager().getTime();
+	unsigned int frameCounter = 1;
+	unsigned int startStep = 0;
+	if (restoreFileName != "")
+	{
+		const Real t = model->getTimeManager().getTime();
+		const Real h = model->getTimeManager().getTimeStepSize();
+		const unsigned int frame = (unsigned int)std::ceil(t * (Real)params.m_exportFPS - static_cast<Real>(1.0e-6));
+		nextFrameTime = (Real)frame / (Real)params.m_exportFPS;
+		frameCounter = frame + 1;
+		if (h > 0.0)
+			startStep = (unsigned int)std::llround(t / h);
+		LOG_INFO << "Continue with step " << startStep << " and frame " << frameCounter;
+	}
+	const unsigned int startFrame = frameCounter;
+	unsigned int step = startStep;
+	TimeStep *timeStep = sim->getTimeStep();
+	TimeStepStatisticsWriter statisticsWriter;
+	MeshExporter meshExporter;
+	SimulationCacheWriter cacheWriter;
+	if (params.m_enableExportCache)
+	{
+		FileSystem::makeDirs(exportPath);
+		const std::string cacheFileName = exportPath + "/simulation.pbdcache";
+		if (restoreFileName != "")
+			rotateFile(cacheFileName);
+		cacheWriter.open(cacheFileName);
+	}
+	if (statisticsFileName != "")
+	{
+		string ext = FileSystem::getFileExt(statisticsFileName);
+		transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
+		timeStep->setCollectStatistics(true);
+		if (restoreFileName != "")
+			rotateFile(statisticsFileName);
+		statisticsWriter.open(statisticsFileName, ext == "BIN");
+	}
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	while (true)
+	{
+		const Real t = model->getTimeManager().getTime();
+		if (doExport && (t >= nextFrameTime))
+		{
+			nextFrameTime += static_cast<Real>(1.0) / (Real)params.m_exportFPS;
+			updateVisMeshes(model);
+			meshExporter.exportFrame(model, exportPath, frameCounter, params.m_enableExportOBJ, params.m_enableExportPLY);
+			if (cacheWriter.isOpen())
+				MeshIO::exportCacheFrame(cacheWriter, model, t);
+			frameCounter++;
+		}
+
+		if (params.m_stopAt >= 0.0)
+		{
+			if (t >= params.m_stopAt)
+				break;
+		}
+		else if (step - startStep >= numSteps)
+			break;
+
+		START_TIMING("SimStep");
+		timeStep->step(*model);
+		STOP_TIMING_AVG;
+		step++;
+		statisticsWriter.write(timeStep->getStatistics());
+
+		if ((checkpointInterval > 0) && (step % checkpointInterval == 0))
+			Checkpoint::save(checkpointPath + "/checkpoint_" + std::to_string(step) + ".bin", *model, compressCheckpoints);
+	}
+	meshExporter.flush();
+	cacheWriter.close();
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	const double wallTime = std::chrono::duration<double>(endTime - startTime).count();
+
+	LOG_INFO << "---------------------------------------------------------------------------";
+	LOG_INFO << "Time steps:       " << step - startStep;
+	LOG_INFO << "Simulated time:   " << model->getTimeManager().getTime();
+	LOG_INFO << "Wall clock time:  " << wallTime << " s";
+	if (wallTime > 0.0)
+		LOG_INFO << "Steps per second: " << (double)(step - startStep) / wallTime;
+	if (doExport)
+		LOG_INFO << "Exported frames:  " << frameCounter - startFrame;
+	Timing::printAverageTimes();
+	Timing::printTimeSums();
+	if ((traceFileName != "") && Timing::writeTrace(traceFileName))
+		LOG_INFO << "Trace written to " << traceFileName;
+
+	delete Simulation::getCurrent();
+	delete model;
+	delete cd;
+
+	return 0;
+}
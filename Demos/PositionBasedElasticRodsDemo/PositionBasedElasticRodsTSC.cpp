@@ -20,7 +20,7 @@ PositionBasedElasticRodsTSC::~PositionBasedElasticRodsTSC()
 
 void PositionBasedElasticRodsTSC::step(SimulationModel &model)
 {
- 	TimeManager *tm = TimeManager::getCurrent ();
+ 	TimeManager *tm = &model.getTimeManager();
 	const Real hOld = tm->getTimeStepSize();
 	PositionBasedElasticRodsModel &ermodel = (PositionBasedElasticRodsModel&)model;
  
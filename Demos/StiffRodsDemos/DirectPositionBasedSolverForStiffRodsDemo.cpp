@@ -328,7 +328,7 @@ void readScene()
 	camPos = data.m_camPosition;
 	camLookat = data.m_camLookat;
 
-	TimeManager::getCurrent()->setTimeStepSize(data.m_timeStepSize);
+	model->getTimeManager().setTimeStepSize(data.m_timeStepSize);
 
 	sceneName = data.m_sceneName;
 
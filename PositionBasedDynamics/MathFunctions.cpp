@@ -1,5 +1,7 @@
 #include "MathFunctions.h"
 #include <cfloat>
+#include <algorithm>
+#include <limits>
 
 using namespace PBD;
 
@@ -417,4 +419,323 @@ void MathFunctions::extractRotation(const Matrix3r &A, Quaternionr &q,	const uns
 		q = Quaternionr(AngleAxisr(w, (1.0 / w) * omega)) *	q;
 		q.normalize();
 	}
-}
\ No newline at end of file
+}
+// ----------------------------------------------------------------------------------------------
+// Kernel of the 3x3 SVD (McAdams et al. 2011) for N matrices stored as structure of arrays. 
+// Each step is a loop over the lanes with a fixed amount of work. Conditions only select values, 
+// so that the loops can be vectorized. Selected values are stored before they are used, which 
+// keeps the compiler from turning a selection into a branch.
+// ----------------------------------------------------------------------------------------------
+static inline void condSwap(const bool c, Real &x, Real &y)
+{
+	const Real z = x;
+	x = c ? y : x;
+	y = c ? z : y;
+}
+
+static inline void condNegSwap(const bool c, Real &x, Real &y)
+{
+	const Real z = -x;
+	x = c ? y : x;
+	y = c ? z : y;
+}
+
+// One Jacobi conjugation of the symmetric matrices S (s11, s21, s22, s31, s32, s33) in the (1,2) plane. 
+// The rotations are accumulated in the quaternions q (x, y, z, w) and the rows/columns of S are permuted 
+// cyclically, so that the next call works on the next pair. (x, y, z) is (0,1,2), (1,2,0) and (2,0,1) for 
+// the three calls of a sweep.
+template<unsigned int N, unsigned int x, unsigned int y, unsigned int z>
+static void jacobiConjugation(Real s[6][N], Real q[4][N])
+{
+	const Real gamma = static_cast<Real>(5.82842712474619);		// 3 + 2 sqrt(2)
+	const Real cStar = static_cast<Real>(0.923879532511287);	// cos(pi/8)
+	const Real sStar = static_cast<Real>(0.38268343236509);		// sin(pi/8)
+	const Real two = 2.0;
+
+	const Real eps2 = std::numeric_limits<Real>::epsilon() * std::numeric_limits<Real>::epsilon();
+
+	// approximate Givens quaternion (ch, sh), which is replaced by the rotation 
+	// about pi/4 if the approximation is not accurate enough. Off-diagonal entries 
+	// which are already negligible are not rotated. Otherwise the quadratic convergence 
+	// drives them into the denormal range, which is extremely slow on most CPUs.
+	Real ch[N], sh[N];
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const Real c = two * (s[0][l] - s[2][l]);
+		const Real s21Sqr = s[1][l] * s[1][l];
+		const bool b = gamma * s21Sqr < c * c;
+		const bool skip = s21Sqr <= eps2 * (s[0][l] * s[0][l] + s[2][l] * s[2][l]);
+		ch[l] = skip ? static_cast<Real>(1.0) : (b ? c : cStar);
+		sh[l] = skip ? static_cast<Real>(0.0) : (b ? s[1][l] : sStar);
+	}
+
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const Real w = static_cast<Real>(1.0) / std::sqrt(ch[l] * ch[l] + sh[l] * sh[l]);
+		const Real c = w * ch[l];
+		const Real sn = w * sh[l];
+		const Real a = c * c - sn * sn;
+		const Real b = two * sn * c;
+
+		const Real t11 = s[0][l];
+		const Real t21 = s[1][l];
+		const Real t22 = s[2][l];
+		const Real t31 = s[3][l];
+		const Real t32 = s[4][l];
+		const Real t33 = s[5][l];
+
+		// conjugation with the rotation and cyclic permutation (1,2,3) -> (3,1,2)
+		s[5][l] = a * (a * t11 + b * t21) + b * (a * t21 + b * t22);
+		s[3][l] = a * (-b * t11 + a * t21) + b * (-b * t21 + a * t22);
+		s[0][l] = -b * (-b * t11 + a * t21) + a * (-b * t21 + a * t22);
+		s[4][l] = a * t31 + b * t32;
+		s[1][l] = -b * t31 + a * t32;
+		s[2][l] = t33;
+
+		// accumulate rotation
+		const Real tx = q[x][l] * sn;
+		const Real ty = q[y][l] * sn;
+		const Real tz = q[z][l] * sn;
+		const Real tw = q[3][l] * sn;
+		q[x][l] = q[x][l] * c + ty;
+		q[y][l] = q[y][l] * c - tx;
+		q[z][l] = q[z][l] * c + tw;
+		q[3][l] = q[3][l] * c - tz;
+	}
+}
+
+// Givens rotation of the QR decomposition which annihilates the entries r(row2, col) by rotating 
+// the rows row1 and row2 of the matrices r (r[3*row+col][lane]). The quaternion (ch, sh) of the 
+// rotation is returned.
+template<unsigned int N>
+static void qrGivensRotation(Real r[9][N], const unsigned int row1, const unsigned int row2, const unsigned int col, 
+	Real ch[N], Real sh[N])
+{
+	Real *a1 = r[3 * row1 + col];
+	Real *a2 = r[3 * row2 + col];
+	const Real eps = static_cast<Real>(1.0e-6);
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const Real rho = std::sqrt(a1[l] * a1[l] + a2[l] * a2[l]);
+		Real s = rho > eps ? a2[l] : static_cast<Real>(0.0);
+		Real c = std::abs(a1[l]) + std::max(rho, eps);
+		condSwap(a1[l] < 0.0, s, c);
+		ch[l] = c;
+		sh[l] = s;
+	}
+
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const Real w = static_cast<Real>(1.0) / std::sqrt(ch[l] * ch[l] + sh[l] * sh[l]);
+		ch[l] *= w;
+		sh[l] *= w;
+		const Real a = static_cast<Real>(1.0) - static_cast<Real>(2.0) * sh[l] * sh[l];
+		const Real b = static_cast<Real>(2.0) * ch[l] * sh[l];
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			const Real r1 = a * r[3 * row1 + k][l] + b * r[3 * row2 + k][l];
+			const Real r2 = -b * r[3 * row1 + k][l] + a * r[3 * row2 + k][l];
+			r[3 * row1 + k][l] = r1;
+			r[3 * row2 + k][l] = r2;
+		}
+	}
+}
+
+// Swap the columns c0 and c1 of B (b[3*col+row][lane]) and V (v[3*row+col][lane]) if column c1 of B 
+// has a larger norm. One swapped column is negated, so that V stays a rotation.
+template<unsigned int N, unsigned int c0, unsigned int c1>
+static void sortColumns(Real b[9][N], Real v[9][N], Real rho[3][N])
+{
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const bool c = rho[c0][l] < rho[c1][l];
+		condNegSwap(c, b[3 * c0][l], b[3 * c1][l]);
+		condNegSwap(c, b[3 * c0 + 1][l], b[3 * c1 + 1][l]);
+		condNegSwap(c, b[3 * c0 + 2][l], b[3 * c1 + 2][l]);
+		condNegSwap(c, v[c0][l], v[c1][l]);
+		condNegSwap(c, v[3 + c0][l], v[3 + c1][l]);
+		condNegSwap(c, v[6 + c0][l], v[6 + c1][l]);
+		condSwap(c, rho[c0][l], rho[c1][l]);
+	}
+}
+
+// SVD A = U diag(sigma) V^T of N matrices stored as structure of arrays (a[3*row+col][lane])
+template<unsigned int N>
+static void svdKernel(const Real a[9][N], Real sigma[3][N], Real u[9][N], Real v[9][N])
+{
+	const Real one = 1.0, two = 2.0, four = 4.0, eight = 8.0;
+
+	// symmetric matrix S = A^T A
+	Real S[6][N];
+	for (unsigned int l = 0; l < N; l++)
+	{
+		S[0][l] = a[0][l] * a[0][l] + a[3][l] * a[3][l] + a[6][l] * a[6][l];
+		S[1][l] = a[1][l] * a[0][l] + a[4][l] * a[3][l] + a[7][l] * a[6][l];
+		S[2][l] = a[1][l] * a[1][l] + a[4][l] * a[4][l] + a[7][l] * a[7][l];
+		S[3][l] = a[2][l] * a[0][l] + a[5][l] * a[3][l] + a[8][l] * a[6][l];
+		S[4][l] = a[2][l] * a[1][l] + a[5][l] * a[4][l] + a[8][l] * a[7][l];
+		S[5][l] = a[2][l] * a[2][l] + a[5][l] * a[5][l] + a[8][l] * a[8][l];
+	}
+
+	// Jacobi eigenanalysis of S with a fixed number of sweeps. The convergence is 
+	// quadratic, so double precision needs one sweep more than single precision.
+	const unsigned int numSweeps = (sizeof(Real) == sizeof(float)) ? 5 : 6;
+	Real q[4][N];
+	for (unsigned int l = 0; l < N; l++)
+	{
+		q[0][l] = 0.0;
+		q[1][l] = 0.0;
+		q[2][l] = 0.0;
+		q[3][l] = 1.0;
+	}
+	for (unsigned int sweep = 0; sweep < numSweeps; sweep++)
+	{
+		jacobiConjugation<N, 0, 1, 2>(S, q);
+		jacobiConjugation<N, 1, 2, 0>(S, q);
+		jacobiConjugation<N, 2, 0, 1>(S, q);
+	}
+
+	// V and B = A V, b is stored column-wise (b[3*col+row][lane])
+	Real b[9][N];
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const Real qn = one / std::sqrt(q[0][l] * q[0][l] + q[1][l] * q[1][l] + q[2][l] * q[2][l] + q[3][l] * q[3][l]);
+		const Real x = q[0][l] * qn, y = q[1][l] * qn, z = q[2][l] * qn, w = q[3][l] * qn;
+		v[0][l] = one - two * (y * y + z * z);
+		v[1][l] = two * (x * y - w * z);
+		v[2][l] = two * (x * z + w * y);
+		v[3][l] = two * (x * y + w * z);
+		v[4][l] = one - two * (x * x + z * z);
+		v[5][l] = two * (y * z - w * x);
+		v[6][l] = two * (x * z - w * y);
+		v[7][l] = two * (y * z + w * x);
+		v[8][l] = one - two * (x * x + y * y);
+		for (unsigned int i = 0; i < 3; i++)
+			for (unsigned int j = 0; j < 3; j++)
+				b[3 * j + i][l] = a[3 * i][l] * v[j][l] + a[3 * i + 1][l] * v[3 + j][l] + a[3 * i + 2][l] * v[6 + j][l];
+	}
+
+	// sort the columns of B by decreasing norm
+	Real rho[3][N];
+	for (unsigned int l = 0; l < N; l++)
+		for (unsigned int j = 0; j < 3; j++)
+			rho[j][l] = b[3 * j][l] * b[3 * j][l] + b[3 * j + 1][l] * b[3 * j + 1][l] + b[3 * j + 2][l] * b[3 * j + 2][l];
+	sortColumns<N, 0, 1>(b, v, rho);
+	sortColumns<N, 0, 2>(b, v, rho);
+	sortColumns<N, 1, 2>(b, v, rho);
+
+	// QR decomposition of B by three Givens rotations: B = U R, 
+	// r is stored row-wise (r[3*row+col][lane])
+	Real r[9][N];
+	for (unsigned int l = 0; l < N; l++)
+		for (unsigned int i = 0; i < 3; i++)
+			for (unsigned int j = 0; j < 3; j++)
+				r[3 * i + j][l] = b[3 * j + i][l];
+	Real ch1[N], sh1[N], ch2[N], sh2[N], ch3[N], sh3[N];
+	qrGivensRotation<N>(r, 0, 1, 0, ch1, sh1);
+	qrGivensRotation<N>(r, 0, 2, 0, ch2, sh2);
+	qrGivensRotation<N>(r, 1, 2, 1, ch3, sh3);
+
+	// U = Q1 Q2 Q3
+	for (unsigned int l = 0; l < N; l++)
+	{
+		const Real sh12 = sh1[l] * sh1[l], sh22 = sh2[l] * sh2[l], sh32 = sh3[l] * sh3[l];
+		u[0][l] = (-one + two * sh12) * (-one + two * sh22);
+		u[1][l] = four * ch2[l] * ch3[l] * (-one + two * sh12) * sh2[l] * sh3[l] + two * ch1[l] * sh1[l] * (-one + two * sh32);
+		u[2][l] = four * ch1[l] * ch3[l] * sh1[l] * sh3[l] - two * ch2[l] * (-one + two * sh12) * sh2[l] * (-one + two * sh32);
+		u[3][l] = two * ch1[l] * sh1[l] * (one - two * sh22);
+		u[4][l] = -eight * ch1[l] * ch2[l] * ch3[l] * sh1[l] * sh2[l] * sh3[l] + (-one + two * sh12) * (-one + two * sh32);
+		u[5][l] = -two * ch3[l] * sh3[l] + four * sh1[l] * (ch3[l] * sh1[l] * sh3[l] + ch1[l] * ch2[l] * sh2[l] * (-one + two * sh32));
+		u[6][l] = two * ch2[l] * sh2[l];
+		u[7][l] = two * ch3[l] * (one - two * sh22) * sh3[l];
+		u[8][l] = (one - two * sh22) * (one - two * sh32);
+
+		sigma[0][l] = r[0][l];
+		sigma[1][l] = r[4][l];
+		sigma[2][l] = r[8][l];
+	}
+}
+
+// ----------------------------------------------------------------------------------------------
+void MathFunctions::svd3x3(const Matrix3r &A, Vector3r &sigma, Matrix3r &U, Matrix3r &VT)
+{
+	Real a[9][1], s[3][1], u[9][1], v[9][1];
+	for (unsigned int i = 0; i < 3; i++)
+		for (unsigned int j = 0; j < 3; j++)
+			a[3 * i + j][0] = A(i, j);
+	svdKernel<1>(a, s, u, v);
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		sigma[i] = s[i][0];
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			U(i, j) = u[3 * i + j][0];
+			VT(j, i) = v[3 * i + j][0];
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------------------------
+void MathFunctions::polarDecomposition3x3(const Matrix3r &A, Matrix3r &R)
+{
+	Vector3r sigma;
+	Matrix3r U, VT;
+	svd3x3(A, sigma, U, VT);
+	R = U * VT;
+}
+
+#ifndef USE_DOUBLE
+// ----------------------------------------------------------------------------------------------
+void MathFunctions::svd3x3Batch(const unsigned int n, const Matrix3r A[], Vector3r sigma[], Matrix3r U[], Matrix3r VT[])
+{
+	const unsigned int blockSize = 8;
+	Real a[9][blockSize], s[3][blockSize], u[9][blockSize], v[9][blockSize];
+	for (unsigned int start = 0; start < n; start += blockSize)
+	{
+		// the unused lanes of the last block are filled with identity matrices
+		const unsigned int m = std::min(blockSize, n - start);
+		for (unsigned int l = 0; l < blockSize; l++)
+			for (unsigned int i = 0; i < 3; i++)
+				for (unsigned int j = 0; j < 3; j++)
+					a[3 * i + j][l] = (l < m) ? A[start + l](i, j) : static_cast<Real>((i == j) ? 1.0 : 0.0);
+
+		svdKernel<blockSize>(a, s, u, v);
+
+		for (unsigned int l = 0; l < m; l++)
+		{
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				sigma[start + l][i] = s[i][l];
+				for (unsigned int j = 0; j < 3; j++)
+				{
+					U[start + l](i, j) = u[3 * i + j][l];
+					VT[start + l](j, i) = v[3 * i + j][l];
+				}
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------------------------
+void MathFunctions::polarDecompositionBatch(const unsigned int n, const Matrix3r A[], Matrix3r R[])
+{
+	const unsigned int blockSize = 8;
+	Real a[9][blockSize], s[3][blockSize], u[9][blockSize], v[9][blockSize];
+	for (unsigned int start = 0; start < n; start += blockSize)
+	{
+		const unsigned int m = std::min(blockSize, n - start);
+		for (unsigned int l = 0; l < blockSize; l++)
+			for (unsigned int i = 0; i < 3; i++)
+				for (unsigned int j = 0; j < 3; j++)
+					a[3 * i + j][l] = (l < m) ? A[start + l](i, j) : static_cast<Real>((i == j) ? 1.0 : 0.0);
+
+		svdKernel<blockSize>(a, s, u, v);
+
+		// R = U V^T
+		for (unsigned int l = 0; l < m; l++)
+			for (unsigned int i = 0; i < 3; i++)
+				for (unsigned int j = 0; j < 3; j++)
+					R[start + l](i, j) = u[3 * i][l] * v[3 * j][l] + u[3 * i + 1][l] * v[3 * j + 1][l] + u[3 * i + 2][l] * v[3 * j + 2][l];
+	}
+}
+#endif
@@ -50,6 +50,32 @@ namespace PBD
 		 * ACM SIGGRAPH Motion in Games, 2016
 		 */
 		static void extractRotation(const Matrix3r &A, Quaternionr &q, const unsigned int maxIter);
+
+		/** Singular value decomposition A = U diag(sigma) V^T of a 3x3 matrix 
+		 * with a fixed number of iterations and without data-dependent branches. 
+		 * U and V are rotations and the singular values are sorted in decreasing 
+		 * order. If A is inverted (det(A) < 0), the last singular value is negative.\n\n
+		 * Implementation of the paper: \n
+		 * Aleka McAdams, Andrew Selle, Rasmus Tamstorf, Joseph Teran and Eftychios Sifakis, 
+		 * "Computing the Singular Value Decomposition of 3x3 matrices with minimal branching 
+		 * and elementary floating point operations", Technical report, University of Wisconsin-Madison, 2011
+		 */
+		static void svd3x3(const Matrix3r &A, Vector3r &sigma, Matrix3r &U, Matrix3r &VT);
+
+		/** Rotational part R = U V^T of a 3x3 matrix using svd3x3(). */
+		static void polarDecomposition3x3(const Matrix3r &A, Matrix3r &R);
+
+#ifndef USE_DOUBLE
+		/** Batch version of svd3x3(). The matrices are processed in blocks 
+		 * which are stored as structure of arrays, so that the lanes of a block 
+		 * can be processed by SIMD instructions. Only available in single precision, 
+		 * in double precision polarDecompositionStable() is faster.
+		 */
+		static void svd3x3Batch(const unsigned int n, const Matrix3r A[], Vector3r sigma[], Matrix3r U[], Matrix3r VT[]);
+
+		/** Batch version of polarDecomposition3x3(). A and R may be the same array. */
+		static void polarDecompositionBatch(const unsigned int n, const Matrix3r A[], Matrix3r R[]);
+#endif
 	};
 }
 
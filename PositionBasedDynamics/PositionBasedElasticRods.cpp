@@ -78,6 +78,345 @@ bool PositionBasedCosseratRods::solve_BendTwistConstraint(
 	return true;
 }
 
+// ----------------------------------------------------------------------------------------------
+void PositionBasedCosseratRods::solve_StretchShearConstraints(
+	const unsigned int n,
+	const unsigned int particleIndices[], const unsigned int quaternionIndices[],
+	Vector3r p[], const Real invMass[],
+	Quaternionr q[], const Real invMassq[],
+	const Vector3r& stretchingAndShearingKs,
+	const Real restLengths[])
+{
+	const unsigned int blockSize = 8;
+	const bool isotropic = (std::abs(stretchingAndShearingKs[0] - stretchingAndShearingKs[1]) < eps && std::abs(stretchingAndShearingKs[0] - stretchingAndShearingKs[2]) < eps);
+	Real x0[3][blockSize], x1[3][blockSize], r[4][blockSize], w0[blockSize], w1[blockSize], wq[blockSize], l[blockSize];
+	Real gamma[3][blockSize];
+	for (unsigned int start = 0; start < n; start += blockSize)
+	{
+		// the unused lanes of the last block repeat the first constraint of the block
+		const unsigned int m = std::min(blockSize, n - start);
+		for (unsigned int k = 0; k < blockSize; k++)
+		{
+			const unsigned int c = start + ((k < m) ? k : 0);
+			const Vector3r &p0 = p[particleIndices[2 * c]];
+			const Vector3r &p1 = p[particleIndices[2 * c + 1]];
+			const Quaternionr &q0 = q[quaternionIndices[c]];
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				x0[i][k] = p0[i];
+				x1[i][k] = p1[i];
+			}
+			r[0][k] = q0.w(); r[1][k] = q0.x(); r[2][k] = q0.y(); r[3][k] = q0.z();
+			w0[k] = invMass[particleIndices[2 * c]];
+			w1[k] = invMass[particleIndices[2 * c + 1]];
+			wq[k] = invMassq[quaternionIndices[c]];
+			l[k] = restLengths[c];
+		}
+
+		// gamma = (p1 - p0) / restLength - d3, see solve_StretchShearConstraint()
+		for (unsigned int k = 0; k < blockSize; k++)
+		{
+			const Real d3x = static_cast<Real>(2.0) * (r[1][k] * r[3][k] + r[0][k] * r[2][k]);
+			const Real d3y = static_cast<Real>(2.0) * (r[2][k] * r[3][k] - r[0][k] * r[1][k]);
+			const Real d3z = r[0][k] * r[0][k] - r[1][k] * r[1][k] - r[2][k] * r[2][k] + r[3][k] * r[3][k];
+			const Real s = (w1[k] + w0[k]) / l[k] + wq[k] * static_cast<Real>(4.0) * l[k] + eps;
+			gamma[0][k] = ((x1[0][k] - x0[0][k]) / l[k] - d3x) / s;
+			gamma[1][k] = ((x1[1][k] - x0[1][k]) / l[k] - d3y) / s;
+			gamma[2][k] = ((x1[2][k] - x0[2][k]) / l[k] - d3z) / s;
+		}
+
+		if (isotropic)
+		{
+			for (unsigned int k = 0; k < blockSize; k++)
+				for (unsigned int i = 0; i < 3; i++)
+					gamma[i][k] *= stretchingAndShearingKs[i];
+		}
+		else
+		{
+			// gamma = R * diag(Ks) * R^T * gamma with the rotation matrix R of the quaternion
+			for (unsigned int k = 0; k < blockSize; k++)
+			{
+				const Real tx = static_cast<Real>(2.0) * r[1][k], ty = static_cast<Real>(2.0) * r[2][k], tz = static_cast<Real>(2.0) * r[3][k];
+				const Real twx = tx * r[0][k], twy = ty * r[0][k], twz = tz * r[0][k];
+				const Real txx = tx * r[1][k], txy = ty * r[1][k], txz = tz * r[1][k];
+				const Real tyy = ty * r[2][k], tyz = tz * r[2][k], tzz = tz * r[3][k];
+				const Real R00 = static_cast<Real>(1.0) - (tyy + tzz), R01 = txy - twz, R02 = txz + twy;
+				const Real R10 = txy + twz, R11 = static_cast<Real>(1.0) - (txx + tzz), R12 = tyz - twx;
+				const Real R20 = txz - twy, R21 = tyz + twx, R22 = static_cast<Real>(1.0) - (txx + tyy);
+				const Real g0 = (R00 * gamma[0][k] + R10 * gamma[1][k] + R20 * gamma[2][k]) * stretchingAndShearingKs[0];
+				const Real g1 = (R01 * gamma[0][k] + R11 * gamma[1][k] + R21 * gamma[2][k]) * stretchingAndShearingKs[1];
+				const Real g2 = (R02 * gamma[0][k] + R12 * gamma[1][k] + R22 * gamma[2][k]) * stretchingAndShearingKs[2];
+				gamma[0][k] = R00 * g0 + R01 * g1 + R02 * g2;
+				gamma[1][k] = R10 * g0 + R11 * g1 + R12 * g2;
+				gamma[2][k] = R20 * g0 + R21 * g1 + R22 * g2;
+			}
+		}
+
+		// corrections, corrq0 = (0, gamma) * q_e_3_bar * 2 * invMassq0 * restLength with q_e_3_bar = (z, -y, x, -w)
+		for (unsigned int k = 0; k < blockSize; k++)
+		{
+			const Real gx = gamma[0][k], gy = gamma[1][k], gz = gamma[2][k];
+			const Real bw = r[3][k], bx = -r[2][k], by = r[1][k], bz = -r[0][k];
+			const Real f = static_cast<Real>(2.0) * wq[k] * l[k];
+			const Real cw = -(gx * bx + gy * by + gz * bz) * f;
+			const Real cx = (bw * gx + gy * bz - gz * by) * f;
+			const Real cy = (bw * gy + gz * bx - gx * bz) * f;
+			const Real cz = (bw * gz + gx * by - gy * bx) * f;
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				x0[i][k] += w0[k] * gamma[i][k];
+				x1[i][k] -= w1[k] * gamma[i][k];
+			}
+			r[0][k] += cw; r[1][k] += cx; r[2][k] += cy; r[3][k] += cz;
+			const Real norm = std::sqrt(r[0][k] * r[0][k] + r[1][k] * r[1][k] + r[2][k] * r[2][k] + r[3][k] * r[3][k]);
+			for (unsigned int i = 0; i < 4; i++)
+				r[i][k] /= norm;
+		}
+
+		for (unsigned int k = 0; k < m; k++)
+		{
+			const unsigned int c = start + k;
+			if (w0[k] != 0.0)
+				p[particleIndices[2 * c]] = Vector3r(x0[0][k], x0[1][k], x0[2][k]);
+			if (w1[k] != 0.0)
+				p[particleIndices[2 * c + 1]] = Vector3r(x1[0][k], x1[1][k], x1[2][k]);
+			if (wq[k] != 0.0)
+				q[quaternionIndices[c]] = Quaternionr(r[0][k], r[1][k], r[2][k], r[3][k]);
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------------------------
+void PositionBasedCosseratRods::solve_BendTwistConstraints(
+	const unsigned int n,
+	const unsigned int quaternionIndices[],
+	Quaternionr q[], const Real invMassq[],
+	const Vector3r& bendingAndTwistingKs,
+	const Quaternionr restDarbouxVectors[])
+{
+	const unsigned int blockSize = 8;
+	Real a[4][blockSize], b[4][blockSize], d[4][blockSize], wa[blockSize], wb[blockSize];
+	for (unsigned int start = 0; start < n; start += blockSize)
+	{
+		// the unused lanes of the last block repeat the first constraint of the block
+		const unsigned int m = std::min(blockSize, n - start);
+		for (unsigned int k = 0; k < blockSize; k++)
+		{
+			const unsigned int c = start + ((k < m) ? k : 0);
+			const Quaternionr &q0 = q[quaternionIndices[2 * c]];
+			const Quaternionr &q1 = q[quaternionIndices[2 * c + 1]];
+			const Quaternionr &rest = restDarbouxVectors[c];
+			a[0][k] = q0.w(); a[1][k] = q0.x(); a[2][k] = q0.y(); a[3][k] = q0.z();
+			b[0][k] = q1.w(); b[1][k] = q1.x(); b[2][k] = q1.y(); b[3][k] = q1.z();
+			d[0][k] = rest.w(); d[1][k] = rest.x(); d[2][k] = rest.y(); d[3][k] = rest.z();
+			wa[k] = invMassq[quaternionIndices[2 * c]];
+			wb[k] = invMassq[quaternionIndices[2 * c + 1]];
+		}
+
+		for (unsigned int k = 0; k < blockSize; k++)
+		{
+			// darboux vector omega = q0.conjugate() * q1, see solve_BendTwistConstraint()
+			const Real ow = a[0][k] * b[0][k] + a[1][k] * b[1][k] + a[2][k] * b[2][k] + a[3][k] * b[3][k];
+			const Real ox = a[0][k] * b[1][k] - a[1][k] * b[0][k] - a[2][k] * b[3][k] + a[3][k] * b[2][k];
+			const Real oy = a[0][k] * b[2][k] + a[1][k] * b[3][k] - a[2][k] * b[0][k] - a[3][k] * b[1][k];
+			const Real oz = a[0][k] * b[3][k] - a[1][k] * b[2][k] + a[2][k] * b[1][k] - a[3][k] * b[0][k];
+			const Real mw = ow - d[0][k], mx = ox - d[1][k], my = oy - d[2][k], mz = oz - d[3][k];
+			const Real pw = ow + d[0][k], px = ox + d[1][k], py = oy + d[2][k], pz = oz + d[3][k];
+			const bool plus = (mw * mw + mx * mx + my * my + mz * mz) > (pw * pw + px * px + py * py + pz * pz);
+			const Real s = static_cast<Real>(1.0) / (wa[k] + wb[k] + static_cast<Real>(1.0e-6));
+			const Real x = (plus ? px : mx) * bendingAndTwistingKs[0] * s;
+			const Real y = (plus ? py : my) * bendingAndTwistingKs[1] * s;
+			const Real z = (plus ? pz : mz) * bendingAndTwistingKs[2] * s;
+
+			// corrq0 = q1 * (0, x, y, z) * invMassq0, corrq1 = -q0 * (0, x, y, z) * invMassq1
+			const Real c0w = (-b[1][k] * x - b[2][k] * y - b[3][k] * z) * wa[k];
+			const Real c0x = (b[0][k] * x + b[2][k] * z - b[3][k] * y) * wa[k];
+			const Real c0y = (b[0][k] * y + b[3][k] * x - b[1][k] * z) * wa[k];
+			const Real c0z = (b[0][k] * z + b[1][k] * y - b[2][k] * x) * wa[k];
+			const Real c1w = (-a[1][k] * x - a[2][k] * y - a[3][k] * z) * wb[k];
+			const Real c1x = (a[0][k] * x + a[2][k] * z - a[3][k] * y) * wb[k];
+			const Real c1y = (a[0][k] * y + a[3][k] * x - a[1][k] * z) * wb[k];
+			const Real c1z = (a[0][k] * z + a[1][k] * y - a[2][k] * x) * wb[k];
+			a[0][k] += c0w; a[1][k] += c0x; a[2][k] += c0y; a[3][k] += c0z;
+			b[0][k] -= c1w; b[1][k] -= c1x; b[2][k] -= c1y; b[3][k] -= c1z;
+
+			const Real normA = std::sqrt(a[0][k] * a[0][k] + a[1][k] * a[1][k] + a[2][k] * a[2][k] + a[3][k] * a[3][k]);
+			const Real normB = std::sqrt(b[0][k] * b[0][k] + b[1][k] * b[1][k] + b[2][k] * b[2][k] + b[3][k] * b[3][k]);
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				a[i][k] /= normA;
+				b[i][k] /= normB;
+			}
+		}
+
+		for (unsigned int k = 0; k < m; k++)
+		{
+			const unsigned int c = start + k;
+			if (wa[k] != 0.0)
+				q[quaternionIndices[2 * c]] = Quaternionr(a[0][k], a[1][k], a[2][k], a[3][k]);
+			if (wb[k] != 0.0)
+				q[quaternionIndices[2 * c + 1]] = Quaternionr(b[0][k], b[1][k], b[2][k], b[3][k]);
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------------------------
+bool PositionBasedCosseratRods::solve_StretchShearBendTwistChain(
+	const unsigned int nEdges,
+	const Vector3r p[], const Real invMass[],
+	const Quaternionr q[], const Real invMassq[],
+	const Vector3r& stretchingAndShearingKs,
+	const Vector3r& bendingAndTwistingKs,
+	const Real restLengths[],
+	const Quaternionr restDarbouxVectors[],
+	Vector3r corr_p[], Quaternionr corr_q[])
+{
+	using Matrix64r = Eigen::Matrix<Real, 6, 4, Eigen::DontAlign>;
+
+	if (nEdges == 0)
+		return false;
+
+	const bool isotropicStretchShear = (std::abs(stretchingAndShearingKs[0] - stretchingAndShearingKs[1]) < eps && std::abs(stretchingAndShearingKs[0] - stretchingAndShearingKs[2]) < eps);
+
+	// Block e contains the stretch-shear constraint of edge e (rows 0-2) and the bend-twist 
+	// constraint between edge e and e+1 (rows 3-5). Jq0 and Jq1 are the Jacobians w.r.t. 
+	// the coefficients of quaternion e and e+1, the Jacobians w.r.t. the particles are +-I/restLength.
+	// The temporary blocks are kept per thread to avoid heap allocations in each solve.
+	static thread_local std::vector<Matrix64r> Jq0, Jq1;
+	static thread_local std::vector<Vector6r> rhs;
+	Jq0.resize(nEdges);
+	Jq1.resize(nEdges);
+	rhs.resize(nEdges);
+	for (unsigned int e = 0; e < nEdges; e++)
+	{
+		const Quaternionr &q0 = q[e];
+		const Real l = restLengths[e];
+		Jq0[e].setZero();
+		Jq1[e].setZero();
+
+		// stretch-shear constraint (eq. 31 in the paper)
+		Vector3r d3;	//third director d3 = q0 * e_3 * q0_conjugate
+		d3[0] = static_cast<Real>(2.0) * (q0.x() * q0.z() + q0.w() * q0.y());
+		d3[1] = static_cast<Real>(2.0) * (q0.y() * q0.z() - q0.w() * q0.x());
+		d3[2] = q0.w() * q0.w() - q0.x() * q0.x() - q0.y() * q0.y() + q0.z() * q0.z();
+
+		Vector3r gamma = (p[e + 1] - p[e]) / l - d3;
+		if (isotropicStretchShear)
+			for (int i = 0; i < 3; i++) gamma[i] *= stretchingAndShearingKs[i];
+		else
+		{
+			Matrix3r R = q0.toRotationMatrix();
+			gamma = (R.transpose() * gamma).eval();
+			for (int i = 0; i < 3; i++) gamma[i] *= stretchingAndShearingKs[i];
+			gamma = (R * gamma).eval();
+		}
+		rhs[e].block<3, 1>(0, 0) = -gamma;
+
+		// -d(d3)/dq, quaternion coefficients in the order x, y, z, w
+		Jq0[e].block<3, 4>(0, 0) <<
+			-static_cast<Real>(2.0)*q0.z(), -static_cast<Real>(2.0)*q0.w(), -static_cast<Real>(2.0)*q0.x(), -static_cast<Real>(2.0)*q0.y(),
+			static_cast<Real>(2.0)*q0.w(), -static_cast<Real>(2.0)*q0.z(), -static_cast<Real>(2.0)*q0.y(), static_cast<Real>(2.0)*q0.x(),
+			static_cast<Real>(2.0)*q0.x(), static_cast<Real>(2.0)*q0.y(), -static_cast<Real>(2.0)*q0.z(), -static_cast<Real>(2.0)*q0.w();
+
+		// bend-twist constraint (eq. 32 in the paper)
+		if (e + 1 < nEdges)
+		{
+			const Quaternionr &q1 = q[e + 1];
+			const Quaternionr &restDarbouxVector = restDarbouxVectors[e];
+			Quaternionr omega = q0.conjugate() * q1;   //darboux vector
+
+			Quaternionr omega_plus;
+			omega_plus.coeffs() = omega.coeffs() + restDarbouxVector.coeffs();
+			omega.coeffs() = omega.coeffs() - restDarbouxVector.coeffs();
+			if (omega.squaredNorm() > omega_plus.squaredNorm()) omega = omega_plus;
+
+			for (int i = 0; i < 3; i++) rhs[e][3 + i] = -bendingAndTwistingKs[i] * omega.coeffs()[i];
+
+			// derivatives of the vector part of q0.conjugate() * q1
+			Jq0[e].block<3, 4>(3, 0) <<
+				-q1.w(), -q1.z(), q1.y(), q1.x(),
+				q1.z(), -q1.w(), -q1.x(), q1.y(),
+				-q1.y(), q1.x(), -q1.w(), q1.z();
+			Jq1[e].block<3, 4>(3, 0) <<
+				q0.w(), q0.z(), -q0.y(), -q0.x(),
+				-q0.z(), q0.w(), q0.x(), -q0.y(),
+				q0.y(), -q0.x(), q0.w(), -q0.z();
+		}
+		else
+			rhs[e].block<3, 1>(3, 0).setZero();
+
+		// The quaternions are normalized after the correction, so a change along q itself has 
+		// no effect. Projecting the Jacobians to the tangent space of the unit quaternions 
+		// (I - q q^T) lets the corrections only rotate and yields the Newton step for the rotations.
+		Jq0[e] = (Jq0[e] * (Matrix4r::Identity() - q0.coeffs() * q0.coeffs().transpose())).eval();
+		if (e + 1 < nEdges)
+			Jq1[e] = (Jq1[e] * (Matrix4r::Identity() - q[e + 1].coeffs() * q[e + 1].coeffs().transpose())).eval();
+	}
+
+	// Block Thomas algorithm: forward elimination. G and g store D^-1 * C and D^-1 * b
+	// of the eliminated blocks, where C is the coupling block of block e and e+1.
+	static thread_local std::vector<Matrix6r> G;
+	static thread_local std::vector<Vector6r> g;
+	G.resize(nEdges);
+	g.resize(nEdges);
+	Matrix6r C_prev;
+	for (unsigned int e = 0; e < nEdges; e++)
+	{
+		const Real l = restLengths[e];
+		const Real wq1 = (e + 1 < nEdges) ? invMassq[e + 1] : static_cast<Real>(0.0);
+
+		// diagonal block J M^-1 J^T
+		Matrix6r D = invMassq[e] * Jq0[e] * Jq0[e].transpose() + wq1 * Jq1[e] * Jq1[e].transpose();
+		D.block<3, 3>(0, 0) += (invMass[e] + invMass[e + 1]) / (l*l) * Matrix3r::Identity();
+		D += eps * Matrix6r::Identity();
+		if (e + 1 == nEdges)
+		{
+			// the last block has no bend-twist constraint
+			D.block<3, 3>(0, 3).setZero();
+			D.block<3, 3>(3, 0).setZero();
+			D.block<3, 3>(3, 3).setIdentity();
+		}
+
+		Vector6r b = rhs[e];
+		if (e > 0)
+		{
+			D -= C_prev.transpose() * G[e - 1];
+			b -= C_prev.transpose() * g[e - 1];
+		}
+
+		Eigen::LDLT<Matrix6r> DLDLT(D);
+		g[e] = DLDLT.solve(b);
+		if (e + 1 < nEdges)
+		{
+			// coupling by the shared particle e+1 and the shared quaternion e+1
+			const Real l1 = restLengths[e + 1];
+			C_prev = wq1 * Jq1[e] * Jq0[e + 1].transpose();
+			C_prev.block<3, 3>(0, 0) -= invMass[e + 1] / (l*l1) * Matrix3r::Identity();
+			G[e] = DLDLT.solve(C_prev);
+		}
+	}
+
+	// back substitution, g contains the Lagrange multipliers afterwards
+	for (int e = (int)nEdges - 2; e >= 0; e--)
+		g[e] -= G[e] * g[e + 1];
+
+	// corrections M^-1 J^T lambda
+	for (unsigned int i = 0; i <= nEdges; i++)
+		corr_p[i].setZero();
+	for (unsigned int e = 0; e < nEdges; e++)
+		corr_q[e].coeffs().setZero();
+
+	for (unsigned int e = 0; e < nEdges; e++)
+	{
+		const Vector3r lambdaStretchShear = g[e].block<3, 1>(0, 0) / restLengths[e];
+		corr_p[e] -= invMass[e] * lambdaStretchShear;
+		corr_p[e + 1] += invMass[e + 1] * lambdaStretchShear;
+		corr_q[e].coeffs() += invMassq[e] * Jq0[e].transpose() * g[e];
+		if (e + 1 < nEdges)
+			corr_q[e + 1].coeffs() += invMassq[e + 1] * Jq1[e].transpose() * g[e];
+	}
+	return true;
+}
 // ----------------------------------------------------------------------------------------------
 bool PositionBasedElasticRods::solve_PerpendiculaBisectorConstraint(
 	const Vector3r &p0, Real invMass0,
@@ -461,177 +800,154 @@ bool PositionBasedElasticRods::computeDarbouxGradient(
 // ----------------------------------------------------------------------------------------------
 
 
-void PBD::DirectPositionBasedSolverForStiffRods::initLists(int numberOfIntervals, std::list <Node*> * &forward, std::list <Node*> * &backward, Node* &root)
+void PBD::DirectPositionBasedSolverForStiffRods::initNodes(int intervalIndex, std::vector<RodSegment*> &rodSegments, Interval* intervals, std::vector<RodConstraint*> &rodConstraints)
 {
-	if (forward != NULL)
-		delete[] forward;
-	if (backward != NULL)
-		delete[] backward;
-	if (root != NULL)
-		delete[] root;
-	forward = new std::list<Node*>[numberOfIntervals];
-	backward = new std::list<Node*>[numberOfIntervals];
-	root = new Node[numberOfIntervals];
-}
+	Interval &interval = intervals[intervalIndex];
 
-bool PBD::DirectPositionBasedSolverForStiffRods::isSegmentInInterval(RodSegment *segment, int intervalIndex, Interval* intervals, std::vector<RodConstraint*> &rodConstraints, std::vector<RodSegment*> &rodSegments)
-{
-	for (int i = intervals[intervalIndex].start; i <= intervals[intervalIndex].end; i++)
-	{
-		if ((segment == rodSegments[rodConstraints[i]->segmentIndex(0)])
-			|| (segment == rodSegments[rodConstraints[i]->segmentIndex(1)]))
-			return true;
-	}
-	return false;
-}
-
-bool PBD::DirectPositionBasedSolverForStiffRods::isConstraintInInterval(RodConstraint *constraint, int intervalIndex, Interval* intervals, std::vector<RodConstraint*> &rodConstraints)
-{
-	for (int i = intervals[intervalIndex].start; i <= intervals[intervalIndex].end; i++)
+	// constraints of the interval which are connected to each segment
+	std::vector<std::vector<int>> segmentConstraints(rodSegments.size());
+	for (int i = interval.start; i <= interval.end; i++)
 	{
-		if (constraint == rodConstraints[i])
-			return true;
+		segmentConstraints[rodConstraints[i]->segmentIndex(0)].push_back(i);
+		segmentConstraints[rodConstraints[i]->segmentIndex(1)].push_back(i);
 	}
-	return false;
-}
-
-void PBD::DirectPositionBasedSolverForStiffRods::initSegmentNode(Node *n, int intervalIndex, std::vector<RodConstraint*> &rodConstraints, std::vector<RodSegment*> &rodSegments, std::vector <RodConstraint*> &markedConstraints, Interval* intervals)
-{
-	RodSegment *segment =
-		(RodSegment*)n->object;
 
-	std::vector<RodConstraint*> constraints;
-	std::vector<int> constraintIndices;
-	for (int j = 0; j < static_cast<int>(rodConstraints.size()); ++j)
+	// find root
+	int rootIndex = -1;
+	for (int i = 0; i < (int)rodSegments.size(); i++)
 	{
-		RodConstraint* constraint(rodConstraints[j]);
-		if (rodSegments[constraint->segmentIndex(0)] == segment
-			|| rodSegments[constraint->segmentIndex(1)] == segment)
+		if (segmentConstraints[i].empty())
+			continue;
+		if (rootIndex == -1)
+			rootIndex = i;
+		if (!rodSegments[i]->isDynamic())
 		{
-			constraints.push_back(constraint);
-			constraintIndices.push_back(j);
+			rootIndex = i;
+			break;
 		}
 	}
+	if (rootIndex == -1)
+		return;
 
-	for (unsigned int i = 0; i < constraints.size(); i++)
+	// Build the tree by a depth-first traversal starting at the root. Constraint nodes 
+	// are inserted between the segment nodes. A node is always created after its parent.
+	std::vector<Node> treeNodes;
+	std::vector<std::vector<int>> treeChildren;
+	std::vector<bool> markedConstraints(rodConstraints.size(), false);
+	std::vector<int> stack;
+
+	treeNodes.push_back(Node());
+	treeChildren.push_back(std::vector<int>());
+	treeNodes[0].isconstraint = false;
+	treeNodes[0].object = rodSegments[rootIndex];
+	treeNodes[0].index = rootIndex;
+	stack.push_back(0);
+
+	while (!stack.empty())
 	{
-		if (!isConstraintInInterval(constraints[i], intervalIndex, intervals, rodConstraints))
-			continue;
-
-		// Test whether the edge has been visited before
-		bool marked = false;
-		for (unsigned int j = 0; j < markedConstraints.size(); j++)
-		{
-			if (constraints[i] == markedConstraints[j])
-			{
-				marked = true;
-				break;
-			}
-		}
-		if (!marked)
+		const int n = stack.back();
+		stack.pop_back();
+		const int segmentIndex = treeNodes[n].index;
+		const std::vector<int> &constraints = segmentConstraints[segmentIndex];
+		for (size_t i = 0; i < constraints.size(); i++)
 		{
-			Node *constraintNode = new Node();
-			constraintNode->index = constraintIndices[i];
-			constraintNode->object = constraints[i];
-			constraintNode->isconstraint = true;
-			constraintNode->parent = n;
-			constraintNode->D.setZero();
-			constraintNode->Dinv.setZero();
-			constraintNode->J.setZero();
-			constraintNode->soln.setZero();
-
-			n->children.push_back(constraintNode);
-
-			Node *segmentNode = new Node();
-			segmentNode->isconstraint = false;
-			segmentNode->parent = constraintNode;
+			const int constraintIndex = constraints[i];
+
+			// Test whether the edge has been visited before
+			if (markedConstraints[constraintIndex])
+				continue;
+			markedConstraints[constraintIndex] = true;
+
+			RodConstraint *constraint = rodConstraints[constraintIndex];
+			const int constraintNode = (int)treeNodes.size();
+			treeNodes.push_back(Node());
+			treeChildren.push_back(std::vector<int>());
+			treeNodes[constraintNode].isconstraint = true;
+			treeNodes[constraintNode].object = constraint;
+			treeNodes[constraintNode].index = constraintIndex;
+			treeNodes[constraintNode].parent = n;
+			treeChildren[n].push_back(constraintNode);
 
 			//	get other segment connected to constraint for new node
-			if (rodSegments[constraints[i]->segmentIndex(0)] == segment)
-			{
-				segmentNode->object = rodSegments[constraints[i]->segmentIndex(1)];
-				segmentNode->index = constraints[i]->segmentIndex(1);
-			}
-			else
-			{
-				segmentNode->object = rodSegments[constraints[i]->segmentIndex(0)];
-				segmentNode->index = constraints[i]->segmentIndex(0);
-			}
-
-			segmentNode->D.setZero();
-			segmentNode->Dinv.setZero();
-			segmentNode->J.setZero();
-			segmentNode->soln.setZero();
-
-			constraintNode->children.push_back(segmentNode);
-
-			// mark constraint
-			markedConstraints.push_back(constraints[i]);
-
-			initSegmentNode(segmentNode, intervalIndex, rodConstraints,
-				rodSegments, markedConstraints, intervals);
+			int otherSegmentIndex = constraint->segmentIndex(0);
+			if (otherSegmentIndex == segmentIndex)
+				otherSegmentIndex = constraint->segmentIndex(1);
+
+			const int segmentNode = (int)treeNodes.size();
+			treeNodes.push_back(Node());
+			treeChildren.push_back(std::vector<int>());
+			treeNodes[segmentNode].isconstraint = false;
+			treeNodes[segmentNode].object = rodSegments[otherSegmentIndex];
+			treeNodes[segmentNode].index = otherSegmentIndex;
+			treeNodes[segmentNode].parent = constraintNode;
+			treeChildren[constraintNode].push_back(segmentNode);
+
+			stack.push_back(segmentNode);
 		}
 	}
-}
 
-void PBD::DirectPositionBasedSolverForStiffRods::orderMatrix(Node *n, int intervalIndex, std::list <Node*> * forward, std::list <Node*> * backward)
-{
-	for (unsigned int i = 0; i < n->children.size(); i++)
-		orderMatrix(n->children[i], intervalIndex, forward, backward);
-	forward[intervalIndex].push_back(n);
-	backward[intervalIndex].push_front(n);
-}
-
-void PBD::DirectPositionBasedSolverForStiffRods::initNodes(int intervalIndex, std::vector<RodSegment*> &rodSegments, Node* &root, Interval* intervals, std::vector<RodConstraint*> &rodConstraints, std::list <Node*> * forward, std::list <Node*> * backward, std::vector <RodConstraint*> &markedConstraints)
-{
-	// find root
-	for (int i = 0; i < (int)rodSegments.size(); i++)
+	// compute the height of each node (leaves have height 0)
+	const int numNodes = (int)treeNodes.size();
+	std::vector<int> height(numNodes, 0);
+	for (int i = numNodes - 1; i > 0; i--)
 	{
-		RodSegment * rb(rodSegments[i]);
-		if (!isSegmentInInterval(rb, intervalIndex, intervals, rodConstraints, rodSegments))
-			continue;
-		else
-		{
-			if (root[intervalIndex].object == NULL)
-			{
-				root[intervalIndex].object = rb;
-				root[intervalIndex].index = i;
-			}
-		}
-
-		if (!rb->isDynamic())
-		{
-			root[intervalIndex].object = rb;
-			root[intervalIndex].index = i;
-			break;
-		}
+		const int p = treeNodes[i].parent;
+		height[p] = std::max(height[p], height[i] + 1);
+	}
+	const int numLevels = height[0] + 1;
+
+	// sort the nodes by their height (counting sort), the root is the last node
+	interval.levels.assign(numLevels + 1, 0);
+	for (int i = 0; i < numNodes; i++)
+		interval.levels[height[i] + 1]++;
+	for (int l = 0; l < numLevels; l++)
+		interval.levels[l + 1] += interval.levels[l];
+
+	std::vector<int> newIndex(numNodes);
+	std::vector<int> levelFill(interval.levels.begin(), interval.levels.end() - 1);
+	for (int i = 0; i < numNodes; i++)
+		newIndex[i] = levelFill[height[i]]++;
+
+	interval.nodes.resize(numNodes);
+	for (int i = 0; i < numNodes; i++)
+	{
+		Node &node = interval.nodes[newIndex[i]];
+		node = treeNodes[i];
+		if (node.parent != -1)
+			node.parent = newIndex[node.parent];
 	}
-	root[intervalIndex].isconstraint = false;
-	root[intervalIndex].parent = NULL;
 
-	root[intervalIndex].D.setZero();
-	root[intervalIndex].Dinv.setZero();
-	root[intervalIndex].soln.setZero();
+	// store the children of each node contiguously
+	interval.children.clear();
+	interval.children.reserve(numNodes);
+	std::vector<int> oldIndex(numNodes);
+	for (int i = 0; i < numNodes; i++)
+		oldIndex[newIndex[i]] = i;
+	for (int i = 0; i < numNodes; i++)
+	{
+		Node &node = interval.nodes[i];
+		node.childrenStart = (int)interval.children.size();
+		const std::vector<int> &children = treeChildren[oldIndex[i]];
+		for (size_t j = 0; j < children.size(); j++)
+			interval.children.push_back(newIndex[children[j]]);
+		node.childrenEnd = (int)interval.children.size();
+	}
 
-	initSegmentNode(&root[intervalIndex], intervalIndex, rodConstraints,
-		rodSegments, markedConstraints, intervals);
-	orderMatrix(&root[intervalIndex], intervalIndex, forward, backward);
+	interval.factorizationRotations.resize(numNodes);
+	interval.factorized = false;
 }
 
-void PBD::DirectPositionBasedSolverForStiffRods::initTree(std::vector<RodConstraint*> &rodConstraints, std::vector<RodSegment*> & rodSegments, Interval* &intervals, int &numberOfIntervals, std::list <Node*> * &forward, std::list <Node*> * &backward, Node* &root)
+void PBD::DirectPositionBasedSolverForStiffRods::initTree(std::vector<RodConstraint*> &rodConstraints, std::vector<RodSegment*> & rodSegments, Interval* &intervals, int &numberOfIntervals)
 {
+	if (intervals != NULL)
+		delete[] intervals;
 	numberOfIntervals = 1;
 	intervals = new Interval[1];
 	intervals[0].start = 0;
 	intervals[0].end = (int)rodConstraints.size() - 1;
-	initLists(numberOfIntervals, forward, backward, root);
 
-	std::vector <RodConstraint*> markedConstraints;
 	for (int i = 0; i < numberOfIntervals; i++)
-	{
-		initNodes(i, rodSegments, root, intervals, rodConstraints, forward, backward, markedConstraints);
-		markedConstraints.clear();
-	}
+		initNodes(i, rodSegments, intervals, rodConstraints);
 }
 
 bool PBD::DirectPositionBasedSolverForStiffRods::computeDarbouxVector(const Quaternionr & q0, const Quaternionr & q1, const Real averageSegmentLength, Vector3r & darbouxVector)
@@ -732,275 +1048,365 @@ void PBD::DirectPositionBasedSolverForStiffRods::getMassMatrix(RodSegment *segme
 		M(i, j) = inertia(i - 3, j - 3);
 }
 
-Real PBD::DirectPositionBasedSolverForStiffRods::factor(const int intervalIndex, const std::vector<RodConstraint*> &rodConstraints, std::vector<RodSegment*> & rodSegments, const Interval* &intervals, std::list <Node*> * forward, std::list <Node*> * backward, std::vector<Vector6r> & RHS, std::vector<Vector6r> & lambdaSums, std::vector<std::vector<Matrix3r>> & bendingAndTorsionJacobians)
+Real PBD::DirectPositionBasedSolverForStiffRods::computeRightHandSide(const std::vector<RodConstraint*> &rodConstraints, std::vector<RodSegment*> & rodSegments, std::vector<Vector6r> & RHS, std::vector<Vector6r> & lambdaSums)
 {
 	Real maxError(0.);
-	
-	// compute right hand side of linear equation system
-	for (size_t currentConstraintIndex = 0; currentConstraintIndex < rodConstraints.size(); ++currentConstraintIndex)
+	const int numConstraints = (int)rodConstraints.size();
+
+	#pragma omp parallel if(numConstraints > MIN_PARALLEL_SIZE) default(shared)
 	{
-		RodConstraint* currentConstraint = rodConstraints[currentConstraintIndex];
+		Real maxErrorLocal(0.);
 
-		RodSegment* segment0 = rodSegments[currentConstraint->segmentIndex(0)];
-		RodSegment* segment1 = rodSegments[currentConstraint->segmentIndex(1)];
+		// compute right hand side of linear equation system
+		#pragma omp for schedule(static)
+		for (int currentConstraintIndex = 0; currentConstraintIndex < numConstraints; ++currentConstraintIndex)
+		{
+			RodConstraint* currentConstraint = rodConstraints[currentConstraintIndex];
 
-		const Quaternionr &q0 = segment0->Rotation();
-		const Quaternionr &q1 = segment1->Rotation();
+			RodSegment* segment0 = rodSegments[currentConstraint->segmentIndex(0)];
+			RodSegment* segment1 = rodSegments[currentConstraint->segmentIndex(1)];
 
-		const Eigen::Matrix<Real, 3, 4, Eigen::DontAlign> &constraintInfo(currentConstraint->getConstraintInfo());
-		Vector6r &rhs(RHS[currentConstraintIndex]);
+			const Quaternionr &q0 = segment0->Rotation();
+			const Quaternionr &q1 = segment1->Rotation();
 
-		// Compute zero-stretch part of constraint violation
-		const Vector3r &connector0 = constraintInfo.col(2);
-		const Vector3r &connector1 = constraintInfo.col(3);
-		Vector3r stretchViolation = connector0 - connector1;
+			const Eigen::Matrix<Real, 3, 4, Eigen::DontAlign> &constraintInfo(currentConstraint->getConstraintInfo());
+			Vector6r &rhs(RHS[currentConstraintIndex]);
 
-		// compute Darboux vector (Equation (7))
-		Vector3r omega;
-		computeDarbouxVector(q0, q1, currentConstraint->getAverageSegmentLength(), omega);
+			// Compute zero-stretch part of constraint violation
+			const Vector3r &connector0 = constraintInfo.col(2);
+			const Vector3r &connector1 = constraintInfo.col(3);
+			Vector3r stretchViolation = connector0 - connector1;
 
-		// Compute bending and torsion part of constraint violation
-		Vector3r bendingAndTorsionViolation = omega - currentConstraint->getRestDarbouxVector();
+			// compute Darboux vector (Equation (7))
+			Vector3r omega;
+			computeDarbouxVector(q0, q1, currentConstraint->getAverageSegmentLength(), omega);
 
-		// fill right hand side of the linear equation system
-		const Vector6r &lambdaSum(lambdaSums[currentConstraintIndex]);
-		rhs.block<3, 1>(0, 0) = -stretchViolation
-			- Vector3r(currentConstraint->getStretchCompliance().array() *
-			lambdaSum.block<3, 1>(0, 0).array());
+			// Compute bending and torsion part of constraint violation
+			Vector3r bendingAndTorsionViolation = omega - currentConstraint->getRestDarbouxVector();
 
-		rhs.block<3, 1>(3, 0) = -bendingAndTorsionViolation
-			- Vector3r(currentConstraint->getBendingAndTorsionCompliance().array() *
-			lambdaSum.block<3, 1>(3, 0).array());
+			// fill right hand side of the linear equation system
+			const Vector6r &lambdaSum(lambdaSums[currentConstraintIndex]);
+			rhs.block<3, 1>(0, 0) = -stretchViolation
+				- Vector3r(currentConstraint->getStretchCompliance().array() *
+				lambdaSum.block<3, 1>(0, 0).array());
 
-		// compute max error
-		for (unsigned char i(0); i < 6; ++i)
-		{
-			maxError = std::max(maxError, std::abs(rhs[i]));
-		}
+			rhs.block<3, 1>(3, 0) = -bendingAndTorsionViolation
+				- Vector3r(currentConstraint->getBendingAndTorsionCompliance().array() *
+				lambdaSum.block<3, 1>(3, 0).array());
 
-		// Compute a part of the Jacobian here, because the relationship
-		// of the first and second segment to the constraint can be determined directly
+			// compute max error
+			for (unsigned char i(0); i < 6; ++i)
+			{
+				maxErrorLocal = std::max(maxErrorLocal, std::abs(rhs[i]));
+			}
+		}
 
-		// compute G matrices
-		Eigen::Matrix<Real, 4, 3> G0, G1;
-		computeMatrixG(q0, G0);
-		computeMatrixG(q1, G1);
+		#pragma omp critical
+		{
+			maxError = std::max(maxError, maxErrorLocal);
+		}
+	}
+	return maxError;
+}
 
-		// compute stretching bending Jacobians (Equation (10) and Equation (11))
-		Eigen::Matrix<Real, 3, 4> jOmega0, jOmega1;
-		computeBendingAndTorsionJacobians(q0, q1, currentConstraint->getAverageSegmentLength(), jOmega0, jOmega1);
+bool PBD::DirectPositionBasedSolverForStiffRods::needsFactorization(const int intervalIndex, const Interval* intervals, const Real refactorizationTolerance)
+{
+	const Interval &interval = intervals[intervalIndex];
+	if (!interval.factorized || (refactorizationTolerance <= 0.0))
+		return true;
 
-		bendingAndTorsionJacobians[currentConstraintIndex][0] = jOmega0*G0;
-		bendingAndTorsionJacobians[currentConstraintIndex][1] = jOmega1*G1;
+	for (size_t i = 0; i < interval.nodes.size(); i++)
+	{
+		const Node &node = interval.nodes[i];
+		if (node.isconstraint)
+			continue;
+		const Quaternionr &q = ((RodSegment*)node.object)->Rotation();
+		if ((q.coeffs() - interval.factorizationRotations[i].coeffs()).cwiseAbs().maxCoeff() > refactorizationTolerance)
+			return true;
 	}
+	return false;
+}
 
-	std::list<Node*>::iterator nodeIter;
-	for (nodeIter = forward[intervalIndex].begin(); nodeIter != forward[intervalIndex].end(); nodeIter++)
-	{
-		Node *node = *nodeIter;
-		// compute system matrix diagonal
-		if (node->isconstraint)
-		{
-			RodConstraint* currentConstraint = (RodConstraint*)node->object;
-			//insert compliance
-			node->D.setZero();
-			const Vector3r &stretchCompliance(currentConstraint->getStretchCompliance());
-
-			node->D(0, 0) -= stretchCompliance[0];
-			node->D(1, 1) -= stretchCompliance[1];
-			node->D(2, 2) -= stretchCompliance[2];
-
-			const Vector3r &bendingAndTorsionCompliance(currentConstraint->getBendingAndTorsionCompliance());
-			node->D(3, 3) -= bendingAndTorsionCompliance[0];
-			node->D(4, 4) -= bendingAndTorsionCompliance[1];
-			node->D(5, 5) -= bendingAndTorsionCompliance[2];
-		}
-		else
-		{
-			getMassMatrix((RodSegment*)node->object, node->D);
-		}
+void PBD::DirectPositionBasedSolverForStiffRods::factor(const int intervalIndex, std::vector<RodSegment*> & rodSegments, Interval* intervals, std::vector<std::vector<Matrix3r>> & bendingAndTorsionJacobians)
+{
+	Interval &interval = intervals[intervalIndex];
+	std::vector<Node> &nodes = interval.nodes;
+	const int numNodes = (int)nodes.size();
 
-		// compute Jacobian
-		if (node->parent != NULL)
+	#pragma omp parallel if(numNodes > MIN_PARALLEL_SIZE) default(shared)
+	{
+		// Compute the bending and torsion part of the Jacobians of the constraints
+		#pragma omp for schedule(static)
+		for (int i = 0; i < numNodes; i++)
 		{
-			if (node->isconstraint)
-			{
-				//compute J 
-				RodConstraint *constraint = (RodConstraint*)node->object;
-				RodSegment *segment = (RodSegment*)node->parent->object;
+			Node &node = nodes[i];
+			if (!node.isconstraint)
+				continue;
 
-				Real sign = 1;
-				int segmentIndex = 0;
-				if (segment == rodSegments[constraint->segmentIndex(1)])
-				{
-					segmentIndex = 1;
-					sign = -1;
-				}
+			RodConstraint* currentConstraint = (RodConstraint*)node.object;
+			const Quaternionr &q0 = rodSegments[currentConstraint->segmentIndex(0)]->Rotation();
+			const Quaternionr &q1 = rodSegments[currentConstraint->segmentIndex(1)]->Rotation();
 
-				const Eigen::Matrix<Real, 3, 4, Eigen::DontAlign> &constraintInfo(constraint->getConstraintInfo());
-				const Vector3r r = constraintInfo.col(2 + segmentIndex) - segment->Position();
-				Matrix3r r_cross;
-				Real crossSign(-static_cast<Real>(1.0)*sign);
-				MathFunctions::crossProductMatrix(crossSign*r, r_cross);
+			// compute G matrices
+			Eigen::Matrix<Real, 4, 3> G0, G1;
+			computeMatrixG(q0, G0);
+			computeMatrixG(q1, G1);
 
-				Eigen::DiagonalMatrix<Real, 3> upperLeft(sign, sign, sign);
-				node->J.block<3, 3>(0, 0) = upperLeft;
+			// compute stretching bending Jacobians (Equation (10) and Equation (11))
+			Eigen::Matrix<Real, 3, 4> jOmega0, jOmega1;
+			computeBendingAndTorsionJacobians(q0, q1, currentConstraint->getAverageSegmentLength(), jOmega0, jOmega1);
 
-				Matrix3r lowerLeft(Matrix3r::Zero());
-				node->J.block<3, 3>(3, 0) = lowerLeft;
-
-				node->J.block<3, 3>(0, 3) = r_cross;
+			bendingAndTorsionJacobians[node.index][0] = jOmega0*G0;
+			bendingAndTorsionJacobians[node.index][1] = jOmega1*G1;
+		}
 
-				Matrix3r &lowerRight(bendingAndTorsionJacobians[node->index][segmentIndex]);
-				node->J.block<3, 3>(3, 3) = lowerRight;
+		#pragma omp for schedule(static)
+		for (int i = 0; i < numNodes; i++)
+		{
+			Node &node = nodes[i];
+			// compute system matrix diagonal
+			if (node.isconstraint)
+			{
+				RodConstraint* currentConstraint = (RodConstraint*)node.object;
+				//insert compliance
+				node.D.setZero();
+				const Vector3r &stretchCompliance(currentConstraint->getStretchCompliance());
+
+				node.D(0, 0) -= stretchCompliance[0];
+				node.D(1, 1) -= stretchCompliance[1];
+				node.D(2, 2) -= stretchCompliance[2];
+
+				const Vector3r &bendingAndTorsionCompliance(currentConstraint->getBendingAndTorsionCompliance());
+				node.D(3, 3) -= bendingAndTorsionCompliance[0];
+				node.D(4, 4) -= bendingAndTorsionCompliance[1];
+				node.D(5, 5) -= bendingAndTorsionCompliance[2];
 			}
 			else
 			{
-				//compute JT
-				RodConstraint *constraint = (RodConstraint*)node->parent->object;
-				RodSegment *segment = (RodSegment*)node->object;
+				RodSegment *segment = (RodSegment*)node.object;
+				getMassMatrix(segment, node.D);
+				interval.factorizationRotations[i] = segment->Rotation();
+			}
 
-				Real sign = 1;
-				int segmentIndex = 0;
-				if (segment == rodSegments[constraint->segmentIndex(1)])
+			// compute Jacobian
+			if (node.parent != -1)
+			{
+				const Node &parent = nodes[node.parent];
+				if (node.isconstraint)
 				{
-					segmentIndex = 1;
-					sign = -1;
+					//compute J 
+					RodConstraint *constraint = (RodConstraint*)node.object;
+					RodSegment *segment = (RodSegment*)parent.object;
+
+					Real sign = 1;
+					int segmentIndex = 0;
+					if (segment == rodSegments[constraint->segmentIndex(1)])
+					{
+						segmentIndex = 1;
+						sign = -1;
+					}
+
+					const Eigen::Matrix<Real, 3, 4, Eigen::DontAlign> &constraintInfo(constraint->getConstraintInfo());
+					const Vector3r r = constraintInfo.col(2 + segmentIndex) - segment->Position();
+					Matrix3r r_cross;
+					Real crossSign(-static_cast<Real>(1.0)*sign);
+					MathFunctions::crossProductMatrix(crossSign*r, r_cross);
+
+					Eigen::DiagonalMatrix<Real, 3> upperLeft(sign, sign, sign);
+					node.J.block<3, 3>(0, 0) = upperLeft;
+
+					Matrix3r lowerLeft(Matrix3r::Zero());
+					node.J.block<3, 3>(3, 0) = lowerLeft;
+
+					node.J.block<3, 3>(0, 3) = r_cross;
+
+					Matrix3r &lowerRight(bendingAndTorsionJacobians[node.index][segmentIndex]);
+					node.J.block<3, 3>(3, 3) = lowerRight;
 				}
+				else
+				{
+					//compute JT
+					RodConstraint *constraint = (RodConstraint*)parent.object;
+					RodSegment *segment = (RodSegment*)node.object;
+
+					Real sign = 1;
+					int segmentIndex = 0;
+					if (segment == rodSegments[constraint->segmentIndex(1)])
+					{
+						segmentIndex = 1;
+						sign = -1;
+					}
 
-				const Eigen::Matrix<Real, 3, 4, Eigen::DontAlign> &constraintInfo(constraint->getConstraintInfo());
-				const Vector3r r = constraintInfo.col(2 + segmentIndex) - segment->Position();
-				Matrix3r r_crossT;
-				MathFunctions::crossProductMatrix(sign*r, r_crossT);
+					const Eigen::Matrix<Real, 3, 4, Eigen::DontAlign> &constraintInfo(constraint->getConstraintInfo());
+					const Vector3r r = constraintInfo.col(2 + segmentIndex) - segment->Position();
+					Matrix3r r_crossT;
+					MathFunctions::crossProductMatrix(sign*r, r_crossT);
 
-				Eigen::DiagonalMatrix<Real, 3> upperLeft(sign, sign, sign);
-				node->J.block<3, 3>(0, 0) = upperLeft;
+					Eigen::DiagonalMatrix<Real, 3> upperLeft(sign, sign, sign);
+					node.J.block<3, 3>(0, 0) = upperLeft;
 
-				node->J.block<3, 3>(3, 0) = r_crossT;
+					node.J.block<3, 3>(3, 0) = r_crossT;
 
-				Matrix3r upperRight(Matrix3r::Zero());
-				node->J.block<3, 3>(0, 3) = upperRight;
+					Matrix3r upperRight(Matrix3r::Zero());
+					node.J.block<3, 3>(0, 3) = upperRight;
 
-				Matrix3r lowerRight(bendingAndTorsionJacobians[node->parent->index][segmentIndex].transpose());
-				node->J.block<3, 3>(3, 3) = lowerRight;
+					Matrix3r lowerRight(bendingAndTorsionJacobians[parent.index][segmentIndex].transpose());
+					node.J.block<3, 3>(3, 3) = lowerRight;
+				}
 			}
 		}
 	}
 
-	for (nodeIter = forward[intervalIndex].begin(); nodeIter != forward[intervalIndex].end(); nodeIter++)
+	// Eliminate the nodes level by level. The children of a node are in lower levels,
+	// so the nodes of one level can be eliminated in parallel.
+	const int numLevels = (int)interval.levels.size() - 1;
+	for (int level = 0; level < numLevels; level++)
 	{
-		Node *node = *nodeIter;
-		std::vector <Node*> children = node->children;
-		for (size_t i = 0; i < children.size(); i++)
-		{
-			Matrix6r JT = (children[i]->J).transpose();
-			Matrix6r &D = children[i]->D;
-			Matrix6r &J = children[i]->J;
-			Matrix6r JTDJ = ((JT * D) * J);
-			node->D = node->D - JTDJ;
-		}
-		bool chk = false;
-		if (!node->isconstraint)
-		{
-			RodSegment *segment = (RodSegment*)node->object;
-			if (!segment->isDynamic())
-			{
-				node->Dinv.setZero();
-				chk = true;
-			}
-		}
+		const int levelStart = interval.levels[level];
+		const int levelEnd = interval.levels[level + 1];
 
-		node->DLDLT.compute(node->D); // result reused in solve()
-		if (node->parent != NULL)
+		#pragma omp parallel if(levelEnd - levelStart > MIN_PARALLEL_SIZE) default(shared)
 		{
-			if (!chk)
-			{
-				node->J = node->DLDLT.solve(node->J);
-			}
-			else
+			#pragma omp for schedule(static)
+			for (int i = levelStart; i < levelEnd; i++)
 			{
-				node->J.setZero();
+				Node &node = nodes[i];
+				for (int c = node.childrenStart; c < node.childrenEnd; c++)
+				{
+					const Node &child = nodes[interval.children[c]];
+					Matrix6r JT = child.J.transpose();
+					Matrix6r JTDJ = ((JT * child.D) * child.J);
+					node.D = node.D - JTDJ;
+				}
+				bool chk = false;
+				if (!node.isconstraint)
+				{
+					RodSegment *segment = (RodSegment*)node.object;
+					if (!segment->isDynamic())
+					{
+						node.Dinv.setZero();
+						chk = true;
+					}
+				}
+
+				node.DLDLT.compute(node.D); // result reused in solve()
+				if (node.parent != -1)
+				{
+					if (!chk)
+					{
+						node.J = node.DLDLT.solve(node.J);
+					}
+					else
+					{
+						node.J.setZero();
+					}
+				}
 			}
 		}
 	}
-	return maxError;
+	interval.factorized = true;
 }
 
-bool PBD::DirectPositionBasedSolverForStiffRods::solve(int intervalIndex, std::list <Node*> * forward, std::list <Node*> * backward, std::vector<Vector6r> & RHS, std::vector<Vector6r> & lambdaSums, std::vector<Vector3r> & corr_x, std::vector<Quaternionr> & corr_q)
+bool PBD::DirectPositionBasedSolverForStiffRods::solve(int intervalIndex, Interval* intervals, std::vector<Vector6r> & RHS, std::vector<Vector6r> & lambdaSums, std::vector<Vector3r> & corr_x, std::vector<Quaternionr> & corr_q)
 {
-	std::list<Node*>::iterator nodeIter;
-	for (nodeIter = forward[intervalIndex].begin(); nodeIter != forward[intervalIndex].end(); nodeIter++)
+	Interval &interval = intervals[intervalIndex];
+	std::vector<Node> &nodes = interval.nodes;
+	const int numNodes = (int)nodes.size();
+	const int numLevels = (int)interval.levels.size() - 1;
+
+	// forward substitution from the leaves to the root
+	for (int level = 0; level < numLevels; level++)
 	{
-		Node *node = *nodeIter;
-		if (node->isconstraint)
-		{
-			node->soln = -RHS[node->index];
-		}
-		else
-		{
-			node->soln.setZero();
-		}
-		std::vector <Node*> &children = node->children;
-		for (size_t i = 0; i < children.size(); ++i)
+		const int levelStart = interval.levels[level];
+		const int levelEnd = interval.levels[level + 1];
+
+		#pragma omp parallel if(levelEnd - levelStart > MIN_PARALLEL_SIZE) default(shared)
 		{
-			Matrix6r cJT = children[i]->J.transpose();
-			Vector6r &csoln = children[i]->soln;
-			Vector6r v = cJT * csoln;
-			node->soln = node->soln - v;
+			#pragma omp for schedule(static)
+			for (int i = levelStart; i < levelEnd; i++)
+			{
+				Node &node = nodes[i];
+				if (node.isconstraint)
+				{
+					node.soln = -RHS[node.index];
+				}
+				else
+				{
+					node.soln.setZero();
+				}
+				for (int c = node.childrenStart; c < node.childrenEnd; c++)
+				{
+					const Node &child = nodes[interval.children[c]];
+					node.soln -= child.J.transpose() * child.soln;
+				}
+			}
 		}
 	}
 
-	for (nodeIter = backward[intervalIndex].begin(); nodeIter != backward[intervalIndex].end(); nodeIter++)
+	// back substitution from the root to the leaves
+	for (int level = numLevels - 1; level >= 0; level--)
 	{
-		Node *node = *nodeIter;
+		const int levelStart = interval.levels[level];
+		const int levelEnd = interval.levels[level + 1];
 
-		bool noZeroDinv(true);
-		if (!node->isconstraint)
-		{
-			RodSegment *segment = (RodSegment*)node->object;
-			noZeroDinv = segment->isDynamic();
-		}
-		if (noZeroDinv) // if DInv == 0 child value is 0 and node->soln is not altered
+		#pragma omp parallel if(levelEnd - levelStart > MIN_PARALLEL_SIZE) default(shared)
 		{
-			node->soln = node->DLDLT.solve(node->soln);
-
-			if (node->parent != NULL)
+			#pragma omp for schedule(static)
+			for (int i = levelStart; i < levelEnd; i++)
 			{
-				node->soln -= node->J * node->parent->soln;
-			}
-		}
-		else
-		{
-			node->soln.setZero(); // segment of node is not dynamic
-		}
+				Node &node = nodes[i];
 
-		if (node->isconstraint)
-		{
-			lambdaSums[node->index] += node->soln;
+				bool noZeroDinv(true);
+				if (!node.isconstraint)
+				{
+					RodSegment *segment = (RodSegment*)node.object;
+					noZeroDinv = segment->isDynamic();
+				}
+				if (noZeroDinv) // if DInv == 0 child value is 0 and node.soln is not altered
+				{
+					node.soln = node.DLDLT.solve(node.soln);
+
+					if (node.parent != -1)
+					{
+						node.soln -= node.J * nodes[node.parent].soln;
+					}
+				}
+				else
+				{
+					node.soln.setZero(); // segment of node is not dynamic
+				}
+
+				if (node.isconstraint)
+				{
+					lambdaSums[node.index] += node.soln;
+				}
+			}
 		}
 	}
 
 	// compute position and orientation updates
-	for (nodeIter = forward[intervalIndex].begin(); nodeIter != forward[intervalIndex].end(); nodeIter++)
+	#pragma omp parallel if(numNodes > MIN_PARALLEL_SIZE) default(shared)
 	{
-		Node *node = *nodeIter;
-		if (!node->isconstraint)
+		#pragma omp for schedule(static)
+		for (int i = 0; i < numNodes; i++)
 		{
-			RodSegment *segment = (RodSegment *)node->object;
+			const Node &node = nodes[i];
+			if (node.isconstraint)
+				continue;
+
+			RodSegment *segment = (RodSegment *)node.object;
 			if (!segment->isDynamic())
-			{
-				break;
-			}
+				continue;
 
-			const Vector6r & soln(node->soln);
+			const Vector6r & soln(node.soln);
 			Vector3r deltaXSoln = Vector3r(-soln[0], -soln[1], -soln[2]);
-			corr_x[node->index] = deltaXSoln;
+			corr_x[node.index] = deltaXSoln;
 
 			Eigen::Matrix<Real, 4, 3> G;
 			computeMatrixG(segment->Rotation(), G);
 			Quaternionr deltaQSoln;
 			deltaQSoln.coeffs() = G * Vector3r(-soln[3], -soln[4], -soln[5]);
-			corr_q[node->index] = deltaQSoln;
+			corr_q[node.index] = deltaQSoln;
 		}
 	}
 	return true;
@@ -1011,9 +1417,6 @@ bool PBD::DirectPositionBasedSolverForStiffRods::init_DirectPositionBasedSolverF
 	std::vector<RodSegment*> & rodSegments, 
 	Interval* &intervals, 
 	int &numberOfIntervals, 
-	std::list <Node*> * &forward, 
-	std::list <Node*> * &backward, 
-	Node* &root, 
 	const std::vector<Vector3r> &constraintPositions,
 	const std::vector<Real> &averageRadii,
 	const std::vector<Real> &youngsModuli,
@@ -1040,7 +1443,7 @@ bool PBD::DirectPositionBasedSolverForStiffRods::init_DirectPositionBasedSolverF
 	}
 	
 	// compute tree data structure for direct solver
-	initTree(rodConstraints, rodSegments, intervals, numberOfIntervals, forward, backward, root);
+	initTree(rodConstraints, rodSegments, intervals, numberOfIntervals);
 
 	RHS.resize(rodConstraints.size());
 	std::fill(RHS.begin(), RHS.end(), Vector6r::Zero());
@@ -1066,7 +1469,9 @@ bool PBD::DirectPositionBasedSolverForStiffRods::init_DirectPositionBasedSolverF
 bool PBD::DirectPositionBasedSolverForStiffRods::initBeforeProjection_DirectPositionBasedSolverForStiffRodsConstraint(
 	const std::vector<RodConstraint*> &rodConstraints,
 	const Real inverseTimeStepSize,
-	std::vector<Vector6r> & lambdaSums
+	std::vector<Vector6r> & lambdaSums,
+	Interval* intervals,
+	const int numberOfIntervals
 	)
 {
 	for (size_t cIdx(0); cIdx < rodConstraints.size(); ++cIdx)
@@ -1081,6 +1486,10 @@ bool PBD::DirectPositionBasedSolverForStiffRods::initBeforeProjection_DirectPosi
 			constraint->getBendingAndTorsionCompliance(),
 			lambdaSums[cIdx]);
 	}
+
+	// the compliance depends on the time step size
+	for (int i = 0; i < numberOfIntervals; i++)
+		intervals[i].factorized = false;
 	return true;
 }
 
@@ -1110,25 +1519,33 @@ bool PBD::DirectPositionBasedSolverForStiffRods::update_DirectPositionBasedSolve
 bool PBD::DirectPositionBasedSolverForStiffRods::solve_DirectPositionBasedSolverForStiffRodsConstraint(
 	const std::vector<RodConstraint*> &rodConstraints, 
 	std::vector<RodSegment*> & rodSegments, 
-	const Interval* intervals, 
+	Interval* intervals, 
 	const int &numberOfIntervals, 
-	std::list <Node*> * forward, 
-	std::list <Node*> * backward, 
 	std::vector<Vector6r> & RHS, 
 	std::vector<Vector6r> & lambdaSums, 
 	std::vector<std::vector<Matrix3r>> & bendingAndTorsionJacobians, 
 	std::vector<Vector3r> & corr_x, 
-	std::vector<Quaternionr> & corr_q
+	std::vector<Quaternionr> & corr_q,
+	const Real refactorizationTolerance
 	)
 {
-	for (int i = 0; i < numberOfIntervals; i++)
+	computeRightHandSide(rodConstraints, rodSegments, RHS, lambdaSums);
+
+	// The intervals contain disjoint sets of constraints, so they can be factorized independently.
+	#pragma omp parallel if(numberOfIntervals > 1) default(shared)
 	{
-		factor(i, rodConstraints, rodSegments, intervals,
-			forward, backward, RHS, lambdaSums, bendingAndTorsionJacobians);
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < numberOfIntervals; i++)
+		{
+			if (needsFactorization(i, intervals, refactorizationTolerance))
+				factor(i, rodSegments, intervals, bendingAndTorsionJacobians);
+		}
 	}
+
+	// Intervals may share segments, so the corrections are determined sequentially.
 	for (int i = 0; i < numberOfIntervals; i++)
 	{
-		solve(i, forward, backward, RHS, lambdaSums, corr_x, corr_q);
+		solve(i, intervals, RHS, lambdaSums, corr_x, corr_q);
 	}
 	return true;
 }
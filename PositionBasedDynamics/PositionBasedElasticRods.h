@@ -28,98 +28,65 @@ namespace PBD
 	/** Node in the simulated tree structure */
 	struct Node {
 		Node() {
-			object = NULL; D = Dinv = J = Matrix6r::Zero(); parent = NULL;
+			object = NULL; D = Dinv = J = Matrix6r::Zero(); parent = -1;
+			childrenStart = childrenEnd = 0;
 			soln.setZero(); index = 0;
 		};
 		bool isconstraint;
 		void *object;
 		Matrix6r D, Dinv, J;
-		std::vector <Node*> children;
-		Node *parent;
+		/** Index of the parent node in the node array of the interval (-1 for the root) */
+		int parent;
+		/** Range [childrenStart, childrenEnd) in the children array of the interval */
+		int childrenStart;
+		int childrenEnd;
 		Vector6r soln;
 		int index;
 		Eigen::LDLT<Matrix6r> DLDLT;
 	};
 
+	/** Index range of constraints which are solved by one tree. The nodes of the tree
+	* are stored contiguously in elimination order: they are sorted by their height
+	* in the tree, so all children of a node precede it and the root is the last node.
+	* Nodes of the same level are independent and are factorized in parallel.
+	*/
 	struct Interval
 	{
+		Interval() { start = 0; end = -1; factorized = false; }
 		int start;
 		int end;
+		std::vector<Node> nodes;
+		/** Indices of the children of all nodes (see Node::childrenStart) */
+		std::vector<int> children;
+		/** Start index of each level in the node array, the last entry is the number of nodes */
+		std::vector<int> levels;
+		/** Rotations of the segment nodes at the time of the last factorization */
+		std::vector<Quaternionr> factorizationRotations;
+		bool factorized;
 	};
 
 	class DirectPositionBasedSolverForStiffRods
 	{
 	private:
 
-		static void initLists(
-			int numberOfIntervals,
-			std::list <Node*> * &forward,
-			std::list <Node*> * &backward,
-			Node* &root);
-
-		/** Returns, whether the passed segment is connected to a constraint in the
-		* passed index range of the entire constraints.
-		*/
-		static bool isSegmentInInterval(
-			RodSegment *segment,
-			int intervalIndex,
-			Interval* intervals,
-			std::vector<RodConstraint*> &rodConstraints,
-			std::vector<RodSegment*> &rodSegments);
-
-		/** Returns, whether the passed constraint is within the passed index range
-		* of the entire constraints.
-		*/
-		static bool isConstraintInInterval(
-			RodConstraint *constraint,
-			int intervalIndex,
-			Interval* intervals,
-			std::vector<RodConstraint*> &rodConstraints);
-
-
-		/** This method recursively visits all segment nodes and inserts constraint nodes between them.
-		*/
-		static void initSegmentNode(
-			Node *n,
-			int intervalIndex,
-			std::vector<RodConstraint*> &rodConstraints,
-			std::vector<RodSegment*> &rodSegments,
-			std::vector <RodConstraint*> &markedConstraints,
-			Interval* intervals);
-
-
-		/** Sorts matrix H.
-		*/
-		static void orderMatrix(
-			Node *n,
-			int intervalIndex,
-			std::list <Node*> * forward,
-			std::list <Node*> * backward);
-
 		/** Initializes the nodes.
 		* The first static node is selected as the root of the tree.
 		* Then, starting from this node, all edges (joints) are followed
-		* and the children and the parent node are saved.
+		* and constraint nodes are inserted between the segment nodes.
+		* Finally, the nodes are sorted by their height in the tree.
 		*/
 		static void initNodes(
 			int intervalIndex,
 			std::vector<RodSegment*> &rodSegments,
-			Node* &root,
 			Interval* intervals,
-			std::vector<RodConstraint*> &rodConstraints,
-			std::list <Node*> * forward,
-			std::list <Node*> * backward,
-			std::vector <RodConstraint*> &markedConstraints);
+			std::vector<RodConstraint*> &rodConstraints);
 
 
 		static void initTree(
 			std::vector<RodConstraint*> &rodConstraints,
 			std::vector<RodSegment*> & rodSegments,
 			Interval* &intervals,
-			int &numberOfIntervals,
-			std::list <Node*> * &forward,
-			std::list <Node*> * &backward,
-			Node* &root
+			int &numberOfIntervals
 			);
 
 
@@ -157,17 +124,30 @@ namespace PBD
 		*/
 		static void getMassMatrix(RodSegment *segment, Matrix6r &M);
 
-		/** Factorizes matrix H and computes the right hand side vector -b.
+		/** Computes the right hand side vector -b and returns the maximal constraint error.
 		*/
-		static Real factor(
-			const int intervalIndex,
+		static Real computeRightHandSide(
 			const std::vector<RodConstraint*> &rodConstraints,
 			std::vector<RodSegment*> & rodSegments,
-			const Interval* &intervals,
-			std::list <Node*> * forward,
-			std::list <Node*> * backward,
 			std::vector<Vector6r> & RHS,
-			std::vector<Vector6r> & lambdaSums,
+			std::vector<Vector6r> & lambdaSums
+			);
+
+		/** Returns true, if the rotation of a segment of the interval differs more than
+		* the passed tolerance from its rotation at the last factorization.
+		*/
+		static bool needsFactorization(
+			const int intervalIndex,
+			const Interval* intervals,
+			const Real refactorizationTolerance
+			);
+
+		/** Factorizes matrix H.
+		*/
+		static void factor(
+			const int intervalIndex,
+			std::vector<RodSegment*> & rodSegments,
+			Interval* intervals,
 			std::vector<std::vector<Matrix3r>> & bendingAndTorsionJacobians
 			);
 
@@ -176,8 +156,7 @@ namespace PBD
 		*/
 		static bool solve(
 			int intervalIndex,
-			std::list <Node*> * forward,
-			std::list <Node*> * backward,
+			Interval* intervals,
 			std::vector<Vector6r> & RHS,
 			std::vector<Vector6r> & lambdaSums,
 			std::vector<Vector3r> & corr_x,
@@ -187,16 +166,15 @@ namespace PBD
 
 		///** Initialize the zero-stretch, bending, and torsion constraints of the rod.
 		//* Computes constraint connectors in segment space, computes the diagonal stiffness matrices
-		//* and the Darboux vectors of the initial state. Initializes the forward and backward lists
-		//* of nodes  for the direct solver\n\n
+		//* and the Darboux vectors of the initial state. Initializes the tree
+		//* of nodes for the direct solver\n\n
 		//*
 		//* @param rodConstraints contains the combined zero-stretch, bending
 		//* and torsion constraints of the rod. The set of constraints must by acyclic.
 		//* @param rodSegments contains the segments of the rod
-		//* @param forward list of nodes in the acyclic tree of rod segments and zero-stretch,
-		//* bending and torsion constraints so that parent nodes occur later in the list than their children
-		//* @param backward list of nodes in the acyclic tree of rod segments and zero-stretch,
-		//* bending and torsion constraints. The reverse of the forward list.
+		//* @param intervals intervals of constraints, each one stores the acyclic tree of rod segments and zero-stretch,
+		//* bending and torsion constraints in elimination order so that parent nodes occur later than their children
+		//* @param numberOfIntervals number of intervals
 		//* @param constraintPositions positions of the rod's constraints in world coordinates
 		//* @param averageRadii the average radii at the constraint positions of the rod. Value in Meters (m)
 		//* @param averageSegmentLengths vector of the average lengths of the two rod segments
@@ -223,9 +201,6 @@ namespace PBD
 			std::vector<RodSegment*> & rodSegments,
 			Interval* &intervals,
 			int &numberOfIntervals,
-			std::list <Node*> * &forward,
-			std::list <Node*> * &backward,
-			Node* &root,
 			const std::vector<Vector3r> &constraintPositions,
 			const std::vector<Real> &averageRadii,
 			const std::vector<Real> &youngsModuli,
@@ -254,19 +229,23 @@ namespace PBD
 		//* @param lambdaSums contains entries of the sum of all lambda updates for
 		//* each constraint in the rod during one time step which is needed by the solver to handle
 		//* compliance in the correct way (cf. the right hand side of eq. 22 in the paper).
+		//* @param intervals intervals of constraints. Their factorizations are invalidated since the compliance changes.
+		//* @param numberOfIntervals number of intervals
 		//*/
 		static bool initBeforeProjection_DirectPositionBasedSolverForStiffRodsConstraint(
 			const std::vector<RodConstraint*> &rodConstraints,
 			const Real inverseTimeStepSize,
-			std::vector<Vector6r> & lambdaSums
+			std::vector<Vector6r> & lambdaSums,
+			Interval* intervals,
+			const int numberOfIntervals
 			);
 
 		///** Determine the position and orientation corrections for all combined zero-stretch, bending and twisting constraints of the rod (eq. 22 in the paper). \n\n
 		//*
 		//* @param rodConstraints contains the combined zero-stretch, bending and torsion constraints of the rod. The set of constraints must by acyclic.
 		//* @param rodSegments contains the segments of the rod
-		//* @param forward list of nodes in the acyclic tree of rod segments and zero-stretch, bending and torsion constraints so that parent nodes occur later in the list than their children
-		//* @param backward list of nodes in the acyclic tree of rod segments and zero-stretch, bending and torsion constraints. The reverse of the forward list.
+		//* @param intervals intervals of constraints, each one stores the acyclic tree of rod segments and zero-stretch, bending and torsion constraints in elimination order
+		//* @param numberOfIntervals number of intervals
 		//* @param RHS vector with entries for each constraint. In concatenation these entries represent the right hand side of the system of equations to be solved. (eq. 22 in the paper)
 		//* @param lambdaSums contains entries of the sum of all lambda updates for
 		//* each constraint in the rod during one time step which is needed by the solver to handle
@@ -277,19 +256,21 @@ namespace PBD
 		//* vector outside of the solve-method avoids repeated reallocation between iterations of the solver		
 		//* @param corr_x vector of position corrections for every segment of the rod (part of delta-x in eq. 22 in the paper)
 		//* @param corr_q vector of rotation corrections for every segment of the rod (part of delta-x in eq. 22 in the paper)
+		//* @param refactorizationTolerance the factorization of an interval is reused as long as no quaternion
+		//* coefficient of its segments changed more than this tolerance since the last factorization.
+		//* A value of 0 refactorizes the system matrix in every iteration.
 		//*/
 		static bool solve_DirectPositionBasedSolverForStiffRodsConstraint(
 			const std::vector<RodConstraint*> &rodConstraints,
 			std::vector<RodSegment*> & rodSegments,
-			const Interval* intervals,
+			Interval* intervals,
 			const int &numberOfIntervals,
-			std::list <Node*> * forward,
-			std::list <Node*> * backward,
 			std::vector<Vector6r> & RHS,
 			std::vector<Vector6r> & lambdaSums,
 			std::vector<std::vector<Matrix3r>> & bendingAndTorsionJacobians,
 			std::vector<Vector3r> & corr_x,
-			std::vector<Quaternionr> & corr_q
+			std::vector<Quaternionr> & corr_q,
+			const Real refactorizationTolerance = 0.0
 			);
 
 		///** Initialize the zero-stretch, bending, and torsion constraint.
@@ -463,6 +444,67 @@ namespace PBD
 			const Vector3r& bendingAndTwistingKs,
 			const Quaternionr& restDarbouxVector,
 			Quaternionr& corrq0, Quaternionr&  corrq1);
+
+		/** Batch version of solve_StretchShearConstraint() for n constraints which share no particles and
+		* no quaternions. Constraint i couples the particles particleIndices[2*i] and particleIndices[2*i+1]
+		* and the quaternion quaternionIndices[i]. The corrections are applied directly, the quaternions
+		* are normalized and particles and quaternions with zero inverse mass are not changed.
+		* The constraints are processed in blocks which are stored as structure of arrays, so that
+		* the lanes of a block can be processed by SIMD instructions.
+		*/
+		static void solve_StretchShearConstraints(
+			const unsigned int n,
+			const unsigned int particleIndices[], const unsigned int quaternionIndices[],
+			Vector3r p[], const Real invMass[],
+			Quaternionr q[], const Real invMassq[],
+			const Vector3r& stretchingAndShearingKs,
+			const Real restLengths[]);
+
+		/** Batch version of solve_BendTwistConstraint() for n constraints which share no quaternions.
+		* Constraint i couples the quaternions quaternionIndices[2*i] and quaternionIndices[2*i+1].
+		* The corrections are applied like in solve_StretchShearConstraints().
+		*/
+		static void solve_BendTwistConstraints(
+			const unsigned int n,
+			const unsigned int quaternionIndices[],
+			Quaternionr q[], const Real invMassq[],
+			const Vector3r& bendingAndTwistingKs,
+			const Quaternionr restDarbouxVectors[]);
+
+		/** Determine the position and orientation corrections for all stretch and shear and all bending and torsion 
+		* constraints of a rod which forms a chain by a direct solve. Particle i and i+1 are the end points of 
+		* edge i and the quaternions i and i+1 are coupled by bend-twist constraint i. The constraints of an 
+		* edge are combined in a block of six rows, so the linearized system is block-tridiagonal and is solved 
+		* in linear time by the block Thomas algorithm. \n\n
+		* The quaternion Jacobians are projected to the tangent space of the unit quaternions, so the 
+		* corrections (followed by a normalization of the quaternions) are a Newton step for the nonlinear 
+		* constraints: with unit stiffness the remaining violation after one solve is quadratic in the 
+		* initial violation. Stiffness values below one scale the constraint violations like the local 
+		* solvers, so the step is damped accordingly. \n\n
+		* The quaternions must be normalized and the rest lengths must be positive. The method returns 
+		* false if the rod has no edge. \n\n
+		*
+		* @param nEdges number of edges of the rod
+		* @param p positions of the nEdges+1 particles
+		* @param invMass inverse masses of the particles
+		* @param q quaternions of the nEdges edges
+		* @param invMassq inverse masses of the quaternions
+		* @param stretchingAndShearingKs stiffness coefficients for stretching and shearing
+		* @param bendingAndTwistingKs stiffness coefficients for bending and twisting
+		* @param restLengths rest lengths of the edges
+		* @param restDarbouxVectors rest Darboux vectors of the nEdges-1 bend-twist constraints
+		* @param corr_p position corrections of the particles
+		* @param corr_q orientation corrections of the quaternions
+		*/
+		static bool solve_StretchShearBendTwistChain(
+			const unsigned int nEdges,
+			const Vector3r p[], const Real invMass[],
+			const Quaternionr q[], const Real invMassq[],
+			const Vector3r& stretchingAndShearingKs,
+			const Vector3r& bendingAndTwistingKs,
+			const Real restLengths[],
+			const Quaternionr restDarbouxVectors[],
+			Vector3r corr_p[], Quaternionr corr_q[]);
 	};
 
 	// Implementation of "Position Based Elastic Rods" paper
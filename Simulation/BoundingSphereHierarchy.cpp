@@ -126,12 +126,12 @@ void TetMeshBSH::updateVertices(const Vector3r* vertices)
 }
 
 
-void BVHTest::traverse(PointCloudBSH const& b1, TetMeshBSH const& b2, TraversalCallback func)
+void BVHTest::traverse(PointCloudBSH const& b1, TetMeshBSH const& b2, TraversalCallback const& func)
 {
 	traverse(b1, 0, b2, 0, func);
 }
 
-void BVHTest::traverse(PointCloudBSH const& b1, const unsigned int node_index1, TetMeshBSH const& b2, const unsigned int node_index2, TraversalCallback func)
+void BVHTest::traverse(PointCloudBSH const& b1, const unsigned int node_index1, TetMeshBSH const& b2, const unsigned int node_index2, TraversalCallback const& func)
 {
 	const BoundingSphere &bs1 = b1.hull(node_index1);
 	const BoundingSphere &bs2 = b2.hull(node_index2);
@@ -60,8 +60,8 @@ namespace PBD
 	public:
 		using TraversalCallback = std::function <void(unsigned int node_index1, unsigned int node_index2)>;
 
-		static void traverse(PointCloudBSH const& b1, TetMeshBSH const& b2, TraversalCallback func);
-		static void traverse(PointCloudBSH const& b1, const unsigned int node_index1, TetMeshBSH const& b2, const unsigned int node_index2, TraversalCallback func);
+		static void traverse(PointCloudBSH const& b1, TetMeshBSH const& b2, TraversalCallback const& func);
+		static void traverse(PointCloudBSH const& b1, const unsigned int node_index1, TetMeshBSH const& b2, const unsigned int node_index2, TraversalCallback const& func);
 	};
 }
 
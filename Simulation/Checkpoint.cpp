@@ -0,0 +1,230 @@
+#include "Checkpoint.h"
+#include "SimulationModel.h"
+#include "TimeManager.h"
+#include "Utils/BinaryReaderWriter.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing.h"
+#include <fstream>
+#include <cstdint>
+
+using namespace PBD;
+using namespace std;
+
+const unsigned int Checkpoint::VERSION = 1;
+
+static const char CHECKPOINT_ID[8] = { 'P', 'B', 'D', 'C', 'H', 'K', 'P', 'T' };
+static const uint32_t CHECKPOINT_COMPRESSED = 1;
+
+void Checkpoint::compress(const std::vector<char> &data, std::vector<char> &result)
+{
+	// Byte shuffle: the i-th bytes of all values of size Real are stored
+	// consecutively, so that the sign and exponent bytes form long runs.
+	const size_t n = data.size();
+	const size_t stride = sizeof(Real);
+	const size_t numValues = n / stride;
+	std::vector<unsigned char> shuffled(n);
+	for (size_t b = 0; b < stride; b++)
+		for (size_t i = 0; i < numValues; i++)
+			shuffled[b * numValues + i] = (unsigned char) data[i * stride + b];
+	for (size_t i = numValues * stride; i < n; i++)
+		shuffled[i] = (unsigned char) data[i];
+
+	// Run-length encoding (PackBits): a control byte c < 128 is followed by c+1 literal
+	// bytes, a control byte c > 128 is followed by one byte which is repeated 257-c times.
+	result.clear();
+	result.reserve(n / 2);
+	size_t i = 0;
+	while (i < n)
+	{
+		size_t run = 1;
+		while ((i + run < n) && (run < 128) && (shuffled[i + run] == shuffled[i]))
+			run++;
+		if (run >= 3)
+		{
+			result.push_back((char)(unsigned char)(257 - run));
+			result.push_back((char)shuffled[i]);
+			i += run;
+		}
+		else
+		{
+			const size_t start = i;
+			size_t length = 0;
+			while ((i < n) && (length < 128))
+			{
+				if ((i + 2 < n) && (shuffled[i] == shuffled[i + 1]) && (shuffled[i] == shuffled[i + 2]))
+					break;
+				i++;
+				length++;
+			}
+			result.push_back((char)(unsigned char)(length - 1));
+			result.insert(result.end(), (const char*)&shuffled[start], (const char*)&shuffled[start] + length);
+		}
+	}
+}
+
+bool Checkpoint::decompress(const std::vector<char> &data, const size_t uncompressedSize, std::vector<char> &result)
+{
+	std::vector<unsigned char> shuffled(uncompressedSize);
+	const unsigned char *in = (const unsigned char*)data.data();
+	const size_t n = data.size();
+	size_t pos = 0;
+	size_t outPos = 0;
+	while (pos < n)
+	{
+		const unsigned int c = in[pos++];
+		if (c < 128)
+		{
+			const size_t length = c + 1;
+			if ((pos + length > n) || (outPos + length > uncompressedSize))
+				return false;
+			memcpy(&shuffled[outPos], &in[pos], length);
+			pos += length;
+			outPos += length;
+		}
+		else if (c > 128)
+		{
+			const size_t length = 257 - c;
+			if ((pos >= n) || (outPos + length > uncompressedSize))
+				return false;
+			memset(&shuffled[outPos], in[pos++], length);
+			outPos += length;
+		}
+		else
+			return false;
+	}
+	if (outPos != uncompressedSize)
+		return false;
+
+	const size_t stride = sizeof(Real);
+	const size_t numValues = uncompressedSize / stride;
+	result.resize(uncompressedSize);
+	for (size_t b = 0; b < stride; b++)
+		for (size_t i = 0; i < numValues; i++)
+			result[i * stride + b] = (char) shuffled[b * numValues + i];
+	for (size_t i = numValues * stride; i < uncompressedSize; i++)
+		result[i] = (char) shuffled[i];
+	return true;
+}
+
+bool Checkpoint::save(const std::string &fileName, SimulationModel &model, const bool compressData)
+{
+	START_TIMING("save checkpoint");
+	Utilities::BinaryWriter binWriter;
+	TimeManager *tm = &model.getTimeManager();
+	binWriter.write(tm->getTime());
+	binWriter.write(tm->getTimeStepSize());
+	model.saveState(binWriter);
+
+	const std::vector<char> &data = binWriter.getBuffer();
+	std::vector<char> compressed;
+	if (compressData)
+		compress(data, compressed);
+	const std::vector<char> &stored = compressData ? compressed : data;
+
+	std::ofstream file(fileName, ios::out | ios::binary);
+	if (!file.is_open())
+	{
+		LOG_ERR << "Cannot open the checkpoint file " << fileName;
+		STOP_TIMING_AVG;
+		return false;
+	}
+	const uint32_t version = VERSION;
+	const uint32_t flags = compressData ? CHECKPOINT_COMPRESSED : 0;
+	const uint32_t realSize = sizeof(Real);
+	const uint64_t dataSize = data.size();
+	const uint64_t storedSize = stored.size();
+	file.write(CHECKPOINT_ID, sizeof(CHECKPOINT_ID));
+	file.write((const char*)&version, sizeof(uint32_t));
+	file.write((const char*)&flags, sizeof(uint32_t));
+	file.write((const char*)&realSize, sizeof(uint32_t));
+	file.write((const char*)&dataSize, sizeof(uint64_t));
+	file.write((const char*)&storedSize, sizeof(uint64_t));
+	file.write(stored.data(), stored.size());
+	const bool res = file.good();
+	file.close();
+	if (!res)
+		LOG_ERR << "Cannot write the checkpoint file " << fileName;
+	STOP_TIMING_AVG;
+	return res;
+}
+
+bool Checkpoint::load(const std::string &fileName, SimulationModel &model)
+{
+	START_TIMING("load checkpoint");
+	std::ifstream file(fileName, ios::in | ios::binary);
+	if (!file.is_open())
+	{
+		LOG_ERR << "Cannot open the checkpoint file " << fileName;
+		STOP_TIMING_AVG;
+		return false;
+	}
+
+	char id[sizeof(CHECKPOINT_ID)];
+	uint32_t version = 0;
+	uint32_t flags = 0;
+	uint32_t realSize = 0;
+	uint64_t dataSize = 0;
+	uint64_t storedSize = 0;
+	file.read(id, sizeof(CHECKPOINT_ID));
+	file.read((char*)&version, sizeof(uint32_t));
+	file.read((char*)&flags, sizeof(uint32_t));
+	file.read((char*)&realSize, sizeof(uint32_t));
+	file.read((char*)&dataSize, sizeof(uint64_t));
+	file.read((char*)&storedSize, sizeof(uint64_t));
+	if (!file.good() || (memcmp(id, CHECKPOINT_ID, sizeof(CHECKPOINT_ID)) != 0))
+	{
+		LOG_ERR << "The file " << fileName << " is not a checkpoint.";
+		STOP_TIMING_AVG;
+		return false;
+	}
+	if (version > VERSION)
+	{
+		LOG_ERR << "The checkpoint " << fileName << " has version " << version << ", supported is version " << VERSION << ".";
+		STOP_TIMING_AVG;
+		return false;
+	}
+	if (realSize != sizeof(Real))
+	{
+		LOG_ERR << "The checkpoint " << fileName << " was written with a different floating point precision.";
+		STOP_TIMING_AVG;
+		return false;
+	}
+
+	std::vector<char> stored((size_t) storedSize);
+	file.read(stored.data(), stored.size());
+	if (!file.good())
+	{
+		LOG_ERR << "The checkpoint " << fileName << " is truncated.";
+		STOP_TIMING_AVG;
+		return false;
+	}
+	file.close();
+
+	std::vector<char> decompressed;
+	if (flags & CHECKPOINT_COMPRESSED)
+	{
+		if (!decompress(stored, (size_t) dataSize, decompressed))
+		{
+			LOG_ERR << "The checkpoint " << fileName << " is corrupt.";
+			STOP_TIMING_AVG;
+			return false;
+		}
+	}
+	const std::vector<char> &data = (flags & CHECKPOINT_COMPRESSED) ? decompressed : stored;
+
+	Utilities::BinaryReader binReader(data.data(), data.size());
+	Real time, h;
+	binReader.read(time);
+	binReader.read(h);
+	if (binReader.hasError() || !model.loadState(binReader))
+	{
+		LOG_ERR << "Cannot restore the checkpoint " << fileName;
+		STOP_TIMING_AVG;
+		return false;
+	}
+	TimeManager *tm = &model.getTimeManager();
+	tm->setTime(time);
+	tm->setTimeStepSize(h);
+	STOP_TIMING_AVG;
+	return true;
+}
@@ -0,0 +1,43 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "Common/Common.h"
+#include <string>
+#include <vector>
+
+namespace PBD
+{
+	class SimulationModel;
+
+	/** \brief Binary checkpoint of the complete simulation state.
+	*
+	* A checkpoint contains the time and the time step size of the model and the dynamic state of
+	* the model: particles, orientations, rigid bodies, the state of the
+	* constraints (Lagrange multipliers, motor targets) and the contacts which
+	* are used in the next time step. The static data (meshes, rest shapes,
+	* parameters) is not stored. Therefore, a checkpoint can only be loaded into
+	* a model which was created from the same scene.
+	*
+	* The arrays are written with a single memory copy each. Optionally the data
+	* is compressed by a byte shuffle followed by a run-length encoding, which is
+	* effective for arrays with many equal values (e.g. static particles, zero
+	* accelerations) and costs only a linear pass over the data.
+	*/
+	class Checkpoint
+	{
+	protected:
+		static void compress(const std::vector<char> &data, std::vector<char> &result);
+		static bool decompress(const std::vector<char> &data, const size_t uncompressedSize, std::vector<char> &result);
+
+	public:
+		static const unsigned int VERSION;
+
+		/** Write the state of the simulation to a file. */
+		static bool save(const std::string &fileName, SimulationModel &model, const bool compressData = false);
+		/** Restore the state of the simulation from a file. If the checkpoint
+		* does not match the model, false is returned. */
+		static bool load(const std::string &fileName, SimulationModel &model);
+	};
+}
+
+#endif
@@ -1,17 +1,26 @@
 #include "CollisionDetection.h"
 #include "Simulation/IDFactory.h"
+#include "Utils/ScratchArena.h"
+#include "omp.h"
 
 using namespace PBD;
 using namespace Utilities;
 using namespace GenParam;
 
 int CollisionDetection::CONTACT_TOLERANCE = -1;
+int CollisionDetection::CONTINUOUS_COLLISION_DETECTION = -1;
+int CollisionDetection::CCD_MOTION_THRESHOLD = -1;
+int CollisionDetection::CLOTH_COLLISIONS = -1;
+int CollisionDetection::CLOTH_THICKNESS = -1;
+int CollisionDetection::SUBSTEP_COLLISION_DETECTION = -1;
 
 int CollisionDetection::CollisionObjectWithoutGeometry::TYPE_ID = IDFactory::getId();
 const unsigned int CollisionDetection::RigidBodyContactType = 0;
 const unsigned int CollisionDetection::ParticleContactType = 1;
 const unsigned int CollisionDetection::ParticleRigidBodyContactType = 2;
 const unsigned int CollisionDetection::ParticleSolidContactType = 3;
+const unsigned int CollisionDetection::TrianglePointContactType = 4;
+const unsigned int CollisionDetection::EdgeEdgeContactType = 5;
 
 const unsigned int CollisionDetection::CollisionObject::RigidBodyCollisionObjectType = 0;
 const unsigned int CollisionDetection::CollisionObject::TriangleModelCollisionObjectType = 1;
@@ -22,7 +31,13 @@ CollisionDetection::CollisionDetection() : m_collisionObjects()
 	m_collisionObjects.reserve(1000);
 	m_contactCB = NULL;
 	m_solidContactCB = NULL;
+	m_clothContactCB = NULL;
 	m_tolerance = static_cast<Real>(0.01);
+	m_continuousCollisionDetection = false;
+	m_ccdMotionThreshold = static_cast<Real>(0.1);
+	m_clothCollisions = false;
+	m_clothThickness = static_cast<Real>(0.01);
+	m_substepCollisionDetection = false;
 }
 
 CollisionDetection::~CollisionDetection()
@@ -44,6 +59,28 @@ void CollisionDetection::initParameters()
 	setGroup(CONTACT_TOLERANCE, "Simulation|Contact");
 	setDescription(CONTACT_TOLERANCE, "Tolerance of the collision detection");
 	static_cast<NumericParameter<Real>*>(getParameter(CONTACT_TOLERANCE))->setMinValue(0.0);
+
+	CONTINUOUS_COLLISION_DETECTION = createBoolParameter("continuousCollisionDetection", "Continuous collision detection", &m_continuousCollisionDetection);
+	setGroup(CONTINUOUS_COLLISION_DETECTION, "Simulation|Contact");
+	setDescription(CONTINUOUS_COLLISION_DETECTION, "Sweep fast bodies and particles to prevent tunneling.");
+
+	CCD_MOTION_THRESHOLD = createNumericParameter("ccdMotionThreshold", "CCD motion threshold", &m_ccdMotionThreshold);
+	setGroup(CCD_MOTION_THRESHOLD, "Simulation|Contact");
+	setDescription(CCD_MOTION_THRESHOLD, "Only bodies and particles which move more than this distance in a time step are swept.");
+	static_cast<NumericParameter<Real>*>(getParameter(CCD_MOTION_THRESHOLD))->setMinValue(0.0);
+
+	CLOTH_COLLISIONS = createBoolParameter("clothCollisions", "Cloth collisions", &m_clothCollisions);
+	setGroup(CLOTH_COLLISIONS, "Simulation|Contact");
+	setDescription(CLOTH_COLLISIONS, "Collisions of cloth with itself and with other cloth models.");
+
+	CLOTH_THICKNESS = createNumericParameter("clothThickness", "Cloth thickness", &m_clothThickness);
+	setGroup(CLOTH_THICKNESS, "Simulation|Contact");
+	setDescription(CLOTH_THICKNESS, "Distance which is kept between cloth particles and triangles. It should be smaller than the edge length.");
+	static_cast<NumericParameter<Real>*>(getParameter(CLOTH_THICKNESS))->setMinValue(0.0);
+
+	SUBSTEP_COLLISION_DETECTION = createBoolParameter("substepCollisionDetection", "Substep collision detection", &m_substepCollisionDetection);
+	setGroup(SUBSTEP_COLLISION_DETECTION, "Simulation|Contact");
+	setDescription(SUBSTEP_COLLISION_DETECTION, "Update the contacts after each substep. The collision pairs are determined once per time step.");
 }
 
 void CollisionDetection::cleanup()
@@ -53,6 +90,27 @@ void CollisionDetection::cleanup()
 	m_collisionObjects.clear();
 }
 
+void CollisionDetection::initContinuousCollisionDetection(SimulationModel &model)
+{
+	if (!m_continuousCollisionDetection)
+		return;
+
+	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
+	const ParticleData &pd = model.getParticles();
+
+	m_startX.resize(rigidBodies.size());
+	m_startQ.resize(rigidBodies.size());
+	for (unsigned int i = 0; i < rigidBodies.size(); i++)
+	{
+		m_startX[i] = rigidBodies[i]->getPosition();
+		m_startQ[i] = rigidBodies[i]->getRotation();
+	}
+
+	m_startParticleX.resize(pd.size());
+	for (unsigned int i = 0; i < pd.size(); i++)
+		m_startParticleX[i] = pd.getPosition(i);
+}
+
 void CollisionDetection::addRigidBodyContact(const unsigned int rbIndex1, const unsigned int rbIndex2,
 											 const Vector3r &cp1, const Vector3r &cp2,
 											 const Vector3r &normal, const Real dist,
@@ -79,6 +137,15 @@ void CollisionDetection::addParticleSolidContact(const unsigned int particleInde
 		m_solidContactCB(ParticleSolidContactType, particleIndex, solidIndex, tetIndex, bary, cp1, cp2, normal, dist, restitutionCoeff, frictionCoeff, m_contactCBUserData);
 }
 
+void CollisionDetection::addClothContact(const unsigned int contactType,
+										 const unsigned int particleIndex0, const unsigned int particleIndex1,
+										 const unsigned int particleIndex2, const unsigned int particleIndex3,
+										 const Real thickness)
+{
+	if (m_clothContactCB)
+		m_clothContactCB(contactType, particleIndex0, particleIndex1, particleIndex2, particleIndex3, thickness, m_clothContactCBUserData);
+}
+
 void CollisionDetection::addCollisionObject(const unsigned int bodyIndex, const unsigned int bodyType)
 {
 	CollisionObjectWithoutGeometry *co = new CollisionObjectWithoutGeometry();
@@ -99,6 +166,12 @@ void CollisionDetection::setSolidContactCallback(CollisionDetection::SolidContac
 	m_solidContactCBUserData = userData;
 }
 
+void CollisionDetection::setClothContactCallback(CollisionDetection::ClothContactCallbackFunction val, void *userData)
+{
+	m_clothContactCB = val;
+	m_clothContactCBUserData = userData;
+}
+
 void CollisionDetection::updateAABBs(SimulationModel &model)
 {
 	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
@@ -123,14 +196,9 @@ void CollisionDetection::updateAABB(SimulationModel &model, CollisionDetection::
 	{
 		const unsigned int rbIndex = co->m_bodyIndex;
 		RigidBody *rb = rigidBodies[rbIndex];
-		const VertexData &vd = rb->getGeometry().getVertexData();
-
-		co->m_aabb.m_p[0] = vd.getPosition(0);
-		co->m_aabb.m_p[1] = vd.getPosition(0);
-		for (unsigned int j = 1; j < vd.size(); j++)
-		{
-			updateAABB(vd.getPosition(j), co->m_aabb);
-		}
+		// transform the bounding box of the local vertices instead of 
+		// the vertices since the world space geometry is updated lazily
+		rb->getGeometry().getWorldBounds(co->m_aabb.m_p[0], co->m_aabb.m_p[1]);
 	}
 	else if (co->m_bodyType == CollisionDetection::CollisionObject::TriangleModelCollisionObjectType)
 	{
@@ -187,3 +255,741 @@ void CollisionDetection::updateAABB(const Vector3r &p, AABB &aabb)
 	if (aabb.m_p[1][2] < p[2])
 		aabb.m_p[1][2] = p[2];
 }
+
+/** Closest point on the triangle (a, b, c) to the point p */
+static Vector3r closestPointOnTriangle(const Vector3r &p, const Vector3r &a, const Vector3r &b, const Vector3r &c)
+{
+	const Vector3r ab = b - a;
+	const Vector3r ac = c - a;
+	const Vector3r ap = p - a;
+	const Real d1 = ab.dot(ap);
+	const Real d2 = ac.dot(ap);
+	if ((d1 <= 0.0) && (d2 <= 0.0))
+		return a;
+
+	const Vector3r bp = p - b;
+	const Real d3 = ab.dot(bp);
+	const Real d4 = ac.dot(bp);
+	if ((d3 >= 0.0) && (d4 <= d3))
+		return b;
+
+	const Real vc = d1 * d4 - d3 * d2;
+	if ((vc <= 0.0) && (d1 >= 0.0) && (d3 <= 0.0))
+		return a + (d1 / (d1 - d3)) * ab;
+
+	const Vector3r cp = p - c;
+	const Real d5 = ab.dot(cp);
+	const Real d6 = ac.dot(cp);
+	if ((d6 >= 0.0) && (d5 <= d6))
+		return c;
+
+	const Real vb = d5 * d2 - d1 * d6;
+	if ((vb <= 0.0) && (d2 >= 0.0) && (d6 <= 0.0))
+		return a + (d2 / (d2 - d6)) * ac;
+
+	const Real va = d3 * d6 - d5 * d4;
+	if ((va <= 0.0) && ((d4 - d3) >= 0.0) && ((d5 - d6) >= 0.0))
+		return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+
+	const Real denom = static_cast<Real>(1.0) / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/** Squared distance between the segments (p0, p1) and (q0, q1) */
+static Real segmentSegmentDistance2(const Vector3r &p0, const Vector3r &p1, const Vector3r &q0, const Vector3r &q1)
+{
+	const Real eps = static_cast<Real>(1.0e-12);
+	const Vector3r d1 = p1 - p0;
+	const Vector3r d2 = q1 - q0;
+	const Vector3r r = p0 - q0;
+	const Real a = d1.squaredNorm();
+	const Real e = d2.squaredNorm();
+	const Real f = d2.dot(r);
+	Real s, t;
+	if ((a <= eps) && (e <= eps))
+		return r.squaredNorm();
+	if (a <= eps)
+	{
+		s = 0.0;
+		t = std::min(std::max(f / e, static_cast<Real>(0.0)), static_cast<Real>(1.0));
+	}
+	else
+	{
+		const Real c = d1.dot(r);
+		if (e <= eps)
+		{
+			t = 0.0;
+			s = std::min(std::max(-c / a, static_cast<Real>(0.0)), static_cast<Real>(1.0));
+		}
+		else
+		{
+			const Real b = d1.dot(d2);
+			const Real denom = a * e - b * b;
+			if (denom != 0.0)
+				s = std::min(std::max((b * f - c * e) / denom, static_cast<Real>(0.0)), static_cast<Real>(1.0));
+			else
+				s = 0.0;
+			t = (b * s + f) / e;
+			if (t < 0.0)
+			{
+				t = 0.0;
+				s = std::min(std::max(-c / a, static_cast<Real>(0.0)), static_cast<Real>(1.0));
+			}
+			else if (t > 1.0)
+			{
+				t = 1.0;
+				s = std::min(std::max((b - c) / a, static_cast<Real>(0.0)), static_cast<Real>(1.0));
+			}
+		}
+	}
+	return ((p0 + s * d1) - (q0 + t * d2)).squaredNorm();
+}
+
+/** Spatial hash of the bounding boxes of primitives. The primitives are 
+* stored per hash cell in a compressed array. */
+struct PrimitiveSpatialHash
+{
+	Real m_invCellSize;
+	unsigned int m_tableSize;
+	ScratchVector<AABB> m_aabbs;
+	ScratchVector<unsigned int> m_start;
+	ScratchVector<unsigned int> m_entries;
+
+	FORCE_INLINE void cell(const Vector3r &x, Eigen::Vector3i &c) const
+	{
+		c = (x * m_invCellSize).array().floor().template cast<int>();
+	}
+
+	FORCE_INLINE unsigned int hash(const int x, const int y, const int z) const
+	{
+		return (((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u)) % m_tableSize;
+	}
+
+	void build(const Real cellSize)
+	{
+		m_invCellSize = static_cast<Real>(1.0) / cellSize;
+		m_tableSize = 2 * (unsigned int)m_aabbs.size() + 1;
+		m_start.assign(m_tableSize + 1, 0);
+
+		Eigen::Vector3i c0, c1;
+		for (unsigned int i = 0; i < m_aabbs.size(); i++)
+		{
+			cell(m_aabbs[i].m_p[0], c0);
+			cell(m_aabbs[i].m_p[1], c1);
+			for (int x = c0[0]; x <= c1[0]; x++)
+				for (int y = c0[1]; y <= c1[1]; y++)
+					for (int z = c0[2]; z <= c1[2]; z++)
+						m_start[hash(x, y, z) + 1]++;
+		}
+		for (unsigned int i = 0; i < m_tableSize; i++)
+			m_start[i + 1] += m_start[i];
+
+		m_entries.resize(m_start[m_tableSize]);
+		ScratchVector<unsigned int> pos(m_start.begin(), m_start.end() - 1);
+		for (unsigned int i = 0; i < m_aabbs.size(); i++)
+		{
+			cell(m_aabbs[i].m_p[0], c0);
+			cell(m_aabbs[i].m_p[1], c1);
+			for (int x = c0[0]; x <= c1[0]; x++)
+				for (int y = c0[1]; y <= c1[1]; y++)
+					for (int z = c0[2]; z <= c1[2]; z++)
+						m_entries[pos[hash(x, y, z)]++] = i;
+		}
+	}
+
+	/** Call f for each primitive whose bounding box intersects the given one. */
+	template<typename F>
+	void query(const AABB &aabb, F f) const
+	{
+		Eigen::Vector3i c0, c1, c;
+		cell(aabb.m_p[0], c0);
+		cell(aabb.m_p[1], c1);
+		for (int x = c0[0]; x <= c1[0]; x++)
+			for (int y = c0[1]; y <= c1[1]; y++)
+				for (int z = c0[2]; z <= c1[2]; z++)
+				{
+					const unsigned int h = hash(x, y, z);
+					for (unsigned int k = m_start[h]; k < m_start[h + 1]; k++)
+					{
+						const unsigned int i = m_entries[k];
+						if (!AABB::intersection(aabb, m_aabbs[i]))
+							continue;
+						// report a pair only in the cell which contains the minimum of the intersection
+						cell(aabb.m_p[0].cwiseMax(m_aabbs[i].m_p[0]), c);
+						if ((c[0] != x) || (c[1] != y) || (c[2] != z))
+							continue;
+						f(i);
+					}
+				}
+	}
+};
+
+/** Particle indices of the triangles, edges and vertices of all triangle models 
+* which are collision objects and the index of the model of each particle. */
+static void getClothPrimitives(const std::vector<CollisionDetection::CollisionObject*> &collisionObjects, 
+	const SimulationModel::TriangleModelVector &triModels, ScratchVector<unsigned int> &triangles, 
+	ScratchVector<unsigned int> &edges, ScratchVector<unsigned int> &vertices, ScratchVector<unsigned int> &modelIndex)
+{
+	for (unsigned int i = 0; i < collisionObjects.size(); i++)
+	{
+		CollisionDetection::CollisionObject *co = collisionObjects[i];
+		if (co->m_bodyType != CollisionDetection::CollisionObject::TriangleModelCollisionObjectType)
+			continue;
+
+		TriangleModel *tm = triModels[co->m_bodyIndex];
+		const unsigned int offset = tm->getIndexOffset();
+		const IndexedFaceMesh &mesh = tm->getParticleMesh();
+		const IndexedFaceMesh::Faces &faces = mesh.getFaces();
+		for (unsigned int j = 0; j < faces.size(); j++)
+			triangles.push_back(faces[j] + offset);
+		const IndexedFaceMesh::Edges &meshEdges = mesh.getEdges();
+		for (unsigned int j = 0; j < meshEdges.size(); j++)
+		{
+			edges.push_back(meshEdges[j].m_vert[0] + offset);
+			edges.push_back(meshEdges[j].m_vert[1] + offset);
+		}
+		for (unsigned int j = 0; j < mesh.numVertices(); j++)
+		{
+			vertices.push_back(j + offset);
+			modelIndex[j + offset] = co->m_bodyIndex;
+		}
+	}
+}
+
+void CollisionDetection::clothCollisionDetection(SimulationModel &model)
+{
+	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
+	const ParticleData &pd = model.getParticles();
+
+	// triangles, edges and vertices of all triangle models which are collision objects
+	// the temporary buffers are taken from the scratch arena of the thread
+	ScratchArena::Scope scope;
+	ScratchVector<unsigned int> triangles;
+	ScratchVector<unsigned int> edges;
+	ScratchVector<unsigned int> vertices;
+	ScratchVector<unsigned int> modelIndex(pd.size(), 0xffffffff);
+	getClothPrimitives(m_collisionObjects, triModels, triangles, edges, vertices, modelIndex);
+	if (triangles.size() == 0)
+		return;
+
+	// Contacts are generated up to the contact tolerance since they are 
+	// resolved in the following time step.
+	const Real maxDist = m_clothThickness + m_tolerance;
+	const Real maxDist2 = maxDist * maxDist;
+	const Vector3r maxDistVec(maxDist, maxDist, maxDist);
+
+	const int numTriangles = (int)triangles.size() / 3;
+	const int numEdges = (int)edges.size() / 2;
+	const int numVertices = (int)vertices.size();
+
+	PrimitiveSpatialHash triangleHash, edgeHash;
+	triangleHash.m_aabbs.resize(numTriangles);
+	edgeHash.m_aabbs.resize(numEdges);
+	Real edgeLength = 0.0;
+
+	#pragma omp parallel if(numEdges > MIN_PARALLEL_SIZE) default(shared)
+	{
+		#pragma omp for schedule(static) nowait
+		for (int i = 0; i < numTriangles; i++)
+		{
+			AABB &aabb = triangleHash.m_aabbs[i];
+			aabb.m_p[0] = pd.getPosition(triangles[3 * i]);
+			aabb.m_p[1] = aabb.m_p[0];
+			updateAABB(pd.getPosition(triangles[3 * i + 1]), aabb);
+			updateAABB(pd.getPosition(triangles[3 * i + 2]), aabb);
+			aabb.m_p[0] -= maxDistVec;
+			aabb.m_p[1] += maxDistVec;
+		}
+
+		#pragma omp for schedule(static) reduction(+:edgeLength)
+		for (int i = 0; i < numEdges; i++)
+		{
+			const Vector3r &x0 = pd.getPosition(edges[2 * i]);
+			const Vector3r &x1 = pd.getPosition(edges[2 * i + 1]);
+			AABB &aabb = edgeHash.m_aabbs[i];
+			aabb.m_p[0] = x0.cwiseMin(x1) - maxDistVec;
+			aabb.m_p[1] = x0.cwiseMax(x1) + maxDistVec;
+			edgeLength += (x1 - x0).norm();
+		}
+	}
+
+	// the cell size is the average edge length
+	const Real cellSize = std::max((numEdges > 0) ? edgeLength / (Real)numEdges : static_cast<Real>(0.0), static_cast<Real>(2.0) * maxDist);
+	triangleHash.build(cellSize);
+	edgeHash.build(cellSize);
+
+	std::vector<std::vector<ClothContactData> > &contacts_mt = m_clothContacts_mt;
+#ifdef _DEBUG
+	const unsigned int maxThreads = 1;
+#else
+	const unsigned int maxThreads = omp_get_max_threads();
+#endif
+	contacts_mt.resize(maxThreads);
+	for (unsigned int i = 0; i < maxThreads; i++)
+		contacts_mt[i].clear();
+
+	#pragma omp parallel if(numEdges > MIN_PARALLEL_SIZE) default(shared)
+	{
+#ifdef _DEBUG
+		const int tid = 0;
+#else
+		const int tid = omp_get_thread_num();
+#endif
+		std::size_t numTests = 0;
+
+		// point-triangle contacts
+		#pragma omp for schedule(static) nowait
+		for (int i = 0; i < numVertices; i++)
+		{
+			const unsigned int v = vertices[i];
+			const Vector3r &x = pd.getPosition(v);
+			AABB aabb;
+			aabb.m_p[0] = x;
+			aabb.m_p[1] = x;
+			triangleHash.query(aabb, [&](const unsigned int t)
+			{
+				const unsigned int a = triangles[3 * t];
+				const unsigned int b = triangles[3 * t + 1];
+				const unsigned int c = triangles[3 * t + 2];
+				if ((v == a) || (v == b) || (v == c))
+					return;
+				if ((pd.getInvMass(v) == 0.0) && (pd.getInvMass(a) == 0.0) && (pd.getInvMass(b) == 0.0) && (pd.getInvMass(c) == 0.0))
+					return;
+
+				numTests++;
+				const Vector3r cp = closestPointOnTriangle(x, pd.getPosition(a), pd.getPosition(b), pd.getPosition(c));
+				if ((x - cp).squaredNorm() >= maxDist2)
+					return;
+
+				// neighbors in the rest state of a cloth model are ignored
+				if (modelIndex[v] == modelIndex[a])
+				{
+					const Vector3r &x0 = pd.getPosition0(v);
+					const Vector3r cp0 = closestPointOnTriangle(x0, pd.getPosition0(a), pd.getPosition0(b), pd.getPosition0(c));
+					if ((x0 - cp0).squaredNorm() < maxDist2)
+						return;
+				}
+				contacts_mt[tid].push_back({ TrianglePointContactType, { v, a, b, c } });
+			});
+		}
+
+		// edge-edge contacts
+		#pragma omp for schedule(static)
+		for (int i = 0; i < numEdges; i++)
+		{
+			const unsigned int a = edges[2 * i];
+			const unsigned int b = edges[2 * i + 1];
+			const Vector3r &xa = pd.getPosition(a);
+			const Vector3r &xb = pd.getPosition(b);
+			AABB aabb;
+			aabb.m_p[0] = xa.cwiseMin(xb);
+			aabb.m_p[1] = xa.cwiseMax(xb);
+			edgeHash.query(aabb, [&](const unsigned int e)
+			{
+				// each pair is tested once
+				if (e <= (unsigned int)i)
+					return;
+				const unsigned int c = edges[2 * e];
+				const unsigned int d = edges[2 * e + 1];
+				if ((a == c) || (a == d) || (b == c) || (b == d))
+					return;
+				if ((pd.getInvMass(a) == 0.0) && (pd.getInvMass(b) == 0.0) && (pd.getInvMass(c) == 0.0) && (pd.getInvMass(d) == 0.0))
+					return;
+
+				numTests++;
+				if (segmentSegmentDistance2(xa, xb, pd.getPosition(c), pd.getPosition(d)) >= maxDist2)
+					return;
+
+				if (modelIndex[a] == modelIndex[c])
+				{
+					if (segmentSegmentDistance2(pd.getPosition0(a), pd.getPosition0(b), pd.getPosition0(c), pd.getPosition0(d)) < maxDist2)
+						return;
+				}
+				contacts_mt[tid].push_back({ EdgeEdgeContactType, { a, b, c, d } });
+			});
+		}
+
+		#pragma omp atomic
+		m_statistics.m_numClothPrimitiveTests += numTests;
+	}
+
+	for (unsigned int i = 0; i < contacts_mt.size(); i++)
+	{
+		for (unsigned int j = 0; j < contacts_mt[i].size(); j++)
+		{
+			const ClothContactData &cc = contacts_mt[i][j];
+			addClothContact(cc.m_type, cc.m_index[0], cc.m_index[1], cc.m_index[2], cc.m_index[3], m_clothThickness);
+		}
+	}
+}
+
+/** Roots of the cubic polynomial c[0] + c[1] t + c[2] t^2 + c[3] t^3 in [0, 1] 
+* in ascending order. The interval is split at the extrema of the polynomial 
+* and each part with a sign change is bisected. */
+static unsigned int cubicRoots(const Real c[4], Real roots[3])
+{
+	auto f = [&](const Real t) { return ((c[3] * t + c[2]) * t + c[1]) * t + c[0]; };
+
+	// extrema, i.e. roots of the derivative a t^2 + b t + c[1]
+	Real bounds[4];
+	unsigned int numBounds = 0;
+	bounds[numBounds++] = 0.0;
+	const Real a = static_cast<Real>(3.0) * c[3];
+	const Real b = static_cast<Real>(2.0) * c[2];
+	const Real disc = b * b - static_cast<Real>(4.0) * a * c[1];
+	if ((a != 0.0) && (disc >= 0.0))
+	{
+		const Real q = static_cast<Real>(-0.5) * (b + ((b >= 0.0) ? sqrt(disc) : -sqrt(disc)));
+		Real t0 = q / a;
+		Real t1 = (q != 0.0) ? c[1] / q : t0;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if ((t0 > 0.0) && (t0 < 1.0))
+			bounds[numBounds++] = t0;
+		if ((t1 > 0.0) && (t1 < 1.0) && (t1 != t0))
+			bounds[numBounds++] = t1;
+	}
+	else if ((a == 0.0) && (b != 0.0))
+	{
+		const Real t0 = -c[1] / b;
+		if ((t0 > 0.0) && (t0 < 1.0))
+			bounds[numBounds++] = t0;
+	}
+	bounds[numBounds++] = 1.0;
+
+	unsigned int numRoots = 0;
+	for (unsigned int i = 0; i + 1 < numBounds; i++)
+	{
+		Real t0 = bounds[i];
+		Real t1 = bounds[i + 1];
+		Real f0 = f(t0);
+		const Real f1 = f(t1);
+		if (f0 == 0.0)
+		{
+			if ((numRoots == 0) || (roots[numRoots - 1] != t0))
+				roots[numRoots++] = t0;
+			continue;
+		}
+		if (f0 * f1 > 0.0)
+			continue;
+		if (f1 == 0.0)
+		{
+			roots[numRoots++] = t1;
+			continue;
+		}
+		for (unsigned int iter = 0; iter < 50; iter++)
+		{
+			const Real tm = static_cast<Real>(0.5) * (t0 + t1);
+			const Real fm = f(tm);
+			if (f0 * fm <= 0.0)
+				t1 = tm;
+			else
+			{
+				t0 = tm;
+				f0 = fm;
+			}
+		}
+		roots[numRoots++] = t1;
+	}
+	return numRoots;
+}
+
+/** Determine if two primitives with the vertices x0[i] at the beginning of the step 
+* which move linearly to x1[i] touch each other. This can only happen when the four 
+* vertices are coplanar, i.e. at a root of the cubic polynomial 
+* (x[1]-x[0]) x (x[2]-x[0]) . (x[3]-x[0]). At each root the distance of the primitives 
+* is checked. If they touch, toi is set to a time before the impact at which the 
+* distance is at least half the given clearance. */
+template<typename DistanceFct>
+static bool sweepPrimitives(const Vector3r x0[4], const Vector3r x1[4], const Real eta, const Real clearance, DistanceFct distance, Real &toi)
+{
+	Vector3r x[4];
+	auto positions = [&](const Real t)
+	{
+		for (unsigned int i = 0; i < 4; i++)
+			x[i] = x0[i] + t * (x1[i] - x0[i]);
+	};
+
+	// contacts at the beginning of the step are handled by the discrete collision detection
+	const Real d0 = distance(x0);
+	if (d0 < eta)
+		return false;
+
+	const Vector3r u1 = x0[1] - x0[0];
+	const Vector3r u2 = x0[2] - x0[0];
+	const Vector3r u3 = x0[3] - x0[0];
+	const Vector3r v1 = (x1[1] - x1[0]) - u1;
+	const Vector3r v2 = (x1[2] - x1[0]) - u2;
+	const Vector3r v3 = (x1[3] - x1[0]) - u3;
+	const Vector3r n0 = u1.cross(u2);
+	const Vector3r n1 = u1.cross(v2) + v1.cross(u2);
+	const Vector3r n2 = v1.cross(v2);
+	const Real c[4] = { n0.dot(u3), n1.dot(u3) + n0.dot(v3), n2.dot(u3) + n1.dot(v3), n2.dot(v3) };
+
+	Real roots[3];
+	const unsigned int numRoots = cubicRoots(c, roots);
+	unsigned int i = 0;
+	for (; i < numRoots; i++)
+	{
+		positions(roots[i]);
+		if (distance(x) < eta)
+			break;
+	}
+	if (i == numRoots)
+		return false;
+
+	// step back from the impact until the primitives are separated
+	const Real delta = static_cast<Real>(0.5) * std::min(d0, clearance);
+	toi = 0.0;
+	for (Real s = static_cast<Real>(1.0 / 1024.0); s < 1.0; s *= 2.0)
+	{
+		const Real t = roots[i] * (static_cast<Real>(1.0) - s);
+		positions(t);
+		if (distance(x) >= delta)
+		{
+			toi = t;
+			break;
+		}
+	}
+	return true;
+}
+
+void CollisionDetection::clothContinuousCollisionDetection(SimulationModel &model)
+{
+	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
+	ParticleData &pd = model.getParticles();
+
+	ScratchArena::Scope scope;
+	ScratchVector<unsigned int> triangles;
+	ScratchVector<unsigned int> edges;
+	ScratchVector<unsigned int> vertices;
+	ScratchVector<unsigned int> modelIndex(pd.size(), 0xffffffff);
+	getClothPrimitives(m_collisionObjects, triModels, triangles, edges, vertices, modelIndex);
+	if (triangles.size() == 0)
+		return;
+
+	const int numTriangles = (int)triangles.size() / 3;
+	const int numEdges = (int)edges.size() / 2;
+	const int numVertices = (int)vertices.size();
+
+	// only pairs with a fast particle are swept
+	ScratchVector<char> fast(pd.size(), 0);
+	bool anyFast = false;
+	for (int i = 0; i < numVertices; i++)
+	{
+		const unsigned int v = vertices[i];
+		if ((pd.getPosition(v) - m_startParticleX[v]).norm() > m_ccdMotionThreshold)
+		{
+			fast[v] = 1;
+			anyFast = true;
+		}
+	}
+	if (!anyFast)
+		return;
+
+	// primitives closer than eta touch, neighbors in the rest state are ignored
+	const Real eta = std::max(static_cast<Real>(0.1) * m_clothThickness, static_cast<Real>(1.0e-6));
+	const Vector3r etaVec(eta, eta, eta);
+	const Real maxDist = m_clothThickness + m_tolerance;
+	const Real maxDist2 = maxDist * maxDist;
+
+	auto pointTriangleDistance = [](const Vector3r x[4])
+	{
+		return (x[3] - closestPointOnTriangle(x[3], x[0], x[1], x[2])).norm();
+	};
+	auto edgeEdgeDistance = [](const Vector3r x[4])
+	{
+		return sqrt(segmentSegmentDistance2(x[0], x[1], x[2], x[3]));
+	};
+
+	std::vector<std::vector<ClothImpactData> > &impacts_mt = m_clothImpacts_mt;
+#ifdef _DEBUG
+	const unsigned int maxThreads = 1;
+#else
+	const unsigned int maxThreads = omp_get_max_threads();
+#endif
+	impacts_mt.resize(maxThreads);
+
+	PrimitiveSpatialHash triangleHash, edgeHash, vertexHash;
+	triangleHash.m_aabbs.resize(numTriangles);
+	edgeHash.m_aabbs.resize(numEdges);
+	vertexHash.m_aabbs.resize(numVertices);
+	ScratchVector<Real> particleToi(pd.size(), 1.0);
+
+	// Moving particles back can cause new impacts with other primitives, 
+	// so the sweeps are repeated. In the last pass the particles of the 
+	// remaining impacts are reset to their positions at the beginning of the step.
+	const unsigned int maxPasses = 8;
+	for (unsigned int pass = 0; pass < maxPasses; pass++)
+	{
+		for (unsigned int i = 0; i < maxThreads; i++)
+			impacts_mt[i].clear();
+
+		// swept bounding boxes
+		Real edgeLength = 0.0;
+		#pragma omp parallel if(numEdges > MIN_PARALLEL_SIZE) default(shared)
+		{
+			#pragma omp for schedule(static) nowait
+			for (int i = 0; i < numTriangles; i++)
+			{
+				AABB &aabb = triangleHash.m_aabbs[i];
+				aabb.m_p[0] = m_startParticleX[triangles[3 * i]];
+				aabb.m_p[1] = aabb.m_p[0];
+				for (unsigned int k = 0; k < 3; k++)
+				{
+					updateAABB(m_startParticleX[triangles[3 * i + k]], aabb);
+					updateAABB(pd.getPosition(triangles[3 * i + k]), aabb);
+				}
+				aabb.m_p[0] -= etaVec;
+				aabb.m_p[1] += etaVec;
+			}
+
+			#pragma omp for schedule(static) nowait
+			for (int i = 0; i < numVertices; i++)
+			{
+				const unsigned int v = vertices[i];
+				AABB &aabb = vertexHash.m_aabbs[i];
+				aabb.m_p[0] = m_startParticleX[v].cwiseMin(pd.getPosition(v)) - etaVec;
+				aabb.m_p[1] = m_startParticleX[v].cwiseMax(pd.getPosition(v)) + etaVec;
+			}
+
+			#pragma omp for schedule(static) reduction(+:edgeLength)
+			for (int i = 0; i < numEdges; i++)
+			{
+				const unsigned int a = edges[2 * i];
+				const unsigned int b = edges[2 * i + 1];
+				AABB &aabb = edgeHash.m_aabbs[i];
+				aabb.m_p[0] = m_startParticleX[a];
+				aabb.m_p[1] = aabb.m_p[0];
+				updateAABB(m_startParticleX[b], aabb);
+				updateAABB(pd.getPosition(a), aabb);
+				updateAABB(pd.getPosition(b), aabb);
+				aabb.m_p[0] -= etaVec;
+				aabb.m_p[1] += etaVec;
+				edgeLength += (pd.getPosition(b) - pd.getPosition(a)).norm();
+			}
+		}
+
+		const Real cellSize = std::max((numEdges > 0) ? edgeLength / (Real)numEdges : static_cast<Real>(0.0), static_cast<Real>(2.0) * eta);
+		triangleHash.build(cellSize);
+		edgeHash.build(cellSize);
+		vertexHash.build(cellSize);
+
+		#pragma omp parallel if(numEdges > MIN_PARALLEL_SIZE) default(shared)
+		{
+#ifdef _DEBUG
+			const int tid = 0;
+#else
+			const int tid = omp_get_thread_num();
+#endif
+			auto sweepPointTriangle = [&](const unsigned int v, const unsigned int t)
+			{
+				const unsigned int a = triangles[3 * t];
+				const unsigned int b = triangles[3 * t + 1];
+				const unsigned int c = triangles[3 * t + 2];
+				if ((v == a) || (v == b) || (v == c))
+					return;
+				if ((pd.getInvMass(v) == 0.0) && (pd.getInvMass(a) == 0.0) && (pd.getInvMass(b) == 0.0) && (pd.getInvMass(c) == 0.0))
+					return;
+				if (modelIndex[v] == modelIndex[a])
+				{
+					const Vector3r &x0 = pd.getPosition0(v);
+					const Vector3r cp0 = closestPointOnTriangle(x0, pd.getPosition0(a), pd.getPosition0(b), pd.getPosition0(c));
+					if ((x0 - cp0).squaredNorm() < maxDist2)
+						return;
+				}
+				const Vector3r x0[4] = { m_startParticleX[a], m_startParticleX[b], m_startParticleX[c], m_startParticleX[v] };
+				const Vector3r x1[4] = { pd.getPosition(a), pd.getPosition(b), pd.getPosition(c), pd.getPosition(v) };
+				Real toi;
+				if (sweepPrimitives(x0, x1, eta, m_clothThickness, pointTriangleDistance, toi))
+					impacts_mt[tid].push_back({ { v, a, b, c }, toi });
+			};
+
+			// fast vertices against all triangles
+			#pragma omp for schedule(static) nowait
+			for (int i = 0; i < numVertices; i++)
+			{
+				const unsigned int v = vertices[i];
+				if (!fast[v])
+					continue;
+				triangleHash.query(vertexHash.m_aabbs[i], [&](const unsigned int t) { sweepPointTriangle(v, t); });
+			}
+
+			// triangles with a fast vertex against the slow vertices
+			#pragma omp for schedule(static) nowait
+			for (int i = 0; i < numTriangles; i++)
+			{
+				if (!fast[triangles[3 * i]] && !fast[triangles[3 * i + 1]] && !fast[triangles[3 * i + 2]])
+					continue;
+				vertexHash.query(triangleHash.m_aabbs[i], [&](const unsigned int j)
+				{
+					if (!fast[vertices[j]])
+						sweepPointTriangle(vertices[j], i);
+				});
+			}
+
+			// edges with a fast vertex against all edges, each pair is tested once
+			#pragma omp for schedule(static)
+			for (int i = 0; i < numEdges; i++)
+			{
+				const unsigned int a = edges[2 * i];
+				const unsigned int b = edges[2 * i + 1];
+				if (!fast[a] && !fast[b])
+					continue;
+				edgeHash.query(edgeHash.m_aabbs[i], [&](const unsigned int e)
+				{
+					const unsigned int c = edges[2 * e];
+					const unsigned int d = edges[2 * e + 1];
+					if ((fast[c] || fast[d]) && (e <= (unsigned int)i))
+						return;
+					if ((a == c) || (a == d) || (b == c) || (b == d))
+						return;
+					if ((pd.getInvMass(a) == 0.0) && (pd.getInvMass(b) == 0.0) && (pd.getInvMass(c) == 0.0) && (pd.getInvMass(d) == 0.0))
+						return;
+					if (modelIndex[a] == modelIndex[c])
+					{
+						if (segmentSegmentDistance2(pd.getPosition0(a), pd.getPosition0(b), pd.getPosition0(c), pd.getPosition0(d)) < maxDist2)
+							return;
+					}
+					const Vector3r x0[4] = { m_startParticleX[a], m_startParticleX[b], m_startParticleX[c], m_startParticleX[d] };
+					const Vector3r x1[4] = { pd.getPosition(a), pd.getPosition(b), pd.getPosition(c), pd.getPosition(d) };
+					Real toi;
+					if (sweepPrimitives(x0, x1, eta, m_clothThickness, edgeEdgeDistance, toi))
+						impacts_mt[tid].push_back({ { a, b, c, d }, toi });
+				});
+			}
+		}
+
+		// move the particles of all impacts back to the earliest time
+		bool impact = false;
+		for (unsigned int i = 0; i < impacts_mt.size(); i++)
+		{
+			for (unsigned int j = 0; j < impacts_mt[i].size(); j++)
+			{
+				const ClothImpactData &ci = impacts_mt[i][j];
+				const Real toi = (pass + 1 < maxPasses) ? ci.m_time : static_cast<Real>(0.0);
+				for (unsigned int k = 0; k < 4; k++)
+					particleToi[ci.m_index[k]] = std::min(particleToi[ci.m_index[k]], toi);
+				impact = true;
+			}
+		}
+		if (!impact)
+			break;
+
+		// The velocities were already updated, so they are scaled like the motion. 
+		// Otherwise the particles would hit the same primitives in the next step.
+		for (int i = 0; i < numVertices; i++)
+		{
+			const unsigned int v = vertices[i];
+			if (particleToi[v] < 1.0)
+			{
+				if (pd.getInvMass(v) != 0.0)
+				{
+					pd.getPosition(v) = m_startParticleX[v] + particleToi[v] * (pd.getPosition(v) - m_startParticleX[v]);
+					pd.getVelocity(v) *= particleToi[v];
+				}
+				particleToi[v] = 1.0;
+			}
+		}
+	}
+}
@@ -12,11 +12,18 @@ namespace PBD
 	{
 	public:
 		static int CONTACT_TOLERANCE;
+		static int CONTINUOUS_COLLISION_DETECTION;
+		static int CCD_MOTION_THRESHOLD;
+		static int CLOTH_COLLISIONS;
+		static int CLOTH_THICKNESS;
+		static int SUBSTEP_COLLISION_DETECTION;
 
 		static const unsigned int RigidBodyContactType;			// = 0;
 		static const unsigned int ParticleContactType;			// = 1;
 		static const unsigned int ParticleRigidBodyContactType; // = 2;
 		static const unsigned int ParticleSolidContactType;		// = 3;
+		static const unsigned int TrianglePointContactType;		// = 4;
+		static const unsigned int EdgeEdgeContactType;			// = 5;
 
 		typedef void (*ContactCallbackFunction)(const unsigned int contactType, const unsigned int bodyIndex1, const unsigned int bodyIndex2,
 												const Vector3r &cp1, const Vector3r &cp2,
@@ -29,6 +36,11 @@ namespace PBD
 													 const Vector3r &normal, const Real dist,
 													 const Real restitutionCoeff, const Real frictionCoeff, void *userData);
 
+		typedef void (*ClothContactCallbackFunction)(const unsigned int contactType, 
+													 const unsigned int particleIndex0, const unsigned int particleIndex1,
+													 const unsigned int particleIndex2, const unsigned int particleIndex3,
+													 const Real thickness, void *userData);
+
 		struct CollisionObject
 		{
 			static const unsigned int RigidBodyCollisionObjectType;		// = 0;
@@ -50,17 +62,87 @@ namespace PBD
 			virtual ~CollisionObjectWithoutGeometry() {}
 		};
 
+		/** \brief Counters of the collision detection. The counters are accumulated 
+		* until resetStatistics() is called (i.e. over all substeps of a time step). 
+		*/
+		struct Statistics
+		{
+			/** Pairs of collision objects with overlapping bounding boxes found by the last broad phase */
+			unsigned int m_numBroadPhasePairs;
+			/** Pairs of collision objects which were tested in the narrow phase */
+			unsigned int m_numNarrowPhaseTests;
+			/** Visited nodes of the bounding volume hierarchies. For the test of two 
+			* hierarchies the overlapping leaf pairs are counted. */
+			std::size_t m_numBVHNodesVisited;
+			/** Point-triangle and edge-edge pairs which were tested by the cloth collision detection */
+			std::size_t m_numClothPrimitiveTests;
+
+			Statistics() { reset(); }
+			void reset()
+			{
+				m_numBroadPhasePairs = 0;
+				m_numNarrowPhaseTests = 0;
+				m_numBVHNodesVisited = 0;
+				m_numClothPrimitiveTests = 0;
+			}
+		};
+
 	protected:
 		Real m_tolerance;
 		ContactCallbackFunction m_contactCB;
 		SolidContactCallbackFunction m_solidContactCB;
+		ClothContactCallbackFunction m_clothContactCB;
 		void *m_contactCBUserData;
 		void *m_solidContactCBUserData;
+		void *m_clothContactCBUserData;
 		std::vector<CollisionObject *> m_collisionObjects;
+		/** Sweep fast bodies and particles from their positions at the beginning 
+		* of the time step to the end positions. */
+		bool m_continuousCollisionDetection;
+		/** Only bodies and particles which move more than this distance in a 
+		* time step are swept. */
+		Real m_ccdMotionThreshold;
+		/** State at the beginning of the time step which is required for the 
+		* continuous collision detection */
+		std::vector<Vector3r> m_startX;
+		std::vector<Quaternionr> m_startQ;
+		std::vector<Vector3r> m_startParticleX;
+		/** Collisions of cloth with itself and with other cloth models */
+		bool m_clothCollisions;
+		/** Distance which is kept between cloth particles and triangles */
+		Real m_clothThickness;
+		struct ClothContactData
+		{
+			unsigned int m_type;
+			unsigned int m_index[4];
+		};
+		/** Contacts found by each thread. The buffers are kept to avoid heap allocations. */
+		std::vector<std::vector<ClothContactData> > m_clothContacts_mt;
+		struct ClothImpactData
+		{
+			unsigned int m_index[4];
+			/** the particles can move up to this fraction of their motion without contact */
+			Real m_time;
+		};
+		/** Point-triangle and edge-edge impacts found by each thread in the continuous collision detection */
+		std::vector<std::vector<ClothImpactData> > m_clothImpacts_mt;
+		/** Update the contacts after each substep. The collision pairs of the 
+		* first substep are reused in the following substeps. */
+		bool m_substepCollisionDetection;
+		Statistics m_statistics;
 
 		void updateAABB(const Vector3r &p, AABB &aabb);
 		virtual void initParameters();
 
+		/** Determine point-triangle and edge-edge contacts between all triangle 
+		* models which are collision objects. */
+		void clothCollisionDetection(SimulationModel &model);
+		/** Sweep the vertices against the triangles and the edges against the edges 
+		* of all triangle models which are collision objects. Pairs with a fast particle 
+		* which would pass through each other in the current time step are moved back 
+		* to a time before the impact, so that clothCollisionDetection generates a contact. */
+		void clothContinuousCollisionDetection(SimulationModel &model);
+
 	public:
 		CollisionDetection();
 		virtual ~CollisionDetection();
@@ -71,6 +153,18 @@ namespace PBD
 
 		Real getTolerance() const { return m_tolerance; }
 		void setTolerance(Real val) { m_tolerance = val; }
+		bool getContinuousCollisionDetection() const { return m_continuousCollisionDetection; }
+		void setContinuousCollisionDetection(bool val) { m_continuousCollisionDetection = val; }
+		Real getCCDMotionThreshold() const { return m_ccdMotionThreshold; }
+		void setCCDMotionThreshold(Real val) { m_ccdMotionThreshold = val; }
+		bool getClothCollisions() const { return m_clothCollisions; }
+		void setClothCollisions(bool val) { m_clothCollisions = val; }
+		Real getClothThickness() const { return m_clothThickness; }
+		void setClothThickness(Real val) { m_clothThickness = val; }
+		bool getSubstepCollisionDetection() const { return m_substepCollisionDetection; }
+		void setSubstepCollisionDetection(bool val) { m_substepCollisionDetection = val; }
+		const Statistics &getStatistics() const { return m_statistics; }
+		void resetStatistics() { m_statistics.reset(); }
 
 		void addRigidBodyContact(const unsigned int rbIndex1, const unsigned int rbIndex2,
 								 const Vector3r &cp1, const Vector3r &cp2,
@@ -88,14 +182,34 @@ namespace PBD
 									 const Vector3r &normal, const Real dist,
 									 const Real restitutionCoeff, const Real frictionCoeff);
 
+		void addClothContact(const unsigned int contactType, 
+							 const unsigned int particleIndex0, const unsigned int particleIndex1,
+							 const unsigned int particleIndex2, const unsigned int particleIndex3,
+							 const Real thickness);
+
 		virtual void addCollisionObject(const unsigned int bodyIndex, const unsigned int bodyType);
 
 		std::vector<CollisionObject *> &getCollisionObjects() { return m_collisionObjects; }
 
 		virtual void collisionDetection(SimulationModel &model) = 0;
+		/** Collision detection after a substep. If updatePairs is set, the 
+		* collision pairs are determined for the motion in timeHorizon. 
+		* Otherwise, the pairs of the last update are reused and only the 
+		* narrow phase is performed. */
+		virtual void substepCollisionDetection(SimulationModel &model, const bool updatePairs, const Real timeHorizon) { collisionDetection(model); }
+
+		/** Store the positions at the beginning of the time step if the 
+		* continuous collision detection is enabled. */
+		void initContinuousCollisionDetection(SimulationModel &model);
+		/** Move bodies and particles which would tunnel through an obstacle 
+		* in the current time step back to the time of impact. This must be 
+		* called before the discrete collision detection which then generates 
+		* the contacts. */
+		virtual void continuousCollisionDetection(SimulationModel &model) {}
 
 		void setContactCallback(CollisionDetection::ContactCallbackFunction val, void *userData);
 		void setSolidContactCallback(CollisionDetection::SolidContactCallbackFunction val, void *userData);
+		void setClothContactCallback(CollisionDetection::ClothContactCallbackFunction val, void *userData);
 		void updateAABBs(SimulationModel &model);
 		void updateAABB(SimulationModel &model, CollisionDetection::CollisionObject *co);
 	};
@@ -6,10 +6,12 @@
 #include "TimeManager.h"
 #include "Simulation/IDFactory.h"
 #include "PositionBasedDynamics/PositionBasedElasticRods.h"
+#include "PositionBasedDynamics/MathFunctions.h"
 
 
 #include <set>
 #include <map>
+#include <algorithm>
 
 using namespace PBD;
 
@@ -43,10 +45,13 @@ int DamperJoint::TYPE_ID = IDFactory::getId();
 int RigidBodyContactConstraint::TYPE_ID = IDFactory::getId();
 int ParticleRigidBodyContactConstraint::TYPE_ID = IDFactory::getId();
 int ParticleTetContactConstraint::TYPE_ID = IDFactory::getId();
+int ClothContactConstraint::TYPE_ID = IDFactory::getId();
 int StretchShearConstraint::TYPE_ID = IDFactory::getId();
 int BendTwistConstraint::TYPE_ID = IDFactory::getId();
 int StretchBendingTwistingConstraint::TYPE_ID = IDFactory::getId();
 int DirectPositionBasedSolverForStiffRodsConstraint::TYPE_ID = IDFactory::getId();
+int CosseratRodsConstraint::TYPE_ID = IDFactory::getId();
+int FastLatticeShapeMatchingConstraint::TYPE_ID = IDFactory::getId();
 
 //////////////////////////////////////////////////////////////////////////
 // BallJoint
@@ -874,7 +879,7 @@ bool DamperJoint::solvePositionConstraint(SimulationModel &model, const unsigned
 	RigidBody &rb1 = *rb[m_bodies[0]];
 	RigidBody &rb2 = *rb[m_bodies[1]];
 
-	const Real dt = TimeManager::getCurrent()->getTimeStepSize();
+	const Real dt = model.getTimeManager().getTimeStepSize();
 
 	if (iter == 0)
 		m_lambda = 0.0;
@@ -1029,7 +1034,7 @@ bool RigidBodySpring::solvePositionConstraint(SimulationModel &model, const unsi
 	RigidBody &rb1 = *rb[m_bodies[0]];
 	RigidBody &rb2 = *rb[m_bodies[1]];
 
-	const Real dt = TimeManager::getCurrent()->getTimeStepSize();
+	const Real dt = model.getTimeManager().getTimeStepSize();
 
 	if (iter == 0)
 		m_lambda = 0.0;
@@ -1236,7 +1241,7 @@ bool DistanceConstraint_XPBD::solvePositionConstraint(SimulationModel& model, co
 	const Real invMass1 = pd.getInvMass(i1);
 	const Real invMass2 = pd.getInvMass(i2);
 
-	const Real dt = TimeManager::getCurrent()->getTimeStepSize();
+	const Real dt = model.getTimeManager().getTimeStepSize();
 
 	if (iter == 0)
 		m_lambda = 0.0;
@@ -1443,7 +1448,7 @@ bool IsometricBendingConstraint_XPBD::solvePositionConstraint(SimulationModel& m
 	const Real invMass3 = pd.getInvMass(i3);
 	const Real invMass4 = pd.getInvMass(i4);
 
-	const Real dt = TimeManager::getCurrent()->getTimeStepSize();
+	const Real dt = model.getTimeManager().getTimeStepSize();
 
 	if (iter == 0)
 		m_lambda = 0.0;
@@ -1720,7 +1725,7 @@ bool VolumeConstraint_XPBD::solvePositionConstraint(SimulationModel& model, cons
 	const Real invMass3 = pd.getInvMass(i3);
 	const Real invMass4 = pd.getInvMass(i4);
 
-	const Real dt = TimeManager::getCurrent()->getTimeStepSize();
+	const Real dt = model.getTimeManager().getTimeStepSize();
 
 	if (iter == 0)
 		m_lambda = 0.0;
@@ -1872,7 +1877,7 @@ bool XPBD_FEMTetConstraint::solvePositionConstraint(SimulationModel &model, cons
 	if (currentVolume / m_volume < 0.2)		// Only 20% of initial volume left
 		handleInversion = true;
 
-	const Real dt = TimeManager::getCurrent()->getTimeStepSize();
+	const Real dt = model.getTimeManager().getTimeStepSize();
 
 	if (iter == 0)
 		m_lambda = 0.0;
@@ -2028,6 +2033,227 @@ bool ShapeMatchingConstraint::solvePositionConstraint(SimulationModel &model, co
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// FastLatticeShapeMatchingConstraint
+//////////////////////////////////////////////////////////////////////////
+bool FastLatticeShapeMatchingConstraint::initConstraint(SimulationModel &model, const unsigned int dim[3], 
+	const unsigned int cellParticles[], const unsigned int regionWidth, const Real stiffness)
+{
+	const Real eps = static_cast<Real>(1e-6);
+	m_stiffness = stiffness;
+	m_regionWidth = regionWidth;
+	m_dim[0] = dim[0];
+	m_dim[1] = dim[1];
+	m_dim[2] = dim[2];
+	const unsigned int numCells = dim[0] * dim[1] * dim[2];
+	if (numCells == 0)
+		return false;
+
+	ParticleData &pd = model.getParticles();
+	m_cellParticles.assign(cellParticles, cellParticles + numCells);
+	m_w.assign(numCells, 0.0);
+	m_x0.assign(numCells, Vector3r::Zero());
+	m_restCm.assign(numCells, Vector3r::Zero());
+	m_numRegions.assign(numCells, 0.0);
+	m_sums.assign(13 * numCells, 0.0);
+	m_A.assign(numCells, Matrix3r::Identity());
+	m_bodies.clear();
+
+	// mass, mass weighted rest position and occupancy per cell
+	for (unsigned int c = 0; c < numCells; c++)
+	{
+		const unsigned int i = m_cellParticles[c];
+		if (i == 0xffffffff)
+			continue;
+		m_bodies.push_back(i);
+		m_x0[c] = pd.getPosition0(i);
+		m_w[c] = static_cast<Real>(1.0) / (pd.getInvMass(i) + eps);
+
+		double *s = &m_sums[13 * c];
+		s[0] = m_w[c];
+		for (unsigned int k = 0; k < 3; k++)
+			s[1 + k] = m_w[c] * m_x0[c][k];
+		s[4] = 1.0;
+	}
+	if (m_bodies.empty())
+		return false;
+
+	computeRegionSums(5);
+
+	for (unsigned int c = 0; c < numCells; c++)
+	{
+		if (m_cellParticles[c] == 0xffffffff)
+			continue;
+		const double *s = &m_sums[13 * c];
+		for (unsigned int k = 0; k < 3; k++)
+			m_restCm[c][k] = static_cast<Real>(s[1 + k] / s[0]);
+		m_numRegions[c] = static_cast<Real>(s[4]);
+	}
+	return true;
+}
+
+void FastLatticeShapeMatchingConstraint::computeRegionSums(const unsigned int numComponents)
+{
+	// The sum over a cubic region is separable. So it is computed by a sliding 
+	// window along each axis, where each window sum is the difference of two 
+	// prefix sums. Double precision avoids cancellation for large masses.
+	const int w = static_cast<int>(m_regionWidth);
+	const unsigned int numCells = m_dim[0] * m_dim[1] * m_dim[2];
+	const unsigned int stride[3] = { m_dim[1] * m_dim[2], m_dim[2], 1 };
+	for (unsigned int a = 0; a < 3; a++)
+	{
+		const int n = static_cast<int>(m_dim[a]);
+		const int numLines = static_cast<int>(numCells / m_dim[a]);
+
+		#pragma omp parallel if(numLines > MIN_PARALLEL_SIZE) default(shared)
+		{
+			std::vector<double> prefix((n + 1) * numComponents);
+			#pragma omp for schedule(static)
+			for (int l = 0; l < numLines; l++)
+			{
+				// first cell of the line
+				const unsigned int base = (l / stride[a]) * stride[a] * n + (l % stride[a]);
+				for (unsigned int k = 0; k < numComponents; k++)
+					prefix[k] = 0.0;
+				for (int x = 0; x < n; x++)
+				{
+					const double *s = &m_sums[13 * (base + x * stride[a])];
+					for (unsigned int k = 0; k < numComponents; k++)
+						prefix[(x + 1) * numComponents + k] = prefix[x * numComponents + k] + s[k];
+				}
+				for (int x = 0; x < n; x++)
+				{
+					const int lo = std::max(x - w, 0);
+					const int hi = std::min(x + w + 1, n);
+					double *s = &m_sums[13 * (base + x * stride[a])];
+					for (unsigned int k = 0; k < numComponents; k++)
+						s[k] = prefix[hi * numComponents + k] - prefix[lo * numComponents + k];
+				}
+			}
+		}
+	}
+}
+
+bool FastLatticeShapeMatchingConstraint::solvePositionConstraint(SimulationModel &model, const unsigned int iter)
+{
+	ParticleData &pd = model.getParticles();
+	const int numCells = static_cast<int>(m_cellParticles.size());
+
+	#pragma omp parallel if(numCells > MIN_PARALLEL_SIZE) default(shared)
+	{
+		// per cell: m, m x, m x x0^T
+		#pragma omp for schedule(static)
+		for (int c = 0; c < numCells; c++)
+		{
+			double *s = &m_sums[13 * c];
+			const unsigned int i = m_cellParticles[c];
+			if (i == 0xffffffff)
+			{
+				for (unsigned int k = 0; k < 13; k++)
+					s[k] = 0.0;
+				continue;
+			}
+			const Vector3r &x = pd.getPosition(i);
+			const double m = m_w[c];
+			s[0] = m;
+			for (unsigned int r = 0; r < 3; r++)
+			{
+				s[1 + r] = m * x[r];
+				for (unsigned int k = 0; k < 3; k++)
+					s[4 + 3 * r + k] = m * x[r] * m_x0[c][k];
+			}
+		}
+	}
+
+	computeRegionSums(13);
+
+	#pragma omp parallel if(numCells > MIN_PARALLEL_SIZE) default(shared)
+	{
+		// A = sum m x x0^T - M cm restCm^T
+		#pragma omp for schedule(static)
+		for (int c = 0; c < numCells; c++)
+		{
+			const double *s = &m_sums[13 * c];
+			Matrix3r &A = m_A[c];
+			if (m_cellParticles[c] == 0xffffffff)
+			{
+				A.setIdentity();
+				continue;
+			}
+			const Vector3r &restCm = m_restCm[c];
+			for (unsigned int r = 0; r < 3; r++)
+				for (unsigned int k = 0; k < 3; k++)
+					A(r, k) = static_cast<Real>(s[4 + 3 * r + k] - s[1 + r] * restCm[k]);
+		}
+
+		// optimal rotations of all regions. In single precision blocks of cells are decomposed
+		// together by the branch-free batch polar decomposition.
+#ifdef USE_DOUBLE
+		#pragma omp for schedule(static)
+		for (int c = 0; c < numCells; c++)
+		{
+			const Matrix3r A = m_A[c];
+			MathFunctions::polarDecompositionStable(A, static_cast<Real>(1e-6), m_A[c]);
+		}
+#else
+		const int blockSize = 64;
+		const int numBlocks = (numCells + blockSize - 1) / blockSize;
+		#pragma omp for schedule(static)
+		for (int b = 0; b < numBlocks; b++)
+		{
+			const int start = b * blockSize;
+			MathFunctions::polarDecompositionBatch(static_cast<unsigned int>(std::min(blockSize, numCells - start)), &m_A[start], &m_A[start]);
+		}
+#endif
+
+		// rotation and translation of each region
+		#pragma omp for schedule(static)
+		for (int c = 0; c < numCells; c++)
+		{
+			double *s = &m_sums[13 * c];
+			if (m_cellParticles[c] == 0xffffffff)
+			{
+				for (unsigned int k = 0; k < 12; k++)
+					s[k] = 0.0;
+				continue;
+			}
+			const double M = s[0];
+			const double cm[3] = { s[1] / M, s[2] / M, s[3] / M };
+			const Matrix3r &R = m_A[c];
+			const Vector3r Rc0 = R * m_restCm[c];
+			for (unsigned int r = 0; r < 3; r++)
+			{
+				for (unsigned int k = 0; k < 3; k++)
+					s[3 * r + k] = R(r, k);
+				s[9 + r] = cm[r] - Rc0[r];
+			}
+		}
+	}
+
+	computeRegionSums(12);
+
+	#pragma omp parallel if(numCells > MIN_PARALLEL_SIZE) default(shared)
+	{
+		// goal position: average of the transformed rest positions of all regions
+		#pragma omp for schedule(static)
+		for (int c = 0; c < numCells; c++)
+		{
+			const unsigned int i = m_cellParticles[c];
+			if ((i == 0xffffffff) || (pd.getInvMass(i) == 0.0))
+				continue;
+			const double *s = &m_sums[13 * c];
+			const Vector3r &x0 = m_x0[c];
+			Vector3r goal;
+			for (unsigned int r = 0; r < 3; r++)
+				goal[r] = static_cast<Real>((s[3 * r] * x0[0] + s[3 * r + 1] * x0[1] + s[3 * r + 2] * x0[2] + s[9 + r]) / m_numRegions[c]);
+			Vector3r &x = pd.getPosition(i);
+			x += m_stiffness * (goal - x);
+		}
+	}
+	return true;
+}
+
+
 //////////////////////////////////////////////////////////////////////////
 // RigidBodyContactConstraint
 //////////////////////////////////////////////////////////////////////////
@@ -2109,6 +2335,24 @@ bool RigidBodyContactConstraint::solveVelocityConstraint(SimulationModel &model,
 	return res;
 }
 
+void RigidBodyContactConstraint::saveState(Utilities::BinaryWriter &binWriter) const
+{
+	binWriter.write(m_bodies);
+	binWriter.write(m_stiffness);
+	binWriter.write(m_frictionCoeff);
+	binWriter.write(m_sum_impulses);
+	binWriter.writeMatrix(m_constraintInfo);
+}
+
+bool RigidBodyContactConstraint::loadState(Utilities::BinaryReader &binReader)
+{
+	binReader.read(m_bodies);
+	binReader.read(m_stiffness);
+	binReader.read(m_frictionCoeff);
+	binReader.read(m_sum_impulses);
+	return binReader.readMatrix(m_constraintInfo);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // ParticleRigidBodyContactConstraint
 //////////////////////////////////////////////////////////////////////////
@@ -2185,6 +2429,24 @@ bool ParticleRigidBodyContactConstraint::solveVelocityConstraint(SimulationModel
 	return res;
 }
 
+void ParticleRigidBodyContactConstraint::saveState(Utilities::BinaryWriter &binWriter) const
+{
+	binWriter.write(m_bodies);
+	binWriter.write(m_stiffness);
+	binWriter.write(m_frictionCoeff);
+	binWriter.write(m_sum_impulses);
+	binWriter.writeMatrix(m_constraintInfo);
+}
+
+bool ParticleRigidBodyContactConstraint::loadState(Utilities::BinaryReader &binReader)
+{
+	binReader.read(m_bodies);
+	binReader.read(m_stiffness);
+	binReader.read(m_frictionCoeff);
+	binReader.read(m_sum_impulses);
+	return binReader.readMatrix(m_constraintInfo);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // ParticleSolidContactConstraint
 //////////////////////////////////////////////////////////////////////////
@@ -2324,6 +2586,117 @@ bool ParticleTetContactConstraint::solveVelocityConstraint(SimulationModel &mode
 	return res;
 }
 
+void ParticleTetContactConstraint::saveState(Utilities::BinaryWriter &binWriter) const
+{
+	binWriter.write(m_bodies);
+	binWriter.write(m_solidIndex);
+	binWriter.write(m_tetIndex);
+	binWriter.writeMatrix(m_bary);
+	binWriter.write(m_lambda);
+	binWriter.write(m_frictionCoeff);
+	binWriter.writeMatrix(m_constraintInfo);
+	binWriter.write(m_invMasses);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		binWriter.writeMatrix(m_x[i]);
+		binWriter.writeMatrix(m_v[i]);
+	}
+}
+
+bool ParticleTetContactConstraint::loadState(Utilities::BinaryReader &binReader)
+{
+	binReader.read(m_bodies);
+	binReader.read(m_solidIndex);
+	binReader.read(m_tetIndex);
+	binReader.readMatrix(m_bary);
+	binReader.read(m_lambda);
+	binReader.read(m_frictionCoeff);
+	binReader.readMatrix(m_constraintInfo);
+	binReader.read(m_invMasses);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		binReader.readMatrix(m_x[i]);
+		binReader.readMatrix(m_v[i]);
+	}
+	return !binReader.hasError();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ClothContactConstraint
+//////////////////////////////////////////////////////////////////////////
+bool ClothContactConstraint::initConstraint(SimulationModel &model, const bool edgeEdge,
+	const unsigned int particleIndex0, const unsigned int particleIndex1,
+	const unsigned int particleIndex2, const unsigned int particleIndex3,
+	const Real thickness, const Real stiffness)
+{
+	m_edgeEdge = edgeEdge;
+	m_bodies[0] = particleIndex0;
+	m_bodies[1] = particleIndex1;
+	m_bodies[2] = particleIndex2;
+	m_bodies[3] = particleIndex3;
+	m_thickness = thickness;
+	m_stiffness = stiffness;
+	return true;
+}
+
+bool ClothContactConstraint::solvePositionConstraint(SimulationModel &model, const unsigned int iter)
+{
+	ParticleData &pd = model.getParticles();
+
+	Vector3r &x0 = pd.getPosition(m_bodies[0]);
+	Vector3r &x1 = pd.getPosition(m_bodies[1]);
+	Vector3r &x2 = pd.getPosition(m_bodies[2]);
+	Vector3r &x3 = pd.getPosition(m_bodies[3]);
+
+	const Real invMass0 = pd.getInvMass(m_bodies[0]);
+	const Real invMass1 = pd.getInvMass(m_bodies[1]);
+	const Real invMass2 = pd.getInvMass(m_bodies[2]);
+	const Real invMass3 = pd.getInvMass(m_bodies[3]);
+
+	// only the compression is resolved
+	Vector3r corr0, corr1, corr2, corr3;
+	bool res;
+	if (m_edgeEdge)
+		res = PositionBasedDynamics::solve_EdgeEdgeDistanceConstraint(
+			x0, invMass0, x1, invMass1, x2, invMass2, x3, invMass3,
+			m_thickness, m_stiffness, 0.0,
+			corr0, corr1, corr2, corr3);
+	else
+		res = PositionBasedDynamics::solve_TrianglePointDistanceConstraint(
+			x0, invMass0, x1, invMass1, x2, invMass2, x3, invMass3,
+			m_thickness, m_stiffness, 0.0,
+			corr0, corr1, corr2, corr3);
+
+	if (res)
+	{
+		if (invMass0 != 0.0)
+			x0 += corr0;
+		if (invMass1 != 0.0)
+			x1 += corr1;
+		if (invMass2 != 0.0)
+			x2 += corr2;
+		if (invMass3 != 0.0)
+			x3 += corr3;
+	}
+	return res;
+}
+
+void ClothContactConstraint::saveState(Utilities::BinaryWriter &binWriter) const
+{
+	binWriter.write(m_bodies);
+	binWriter.write(m_edgeEdge);
+	binWriter.write(m_thickness);
+	binWriter.write(m_stiffness);
+}
+
+bool ClothContactConstraint::loadState(Utilities::BinaryReader &binReader)
+{
+	binReader.read(m_bodies);
+	binReader.read(m_edgeEdge);
+	binReader.read(m_thickness);
+	return binReader.read(m_stiffness);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // StretchShearConstraint
 //////////////////////////////////////////////////////////////////////////
@@ -2453,6 +2826,256 @@ bool BendTwistConstraint::solvePositionConstraint(SimulationModel &model, const
 	return res;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// CosseratRodsConstraint
+//////////////////////////////////////////////////////////////////////////
+bool CosseratRodsConstraint::initConstraint(SimulationModel &model, const std::vector<unsigned int> &lineModelIndices,
+	const Real stretchingStiffness, const Real shearingStiffness1, const Real shearingStiffness2,
+	const Real twistingStiffness, const Real bendingStiffness1, const Real bendingStiffness2)
+{
+	m_stretchingStiffness = stretchingStiffness;
+	m_shearingStiffness1 = shearingStiffness1;
+	m_shearingStiffness2 = shearingStiffness2;
+	m_twistingStiffness = twistingStiffness;
+	m_bendingStiffness1 = bendingStiffness1;
+	m_bendingStiffness2 = bendingStiffness2;
+
+	ParticleData &pd = model.getParticles();
+	OrientationData &od = model.getOrientations();
+	SimulationModel::LineModelVector &lineModels = model.getLineModels();
+
+	m_stretchShearParticles.clear();
+	m_stretchShearQuaternions.clear();
+	m_restLengths.clear();
+	m_bendTwistQuaternions.clear();
+	m_restDarbouxVectors.clear();
+	m_bodies.clear();
+
+	m_rodOffsets.resize(lineModelIndices.size() + 1);
+	m_rodOffsets[0] = 0;
+	m_isChain = true;
+	for (unsigned int i = 0; i < lineModelIndices.size(); i++)
+	{
+		const LineModel::Edges &edges = lineModels[lineModelIndices[i]]->getEdges();
+		m_rodOffsets[i + 1] = m_rodOffsets[i] + (unsigned int)edges.size();
+		for (unsigned int e = 0; e + 1 < edges.size(); e++)
+			m_isChain = m_isChain && (edges[e].m_vert[1] == edges[e + 1].m_vert[0]);
+	}
+	m_rodStretchShear.resize(m_rodOffsets.back());
+	m_rodBendTwist.resize(m_rodOffsets.back());
+
+	// The edges of a line model form a chain. First all even and then all odd edges
+	// of the rods are stored, so that each phase can be solved in parallel.
+	for (unsigned int phase = 0; phase < 2; phase++)
+	{
+		m_stretchShearPhases[phase] = (unsigned int)m_restLengths.size();
+		m_bendTwistPhases[phase] = (unsigned int)m_restDarbouxVectors.size();
+		for (unsigned int i = 0; i < lineModelIndices.size(); i++)
+		{
+			LineModel *lineModel = lineModels[lineModelIndices[i]];
+			const unsigned int offset = lineModel->getIndexOffset();
+			const unsigned int offsetQuaternions = lineModel->getIndexOffsetQuaternions();
+			const LineModel::Edges &edges = lineModel->getEdges();
+			const unsigned int nEdges = (unsigned int)edges.size();
+
+			// stretch-shear constraints
+			for (unsigned int e = phase; e < nEdges; e += 2)
+			{
+				const unsigned int v1 = edges[e].m_vert[0] + offset;
+				const unsigned int v2 = edges[e].m_vert[1] + offset;
+				const unsigned int q1 = edges[e].m_quat + offsetQuaternions;
+				m_rodStretchShear[m_rodOffsets[i] + e] = (unsigned int)m_restLengths.size();
+				m_stretchShearParticles.push_back(v1);
+				m_stretchShearParticles.push_back(v2);
+				m_stretchShearQuaternions.push_back(q1);
+				m_restLengths.push_back((pd.getPosition0(v2) - pd.getPosition0(v1)).norm());
+			}
+
+			// bend-twist constraints
+			for (unsigned int e = phase; e + 1 < nEdges; e += 2)
+			{
+				const unsigned int q1 = edges[e].m_quat + offsetQuaternions;
+				const unsigned int q2 = edges[e + 1].m_quat + offsetQuaternions;
+				m_rodBendTwist[m_rodOffsets[i] + e] = (unsigned int)m_restDarbouxVectors.size();
+				m_bendTwistQuaternions.push_back(q1);
+				m_bendTwistQuaternions.push_back(q2);
+
+				const Quaternionr &q1_0 = od.getQuaternion(q1);
+				const Quaternionr &q2_0 = od.getQuaternion(q2);
+				Quaternionr restDarbouxVector = q1_0.conjugate() * q2_0;
+				Quaternionr omega_plus, omega_minus;
+				omega_plus.coeffs() = restDarbouxVector.coeffs() + Quaternionr(1, 0, 0, 0).coeffs();
+				omega_minus.coeffs() = restDarbouxVector.coeffs() - Quaternionr(1, 0, 0, 0).coeffs();
+				if (omega_minus.squaredNorm() > omega_plus.squaredNorm())
+					restDarbouxVector.coeffs() *= -1.0;
+				m_restDarbouxVectors.push_back(restDarbouxVector);
+			}
+		}
+	}
+	m_stretchShearPhases[2] = (unsigned int)m_restLengths.size();
+	m_bendTwistPhases[2] = (unsigned int)m_restDarbouxVectors.size();
+
+	// initialize m_bodies for constraint colouring algorithm of multi threading implementation,
+	// the particle indices are stored first (see numberOfParticles())
+	std::set<unsigned int> particles(m_stretchShearParticles.begin(), m_stretchShearParticles.end());
+	std::set<unsigned int> quaternions(m_stretchShearQuaternions.begin(), m_stretchShearQuaternions.end());
+	m_bodies.assign(particles.begin(), particles.end());
+	m_bodies.insert(m_bodies.end(), quaternions.begin(), quaternions.end());
+	m_numParticles = (unsigned int)particles.size();
+
+	return true;
+}
+
+void CosseratRodsConstraint::solveStretchShearConstraints(SimulationModel &model, const unsigned int start, const unsigned int end)
+{
+	ParticleData &pd = model.getParticles();
+	OrientationData &od = model.getOrientations();
+	const Vector3r stiffness(m_shearingStiffness1,
+		m_shearingStiffness2,
+		m_stretchingStiffness);
+
+	// The constraints of a phase are independent, so blocks of them are solved 
+	// by the batch solver which processes several constraints by SIMD instructions.
+	const int numConstraints = (int)(end - start);
+	const int blockSize = 64;
+	const int numBlocks = (numConstraints + blockSize - 1) / blockSize;
+	#pragma omp parallel if(numConstraints > MIN_PARALLEL_SIZE) default(shared)
+	{
+		#pragma omp for schedule(static)
+		for (int b = 0; b < numBlocks; b++)
+		{
+			const unsigned int i = start + b * blockSize;
+			PositionBasedCosseratRods::solve_StretchShearConstraints(
+				static_cast<unsigned int>(std::min(blockSize, numConstraints - b * blockSize)),
+				&m_stretchShearParticles[2 * i], &m_stretchShearQuaternions[i],
+				&pd.getPosition(0), &pd.getInvMass(0),
+				&od.getQuaternion(0), &od.getInvMass(0),
+				stiffness, &m_restLengths[i]);
+		}
+	}
+}
+
+void CosseratRodsConstraint::solveBendTwistConstraints(SimulationModel &model, const unsigned int start, const unsigned int end)
+{
+	OrientationData &od = model.getOrientations();
+	const Vector3r stiffness(m_bendingStiffness1,
+		m_bendingStiffness2,
+		m_twistingStiffness);
+
+	const int numConstraints = (int)(end - start);
+	const int blockSize = 64;
+	const int numBlocks = (numConstraints + blockSize - 1) / blockSize;
+	#pragma omp parallel if(numConstraints > MIN_PARALLEL_SIZE) default(shared)
+	{
+		#pragma omp for schedule(static)
+		for (int b = 0; b < numBlocks; b++)
+		{
+			const unsigned int i = start + b * blockSize;
+			PositionBasedCosseratRods::solve_BendTwistConstraints(
+				static_cast<unsigned int>(std::min(blockSize, numConstraints - b * blockSize)),
+				&m_bendTwistQuaternions[2 * i],
+				&od.getQuaternion(0), &od.getInvMass(0),
+				stiffness, &m_restDarbouxVectors[i]);
+		}
+	}
+}
+
+void CosseratRodsConstraint::solveRodsDirect(SimulationModel &model)
+{
+	ParticleData &pd = model.getParticles();
+	OrientationData &od = model.getOrientations();
+	const Vector3r stretchingAndShearingKs(m_shearingStiffness1,
+		m_shearingStiffness2,
+		m_stretchingStiffness);
+	const Vector3r bendingAndTwistingKs(m_bendingStiffness1,
+		m_bendingStiffness2,
+		m_twistingStiffness);
+
+	const int numRods = (int)m_rodOffsets.size() - 1;
+	#pragma omp parallel if((numRods > 1) && (getCost() > MIN_PARALLEL_SIZE)) default(shared)
+	{
+		std::vector<Vector3r> p, corr_p;
+		std::vector<Quaternionr> q, corr_q, restDarbouxVectors;
+		std::vector<Real> invMass, invMassq, restLengths;
+
+		// the rods can have different lengths
+		#pragma omp for schedule(dynamic, 1)
+		for (int r = 0; r < numRods; r++)
+		{
+			const unsigned int nEdges = m_rodOffsets[r + 1] - m_rodOffsets[r];
+			if (nEdges == 0)
+				continue;
+
+			// gather the data of the rod
+			p.resize(nEdges + 1); corr_p.resize(nEdges + 1); invMass.resize(nEdges + 1);
+			q.resize(nEdges); corr_q.resize(nEdges); invMassq.resize(nEdges); restLengths.resize(nEdges);
+			restDarbouxVectors.resize(nEdges - 1);
+			for (unsigned int e = 0; e < nEdges; e++)
+			{
+				const unsigned int c = m_rodStretchShear[m_rodOffsets[r] + e];
+				const unsigned int i1 = m_stretchShearParticles[2 * c];
+				const unsigned int iq = m_stretchShearQuaternions[c];
+				p[e] = pd.getPosition(i1);
+				invMass[e] = pd.getInvMass(i1);
+				q[e] = od.getQuaternion(iq);
+				invMassq[e] = od.getInvMass(iq);
+				restLengths[e] = m_restLengths[c];
+				if (e + 1 < nEdges)
+					restDarbouxVectors[e] = m_restDarbouxVectors[m_rodBendTwist[m_rodOffsets[r] + e]];
+				else
+				{
+					const unsigned int i2 = m_stretchShearParticles[2 * c + 1];
+					p[e + 1] = pd.getPosition(i2);
+					invMass[e + 1] = pd.getInvMass(i2);
+				}
+			}
+
+			const bool res = PositionBasedCosseratRods::solve_StretchShearBendTwistChain(
+				nEdges, p.data(), invMass.data(), q.data(), invMassq.data(),
+				stretchingAndShearingKs, bendingAndTwistingKs,
+				restLengths.data(), restDarbouxVectors.data(), corr_p.data(), corr_q.data());
+			if (!res)
+				continue;
+
+			// apply the corrections
+			for (unsigned int e = 0; e < nEdges; e++)
+			{
+				const unsigned int c = m_rodStretchShear[m_rodOffsets[r] + e];
+				const unsigned int i1 = m_stretchShearParticles[2 * c];
+				const unsigned int iq = m_stretchShearQuaternions[c];
+				if (invMass[e] != 0.0)
+					pd.getPosition(i1) += corr_p[e];
+				if (invMassq[e] != 0.0)
+				{
+					Quaternionr &q1 = od.getQuaternion(iq);
+					q1.coeffs() += corr_q[e].coeffs();
+					q1.normalize();
+				}
+				if ((e + 1 == nEdges) && (invMass[e + 1] != 0.0))
+					pd.getPosition(m_stretchShearParticles[2 * c + 1]) += corr_p[e + 1];
+			}
+		}
+	}
+}
+
+bool CosseratRodsConstraint::solvePositionConstraint(SimulationModel &model, const unsigned int iter)
+{
+	if (m_directSolver && m_isChain)
+	{
+		solveRodsDirect(model);
+		return true;
+	}
+
+	// even and odd stretch-shear constraints
+	solveStretchShearConstraints(model, m_stretchShearPhases[0], m_stretchShearPhases[1]);
+	solveStretchShearConstraints(model, m_stretchShearPhases[1], m_stretchShearPhases[2]);
+
+	// even and odd bend-twist constraints
+	solveBendTwistConstraints(model, m_bendTwistPhases[0], m_bendTwistPhases[1]);
+	solveBendTwistConstraints(model, m_bendTwistPhases[1], m_bendTwistPhases[2]);
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // StretchBendingTwistingConstraint
 //////////////////////////////////////////////////////////////////////////
@@ -2497,7 +3120,7 @@ bool StretchBendingTwistingConstraint::initConstraintBeforeProjection(Simulation
 {
 	DirectPositionBasedSolverForStiffRods::initBeforeProjection_StretchBendingTwistingConstraint(
 		m_stiffnessCoefficientK,
-		static_cast<Real>(1.0) / TimeManager::getCurrent()->getTimeStepSize(),
+		static_cast<Real>(1.0) / model.getTimeManager().getTimeStepSize(),
 		m_averageSegmentLength,
 		m_stretchCompliance,
 		m_bendingAndTorsionCompliance,
@@ -2573,38 +3196,12 @@ bool StretchBendingTwistingConstraint::solvePositionConstraint(SimulationModel &
 
 PBD::DirectPositionBasedSolverForStiffRodsConstraint::~DirectPositionBasedSolverForStiffRodsConstraint()
 {
-	deleteNodes();
 	if (intervals != NULL)
 		delete[] intervals;
-	if (forward != NULL)
-		delete[] forward;
-	if (backward != NULL)
-		delete[] backward;
-	if (root != NULL)
-		delete[] root;
-	root = NULL;
-	forward = NULL;
-	backward = NULL;
 	intervals = NULL;
 	numberOfIntervals = 0;
 }
 
-void DirectPositionBasedSolverForStiffRodsConstraint::deleteNodes()
-{
-	std::list<Node*>::iterator nodeIter;
-	for (int i = 0; i < numberOfIntervals; i++)
-	{
-		for (nodeIter = forward[i].begin(); nodeIter != forward[i].end(); nodeIter++)
-		{
-			Node *node = *nodeIter;
-
-			// Root node does not have to be deleted
-			if (node->parent != NULL)
-				delete node;
-		}
-	}
-}
-
 bool PBD::DirectPositionBasedSolverForStiffRodsConstraint::initConstraint(
 	SimulationModel &model, 
 	const std::vector<std::pair<unsigned int, unsigned int>> & constraintSegmentIndices, 
@@ -2669,9 +3266,8 @@ bool PBD::DirectPositionBasedSolverForStiffRodsConstraint::initConstraint(
 	}
 
 	// initialize data of the sparse direct solver
-	deleteNodes();
 	DirectPositionBasedSolverForStiffRods::init_DirectPositionBasedSolverForStiffRodsConstraint(
-		m_rodConstraints, m_rodSegments, intervals, numberOfIntervals, forward, backward, root,
+		m_rodConstraints, m_rodSegments, intervals, numberOfIntervals,
 		constraintPositions, averageRadii, youngsModuli, torsionModuli,
 		m_rightHandSide, m_lambdaSums, m_bendingAndTorsionJacobians, m_corr_x, m_corr_q);
 
@@ -2681,7 +3277,8 @@ bool PBD::DirectPositionBasedSolverForStiffRodsConstraint::initConstraint(
 bool PBD::DirectPositionBasedSolverForStiffRodsConstraint::initConstraintBeforeProjection(SimulationModel &model)
 {
 	DirectPositionBasedSolverForStiffRods::initBeforeProjection_DirectPositionBasedSolverForStiffRodsConstraint(
-		m_rodConstraints, static_cast<Real>(1.0) / TimeManager::getCurrent()->getTimeStepSize(), m_lambdaSums);
+		m_rodConstraints, static_cast<Real>(1.0) / model.getTimeManager().getTimeStepSize(), m_lambdaSums,
+		intervals, numberOfIntervals);
 	return true;
 }
 
@@ -2697,8 +3294,9 @@ bool PBD::DirectPositionBasedSolverForStiffRodsConstraint::updateConstraint(Simu
 bool PBD::DirectPositionBasedSolverForStiffRodsConstraint::solvePositionConstraint(SimulationModel &model, const unsigned int iter)
 {
 	const bool res = DirectPositionBasedSolverForStiffRods::solve_DirectPositionBasedSolverForStiffRodsConstraint(
-		m_rodConstraints, m_rodSegments, intervals, numberOfIntervals, forward, backward,
-		m_rightHandSide, m_lambdaSums, m_bendingAndTorsionJacobians, m_corr_x, m_corr_q
+		m_rodConstraints, m_rodSegments, intervals, numberOfIntervals,
+		m_rightHandSide, m_lambdaSums, m_bendingAndTorsionJacobians, m_corr_x, m_corr_q,
+		m_refactorizationTolerance
 		);
 	
 	// apply corrections to bodies
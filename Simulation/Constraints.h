@@ -9,6 +9,7 @@
 #include <list>
 #include <memory>
 #include "PositionBasedDynamics/DirectPositionBasedSolverForStiffRodsInterface.h"
+#include "Utils/BinaryReaderWriter.h"
 
 namespace PBD
 {
@@ -28,11 +29,31 @@ namespace PBD
 		unsigned int numberOfBodies() const { return static_cast<unsigned int>(m_bodies.size()); }
 		virtual ~Constraint() {};
 		virtual int &getTypeId() const = 0;
+		/** Name of the constraint type which is used in the solver statistics */
+		virtual const char *getTypeName() const { return "Constraint"; }
 
 		virtual bool initConstraintBeforeProjection(SimulationModel &model) { return true; };
 		virtual bool updateConstraint(SimulationModel &model) { return true; };
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter) { return true; };
 		virtual bool solveVelocityConstraint(SimulationModel &model, const unsigned int iter) { return true; };
+
+		/** Estimated cost of one solve of the constraint relative to a simple constraint. 
+		* Coarse-grained constraints which solve many bodies at once return a larger value. */
+		virtual unsigned int getCost() const { return 1; }
+
+		/** Number of leading entries of m_bodies which are rigid body indices. 
+		* The remaining entries are particle indices. */
+		virtual unsigned int numberOfRigidBodies() const { return 0; }
+
+		/** Number of particle indices which follow the rigid body indices in m_bodies. 
+		* Constraints which also store other indices (e.g. of orientations) return a 
+		* smaller value. */
+		virtual unsigned int numberOfParticles() const { return numberOfBodies() - numberOfRigidBodies(); }
+
+		/** Write the state of the constraint which changes during the simulation 
+		* (e.g. Lagrange multipliers or motor targets) to a checkpoint. */
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const {}
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return true; }
 	};
 
 	class BallJoint : public Constraint
@@ -43,6 +64,8 @@ namespace PBD
 
 		BallJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "BallJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -57,6 +80,8 @@ namespace PBD
 
 		BallOnLineJoint() : Constraint(2) {} 
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "BallOnLineJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &dir);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -71,6 +96,8 @@ namespace PBD
 
 		HingeJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "HingeJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &axis);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -85,6 +112,8 @@ namespace PBD
 
 		UniversalJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "UniversalJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &axis1, const Vector3r &axis2);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -99,6 +128,8 @@ namespace PBD
 
 		SliderJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "SliderJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &axis);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -111,6 +142,7 @@ namespace PBD
 		Real m_target;
 		std::vector<Real> m_targetSequence;
 		MotorJoint() : Constraint(2) { m_target = 0.0; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		virtual Real getTarget() const { return m_target; }
 		virtual void setTarget(const Real val) { m_target = val; }
@@ -121,6 +153,16 @@ namespace PBD
 		bool getRepeatSequence() const { return m_repeatSequence; }
 		void setRepeatSequence(bool val) { m_repeatSequence = val; }
 
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const 
+		{ 
+			binWriter.write(m_target); 
+			binWriter.writeVector(m_targetSequence);
+		}
+		virtual bool loadState(Utilities::BinaryReader &binReader) 
+		{ 
+			return binReader.read(m_target) && binReader.readVector(m_targetSequence);
+		}
+
 	private:
 		bool m_repeatSequence;
 	};
@@ -133,6 +175,7 @@ namespace PBD
 
 		TargetPositionMotorSliderJoint() : MotorJoint() {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "TargetPositionMotorSliderJoint"; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &axis);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -147,6 +190,7 @@ namespace PBD
 
 		TargetVelocityMotorSliderJoint() : MotorJoint() {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "TargetVelocityMotorSliderJoint"; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &axis);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -161,6 +205,7 @@ namespace PBD
 		Eigen::Matrix<Real, 4, 8, Eigen::DontAlign> m_jointInfo;
 		TargetAngleMotorHingeJoint() : MotorJoint() {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "TargetAngleMotorHingeJoint"; }
 
 		virtual void setTarget(const Real val) 
 		{ 
@@ -183,6 +228,7 @@ namespace PBD
 		Eigen::Matrix<Real, 4, 8, Eigen::DontAlign> m_jointInfo;
 		TargetVelocityMotorHingeJoint() : MotorJoint() {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "TargetVelocityMotorHingeJoint"; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &axis);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -200,10 +246,14 @@ namespace PBD
 
 		DamperJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "DamperJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &axis, const Real stiffness);
 		virtual bool updateConstraint(SimulationModel &model);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.write(m_lambda); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.read(m_lambda); }
 	};
  
 	class RigidBodyParticleBallJoint : public Constraint
@@ -214,6 +264,8 @@ namespace PBD
 
 		RigidBodyParticleBallJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "RigidBodyParticleBallJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 1; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex, const unsigned int particleIndex);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -231,10 +283,14 @@ namespace PBD
 
 		RigidBodySpring() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "RigidBodySpring"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos1, const Vector3r &pos2, const Real stiffness);
 		virtual bool updateConstraint(SimulationModel &model);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.write(m_lambda); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.read(m_lambda); }
 	};
 
 	class DistanceJoint : public Constraint
@@ -246,6 +302,8 @@ namespace PBD
 
 		DistanceJoint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "DistanceJoint"; }
+		virtual unsigned int numberOfRigidBodies() const { return 2; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos1, const Vector3r &pos2);
 		virtual bool updateConstraint(SimulationModel &model);
@@ -261,6 +319,7 @@ namespace PBD
 
 		DistanceConstraint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "DistanceConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2, const Real stiffness);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
@@ -276,9 +335,12 @@ namespace PBD
 
 		DistanceConstraint_XPBD() : Constraint(2) {}
 		virtual int& getTypeId() const { return TYPE_ID; }
+		virtual const char* getTypeName() const { return "DistanceConstraint_XPBD"; }
 
 		virtual bool initConstraint(SimulationModel& model, const unsigned int particle1, const unsigned int particle2, const Real stiffness);
 		virtual bool solvePositionConstraint(SimulationModel& model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.write(m_lambda); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.read(m_lambda); }
 	};
 
 	class DihedralConstraint : public Constraint
@@ -290,6 +352,7 @@ namespace PBD
 
 		DihedralConstraint() : Constraint(4) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "DihedralConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 									const unsigned int particle3, const unsigned int particle4, const Real stiffness);
@@ -305,6 +368,7 @@ namespace PBD
 
 		IsometricBendingConstraint() : Constraint(4) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "IsometricBendingConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 									const unsigned int particle3, const unsigned int particle4, const Real stiffness);
@@ -321,10 +385,13 @@ namespace PBD
 
 		IsometricBendingConstraint_XPBD() : Constraint(4) {}
 		virtual int& getTypeId() const { return TYPE_ID; }
+		virtual const char* getTypeName() const { return "IsometricBendingConstraint_XPBD"; }
 
 		virtual bool initConstraint(SimulationModel& model, const unsigned int particle1, const unsigned int particle2,
 					const unsigned int particle3, const unsigned int particle4, const Real stiffness);
 		virtual bool solvePositionConstraint(SimulationModel& model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.write(m_lambda); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.read(m_lambda); }
 	};
 
 	class FEMTriangleConstraint : public Constraint
@@ -341,6 +408,7 @@ namespace PBD
 
 		FEMTriangleConstraint() : Constraint(3) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "FEMTriangleConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 			const unsigned int particle3, const Real xxStiffness, const Real yyStiffness, const Real xyStiffness, 
@@ -361,6 +429,7 @@ namespace PBD
 
 		StrainTriangleConstraint() : Constraint(3) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "StrainTriangleConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 			const unsigned int particle3, const Real xxStiffness, const Real yyStiffness, const Real xyStiffness, 
@@ -377,6 +446,7 @@ namespace PBD
 
 		VolumeConstraint() : Constraint(4) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "VolumeConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 								const unsigned int particle3, const unsigned int particle4, const Real stiffness);
@@ -393,10 +463,13 @@ namespace PBD
 
 		VolumeConstraint_XPBD() : Constraint(4) {}
 		virtual int& getTypeId() const { return TYPE_ID; }
+		virtual const char* getTypeName() const { return "VolumeConstraint_XPBD"; }
 
 		virtual bool initConstraint(SimulationModel& model, const unsigned int particle1, const unsigned int particle2,
 			const unsigned int particle3, const unsigned int particle4, const Real stiffness);
 		virtual bool solvePositionConstraint(SimulationModel& model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.write(m_lambda); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.read(m_lambda); }
 	};
 
 	class FEMTetConstraint : public Constraint
@@ -410,6 +483,7 @@ namespace PBD
 
 		FEMTetConstraint() : Constraint(4) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "FEMTetConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 									const unsigned int particle3, const unsigned int particle4, 
@@ -429,11 +503,14 @@ namespace PBD
 
 		XPBD_FEMTetConstraint() : Constraint(4) {}
 		virtual int& getTypeId() const { return TYPE_ID; }
+		virtual const char* getTypeName() const { return "XPBD_FEMTetConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 									const unsigned int particle3, const unsigned int particle4, 
 									const Real stiffness, const Real poissonRatio);
 		virtual bool solvePositionConstraint(SimulationModel& model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.write(m_lambda); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.read(m_lambda); }
 	};
 
 	class StrainTetConstraint : public Constraint
@@ -448,6 +525,7 @@ namespace PBD
 
 		StrainTetConstraint() : Constraint(4) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "StrainTetConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2,
 			const unsigned int particle3, const unsigned int particle4, 
@@ -485,11 +563,58 @@ namespace PBD
 			delete[] m_numClusters;
 		}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "ShapeMatchingConstraint"; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particleIndices[], const unsigned int numClusters[], const Real stiffness);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
 	};
 
+	/** Lattice shape matching (FastLSM) of particles on a regular lattice.
+	 * Each occupied lattice cell defines a cubic region of cells with the
+	 * half width m_regionWidth. The sums over all regions are computed by
+	 * separable prefix sums along the lattice axes. So the cost of a step
+	 * does not depend on the region width.\n\n
+	 * Alec R. Rivers and Doug L. James, 
+	 * "FastLSM: Fast Lattice Shape Matching for Robust Real-Time Deformation",
+	 * ACM Transactions on Graphics 26(3), 2007
+	 */
+	class FastLatticeShapeMatchingConstraint : public Constraint
+	{
+	public:
+		static int TYPE_ID;
+		Real m_stiffness;
+		/** number of lattice cells in x, y and z direction */
+		unsigned int m_dim[3];
+		unsigned int m_regionWidth;
+		/** particle index of each cell (cell index i*dim[1]*dim[2] + j*dim[2] + k), 0xffffffff for empty cells */
+		std::vector<unsigned int> m_cellParticles;
+		/** mass weight 1/(w+eps) and rest position of each cell */
+		std::vector<Real> m_w;
+		std::vector<Vector3r> m_x0;
+		/** rest center of mass of the region of each cell */
+		std::vector<Vector3r> m_restCm;
+		/** number of regions which contain the particle of each cell */
+		std::vector<Real> m_numRegions;
+		/** sums per cell, 13 values per cell */
+		std::vector<double> m_sums;
+		/** matrix A of the region of each cell, replaced by its rotational part */
+		std::vector<Matrix3r> m_A;
+
+		FastLatticeShapeMatchingConstraint() : Constraint(0), m_regionWidth(1) {}
+		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "FastLatticeShapeMatchingConstraint"; }
+
+		virtual bool initConstraint(SimulationModel &model, const unsigned int dim[3], const unsigned int cellParticles[],
+			const unsigned int regionWidth, const Real stiffness);
+		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+		virtual unsigned int getCost() const { return static_cast<unsigned int>(m_cellParticles.size()); }
+
+	protected:
+		/** Replace the first numComponents values of each cell by their sum
+		 * over the region of the cell. */
+		void computeRegionSums(const unsigned int numComponents);
+	};
+
 	class RigidBodyContactConstraint 
 	{
 	public:
@@ -510,6 +635,9 @@ namespace PBD
 			const Vector3r &normal, const Real dist, 
 			const Real restitutionCoeff, const Real stiffness, const Real frictionCoeff);
 		virtual bool solveVelocityConstraint(SimulationModel &model, const unsigned int iter);
+
+		void saveState(Utilities::BinaryWriter &binWriter) const;
+		bool loadState(Utilities::BinaryReader &binReader);
 	};
 
 	class ParticleRigidBodyContactConstraint
@@ -532,6 +660,9 @@ namespace PBD
 			const Vector3r &normal, const Real dist,
 			const Real restitutionCoeff, const Real stiffness, const Real frictionCoeff);
 		virtual bool solveVelocityConstraint(SimulationModel &model, const unsigned int iter);
+
+		void saveState(Utilities::BinaryWriter &binWriter) const;
+		bool loadState(Utilities::BinaryReader &binReader);
 	};
 
 	class ParticleTetContactConstraint
@@ -561,6 +692,37 @@ namespace PBD
 			const Real frictionCoeff);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
 		virtual bool solveVelocityConstraint(SimulationModel &model, const unsigned int iter);
+
+		void saveState(Utilities::BinaryWriter &binWriter) const;
+		bool loadState(Utilities::BinaryReader &binReader);
+	};
+
+	/** Repulsion between cloth particles. The constraint is either a 
+	* point-triangle (point, triangle vertices) or an edge-edge contact
+	* (vertices of both edges) and only acts if the distance is smaller 
+	* than the thickness. */
+	class ClothContactConstraint
+	{
+	public:
+		static int TYPE_ID;
+		/** indices of the linked particles */
+		std::array<unsigned int, 4> m_bodies;
+		bool m_edgeEdge;
+		Real m_thickness;
+		Real m_stiffness;
+
+		ClothContactConstraint() { }
+		~ClothContactConstraint() {}
+		virtual int &getTypeId() const { return TYPE_ID; }
+
+		bool initConstraint(SimulationModel &model, const bool edgeEdge, 
+			const unsigned int particleIndex0, const unsigned int particleIndex1,
+			const unsigned int particleIndex2, const unsigned int particleIndex3,
+			const Real thickness, const Real stiffness);
+		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+
+		void saveState(Utilities::BinaryWriter &binWriter) const;
+		bool loadState(Utilities::BinaryReader &binReader);
 	};
 
 	class StretchShearConstraint : public Constraint
@@ -574,6 +736,8 @@ namespace PBD
 
 		StretchShearConstraint() : Constraint(3) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "StretchShearConstraint"; }
+		virtual unsigned int numberOfParticles() const { return 2; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int particle1, const unsigned int particle2, 
 			const unsigned int quaternion1, const Real stretchingStiffness, 
@@ -592,6 +756,8 @@ namespace PBD
 
 		BendTwistConstraint() : Constraint(2) {}
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "BendTwistConstraint"; }
+		virtual unsigned int numberOfParticles() const { return 0; }
 
 		virtual bool initConstraint(SimulationModel &model, const unsigned int quaternion1, 
 			const unsigned int quaternion2, const Real twistingStiffness,
@@ -599,6 +765,64 @@ namespace PBD
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
 	};
 
+	/** Stretch-shear and bend-twist constraints of a set of Cosserat rods (line models)
+	* which are solved as one constraint. The data of the constraints is stored contiguously 
+	* for each rod. Neighboring constraints of a rod share a particle or a quaternion, so
+	* all even and then all odd constraints of all rods are solved in parallel.
+	* Alternatively, if all rods are chains, each rod can be solved by a direct solver.
+	*/
+	class CosseratRodsConstraint : public Constraint
+	{
+	public:
+		static int TYPE_ID;
+		/** particle indices of the stretch-shear constraints (two per constraint) */
+		std::vector<unsigned int> m_stretchShearParticles;
+		/** quaternion indices of the stretch-shear constraints */
+		std::vector<unsigned int> m_stretchShearQuaternions;
+		std::vector<Real> m_restLengths;
+		/** quaternion indices of the bend-twist constraints (two per constraint) */
+		std::vector<unsigned int> m_bendTwistQuaternions;
+		std::vector<Quaternionr> m_restDarbouxVectors;
+		/** start indices of the even and the odd constraints, the last entry is the number of constraints */
+		unsigned int m_stretchShearPhases[3];
+		unsigned int m_bendTwistPhases[3];
+		Real m_stretchingStiffness;
+		Real m_shearingStiffness1;
+		Real m_shearingStiffness2;
+		Real m_twistingStiffness;
+		Real m_bendingStiffness1;
+		Real m_bendingStiffness2;
+		/** Solve each rod by a direct block-tridiagonal solver instead of Gauss-Seidel iterations */
+		bool m_directSolver;
+		/** true if the edges of all rods form chains, which is required by the direct solver */
+		bool m_isChain;
+		/** start index of each rod in m_rodStretchShear, the last entry is the number of edges */
+		std::vector<unsigned int> m_rodOffsets;
+		/** indices of the stretch-shear constraints of the rods in the order of the edges */
+		std::vector<unsigned int> m_rodStretchShear;
+		/** indices of the bend-twist constraints of the rods in the order of the edges, rod i starts at m_rodOffsets[i]
+		 * (the entry of the last edge of a rod is unused, so rods without edges need no special case) */
+		std::vector<unsigned int> m_rodBendTwist;
+		/** number of particles in m_bodies, they are followed by the quaternion indices */
+		unsigned int m_numParticles;
+
+		CosseratRodsConstraint() : Constraint(0), m_directSolver(false), m_isChain(false), m_numParticles(0) {}
+		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "CosseratRodsConstraint"; }
+		virtual unsigned int numberOfParticles() const { return m_numParticles; }
+
+		virtual bool initConstraint(SimulationModel &model, const std::vector<unsigned int> &lineModelIndices, 
+			const Real stretchingStiffness, const Real shearingStiffness1, const Real shearingStiffness2,
+			const Real twistingStiffness, const Real bendingStiffness1, const Real bendingStiffness2);
+		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+		virtual unsigned int getCost() const { return static_cast<unsigned int>(m_restLengths.size() + m_restDarbouxVectors.size()); }
+
+	protected:
+		void solveStretchShearConstraints(SimulationModel &model, const unsigned int start, const unsigned int end);
+		void solveBendTwistConstraints(SimulationModel &model, const unsigned int start, const unsigned int end);
+		void solveRodsDirect(SimulationModel &model);
+	};
+
 	class StretchBendingTwistingConstraint : public Constraint
 	{
 		using Matrix6r = Eigen::Matrix<Real, 6, 6, Eigen::DontAlign>;
@@ -618,12 +842,16 @@ namespace PBD
 		StretchBendingTwistingConstraint() : Constraint(2){}
 
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "StretchBendingTwistingConstraint"; }
+		virtual unsigned int numberOfParticles() const { return 0; }
 
 		bool initConstraint(SimulationModel &model, const unsigned int segmentIndex1, const unsigned int segmentIndex2, const Vector3r &pos,
 			const Real averageRadius, const Real averageSegmentLength, Real youngsModulus, Real torsionModulus);
 		virtual bool initConstraintBeforeProjection(SimulationModel &model);
 		virtual bool updateConstraint(SimulationModel &model);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.writeMatrix(m_lambdaSum); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.readMatrix(m_lambdaSum); }
 	};
 
 	struct Node;
@@ -680,10 +908,12 @@ namespace PBD
 		static int TYPE_ID;
 
 		DirectPositionBasedSolverForStiffRodsConstraint() :  Constraint(2),
-			root(NULL), numberOfIntervals(0), intervals(NULL), forward(NULL), backward(NULL){}
+			m_refactorizationTolerance(0.0), intervals(NULL), numberOfIntervals(0) {}
 		~DirectPositionBasedSolverForStiffRodsConstraint();
 
 		virtual int &getTypeId() const { return TYPE_ID; }
+		virtual const char *getTypeName() const { return "DirectPositionBasedSolverForStiffRodsConstraint"; }
+		virtual unsigned int numberOfRigidBodies() const { return numberOfBodies(); }
 
 		bool initConstraint(SimulationModel &model,
 			const std::vector<std::pair<unsigned int, unsigned int>> & constraintSegmentIndices,
@@ -696,19 +926,22 @@ namespace PBD
 		virtual bool initConstraintBeforeProjection(SimulationModel &model);
 		virtual bool updateConstraint(SimulationModel &model);
 		virtual bool solvePositionConstraint(SimulationModel &model, const unsigned int iter);
+		/** The cost is proportional to the number of nodes in the tree of the direct solver. */
+		virtual unsigned int getCost() const { return static_cast<unsigned int>(m_Segments.size() + m_Constraints.size()); }
+
+		virtual void saveState(Utilities::BinaryWriter &binWriter) const { binWriter.writeVector(m_lambdaSums); }
+		virtual bool loadState(Utilities::BinaryReader &binReader) { return binReader.readVector(m_lambdaSums, m_lambdaSums.size()); }
+
+		/** The factorization of the system matrix is reused as long as no quaternion coefficient 
+		* of a segment changed more than this tolerance. 0 refactorizes in every iteration. */
+		Real m_refactorizationTolerance;
 
 	protected:
 		
-		/** root node */
-		Node *root;
-		/** intervals of constraints */
+		/** intervals of constraints, each one stores the nodes of its tree in elimination order */
 		Interval *intervals;
 		/** number of intervals */
 		int numberOfIntervals;		
-		/** list to process nodes with increasing row index in the system matrix H (from the leaves to the root) */
-		std::list <Node*> *forward;
-		/** list to process nodes starting with the highest row index to row index zero in the matrix H (from the root to the leaves) */
-		std::list <Node*> *backward;
 
 		std::vector<RodConstraintImpl> m_Constraints;
 		std::vector<RodConstraint*> m_rodConstraints;
@@ -721,8 +954,6 @@ namespace PBD
 		std::vector<std::vector<Matrix3r>> m_bendingAndTorsionJacobians;
 		std::vector<Vector3r> m_corr_x;
 		std::vector<Quaternionr> m_corr_q;
-
-		void deleteNodes();
 	};
 }
 
@@ -30,7 +30,7 @@ void CubicSDFCollisionDetection::addCubicSDFCollisionObject(const unsigned int b
 	co->m_scale = scale;
 	co->m_sdf = std::make_shared<Grid>(co->m_sdfFile);
  	co->m_bvh.init(vertices, numVertices);
- 	co->m_bvh.construct();
+ 	constructBVH(co);
 	co->m_testMesh = testMesh;
 	co->m_invertSDF = 1.0;
 	if (invertSDF)
@@ -47,7 +47,7 @@ void PBD::CubicSDFCollisionDetection::addCubicSDFCollisionObject(const unsigned
 	co->m_scale = scale;
 	co->m_sdf = sdf;
 	co->m_bvh.init(vertices, numVertices);
-	co->m_bvh.construct();
+	constructBVH(co);
 	co->m_testMesh = testMesh;
 	co->m_invertSDF = 1.0;
 	if (invertSDF)
@@ -72,6 +72,29 @@ double CubicSDFCollisionDetection::CubicSDFCollisionObject::distance(const Eigen
 	return m_invertSDF * m_scale[0]*dist - tolerance;
 }
 
+double CubicSDFCollisionDetection::CubicSDFCollisionObject::distanceLowerBound(const Eigen::Vector3d &x, const Real tolerance)
+{
+	const double dist = distance(x, tolerance);
+	// Outside of the grid the point is inside of an inverted SDF, so there is no bound.
+	if ((dist != std::numeric_limits<double>::max()) || (m_invertSDF < 0.0))
+		return dist;
+
+	// The surface lies in the domain of the grid, so the distance to the 
+	// domain box is a lower bound. A tighter one follows from the distance 
+	// at the closest point of the domain (triangle inequality).
+	const Eigen::AlignedBox3d &domain = m_sdf->domain();
+	const Eigen::Vector3d s = m_scale.template cast<double>();
+	const Eigen::Vector3d scaled_x = x.cwiseProduct(s.cwiseInverse());
+	const double minScale = s.cwiseAbs().minCoeff();
+	const double eps = 1.0e-6 * domain.diagonal().norm();
+	const Eigen::Vector3d p = scaled_x.array().max(domain.min().array() + eps).min(domain.max().array() - eps).matrix();
+	const double boxDist = minScale * domain.exteriorDistance(scaled_x) - tolerance;
+	const double pDist = distance(p.cwiseProduct(s), tolerance);
+	if (pDist == std::numeric_limits<double>::max())
+		return boxDist;
+	return std::max(boxDist, pDist - (x - p.cwiseProduct(s)).norm());
+}
+
 bool CubicSDFCollisionDetection::CubicSDFCollisionObject::collisionTest(const Vector3r &x, const Real tolerance, Vector3r &cp, Vector3r &n, Real &dist, const Real maxDist)
 {
 	const Vector3r scaled_x = x.cwiseProduct(m_scale.cwiseInverse());
@@ -29,6 +29,7 @@ namespace PBD
 			virtual int &getTypeId() const { return TYPE_ID; }
 			virtual bool collisionTest(const Vector3r &x, const Real tolerance, Vector3r &cp, Vector3r &n, Real &dist, const Real maxDist = 0.0);
 			virtual double distance(const Eigen::Vector3d &x, const Real tolerance);
+			virtual double distanceLowerBound(const Eigen::Vector3d &x, const Real tolerance);
 		};
 
 	public:
@@ -1,5 +1,7 @@
 #include "DistanceFieldCollisionDetection.h"
 #include "Simulation/IDFactory.h"
+#include "Utils/ScratchArena.h"
+#include "Utils/Timing.h"
 #include "omp.h"
 
 using namespace PBD;
@@ -17,6 +19,8 @@ int DistanceFieldCollisionDetection::DistanceFieldCollisionObjectWithoutGeometry
 DistanceFieldCollisionDetection::DistanceFieldCollisionDetection() :
 	CollisionDetection()
 {
+	m_deferBVHConstruction = false;
+	m_firstDeferredObject = 0;
 }
 
 DistanceFieldCollisionDetection::~DistanceFieldCollisionDetection()
@@ -26,34 +30,51 @@ DistanceFieldCollisionDetection::~DistanceFieldCollisionDetection()
 void DistanceFieldCollisionDetection::collisionDetection(SimulationModel &model)
 {
 	model.resetContacts();
-	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
-	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
-	const SimulationModel::TetModelVector &tetModels = model.getTetModels();
-	const ParticleData &pd = model.getParticles();
+	updateCollisionObjects(model, false);
+	determineCollisionPairs(model, 0.0);
+	narrowPhase(model);
+}
 
-	std::vector < std::pair<unsigned int, unsigned int>> coPairs;
-	for (unsigned int i = 0; i < m_collisionObjects.size(); i++)
+void DistanceFieldCollisionDetection::substepCollisionDetection(SimulationModel &model, const bool updatePairs, const Real timeHorizon)
+{
+	model.resetContacts();
+	if (updatePairs || (m_sweptAABBs.size() != m_collisionObjects.size()))
 	{
-		CollisionDetection::CollisionObject *co1 = m_collisionObjects[i];
-		for (unsigned int k = 0; k < m_collisionObjects.size(); k++)
+		updateCollisionObjects(model, false);
+		determineCollisionPairs(model, timeHorizon);
+	}
+	else
+	{
+		// Only the bounding volume hierarchies of objects in collision pairs 
+		// are refitted. The pairs are determined again if an object left its 
+		// swept bounding box.
+		updateCollisionObjects(model, true);
+		bool valid = true;
+		for (unsigned int i = 0; i < m_collisionObjects.size(); i++)
 		{
-			CollisionDetection::CollisionObject *co2 = m_collisionObjects[k];
-			if ((i != k))
+			const AABB &aabb = m_collisionObjects[i]->m_aabb;
+			if ((aabb.m_p[0].array() < m_sweptAABBs[i].m_p[0].array()).any() ||
+				(aabb.m_p[1].array() > m_sweptAABBs[i].m_p[1].array()).any())
 			{
-				// ToDo: self collisions for deformables
-				coPairs.push_back({ i, k });
+				valid = false;
+				break;
 			}
 		}
+		if (!valid)
+		{
+			updateCollisionObjects(model, false);
+			determineCollisionPairs(model, timeHorizon);
+		}
 	}
+	narrowPhase(model);
+}
 
-	//omp_set_num_threads(1);
-	std::vector<std::vector<ContactData> > contacts_mt;	
-#ifdef _DEBUG
-	const unsigned int maxThreads = 1;
-#else
-	const unsigned int maxThreads = omp_get_max_threads();
-#endif
-	contacts_mt.resize(maxThreads);
+void DistanceFieldCollisionDetection::updateCollisionObjects(SimulationModel &model, const bool activeOnly)
+{
+	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
+	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
+	const SimulationModel::TetModelVector &tetModels = model.getTetModels();
+	const ParticleData &pd = model.getParticles();
 
 	#pragma omp parallel default(shared)
 	{
@@ -62,7 +83,13 @@ void DistanceFieldCollisionDetection::collisionDetection(SimulationModel &model)
 		for (int i = 0; i < (int)m_collisionObjects.size(); i++)
 		{
 			CollisionDetection::CollisionObject *co = m_collisionObjects[i];
+			// the mesh of a sleeping body is not updated, so its AABB does not change
+			if ((co->m_bodyType == CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) &&
+				rigidBodies[co->m_bodyIndex]->isSleeping())
+				continue;
 			updateAABB(model, co);
+			if (activeOnly && !m_activeObjects[i])
+				continue;
 			if (isDistanceFieldCollisionObject(co))
 			{
 				if (co->m_bodyType == CollisionDetection::CollisionObject::TriangleModelCollisionObjectType) 
@@ -93,21 +120,118 @@ void DistanceFieldCollisionDetection::collisionDetection(SimulationModel &model)
 				}
 			}
 		}
+	}
+}
 
-		#pragma omp for schedule(static)
-		for (int i = 0; i < (int)coPairs.size(); i++)
+void DistanceFieldCollisionDetection::determineCollisionPairs(SimulationModel &model, const Real timeHorizon)
+{
+	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
+	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
+	const SimulationModel::TetModelVector &tetModels = model.getTetModels();
+	const ParticleData &pd = model.getParticles();
+	const int numObjects = (int)m_collisionObjects.size();
+
+	// The bounding boxes are extended by the distance which the objects 
+	// can travel with their current velocities in the given time.
+	m_sweptAABBs.resize(numObjects);
+	#pragma omp parallel if(numObjects > MIN_PARALLEL_SIZE) default(shared)
+	{
+		#pragma omp for schedule(static)  
+		for (int i = 0; i < numObjects; i++)
 		{
-			std::pair<unsigned int, unsigned int> &coPair = coPairs[i];
-			CollisionDetection::CollisionObject *co1 = m_collisionObjects[coPair.first];
-			CollisionDetection::CollisionObject *co2 = m_collisionObjects[coPair.second];
+			CollisionDetection::CollisionObject *co = m_collisionObjects[i];
+			Real speed = 0.0;
+			if (timeHorizon > 0.0)
+			{
+				if (co->m_bodyType == CollisionDetection::CollisionObject::RigidBodyCollisionObjectType)
+				{
+					RigidBody *rb = rigidBodies[co->m_bodyIndex];
+					if (!rb->isSleeping())
+						speed = rb->getVelocity().norm() + rb->getAngularVelocity().norm() * rb->getGeometry().getBoundingRadius();
+				}
+				else
+				{
+					unsigned int offset = 0;
+					unsigned int numVert = 0;
+					if (co->m_bodyType == CollisionDetection::CollisionObject::TriangleModelCollisionObjectType)
+					{
+						offset = triModels[co->m_bodyIndex]->getIndexOffset();
+						numVert = triModels[co->m_bodyIndex]->getParticleMesh().numVertices();
+					}
+					else if (co->m_bodyType == CollisionDetection::CollisionObject::TetModelCollisionObjectType)
+					{
+						offset = tetModels[co->m_bodyIndex]->getIndexOffset();
+						numVert = tetModels[co->m_bodyIndex]->getParticleMesh().numVertices();
+					}
+					for (unsigned int j = offset; j < offset + numVert; j++)
+						speed = std::max(speed, pd.getVelocity(j).squaredNorm());
+					speed = sqrt(speed);
+				}
+			}
+			const Vector3r d = Vector3r::Constant(speed * timeHorizon);
+			m_sweptAABBs[i].m_p[0] = co->m_aabb.m_p[0] - d;
+			m_sweptAABBs[i].m_p[1] = co->m_aabb.m_p[1] + d;
+		}
+	}
 
-			if (((co2->m_bodyType != CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) &&
+	m_collisionPairs.clear();
+	m_activeObjects.assign(numObjects, 0);
+	for (int i = 0; i < numObjects; i++)
+	{
+		CollisionDetection::CollisionObject *co1 = m_collisionObjects[i];
+		if (!isDistanceFieldCollisionObject(co1))
+			continue;
+		for (int k = 0; k < numObjects; k++)
+		{
+			CollisionDetection::CollisionObject *co2 = m_collisionObjects[k];
+			// self collisions of cloth are handled by clothCollisionDetection
+			if ((i == k) || 
+				((co2->m_bodyType != CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) &&
 				(co2->m_bodyType != CollisionDetection::CollisionObject::TetModelCollisionObjectType)) ||
-				!isDistanceFieldCollisionObject(co1) ||
 				!isDistanceFieldCollisionObject(co2) ||
-				!AABB::intersection(co1->m_aabb, co2->m_aabb))
+				!AABB::intersection(m_sweptAABBs[i], m_sweptAABBs[k]))
 				continue;
+			m_collisionPairs.push_back({ (unsigned int)i, (unsigned int)k });
+			m_activeObjects[i] = 1;
+			m_activeObjects[k] = 1;
+		}
+	}
+	m_statistics.m_numBroadPhasePairs = (unsigned int)m_collisionPairs.size();
+}
 
+void DistanceFieldCollisionDetection::narrowPhase(SimulationModel &model)
+{
+	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
+	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
+	const SimulationModel::TetModelVector &tetModels = model.getTetModels();
+	const ParticleData &pd = model.getParticles();
+
+	//omp_set_num_threads(1);
+	std::vector<std::vector<ContactData> > &contacts_mt = m_contacts_mt;	
+#ifdef _DEBUG
+	const unsigned int maxThreads = 1;
+#else
+	const unsigned int maxThreads = omp_get_max_threads();
+#endif
+	contacts_mt.resize(maxThreads);
+	for (unsigned int i = 0; i < maxThreads; i++)
+		contacts_mt[i].clear();
+
+	#pragma omp parallel default(shared)
+	{
+		START_TIMING("narrow phase");
+		unsigned int numTests = 0;
+		#pragma omp for schedule(static) nowait
+		for (int i = 0; i < (int)m_collisionPairs.size(); i++)
+		{
+			std::pair<unsigned int, unsigned int> &coPair = m_collisionPairs[i];
+			CollisionDetection::CollisionObject *co1 = m_collisionObjects[coPair.first];
+			CollisionDetection::CollisionObject *co2 = m_collisionObjects[coPair.second];
+
+			// the pairs may stem from the swept bounding boxes of a previous substep
+			if (!AABB::intersection(co1->m_aabb, co2->m_aabb))
+				continue;
+			numTests++;
 
 			if ((co1->m_bodyType == CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) &&
 				(co2->m_bodyType == CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) &&
@@ -171,6 +295,10 @@ void DistanceFieldCollisionDetection::collisionDetection(SimulationModel &model)
  				);
  			}
 		}
+
+		#pragma omp atomic
+		m_statistics.m_numNarrowPhaseTests += numTests;
+		STOP_TIMING_AVG;
 	}
 
 	for (unsigned int i = 0; i < contacts_mt.size(); i++)
@@ -194,6 +322,10 @@ void DistanceFieldCollisionDetection::collisionDetection(SimulationModel &model)
 			}
 		}
 	}
+
+	// collisions of cloth with itself and other cloth models
+	if (m_clothCollisions)
+		clothCollisionDetection(model);
 }
 
 void DistanceFieldCollisionDetection::collisionDetectionRigidBodies(RigidBody *rb1, DistanceFieldCollisionObject *co1, RigidBody *rb2, DistanceFieldCollisionObject *co2, 
@@ -201,10 +333,15 @@ void DistanceFieldCollisionDetection::collisionDetectionRigidBodies(RigidBody *r
 	, std::vector<std::vector<ContactData> > &contacts_mt
 	)
 {
-	if ((rb1->getMass() == 0.0) && (rb2->getMass() == 0.0))
+	// static or sleeping bodies cannot collide with each other
+	if (((rb1->getMass() == 0.0) || rb1->isSleeping()) && ((rb2->getMass() == 0.0) || rb2->isSleeping()))
 		return;
 
-	const VertexData &vd = rb1->getGeometry().getVertexData();
+	// the world space vertices of the geometry are updated lazily, so the
+	// local vertices are transformed here
+	const VertexData &vd = rb1->getGeometry().getVertexDataLocal();
+	const Matrix3r &R1 = rb1->getRotationMatrix();
+	const Vector3r &com1 = rb1->getPosition();
 
 	const Vector3r &com2 = rb2->getPosition();
 
@@ -223,7 +360,7 @@ void DistanceFieldCollisionDetection::collisionDetectionRigidBodies(RigidBody *r
 	const Vector3r &v2 = rb2->getTransformationV2();
 
 	const PointCloudBSH &bvh = ((DistanceFieldCollisionDetection::DistanceFieldCollisionObject*) co1)->m_bvh;
-	std::function<bool(unsigned int, unsigned int)> predicate = [&](unsigned int node_index, unsigned int depth)
+	auto predicate = [&](unsigned int node_index, unsigned int depth)
 	{
 		const BoundingSphere &bs = bvh.hull(node_index);
 		const Vector3r &sphere_x = bs.x();
@@ -247,8 +384,10 @@ void DistanceFieldCollisionDetection::collisionDetectionRigidBodies(RigidBody *r
 		}
 		return false;
 	};
-	std::function<void(unsigned int, unsigned int)> cb = [&](unsigned int node_index, unsigned int depth)
+	std::size_t numNodesVisited = 0;
+	auto cb = [&](unsigned int node_index, unsigned int depth)
 	{
+		numNodesVisited++;
 		auto const& node = bvh.node(node_index);
 		if (!node.is_leaf())
 			return;
@@ -256,7 +395,7 @@ void DistanceFieldCollisionDetection::collisionDetectionRigidBodies(RigidBody *r
 		for (auto i = node.begin; i < node.begin + node.n; ++i)
 		{
 			unsigned int index = bvh.entity(i);
-			const Vector3r &x_w = vd.getPosition(index);
+			const Vector3r x_w = R1 * vd.getPosition(index) + com1;
 			const Vector3r x = R * (x_w - com2) + v1;
 			Vector3r cp, n;
 			Real dist;
@@ -276,6 +415,9 @@ void DistanceFieldCollisionDetection::collisionDetectionRigidBodies(RigidBody *r
 		}
 	};
 	bvh.traverse_depth_first(predicate, cb);
+
+	#pragma omp atomic
+	m_statistics.m_numBVHNodesVisited += numNodesVisited;
 }
 
 
@@ -303,7 +445,7 @@ void DistanceFieldCollisionDetection::collisionDetectionRBSolid(const ParticleDa
 
 	const PointCloudBSH &bvh = ((DistanceFieldCollisionDetection::DistanceFieldCollisionObject*) co1)->m_bvh;
 
-	std::function<bool(unsigned int, unsigned int)> predicate = [&](unsigned int node_index, unsigned int depth)
+	auto predicate = [&](unsigned int node_index, unsigned int depth)
 	{
 		const BoundingSphere &bs = bvh.hull(node_index);
 		const Vector3r &sphere_x_w = bs.x();
@@ -327,8 +469,10 @@ void DistanceFieldCollisionDetection::collisionDetectionRBSolid(const ParticleDa
 		return false;
 	};
 
-	std::function<void(unsigned int, unsigned int)> cb = [&](unsigned int node_index, unsigned int depth)
+	std::size_t numNodesVisited = 0;
+	auto cb = [&](unsigned int node_index, unsigned int depth)
 	{
+		numNodesVisited++;
 		auto const& node = bvh.node(node_index);
 		if (!node.is_leaf())
 			return;
@@ -356,6 +500,9 @@ void DistanceFieldCollisionDetection::collisionDetectionRBSolid(const ParticleDa
 	};
 
 	bvh.traverse_depth_first(predicate, cb);
+
+	#pragma omp atomic
+	m_statistics.m_numBVHNodesVisited += numNodesVisited;
 }
 
 void DistanceFieldCollisionDetection::collisionDetectionSolidSolid(const ParticleData &pd, const unsigned int offset, const unsigned int numVert,
@@ -370,10 +517,12 @@ void DistanceFieldCollisionDetection::collisionDetectionSolidSolid(const Particl
 	const unsigned int offset2 = tm2->getIndexOffset();
 
 
+	std::size_t numNodesVisited = 0;
 	// callback function for BVH which is called if a leaf node in the point cloud BVH
 	// has a collision with a leaf node in the tet BVH
-	std::function<void(unsigned int, unsigned int)> cb = [&](unsigned int node_index1, unsigned int node_index2)
+	auto cb = [&](unsigned int node_index1, unsigned int node_index2)
 	{
+		numNodesVisited++;
 		auto const& node1 = bvh1.node(node_index1);
 		auto const& node2 = bvh2.node(node_index2);
 
@@ -480,8 +629,308 @@ void DistanceFieldCollisionDetection::collisionDetectionSolidSolid(const Particl
 
 	BVHTest::traverse(bvh1, bvh2, cb);
 
+	#pragma omp atomic
+	m_statistics.m_numBVHNodesVisited += numNodesVisited;
 }
 
+/** Rotation angle between two orientations */
+static Real rotationAngle(const Quaternionr &q0, const Quaternionr &q1)
+{
+	const Real d = std::min(std::abs(q0.dot(q1)), static_cast<Real>(1.0));
+	return static_cast<Real>(2.0) * acos(d);
+}
+
+void DistanceFieldCollisionDetection::continuousCollisionDetection(SimulationModel &model)
+{
+	if (!m_continuousCollisionDetection)
+		return;
+
+	const SimulationModel::RigidBodyVector &rigidBodies = model.getRigidBodies();
+	const SimulationModel::TriangleModelVector &triModels = model.getTriangleModels();
+	const SimulationModel::TetModelVector &tetModels = model.getTetModels();
+	ParticleData &pd = model.getParticles();
+
+	// the state at the beginning of the step is not available, 
+	// e.g. if bodies were added after the step started
+	if ((m_startX.size() != rigidBodies.size()) || (m_startParticleX.size() != pd.size()))
+		return;
+
+	ScratchArena::Scope scope;
+
+	// swept bounding boxes of the rigid bodies
+	const unsigned int numBodies = (unsigned int)rigidBodies.size();
+	ScratchVector<AABB> sweptAABBs(numBodies);
+	ScratchVector<char> fast(numBodies);
+	for (unsigned int i = 0; i < numBodies; i++)
+	{
+		RigidBody *rb = rigidBodies[i];
+		const Real r = rb->getGeometry().getBoundingRadius();
+		const Real motion = (rb->getPosition() - m_startX[i]).norm() + rotationAngle(m_startQ[i], rb->getRotation()) * r;
+		fast[i] = (rb->getMass() != 0.0) && (motion > m_ccdMotionThreshold);
+		sweptAABBs[i].m_p[0] = m_startX[i].cwiseMin(rb->getPosition()) - Vector3r(r, r, r);
+		sweptAABBs[i].m_p[1] = m_startX[i].cwiseMax(rb->getPosition()) + Vector3r(r, r, r);
+	}
+
+	// pairs of rigid bodies where at least one body is fast
+	ScratchVector<std::pair<unsigned int, unsigned int>> coPairs;
+	ScratchVector<unsigned int> rbCollisionObjects;
+	for (unsigned int i = 0; i < m_collisionObjects.size(); i++)
+	{
+		CollisionDetection::CollisionObject *co1 = m_collisionObjects[i];
+		if ((co1->m_bodyType != CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) ||
+			!isDistanceFieldCollisionObject(co1))
+			continue;
+		rbCollisionObjects.push_back(i);
+		if (!((DistanceFieldCollisionObject*)co1)->m_testMesh)
+			continue;
+
+		for (unsigned int k = 0; k < m_collisionObjects.size(); k++)
+		{
+			CollisionDetection::CollisionObject *co2 = m_collisionObjects[k];
+			if ((i == k) ||
+				(co2->m_bodyType != CollisionDetection::CollisionObject::RigidBodyCollisionObjectType) ||
+				!isDistanceFieldCollisionObject(co2))
+				continue;
+			if ((!fast[co1->m_bodyIndex] && !fast[co2->m_bodyIndex]) ||
+				!AABB::intersection(sweptAABBs[co1->m_bodyIndex], sweptAABBs[co2->m_bodyIndex]))
+				continue;
+			coPairs.push_back({ i, k });
+		}
+	}
+
+	ScratchVector<Real> pairToi(coPairs.size(), 1.0);
+	#pragma omp parallel default(shared)
+	{
+		#pragma omp for schedule(static)
+		for (int i = 0; i < (int)coPairs.size(); i++)
+		{
+			DistanceFieldCollisionObject *co1 = (DistanceFieldCollisionObject*) m_collisionObjects[coPairs[i].first];
+			DistanceFieldCollisionObject *co2 = (DistanceFieldCollisionObject*) m_collisionObjects[coPairs[i].second];
+			Real toi;
+			if (sweepRigidBodies(co1->m_bodyIndex, rigidBodies[co1->m_bodyIndex], co1, co2->m_bodyIndex, rigidBodies[co2->m_bodyIndex], co2, toi))
+				pairToi[i] = toi;
+		}
+	}
+
+	// move fast bodies back to their earliest time of impact
+	ScratchVector<Real> bodyToi(numBodies, 1.0);
+	for (unsigned int i = 0; i < coPairs.size(); i++)
+	{
+		const unsigned int rbIndex1 = m_collisionObjects[coPairs[i].first]->m_bodyIndex;
+		const unsigned int rbIndex2 = m_collisionObjects[coPairs[i].second]->m_bodyIndex;
+		if (fast[rbIndex1])
+			bodyToi[rbIndex1] = std::min(bodyToi[rbIndex1], pairToi[i]);
+		if (fast[rbIndex2])
+			bodyToi[rbIndex2] = std::min(bodyToi[rbIndex2], pairToi[i]);
+	}
+	for (unsigned int i = 0; i < numBodies; i++)
+	{
+		if (bodyToi[i] < 1.0)
+		{
+			RigidBody *rb = rigidBodies[i];
+			const Real t = bodyToi[i];
+			rb->getPosition() = (static_cast<Real>(1.0) - t) * m_startX[i] + t * rb->getPosition();
+			rb->getRotation() = m_startQ[i].slerp(t, rb->getRotation());
+			rb->rotationUpdated();
+			rb->getGeometry().updateMeshTransformation(rb->getPosition(), rb->getRotationMatrix());
+			sweptAABBs[i].m_p[0] = m_startX[i].cwiseMin(rb->getPosition()) - Vector3r::Constant(rb->getGeometry().getBoundingRadius());
+			sweptAABBs[i].m_p[1] = m_startX[i].cwiseMax(rb->getPosition()) + Vector3r::Constant(rb->getGeometry().getBoundingRadius());
+		}
+	}
+
+	// fast particles of deformable models against the rigid bodies
+	for (unsigned int i = 0; i < m_collisionObjects.size(); i++)
+	{
+		CollisionDetection::CollisionObject *co1 = m_collisionObjects[i];
+		if (!isDistanceFieldCollisionObject(co1) || !((DistanceFieldCollisionObject*)co1)->m_testMesh)
+			continue;
+
+		unsigned int offset, numVert;
+		if (co1->m_bodyType == CollisionDetection::CollisionObject::TriangleModelCollisionObjectType)
+		{
+			offset = triModels[co1->m_bodyIndex]->getIndexOffset();
+			numVert = triModels[co1->m_bodyIndex]->getParticleMesh().numVertices();
+		}
+		else if (co1->m_bodyType == CollisionDetection::CollisionObject::TetModelCollisionObjectType)
+		{
+			offset = tetModels[co1->m_bodyIndex]->getIndexOffset();
+			numVert = tetModels[co1->m_bodyIndex]->getParticleMesh().numVertices();
+		}
+		else
+			continue;
+
+		#pragma omp parallel if(numVert > MIN_PARALLEL_SIZE) default(shared)
+		{
+			#pragma omp for schedule(static)
+			for (int j = 0; j < (int)numVert; j++)
+			{
+				const unsigned int index = offset + j;
+				if (pd.getMass(index) == 0.0)
+					continue;
+				const Vector3r &x0 = m_startParticleX[index];
+				const Vector3r x1 = pd.getPosition(index);
+				if ((x1 - x0).norm() <= m_ccdMotionThreshold)
+					continue;
+
+				AABB aabb;
+				aabb.m_p[0] = x0.cwiseMin(x1);
+				aabb.m_p[1] = x0.cwiseMax(x1);
+				Real minToi = 1.0;
+				for (unsigned int k = 0; k < rbCollisionObjects.size(); k++)
+				{
+					DistanceFieldCollisionObject *co2 = (DistanceFieldCollisionObject*) m_collisionObjects[rbCollisionObjects[k]];
+					if (!AABB::intersection(aabb, sweptAABBs[co2->m_bodyIndex]))
+						continue;
+					Real toi;
+					if (sweepParticle(x0, x1, co2->m_bodyIndex, rigidBodies[co2->m_bodyIndex], co2, toi))
+						minToi = std::min(minToi, toi);
+				}
+				if (minToi < 1.0)
+					pd.getPosition(index) = x0 + minToi * (x1 - x0);
+			}
+		}
+	}
+
+	// vertex-triangle and edge-edge sweeps of the cloth models
+	if (m_clothCollisions)
+		clothContinuousCollisionDetection(model);
+}
+
+bool DistanceFieldCollisionDetection::conservativeAdvancement(const std::function<Real(const Real, Real&)> &distance, Real &toi)
+{
+	Real bound;
+	Real d = distance(0.0, bound);
+	// penetrations at the beginning of the step are handled by the discrete collision detection
+	if ((d == std::numeric_limits<Real>::max()) || (d <= 0.0))
+		return false;
+
+	// Objects are advanced until their distance is in [0.5*delta, delta] 
+	// so that the discrete collision detection generates a contact. Objects 
+	// which are already in contact are only stopped if they get closer.
+	Real delta = std::max(m_tolerance, static_cast<Real>(1.0e-6));
+	if (d < delta)
+		delta = static_cast<Real>(0.5) * d;
+
+	const unsigned int maxIterations = 50;
+	Real t = 0.0;
+	for (unsigned int iter = 0; iter < maxIterations; iter++)
+	{
+		if (bound < static_cast<Real>(1.0e-9))
+			return false;
+		t += (d - static_cast<Real>(0.5) * delta) / bound;
+		if (t >= 1.0)
+			return false;
+		d = distance(t, bound);
+		if (d == std::numeric_limits<Real>::max())
+			return false;
+		if (d < delta)
+		{
+			toi = t;
+			return true;
+		}
+	}
+	// no convergence, but t is still free of collisions
+	toi = t;
+	return true;
+}
+
+bool DistanceFieldCollisionDetection::sweepRigidBodies(const unsigned int rbIndex1, RigidBody *rb1, DistanceFieldCollisionObject *co1,
+	const unsigned int rbIndex2, RigidBody *rb2, DistanceFieldCollisionObject *co2, Real &toi)
+{
+	const Vector3r &x1_0 = m_startX[rbIndex1];
+	const Quaternionr &q1_0 = m_startQ[rbIndex1];
+	const Vector3r &x1_1 = rb1->getPosition();
+	const Quaternionr &q1_1 = rb1->getRotation();
+	const Vector3r &x2_0 = m_startX[rbIndex2];
+	const Quaternionr &q2_0 = m_startQ[rbIndex2];
+	const Vector3r &x2_1 = rb2->getPosition();
+	const Quaternionr &q2_1 = rb2->getRotation();
+
+	const Real r1 = rb1->getGeometry().getBoundingRadius();
+	const Real r2 = rb2->getGeometry().getBoundingRadius();
+	const Real linearMotion = (x1_1 - x1_0).norm() + (x2_1 - x2_0).norm();
+	const Real angle1 = rotationAngle(q1_0, q1_1);
+	const Real angle2 = rotationAngle(q2_0, q2_1);
+
+	// transformation world to local of the distance field (see collisionDetectionRigidBodies)
+	// at the interpolated orientation of body 2
+	const Quaternionr q2_MAT = rb2->getRotationInitial().inverse() * rb2->getRotationMAT();
+	const Vector3r &v1 = rb2->getTransformationV1();
+
+	const VertexData &vd = rb1->getGeometry().getVertexDataLocal();
+	const PointCloudBSH &bvh = co1->m_bvh;
+
+	std::function<Real(const Real, Real&)> distance = [&](const Real t, Real &bound)
+	{
+		const Matrix3r R1 = q1_0.slerp(t, q1_1).matrix();
+		const Vector3r x1 = (static_cast<Real>(1.0) - t) * x1_0 + t * x1_1;
+		const Matrix3r R = (q2_MAT * q2_0.slerp(t, q2_1).inverse()).matrix();
+		const Vector3r x2 = (static_cast<Real>(1.0) - t) * x2_0 + t * x2_1;
+
+		Real dMin = std::numeric_limits<Real>::max();
+		auto predicate = [&](unsigned int node_index, unsigned int depth)
+		{
+			const BoundingSphere &bs = bvh.hull(node_index);
+			const Vector3r x = R * (R1 * bs.x() + x1 - x2) + v1;
+			const double dist = co2->distanceLowerBound(x.template cast<double>(), 0.0);
+			if (dist == std::numeric_limits<double>::max())
+				return true;
+			return static_cast<Real>(dist) - bs.r() < dMin;
+		};
+		auto cb = [&](unsigned int node_index, unsigned int depth)
+		{
+			auto const& node = bvh.node(node_index);
+			if (!node.is_leaf())
+				return;
+
+			for (auto i = node.begin; i < node.begin + node.n; ++i)
+			{
+				const Vector3r x = R * (R1 * vd.getPosition(bvh.entity(i)) + x1 - x2) + v1;
+				const double dist = co2->distanceLowerBound(x.template cast<double>(), 0.0);
+				if (dist != std::numeric_limits<double>::max())
+					dMin = std::min(dMin, static_cast<Real>(dist));
+			}
+		};
+		bvh.traverse_depth_first(predicate, cb);
+
+		// points close to body 2 are at most r2 + dMin away from its center
+		bound = linearMotion + angle1 * r1 + angle2 * (r2 + std::max(dMin, static_cast<Real>(0.0)));
+		return dMin;
+	};
+	return conservativeAdvancement(distance, toi);
+}
+
+bool DistanceFieldCollisionDetection::sweepParticle(const Vector3r &x0, const Vector3r &x1,
+	const unsigned int rbIndex2, RigidBody *rb2, DistanceFieldCollisionObject *co2, Real &toi)
+{
+	const Vector3r &x2_0 = m_startX[rbIndex2];
+	const Quaternionr &q2_0 = m_startQ[rbIndex2];
+	const Vector3r &x2_1 = rb2->getPosition();
+	const Quaternionr &q2_1 = rb2->getRotation();
+
+	const Real r2 = rb2->getGeometry().getBoundingRadius();
+	const Real linearMotion = (x1 - x0).norm() + (x2_1 - x2_0).norm();
+	const Real angle2 = rotationAngle(q2_0, q2_1);
+
+	const Quaternionr q2_MAT = rb2->getRotationInitial().inverse() * rb2->getRotationMAT();
+	const Vector3r &v1 = rb2->getTransformationV1();
+
+	std::function<Real(const Real, Real&)> distance = [&](const Real t, Real &bound)
+	{
+		const Vector3r x_w = (static_cast<Real>(1.0) - t) * x0 + t * x1;
+		const Matrix3r R = (q2_MAT * q2_0.slerp(t, q2_1).inverse()).matrix();
+		const Vector3r x2 = (static_cast<Real>(1.0) - t) * x2_0 + t * x2_1;
+		const Vector3r x = R * (x_w - x2) + v1;
+		const double dist = co2->distanceLowerBound(x.template cast<double>(), 0.0);
+		if (dist == std::numeric_limits<double>::max())
+			return std::numeric_limits<Real>::max();
+		bound = linearMotion + angle2 * (r2 + std::max(static_cast<Real>(dist), static_cast<Real>(0.0)));
+		return static_cast<Real>(dist);
+	};
+	return conservativeAdvancement(distance, toi);
+}
+
+
 bool DistanceFieldCollisionDetection::isDistanceFieldCollisionObject(CollisionObject *co) const
 {
 	return (co->getTypeId() == DistanceFieldCollisionDetection::DistanceFieldCollisionBox::TYPE_ID) ||
@@ -501,7 +950,7 @@ void DistanceFieldCollisionDetection::addCollisionBox(const unsigned int bodyInd
 	// distance function requires 0.5*box 
 	cf->m_box = 0.5*box;
 	cf->m_bvh.init(vertices, numVertices);
-	cf->m_bvh.construct();
+	constructBVH(cf);
 	cf->m_testMesh = testMesh;
 	if (invertSDF)
 		cf->m_invertSDF = -1.0;
@@ -515,7 +964,7 @@ void DistanceFieldCollisionDetection::addCollisionSphere(const unsigned int body
 	cs->m_bodyType = bodyType;
 	cs->m_radius = radius;
 	cs->m_bvh.init(vertices, numVertices);
-	cs->m_bvh.construct();
+	constructBVH(cs);
 	cs->m_testMesh = testMesh;
 	if (invertSDF)
 		cs->m_invertSDF = -1.0;
@@ -529,7 +978,7 @@ void DistanceFieldCollisionDetection::addCollisionTorus(const unsigned int bodyI
 	ct->m_bodyType = bodyType;
 	ct->m_radii = radii;
 	ct->m_bvh.init(vertices, numVertices);
-	ct->m_bvh.construct();
+	constructBVH(ct);
 	ct->m_testMesh = testMesh;
 	if (invertSDF)
 		ct->m_invertSDF = -1.0;
@@ -545,7 +994,7 @@ void DistanceFieldCollisionDetection::addCollisionCylinder(const unsigned int bo
 	// distance function uses height/2
 	ct->m_dim[1] *= 0.5;
 	ct->m_bvh.init(vertices, numVertices);
-	ct->m_bvh.construct();
+	constructBVH(ct);
 	ct->m_testMesh = testMesh;
 	if (invertSDF)
 		ct->m_invertSDF = -1.0;
@@ -560,7 +1009,7 @@ void DistanceFieldCollisionDetection::addCollisionHollowSphere(const unsigned in
 	cs->m_radius = radius;
 	cs->m_thickness = thickness;
 	cs->m_bvh.init(vertices, numVertices);
-	cs->m_bvh.construct();
+	constructBVH(cs);
 	cs->m_testMesh = testMesh;
 	if (invertSDF)
 		cs->m_invertSDF = -1.0;
@@ -576,20 +1025,51 @@ void DistanceFieldCollisionDetection::addCollisionHollowBox(const unsigned int b
 	cf->m_box = 0.5*box;
 	cf->m_thickness = thickness;
 	cf->m_bvh.init(vertices, numVertices);
-	cf->m_bvh.construct();
+	constructBVH(cf);
 	cf->m_testMesh = testMesh;
 	if (invertSDF)
 		cf->m_invertSDF = -1.0;
 	m_collisionObjects.push_back(cf);
 }
 
+void DistanceFieldCollisionDetection::constructBVH(DistanceFieldCollisionObject *co)
+{
+	if (!m_deferBVHConstruction)
+		co->m_bvh.construct();
+}
+
+void DistanceFieldCollisionDetection::setDeferBVHConstruction(const bool defer)
+{
+	if (defer == m_deferBVHConstruction)
+		return;
+	m_deferBVHConstruction = defer;
+	if (defer)
+	{
+		m_firstDeferredObject = static_cast<unsigned int>(m_collisionObjects.size());
+		return;
+	}
+
+	// construct the hierarchies of the objects which were added in the meantime
+	const int numObjects = static_cast<int>(m_collisionObjects.size());
+	const int first = static_cast<int>(m_firstDeferredObject);
+	#pragma omp parallel if(numObjects - first > 1) default(shared)
+	{
+		#pragma omp for schedule(dynamic)
+		for (int i = first; i < numObjects; i++)
+		{
+			if (isDistanceFieldCollisionObject(m_collisionObjects[i]))
+				static_cast<DistanceFieldCollisionObject*>(m_collisionObjects[i])->m_bvh.construct();
+		}
+	}
+}
+
 void DistanceFieldCollisionDetection::addCollisionObjectWithoutGeometry(const unsigned int bodyIndex, const unsigned int bodyType, const Vector3r *vertices, const unsigned int numVertices, const bool testMesh)
 {
 	DistanceFieldCollisionObjectWithoutGeometry *co = new DistanceFieldCollisionObjectWithoutGeometry();
 	co->m_bodyIndex = bodyIndex;
 	co->m_bodyType = bodyType;
 	co->m_bvh.init(vertices, numVertices);
-	co->m_bvh.construct();
+	constructBVH(co);
 	co->m_testMesh = testMesh;
 	co->m_invertSDF = 1.0;
 	m_collisionObjects.push_back(co);
@@ -747,17 +1227,18 @@ bool DistanceFieldCollisionDetection::findRefTetAt(const ParticleData &pd, TetMo
  	const TetMeshBSH &bvh0 = ((DistanceFieldCollisionDetection::DistanceFieldCollisionObject*) co)->m_bvhTets0;
  	const unsigned int *indices = tm->getParticleMesh().getTets().data();
  	const unsigned int offset = tm->getIndexOffset();
-	std::vector<Vector3r> bary;
-	std::vector<unsigned int> tets;
+	ScratchArena::Scope scope;
+	ScratchVector<Vector3r> bary;
+	ScratchVector<unsigned int> tets;
 	bary.reserve(100);
 	tets.reserve(100);
 
-	std::function<bool(unsigned int, unsigned int)> predicate = [&](unsigned int node_index, unsigned int depth)
+	auto predicate = [&](unsigned int node_index, unsigned int depth)
  	{
  		const BoundingSphere &bs = bvh0.hull(node_index);
 		return bs.contains(X);
  	};
- 	std::function<void(unsigned int, unsigned int)> cb = [&](unsigned int node_index, unsigned int depth)
+ 	auto cb = [&](unsigned int node_index, unsigned int depth)
  	{
  		auto const& node = bvh0.node(node_index);
  		if (!node.is_leaf())
@@ -26,6 +26,10 @@ namespace PBD
 			virtual void approximateNormal(const Eigen::Vector3d &x, const Real tolerance, Vector3r &n);
 
 			virtual double distance(const Eigen::Vector3d &x, const Real tolerance) = 0;
+			/** Lower bound of the distance which is used by the continuous collision detection. 
+			* In contrast to distance() it is also defined outside the domain of a discrete 
+			* distance field. Returns numeric_limits<double>::max() if no bound is known. */
+			virtual double distanceLowerBound(const Eigen::Vector3d &x, const Real tolerance) { return distance(x, tolerance); }
 			void initTetBVH(const Vector3r *vertices, const unsigned int numVertices, const unsigned int *indices, const unsigned int numTets, const Real tolerance);
 		};
 
@@ -123,6 +127,25 @@ namespace PBD
 		};
 
 	protected:
+		/** Pairs of collision objects whose (swept) bounding boxes intersect */
+		std::vector<std::pair<unsigned int, unsigned int>> m_collisionPairs;
+		/** Bounding boxes of the collision objects extended by their motion */
+		std::vector<AABB> m_sweptAABBs;
+		/** Flags for the collision objects which are part of a collision pair */
+		std::vector<char> m_activeObjects;
+		/** Contacts found by each thread. The buffers are kept to avoid heap allocations. */
+		std::vector<std::vector<ContactData> > m_contacts_mt;
+
+		/** Update the bounding boxes and refit the bounding volume hierarchies 
+		* of the collision objects. If activeOnly is set, only the hierarchies
+		* of objects in collision pairs are refitted. */
+		void updateCollisionObjects(SimulationModel &model, const bool activeOnly);
+		/** Determine the collision pairs using the bounding boxes extended by
+		* the distance that the objects can travel in timeHorizon. */
+		void determineCollisionPairs(SimulationModel &model, const Real timeHorizon);
+		/** Generate the contacts of the current collision pairs. */
+		void narrowPhase(SimulationModel &model);
+
 		void collisionDetectionRigidBodies(RigidBody *rb1, DistanceFieldCollisionObject *co1, RigidBody *rb2, DistanceFieldCollisionObject *co2,
 			const Real restitutionCoeff, const Real frictionCoeff
 			, std::vector<std::vector<ContactData> > &contacts_mt
@@ -139,6 +162,26 @@ namespace PBD
 			, std::vector<std::vector<ContactData> > &contacts_mt
 		);
 
+		/** Conservative advancement in the time interval [0,1] of the time step. 
+		* The function distance(t, bound) returns a lower bound of the distance at 
+		* time t and an upper bound of the approach speed in the time interval. 
+		* Returns true if the distance falls below the contact tolerance. */
+		bool conservativeAdvancement(const std::function<Real(const Real, Real&)> &distance, Real &toi);
+		/** Sweep the vertices of the first body against the distance field of the second one. */
+		bool sweepRigidBodies(const unsigned int rbIndex1, RigidBody *rb1, DistanceFieldCollisionObject *co1, 
+			const unsigned int rbIndex2, RigidBody *rb2, DistanceFieldCollisionObject *co2, Real &toi);
+		/** Sweep the particle from x0 to x1 against the distance field of the rigid body. */
+		bool sweepParticle(const Vector3r &x0, const Vector3r &x1, 
+			const unsigned int rbIndex2, RigidBody *rb2, DistanceFieldCollisionObject *co2, Real &toi);
+
+		/** If set, the hierarchies of new collision objects are constructed later (see setDeferBVHConstruction()). */
+		bool m_deferBVHConstruction;
+		/** Index of the first collision object which was added while the construction was deferred */
+		unsigned int m_firstDeferredObject;
+
+		/** Construct the bounding volume hierarchy of a new collision object unless the construction is deferred. */
+		void constructBVH(DistanceFieldCollisionObject *co);
+
 		bool findRefTetAt(const ParticleData &pd, TetModel *tm, const DistanceFieldCollisionDetection::DistanceFieldCollisionObject *co, const Vector3r &X, 
 			unsigned int &tetIndex, Vector3r &barycentricCoordinates);
 
@@ -148,9 +191,19 @@ namespace PBD
 		virtual ~DistanceFieldCollisionDetection();
 
 		virtual void collisionDetection(SimulationModel &model);
+		virtual void substepCollisionDetection(SimulationModel &model, const bool updatePairs, const Real timeHorizon);
+		virtual void continuousCollisionDetection(SimulationModel &model);
 
 		virtual bool isDistanceFieldCollisionObject(CollisionObject *co) const;
 
+		/** Defer the construction of the bounding volume hierarchies of the collision
+		* objects which are added, e.g. while a scene with many bodies is created.
+		* When the deferral is switched off, the hierarchies of all objects which were
+		* added in the meantime are constructed in parallel. The collision objects must
+		* not be removed in between.
+		*/
+		void setDeferBVHConstruction(const bool defer);
+
 		void addCollisionBox(const unsigned int bodyIndex, const unsigned int bodyType, const Vector3r *vertices, const unsigned int numVertices, const Vector3r &box, const bool testMesh = true, const bool invertSDF = false);
 		void addCollisionSphere(const unsigned int bodyIndex, const unsigned int bodyType, const Vector3r *vertices, const unsigned int numVertices, const Real radius, const bool testMesh = true, const bool invertSDF = false);
 		void addCollisionTorus(const unsigned int bodyIndex, const unsigned int bodyType, const Vector3r *vertices, const unsigned int numVertices, const Vector2r &radii, const bool testMesh = true, const bool invertSDF = false);
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "Common/Common.h"
+#include "Utils/BinaryReaderWriter.h"
 
 
 namespace PBD
@@ -250,6 +251,11 @@ namespace PBD
 				return m_invMasses[i];
 			}
 
+			FORCE_INLINE Real& getInvMass(const unsigned int i)
+			{
+				return m_invMasses[i];
+			}
+
 			FORCE_INLINE const unsigned int getNumberOfParticles() const
 			{
 				return (unsigned int) m_x.size();
@@ -308,6 +314,36 @@ namespace PBD
 			{
 				return (unsigned int) m_x.size();
 			}
+
+			/** Write the masses and the dynamic state of all particles. */
+			void saveState(Utilities::BinaryWriter &binWriter) const
+			{
+				binWriter.writeVector(m_masses);
+				binWriter.writeVector(m_x0);
+				binWriter.writeVector(m_x);
+				binWriter.writeVector(m_v);
+				binWriter.writeVector(m_a);
+				binWriter.writeVector(m_oldX);
+				binWriter.writeVector(m_lastX);
+			}
+
+			/** Read the state written by saveState. The number of particles 
+			 * must not have changed. */
+			bool loadState(Utilities::BinaryReader &binReader)
+			{
+				const size_t n = m_x.size();
+				if (!binReader.readVector(m_masses, n) ||
+					!binReader.readVector(m_x0, n) ||
+					!binReader.readVector(m_x, n) ||
+					!binReader.readVector(m_v, n) ||
+					!binReader.readVector(m_a, n) ||
+					!binReader.readVector(m_oldX, n) ||
+					!binReader.readVector(m_lastX, n))
+					return false;
+				for (size_t i = 0; i < n; i++)
+					m_invMasses[i] = (m_masses[i] != 0.0) ? static_cast<Real>(1.0) / m_masses[i] : static_cast<Real>(0.0);
+				return true;
+			}
 	};
 
 	/** This class encapsulates the state of all orientations of a quaternion model.
@@ -480,6 +516,11 @@ namespace PBD
 			return m_invMasses[i];
 		}
 
+		FORCE_INLINE Real& getInvMass(const unsigned int i)
+		{
+			return m_invMasses[i];
+		}
+
 		FORCE_INLINE const unsigned int getNumberOfQuaternions() const
 		{
 			return (unsigned int)m_q.size();
@@ -533,6 +574,36 @@ namespace PBD
 		{
 			return (unsigned int)m_q.size();
 		}
+
+		/** Write the masses and the dynamic state of all quaternions. */
+		void saveState(Utilities::BinaryWriter &binWriter) const
+		{
+			binWriter.writeVector(m_masses);
+			binWriter.writeVector(m_q0);
+			binWriter.writeVector(m_q);
+			binWriter.writeVector(m_omega);
+			binWriter.writeVector(m_alpha);
+			binWriter.writeVector(m_oldQ);
+			binWriter.writeVector(m_lastQ);
+		}
+
+		/** Read the state written by saveState. The number of quaternions
+		* must not have changed. */
+		bool loadState(Utilities::BinaryReader &binReader)
+		{
+			const size_t n = m_q.size();
+			if (!binReader.readVector(m_masses, n) ||
+				!binReader.readVector(m_q0, n) ||
+				!binReader.readVector(m_q, n) ||
+				!binReader.readVector(m_omega, n) ||
+				!binReader.readVector(m_alpha, n) ||
+				!binReader.readVector(m_oldQ, n) ||
+				!binReader.readVector(m_lastQ, n))
+				return false;
+			for (size_t i = 0; i < n; i++)
+				m_invMasses[i] = (m_masses[i] != 0.0) ? static_cast<Real>(1.0) / m_masses[i] : static_cast<Real>(0.0);
+			return true;
+		}
 	};
 }
 
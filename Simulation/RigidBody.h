@@ -5,6 +5,7 @@
 #include "Common/Common.h"
 #include "RigidBodyGeometry.h"
 #include "Utils/VolumeIntegration.h"
+#include "Utils/BinaryReaderWriter.h"
 
 
 namespace PBD
@@ -67,6 +68,16 @@ namespace PBD
 			Real m_restitutionCoeff;
 			Real m_frictionCoeff;
 
+			/** true if the body belongs to a sleeping simulation island */
+			bool m_sleeping;
+			/** time span in which the velocities of the body were below the sleep thresholds */
+			Real m_sleepTimer;
+			/** Sleep thresholds of the body. A negative value means that the threshold
+			* of the time step controller is used. */
+			Real m_sleepLinearVelocity;
+			Real m_sleepAngularVelocity;
+			Real m_sleepTime;
+
 			RigidBodyGeometry m_geometry;
 
 			// transformation required to transform a point to local space or vice vera
@@ -76,7 +87,22 @@ namespace PBD
 			Vector3r m_transformation_R_X_v1;
 			
 		public:
-			RigidBody(void) 
+			/** Mass, inertia tensor, principal axes and center of mass of a mesh in its
+			* local coordinate system. Bodies with the same mesh, scale and density have
+			* the same mass properties, so these can be computed once and shared.
+			*/
+			struct MassProperties
+			{
+				Real m_mass;
+				Vector3r m_inertiaTensor;
+				Matrix3r m_principalAxes;
+				Vector3r m_centerOfMass;
+			};
+
+			RigidBody(void) :
+				m_sleepLinearVelocity(-1.0),
+				m_sleepAngularVelocity(-1.0),
+				m_sleepTime(-1.0)
 			{
 			}
 
@@ -114,6 +140,8 @@ namespace PBD
 
 				m_restitutionCoeff = static_cast<Real>(0.6);
 				m_frictionCoeff = static_cast<Real>(0.2);
+				m_sleeping = false;
+				m_sleepTimer = 0.0;
 
 				getGeometry().initMesh(vertices.size(), mesh.numFaces(), &vertices.getPosition(0), mesh.getFaces().data(), mesh.getUVIndices(), mesh.getUVs(), scale, mesh.getFlatShading());
 				getGeometry().updateMeshTransformation(getPosition(), getRotationMatrix());
@@ -144,12 +172,51 @@ namespace PBD
 
 				m_restitutionCoeff = static_cast<Real>(0.6);
 				m_frictionCoeff = static_cast<Real>(0.2);
+				m_sleeping = false;
+				m_sleepTimer = 0.0;
 
 				getGeometry().initMesh(vertices.size(), mesh.numFaces(), &vertices.getPosition(0), mesh.getFaces().data(), mesh.getUVIndices(), mesh.getUVs(), scale, mesh.getFlatShading());
 				determineMassProperties(density);
 				getGeometry().updateMeshTransformation(getPosition(), getRotationMatrix());
 			}
 
+			/** Initialize the body with precomputed mass properties of the scaled mesh
+			* (see computeMassProperties()). This is equivalent to the initialization with
+			* the density but avoids the volume integration.
+			*/
+			void initBody(const MassProperties &massProperties, const Vector3r &x, const Quaternionr &rotation,
+				const VertexData &vertices, const Utilities::IndexedFaceMesh &mesh, const Vector3r &scale = Vector3r(1.0, 1.0, 1.0))
+			{
+				m_mass = 1.0;
+				m_inertiaTensor = Vector3r(1.0, 1.0, 1.0);
+				m_x = x;
+				m_x0 = x;
+				m_lastX = x;
+				m_oldX = x;
+				m_v.setZero();
+				m_v0.setZero();
+				m_a.setZero();
+
+				m_q = rotation;
+				m_q0 = rotation;
+				m_lastQ = rotation;
+				m_oldQ = rotation;
+				m_rot = m_q.matrix();
+				rotationUpdated();
+				m_omega.setZero();
+				m_omega0.setZero();
+				m_torque.setZero();
+
+				m_restitutionCoeff = static_cast<Real>(0.6);
+				m_frictionCoeff = static_cast<Real>(0.2);
+				m_sleeping = false;
+				m_sleepTimer = 0.0;
+
+				getGeometry().initMesh(vertices.size(), mesh.numFaces(), &vertices.getPosition(0), mesh.getFaces().data(), mesh.getUVIndices(), mesh.getUVs(), scale, mesh.getFlatShading());
+				applyMassProperties(massProperties);
+				getGeometry().updateMeshTransformation(getPosition(), getRotationMatrix());
+			}
+
 			void reset()
 			{
 				getPosition() = getPosition0();
@@ -166,6 +233,9 @@ namespace PBD
 				getAcceleration().setZero();
 				getTorque().setZero();
 
+				m_sleeping = false;
+				m_sleepTimer = 0.0;
+
 				rotationUpdated();
 			}
 
@@ -206,23 +276,40 @@ namespace PBD
 				}
 			}
 
+			/** Compute the mass properties of a mesh with the given density. */
+			static void computeMassProperties(const unsigned int nVertices, Vector3r * const vertices, const unsigned int nFaces, const unsigned int *indices,
+				const Real density, MassProperties &massProperties)
+			{
+				Utilities::VolumeIntegration vi(nVertices, nFaces, vertices, indices);
+				vi.compute_inertia_tensor(density);
+
+				// Diagonalize Inertia Tensor
+				Eigen::SelfAdjointEigenSolver<Matrix3r> es(vi.getInertia());
+				massProperties.m_mass = vi.getMass();
+				massProperties.m_inertiaTensor = es.eigenvalues();
+				massProperties.m_principalAxes = es.eigenvectors();
+				massProperties.m_centerOfMass = vi.getCenterOfMass();
+			}
+
 			/** Determine mass and inertia tensor of the given geometry.
 			 */
 			void determineMassProperties(const Real density)
+			{
+				MassProperties massProperties;
+				computeMassProperties(m_geometry.getVertexDataLocal().size(), &m_geometry.getVertexDataLocal().getPosition(0), m_geometry.getMesh().numFaces(), m_geometry.getMesh().getFaces().data(), density, massProperties);
+				applyMassProperties(massProperties);
+			}
+
+			/** Set mass and inertia tensor and transform the body to its principal axis system. */
+			void applyMassProperties(const MassProperties &massProperties)
 			{
 				// apply initial rotation
 				VertexData &vd = m_geometry.getVertexDataLocal();
-				
-				Utilities::VolumeIntegration vi(m_geometry.getVertexDataLocal().size(), m_geometry.getMesh().numFaces(), &m_geometry.getVertexDataLocal().getPosition(0), m_geometry.getMesh().getFaces().data());
-				vi.compute_inertia_tensor(density);
 
-				// Diagonalize Inertia Tensor
-				Eigen::SelfAdjointEigenSolver<Matrix3r> es(vi.getInertia());
-				Vector3r inertiaTensor = es.eigenvalues();
-				Matrix3r R = es.eigenvectors();
+				Matrix3r R = massProperties.m_principalAxes;
 
-				setMass(vi.getMass());
-				setInertiaTensor(inertiaTensor);
+				setMass(massProperties.m_mass);
+				setInertiaTensor(massProperties.m_inertiaTensor);
 
 				if (R.determinant() < 0.0)
 					R = -R;
@@ -230,13 +317,14 @@ namespace PBD
 				for (unsigned int i = 0; i < vd.size(); i++)
 					vd.getPosition(i) = m_rot * vd.getPosition(i) + m_x0;
 
-				Vector3r x_MAT = vi.getCenterOfMass();
+				Vector3r x_MAT = massProperties.m_centerOfMass;
 				R = m_rot * R;
 				x_MAT = m_rot * x_MAT + m_x0;
 
 				// rotate vertices back				
 				for (unsigned int i = 0; i < vd.size(); i++)
 					vd.getPosition(i) = R.transpose() * (vd.getPosition(i) - x_MAT);
+				m_geometry.updateLocalBounds();
 
 				// set rotation
 				Quaternionr qR = Quaternionr(R);
@@ -619,10 +707,134 @@ namespace PBD
 				m_frictionCoeff = val; 
 			}
 
+			FORCE_INLINE bool isSleeping() const 
+			{ 
+				return m_sleeping; 
+			}
+
+			FORCE_INLINE void setSleeping(const bool val) 
+			{ 
+				m_sleeping = val; 
+			}
+
+			FORCE_INLINE Real &getSleepTimer()
+			{
+				return m_sleepTimer;
+			}
+
+			FORCE_INLINE Real getSleepLinearVelocity() const
+			{
+				return m_sleepLinearVelocity;
+			}
+
+			/** Set the linear velocity threshold for sleeping. A negative value
+			* means that the threshold of the time step controller is used. */
+			FORCE_INLINE void setSleepLinearVelocity(const Real val)
+			{
+				m_sleepLinearVelocity = val;
+			}
+
+			FORCE_INLINE Real getSleepAngularVelocity() const
+			{
+				return m_sleepAngularVelocity;
+			}
+
+			/** Set the angular velocity threshold for sleeping. A negative value
+			* means that the threshold of the time step controller is used. */
+			FORCE_INLINE void setSleepAngularVelocity(const Real val)
+			{
+				m_sleepAngularVelocity = val;
+			}
+
+			FORCE_INLINE Real getSleepTime() const
+			{
+				return m_sleepTime;
+			}
+
+			/** Set the time span in which the body must be at rest before its island
+			* can sleep. A negative value means that the time of the time step
+			* controller is used. */
+			FORCE_INLINE void setSleepTime(const Real val)
+			{
+				m_sleepTime = val;
+			}
+
+			/** Wake up the body. The other bodies of its simulation island are 
+			* woken up in the next simulation step. */
+			FORCE_INLINE void wakeUp()
+			{
+				m_sleeping = false;
+				m_sleepTimer = 0.0;
+			}
+
 			RigidBodyGeometry& getGeometry()
 			{
 				return m_geometry;
 			}
+
+			/** Write the mass properties and the dynamic state of the body. */
+			void saveState(Utilities::BinaryWriter &binWriter) const
+			{
+				binWriter.write(m_mass);
+				binWriter.writeMatrix(m_inertiaTensor);
+				binWriter.writeMatrix(m_inertiaTensorInverse);
+				binWriter.writeMatrix(m_x);
+				binWriter.writeMatrix(m_lastX);
+				binWriter.writeMatrix(m_oldX);
+				binWriter.writeMatrix(m_x0);
+				binWriter.writeMatrix(m_v);
+				binWriter.writeMatrix(m_v0);
+				binWriter.writeMatrix(m_a);
+				binWriter.writeMatrix(m_q.coeffs());
+				binWriter.writeMatrix(m_lastQ.coeffs());
+				binWriter.writeMatrix(m_oldQ.coeffs());
+				binWriter.writeMatrix(m_q0.coeffs());
+				binWriter.writeMatrix(m_omega);
+				binWriter.writeMatrix(m_omega0);
+				binWriter.writeMatrix(m_torque);
+				binWriter.write(m_restitutionCoeff);
+				binWriter.write(m_frictionCoeff);
+				binWriter.write(m_sleeping);
+				binWriter.write(m_sleepTimer);
+			}
+
+			/** Read the state written by saveState and update the derived
+			* quantities (rotation matrix, world space inertia tensors and mesh). */
+			bool loadState(Utilities::BinaryReader &binReader)
+			{
+				Real mass;
+				binReader.read(mass);
+				binReader.readMatrix(m_inertiaTensor);
+				binReader.readMatrix(m_inertiaTensorInverse);
+				binReader.readMatrix(m_x);
+				binReader.readMatrix(m_lastX);
+				binReader.readMatrix(m_oldX);
+				binReader.readMatrix(m_x0);
+				binReader.readMatrix(m_v);
+				binReader.readMatrix(m_v0);
+				binReader.readMatrix(m_a);
+				binReader.readMatrix(m_q.coeffs());
+				binReader.readMatrix(m_lastQ.coeffs());
+				binReader.readMatrix(m_oldQ.coeffs());
+				binReader.readMatrix(m_q0.coeffs());
+				binReader.readMatrix(m_omega);
+				binReader.readMatrix(m_omega0);
+				binReader.readMatrix(m_torque);
+				binReader.read(m_restitutionCoeff);
+				binReader.read(m_frictionCoeff);
+				binReader.read(m_sleeping);
+				binReader.read(m_sleepTimer);
+				if (binReader.hasError())
+					return false;
+
+				setMass(mass);
+				// static bodies can be moved by the user, so their transformation is updated as well
+				m_rot = m_q.matrix();
+				updateInertiaW();
+				updateInverseTransformation();
+				getGeometry().updateMeshTransformation(getPosition(), getRotationMatrix());
+				return true;
+			}
 	};
 }
 
@@ -2,9 +2,16 @@
 
 using namespace PBD;
 
+bool RigidBodyGeometry::m_updateVertexData = true;
+
 RigidBodyGeometry::RigidBodyGeometry() :
 	m_mesh()
 {	
+	m_R.setIdentity();
+	m_x.setZero();
+	m_vertexDataOutdated = false;
+	m_localBounds[0].setZero();
+	m_localBounds[1].setZero();
 }
 
 RigidBodyGeometry::~RigidBodyGeometry(void)
@@ -37,6 +44,10 @@ void RigidBodyGeometry::initMesh(const unsigned int nVertices, const unsigned in
 	m_mesh.copyUVs(uvIndices, uvs);
 	m_mesh.buildNeighbors();
 	updateMeshNormals(m_vertexData);
+	m_R.setIdentity();
+	m_x.setZero();
+	m_vertexDataOutdated = false;
+	updateLocalBounds();
 }
 
 void RigidBodyGeometry::updateMeshNormals(const VertexData &vd)
@@ -47,20 +58,47 @@ void RigidBodyGeometry::updateMeshNormals(const VertexData &vd)
 
 void RigidBodyGeometry::updateMeshTransformation(const Vector3r &x, const Matrix3r &R)
 {
+	m_x = x;
+	m_R = R;
+	m_vertexDataOutdated = true;
+}
+
+void RigidBodyGeometry::updateVertexData()
+{
+	if (!m_vertexDataOutdated || !m_updateVertexData)
+		return;
 	for (unsigned int i = 0; i < m_vertexData_local.size(); i++)
 	{
-		m_vertexData.getPosition(i) = R * m_vertexData_local.getPosition(i) + x;
+		m_vertexData.getPosition(i) = m_R * m_vertexData_local.getPosition(i) + m_x;
 	}
 	updateMeshNormals(m_vertexData);
+	m_vertexDataOutdated = false;
 }
 
-VertexData & RigidBodyGeometry::getVertexData()
+void RigidBodyGeometry::updateLocalBounds()
 {
-	return m_vertexData;
+	if (m_vertexData_local.size() == 0)
+		return;
+	m_localBounds[0] = m_vertexData_local.getPosition(0);
+	m_localBounds[1] = m_vertexData_local.getPosition(0);
+	for (unsigned int i = 1; i < m_vertexData_local.size(); i++)
+	{
+		m_localBounds[0] = m_localBounds[0].cwiseMin(m_vertexData_local.getPosition(i));
+		m_localBounds[1] = m_localBounds[1].cwiseMax(m_vertexData_local.getPosition(i));
+	}
+}
+
+void RigidBodyGeometry::getWorldBounds(Vector3r &minX, Vector3r &maxX) const
+{
+	const Vector3r center = m_R * (static_cast<Real>(0.5) * (m_localBounds[0] + m_localBounds[1])) + m_x;
+	const Vector3r extents = m_R.cwiseAbs() * (static_cast<Real>(0.5) * (m_localBounds[1] - m_localBounds[0]));
+	minX = center - extents;
+	maxX = center + extents;
 }
 
-const VertexData & RigidBodyGeometry::getVertexData() const
+VertexData & RigidBodyGeometry::getVertexData()
 {
+	updateVertexData();
 	return m_vertexData;
 }
 
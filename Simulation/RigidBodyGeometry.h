@@ -17,22 +17,51 @@ namespace PBD
 			typedef Utilities::IndexedFaceMesh Mesh;
 
 		protected:
+			/** If false, the world space vertices are not updated at all, e.g. in headless simulations. 
+			* The flag is shared by all models, so it must not be changed while a model is simulated. */
+			static bool m_updateVertexData;
+
 			Mesh m_mesh;
 			VertexData m_vertexData_local;
 			VertexData m_vertexData;
+			/** Transformation of the local vertices. It is applied lazily to the 
+			* world space vertices and normals when these are accessed. */
+			Matrix3r m_R;
+			Vector3r m_x;
+			bool m_vertexDataOutdated;
+			/** bounding box of the local vertices */
+			Vector3r m_localBounds[2];
 
 		public:
+			static bool getUpdateVertexData() { return m_updateVertexData; }
+			static void setUpdateVertexData(const bool val) { m_updateVertexData = val; }
+
 			Mesh &getMesh();
+			/** Transform the local vertices and normals to world space if the transformation 
+			* has changed. Call this once before the world space vertices are read by several 
+			* threads, since the update is not thread-safe. */
+			void updateVertexData();
+			/** World space vertices. They are updated by updateVertexData() on access, so this 
+			* function must not be called concurrently for the same body. */
 			VertexData &getVertexData();
-			const VertexData &getVertexData() const;
 			VertexData &getVertexDataLocal();
 			const VertexData &getVertexDataLocal() const;
+			const Matrix3r &getRotation() const { return m_R; }
+			const Vector3r &getTranslation() const { return m_x; }
 
 			void initMesh(const unsigned int nVertices, const unsigned int nFaces, const Vector3r *vertices, const unsigned int* indices, const Mesh::UVIndices& uvIndices, const Mesh::UVs& uvs, const Vector3r &scale = Vector3r(1.0, 1.0, 1.0), const bool flatShading = false);
+			/** Set the transformation of the local vertices. The world space vertices are 
+			* not transformed before they are accessed. */
 			void updateMeshTransformation(const Vector3r &x, const Matrix3r &R);
 			void updateMeshNormals(const VertexData &vd);
-			
+			/** Update the bounding box of the local vertices. This must be called 
+			* when the local vertices are modified. */
+			void updateLocalBounds();
+			/** Axis-aligned bounding box of the transformed local bounding box in world space */
+			void getWorldBounds(Vector3r &minX, Vector3r &maxX) const;
+			/** Radius of a sphere around the local origin which contains all local vertices */
+			Real getBoundingRadius() const { return m_localBounds[0].cwiseAbs().cwiseMax(m_localBounds[1].cwiseAbs()).norm(); }
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -22,7 +22,9 @@ Simulation::Simulation ()
 Simulation::~Simulation () 
 {
 	delete m_timeStep;
-	delete TimeManager::getCurrent();
+	// the time manager of the model is deleted with the model
+	if (TimeManager::hasCurrent() && ((m_model == nullptr) || (TimeManager::getCurrent() != &m_model->getTimeManager())))
+		delete TimeManager::getCurrent();
 
 	current = nullptr;
 }
@@ -53,7 +55,6 @@ void Simulation::init()
 	
 	m_timeStep = new TimeStepController();
 	m_timeStep->init();
-	TimeManager::getCurrent()->setTimeStepSize(static_cast<Real>(0.005));
 }
 
 void Simulation::initParameters()
@@ -71,6 +72,13 @@ void Simulation::reset()
 	if (m_timeStep)
 		m_timeStep->reset();
 
-	TimeManager::getCurrent()->setTime(static_cast<Real>(0.0));
+	m_model->getTimeManager().setTime(static_cast<Real>(0.0));
+}
+
+void Simulation::setModel(SimulationModel *model)
+{
+	m_model = model;
+	if (m_model != nullptr)
+		TimeManager::setCurrent(&m_model->getTimeManager());
 }
 
@@ -43,7 +43,8 @@ namespace PBD
 		static bool hasCurrent();
 
 		SimulationModel *getModel() { return m_model; }
-		void setModel(SimulationModel *model) { m_model = model; }
+		/** Set the model of the simulation. Its time manager becomes the current one. */
+		void setModel(SimulationModel *model);
 
 		TimeStep *getTimeStep() { return m_timeStep; }
 		void setTimeStep(TimeStep *ts) { m_timeStep = ts; }
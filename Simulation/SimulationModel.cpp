@@ -1,6 +1,9 @@
 #include "SimulationModel.h"
 #include "PositionBasedDynamics/PositionBasedRigidBodyDynamics.h"
 #include "Constraints.h"
+#include "Utils/ScratchArena.h"
+#include "Utils/Logger.h"
+#include <algorithm>
 
 using namespace PBD;
 using namespace GenParam;
@@ -49,12 +52,15 @@ int SimulationModel::ROD_TWISTING_STIFFNESS = -1;
 
 int SimulationModel::CONTACT_STIFFNESS_RB = -1;
 int SimulationModel::CONTACT_STIFFNESS_PARTICLE_RB = -1;
+int SimulationModel::CONTACT_STIFFNESS_CLOTH = -1;
 
 
 SimulationModel::SimulationModel()
 {
 	m_contactStiffnessRigidBody = 1.0;
 	m_contactStiffnessParticleRigidBody = 100.0;
+	m_contactStiffnessCloth = 1.0;
+	m_clothContactGroupsInitialized = false;
 
 	m_clothSimulationMethod = 2;
 	m_clothBendingMethod = 2;
@@ -120,6 +126,7 @@ void SimulationModel::cleanup()
 	for (unsigned int i = 0; i < m_constraints.size(); i++)
 		delete m_constraints[i];
 	m_constraints.clear();
+	m_rigidBodyIslands.clear();
 	m_particles.release();
 	m_orientations.release();
 	m_groupsInitialized = false;
@@ -265,6 +272,12 @@ void SimulationModel::initParameters()
 	setGroup(CONTACT_STIFFNESS_PARTICLE_RB, "Simulation|Contact");
 	setDescription(CONTACT_STIFFNESS_PARTICLE_RB, "Stiffness coefficient for particle-rigid contact resolution.");
 	static_cast<NumericParameter<Real>*>(getParameter(CONTACT_STIFFNESS_PARTICLE_RB))->setMinValue(0.0);
+
+	CONTACT_STIFFNESS_CLOTH = createNumericParameter<Real>("contactStiffnessCloth", "Contact stiffness cloth", std::bind(&SimulationModel::getContactStiffnessCloth, this), std::bind(static_cast<void (SimulationModel::*)(const Real)>(&SimulationModel::setContactStiffnessCloth), this, std::placeholders::_1));
+	setGroup(CONTACT_STIFFNESS_CLOTH, "Simulation|Contact");
+	setDescription(CONTACT_STIFFNESS_CLOTH, "Stiffness coefficient for cloth-cloth contact resolution.");
+	static_cast<NumericParameter<Real>*>(getParameter(CONTACT_STIFFNESS_CLOTH))->setMinValue(0.0);
+	static_cast<NumericParameter<Real>*>(getParameter(CONTACT_STIFFNESS_CLOTH))->setMaxValue(1.0);
 }
 
 void SimulationModel::reset()
@@ -318,6 +331,11 @@ OrientationData & SimulationModel::getOrientations()
 	return m_orientations;
 }
 
+TimeManager & SimulationModel::getTimeManager()
+{
+	return m_timeManager;
+}
+
 SimulationModel::TriangleModelVector & SimulationModel::getTriangleModels()
 {
 	return m_triangleModels;
@@ -353,11 +371,41 @@ SimulationModel::ParticleSolidContactConstraintVector & SimulationModel::getPart
 	return m_particleSolidContactConstraints;
 }
 
+SimulationModel::ClothContactConstraintVector & SimulationModel::getClothContactConstraints()
+{
+	return m_clothContactConstraints;
+}
+
+SimulationModel::ConstraintGroupVector & SimulationModel::getClothContactGroups()
+{
+	return m_clothContactGroups;
+}
+
 SimulationModel::ConstraintGroupVector & SimulationModel::getConstraintGroups()
 {
 	return m_constraintGroups;
 }
 
+std::vector<unsigned int> & SimulationModel::getConstraintGroupCosts()
+{
+	return m_constraintGroupCosts;
+}
+
+SimulationModel::ConstraintIslandVector & SimulationModel::getConstraintIslands()
+{
+	return m_constraintIslands;
+}
+
+std::vector<unsigned int> & SimulationModel::getConstraintIslandCosts()
+{
+	return m_constraintIslandCosts;
+}
+
+SimulationModel::RigidBodyIslandVector & SimulationModel::getRigidBodyIslands()
+{
+	return m_rigidBodyIslands;
+}
+
 void SimulationModel::updateConstraints()
 {
 	for (unsigned int i = 0; i < m_constraints.size(); i++)
@@ -548,6 +596,20 @@ bool SimulationModel::addRigidBodyContactConstraint(const unsigned int rbIndex1,
  	return res;
 }
 
+bool SimulationModel::addClothContactConstraint(const bool edgeEdge,
+	const unsigned int particleIndex0, const unsigned int particleIndex1,
+	const unsigned int particleIndex2, const unsigned int particleIndex3,
+	const Real thickness)
+{
+	m_clothContactConstraints.emplace_back(ClothContactConstraint());
+	ClothContactConstraint &cc = m_clothContactConstraints.back();
+	const bool res = cc.initConstraint(*this, edgeEdge, particleIndex0, particleIndex1, particleIndex2, particleIndex3, thickness, m_contactStiffnessCloth);
+	if (!res)
+		m_clothContactConstraints.pop_back();
+	m_clothContactGroupsInitialized = false;
+	return res;
+}
+
 bool SimulationModel::addParticleSolidContactConstraint(const unsigned int particleIndex, const unsigned int solidIndex, 
 	const unsigned int tetIndex, const Vector3r &bary,
  	const Vector3r &cp1, const Vector3r &cp2, 
@@ -737,6 +799,20 @@ bool SimulationModel::addShapeMatchingConstraint(const unsigned int numberOfPart
 	return res;
 }
 
+bool SimulationModel::addFastLatticeShapeMatchingConstraint(const unsigned int width, const unsigned int height, const unsigned int depth, 
+	const unsigned int cellParticles[], const unsigned int regionWidth, const Real stiffness)
+{
+	FastLatticeShapeMatchingConstraint *c = new FastLatticeShapeMatchingConstraint();
+	const unsigned int dim[3] = { width, height, depth };
+	const bool res = c->initConstraint(*this, dim, cellParticles, regionWidth, stiffness);
+	if (res)
+	{
+		m_constraints.push_back(c);
+		m_groupsInitialized = false;
+	}
+	return res;
+}
+
 bool SimulationModel::addStretchShearConstraint(const unsigned int particle1, const unsigned int particle2, 
 	const unsigned int quaternion1, const Real stretchingStiffness,
 	const Real shearingStiffness1, const Real shearingStiffness2)
@@ -765,6 +841,21 @@ bool SimulationModel::addBendTwistConstraint(const unsigned int quaternion1,
 	return res;
 }
 
+bool SimulationModel::addCosseratRodsConstraint(const std::vector<unsigned int> &lineModelIndices,
+	const Real stretchingStiffness, const Real shearingStiffness1, const Real shearingStiffness2,
+	const Real twistingStiffness, const Real bendingStiffness1, const Real bendingStiffness2)
+{
+	CosseratRodsConstraint *c = new CosseratRodsConstraint();
+	const bool res = c->initConstraint(*this, lineModelIndices, stretchingStiffness, shearingStiffness1, shearingStiffness2, 
+		twistingStiffness, bendingStiffness1, bendingStiffness2);
+	if (res)
+	{
+		m_constraints.push_back(c);
+		m_groupsInitialized = false;
+	}
+	return res;
+}
+
 bool PBD::SimulationModel::addStretchBendingTwistingConstraint(
 	const unsigned int rbIndex1,
 	const unsigned int rbIndex2,
@@ -1040,12 +1131,85 @@ void SimulationModel::initConstraintGroups()
 	const unsigned int numRigidBodies = (unsigned int) m_rigidBodies.size();
 	const unsigned int numBodies = numParticles + numRigidBodies;
 	m_constraintGroups.clear();
+	m_constraintIslands.clear();
+	m_constraintIslandCosts.clear();
+
+	// Determine the islands of constraints which are connected by common bodies. 
+	// As for the coloring, bodies are identified by their index only. This can 
+	// merge independent islands but never separates constraints with a common body.
+	std::vector<unsigned int> parent(numBodies);
+	for (unsigned int i = 0; i < numBodies; i++)
+		parent[i] = i;
+	auto findRoot = [&](unsigned int i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+	for (unsigned int i = 0; i < numConstraints; i++)
+	{
+		const Constraint *constraint = m_constraints[i];
+		for (unsigned int k = 1; k < constraint->numberOfBodies(); k++)
+		{
+			const unsigned int r0 = findRoot(constraint->m_bodies[0]);
+			const unsigned int rk = findRoot(constraint->m_bodies[k]);
+			if (r0 != rk)
+				parent[std::max(r0, rk)] = std::min(r0, rk);
+		}
+	}
+
+	std::vector<unsigned int> islandIndex(numBodies, 0xffffffff);
+	ConstraintIslandVector islands;
+	std::vector<unsigned int> islandCosts;
+	for (unsigned int i = 0; i < numConstraints; i++)
+	{
+		if (m_constraints[i]->numberOfBodies() == 0)
+		{
+			islands.push_back({ i });
+			islandCosts.push_back(m_constraints[i]->getCost());
+			continue;
+		}
+		const unsigned int root = findRoot(m_constraints[i]->m_bodies[0]);
+		if (islandIndex[root] == 0xffffffff)
+		{
+			islandIndex[root] = (unsigned int)islands.size();
+			islands.emplace_back();
+			islandCosts.push_back(0);
+		}
+		islands[islandIndex[root]].push_back(i);
+		islandCosts[islandIndex[root]] += m_constraints[i]->getCost();
+	}
+
+	// Small islands are solved as tasks, the most expensive ones first. 
+	// The constraints of the other islands are colored.
+	std::vector<unsigned int> coloredConstraints;
+	std::vector<unsigned int> order(islands.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](const unsigned int a, const unsigned int b)
+		{ return islandCosts[a] > islandCosts[b]; });
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		const unsigned int island = order[i];
+		if (islandCosts[island] > MAX_ISLAND_TASK_COST)
+			coloredConstraints.insert(coloredConstraints.end(), islands[island].begin(), islands[island].end());
+		else
+		{
+			m_constraintIslands.push_back(std::move(islands[island]));
+			m_constraintIslandCosts.push_back(islandCosts[island]);
+		}
+	}
+	std::sort(coloredConstraints.begin(), coloredConstraints.end());
 
 	// Maps in which group a particle is or 0 if not yet mapped
 	std::vector<unsigned char*> mapping;
 
-	for (unsigned int i = 0; i < numConstraints; i++)
+	for (unsigned int c = 0; c < coloredConstraints.size(); c++)
 	{
+		const unsigned int i = coloredConstraints[c];
 		Constraint *constraint = m_constraints[i];
 
 		bool addToNewGroup = true;
@@ -1090,6 +1254,24 @@ void SimulationModel::initConstraintGroups()
 	}
 	mapping.clear();
 
+	// Determine the cost of each group. Groups containing coarse-grained constraints 
+	// are sorted by decreasing cost so that the expensive constraints are scheduled first.
+	m_constraintGroupCosts.resize(m_constraintGroups.size());
+	for (unsigned int j = 0; j < m_constraintGroups.size(); j++)
+	{
+		ConstraintGroup &group = m_constraintGroups[j];
+		unsigned int cost = 0;
+		for (unsigned int i = 0; i < group.size(); i++)
+			cost += m_constraints[group[i]]->getCost();
+		m_constraintGroupCosts[j] = cost;
+
+		if (cost > group.size())
+		{
+			std::stable_sort(group.begin(), group.end(), [&](const unsigned int a, const unsigned int b)
+				{ return m_constraints[a]->getCost() > m_constraints[b]->getCost(); });
+		}
+	}
+
 	m_groupsInitialized = true;
 }
 
@@ -1115,11 +1297,122 @@ void PBD::SimulationModel::setSolidSimulationMethod(int val)
 }
 
 
+void SimulationModel::determineRigidBodyIslands()
+{
+	const unsigned int numRigidBodies = (unsigned int)m_rigidBodies.size();
+
+	// union-find of the connected dynamic bodies
+	Utilities::ScratchArena::Scope scope;
+	Utilities::ScratchVector<unsigned int> parent(numRigidBodies);
+	for (unsigned int i = 0; i < numRigidBodies; i++)
+		parent[i] = i;
+
+	auto findRoot = [&](unsigned int i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+
+	auto connect = [&](const unsigned int i, const unsigned int j)
+	{
+		const unsigned int ri = findRoot(i);
+		const unsigned int rj = findRoot(j);
+		if (ri != rj)
+			parent[std::max(ri, rj)] = std::min(ri, rj);
+	};
+
+	for (unsigned int i = 0; i < m_constraints.size(); i++)
+	{
+		const Constraint *constraint = m_constraints[i];
+		unsigned int first = 0xffffffff;
+		for (unsigned int k = 0; k < constraint->numberOfRigidBodies(); k++)
+		{
+			const unsigned int rbIndex = constraint->m_bodies[k];
+			if (m_rigidBodies[rbIndex]->getMass() == 0.0)
+				continue;
+			if (first == 0xffffffff)
+				first = rbIndex;
+			else
+				connect(first, rbIndex);
+		}
+	}
+
+	for (unsigned int i = 0; i < m_rigidBodyContactConstraints.size(); i++)
+	{
+		const RigidBodyContactConstraint &cc = m_rigidBodyContactConstraints[i];
+		if ((m_rigidBodies[cc.m_bodies[0]]->getMass() != 0.0) && (m_rigidBodies[cc.m_bodies[1]]->getMass() != 0.0))
+			connect(cc.m_bodies[0], cc.m_bodies[1]);
+	}
+
+	// keep the index lists of the islands to reuse their memory
+	for (auto &island : m_rigidBodyIslands)
+		island.clear();
+	unsigned int numIslands = 0;
+	Utilities::ScratchVector<unsigned int> islandIndex(numRigidBodies, 0xffffffff);
+	for (unsigned int i = 0; i < numRigidBodies; i++)
+	{
+		if (m_rigidBodies[i]->getMass() == 0.0)
+			continue;
+		const unsigned int root = findRoot(i);
+		if (islandIndex[root] == 0xffffffff)
+		{
+			islandIndex[root] = numIslands++;
+			if (numIslands > m_rigidBodyIslands.size())
+				m_rigidBodyIslands.emplace_back();
+		}
+		m_rigidBodyIslands[islandIndex[root]].push_back(i);
+	}
+	m_rigidBodyIslands.resize(numIslands);
+}
+
 void SimulationModel::resetContacts()
 {
 	m_rigidBodyContactConstraints.clear();
 	m_particleRigidBodyContactConstraints.clear();
 	m_particleSolidContactConstraints.clear();
+	m_clothContactConstraints.clear();
+	for (auto &group : m_clothContactGroups)
+		group.clear();
+	m_clothContactGroupsInitialized = false;
+}
+
+void SimulationModel::initClothContactGroups()
+{
+	if (m_clothContactGroupsInitialized)
+		return;
+
+	// Greedy coloring with a bit mask of the used colors per particle
+	static_assert(MAX_CLOTH_CONTACT_COLORS <= 64, "The colors must fit into a 64 bit mask.");
+	const unsigned int maxColors = MAX_CLOTH_CONTACT_COLORS;
+	Utilities::ScratchArena::Scope scope;
+	Utilities::ScratchVector<uint64_t> usedColors(m_particles.size(), 0);
+	for (auto &group : m_clothContactGroups)
+		group.clear();
+	for (unsigned int i = 0; i < m_clothContactConstraints.size(); i++)
+	{
+		const ClothContactConstraint &cc = m_clothContactConstraints[i];
+		uint64_t used = 0;
+		for (unsigned int k = 0; k < 4; k++)
+			used |= usedColors[cc.m_bodies[k]];
+
+		unsigned int color = 0;
+		while ((color < maxColors) && (used & ((uint64_t)1 << color)))
+			color++;
+
+		if (color < maxColors)
+		{
+			for (unsigned int k = 0; k < 4; k++)
+				usedColors[cc.m_bodies[k]] |= ((uint64_t)1 << color);
+		}
+		if (color >= m_clothContactGroups.size())
+			m_clothContactGroups.resize(color + 1);
+		m_clothContactGroups[color].push_back(i);
+	}
+	m_clothContactGroupsInitialized = true;
 }
 
 void SimulationModel::addClothConstraints(const TriangleModel* tm, const unsigned int clothMethod, 
@@ -1418,6 +1711,7 @@ void PBD::SimulationModel::setSolidStiffness(Real val)
 	setConstraintValue<DistanceConstraint, Real, &DistanceConstraint::m_stiffness>(val);
 	setConstraintValue<DistanceConstraint_XPBD, Real, &DistanceConstraint_XPBD::m_stiffness>(val);
 	setConstraintValue<ShapeMatchingConstraint, Real, &ShapeMatchingConstraint::m_stiffness>(val);
+	setConstraintValue<FastLatticeShapeMatchingConstraint, Real, &FastLatticeShapeMatchingConstraint::m_stiffness>(val);
 }
 
 void PBD::SimulationModel::setSolidPoissonRatio(Real val)
@@ -1450,6 +1744,7 @@ void PBD::SimulationModel::setRodStretchingStiffness(Real val)
 {
 	m_rod_stretchingStiffness = val;
 	setConstraintValue<StretchShearConstraint, Real, &StretchShearConstraint::m_stretchingStiffness>(val);
+	setConstraintValue<CosseratRodsConstraint, Real, &CosseratRodsConstraint::m_stretchingStiffness>(val);
 	setConstraintValue<DistanceConstraint, Real, &DistanceConstraint::m_stiffness>(val);
 	setConstraintValue<DistanceConstraint_XPBD, Real, &DistanceConstraint_XPBD::m_stiffness>(val);
 }
@@ -1458,28 +1753,131 @@ void PBD::SimulationModel::setRodShearingStiffnessX(Real val)
 {
 	m_rod_shearingStiffnessX = val;
 	setConstraintValue<StretchShearConstraint, Real, &StretchShearConstraint::m_shearingStiffness1>(val);
+	setConstraintValue<CosseratRodsConstraint, Real, &CosseratRodsConstraint::m_shearingStiffness1>(val);
 }
 
 void PBD::SimulationModel::setRodShearingStiffnessY(Real val)
 {
 	m_rod_shearingStiffnessY = val;
 	setConstraintValue<StretchShearConstraint, Real, &StretchShearConstraint::m_shearingStiffness2>(val);
+	setConstraintValue<CosseratRodsConstraint, Real, &CosseratRodsConstraint::m_shearingStiffness2>(val);
 }
 
 void PBD::SimulationModel::setRodBendingStiffnessX(Real val)
 {
 	m_rod_bendingStiffnessX = val;
 	setConstraintValue<BendTwistConstraint, Real, &BendTwistConstraint::m_bendingStiffness1>(val);
+	setConstraintValue<CosseratRodsConstraint, Real, &CosseratRodsConstraint::m_bendingStiffness1>(val);
 }
 
 void PBD::SimulationModel::setRodBendingStiffnessY(Real val)
 {
 	m_rod_bendingStiffnessY = val;
 	setConstraintValue<BendTwistConstraint, Real, &BendTwistConstraint::m_bendingStiffness2>(val);
+	setConstraintValue<CosseratRodsConstraint, Real, &CosseratRodsConstraint::m_bendingStiffness2>(val);
 }
 
 void PBD::SimulationModel::setRodTwistingStiffness(Real val)
 {
 	m_rod_twistingStiffness = val;
 	setConstraintValue<BendTwistConstraint, Real, &BendTwistConstraint::m_twistingStiffness>(val);
+	setConstraintValue<CosseratRodsConstraint, Real, &CosseratRodsConstraint::m_twistingStiffness>(val);
+}
+
+template<typename ContactVector>
+static void saveContacts(Utilities::BinaryWriter &binWriter, const ContactVector &contacts)
+{
+	binWriter.write((unsigned int) contacts.size());
+	for (unsigned int i = 0; i < contacts.size(); i++)
+		contacts[i].saveState(binWriter);
+}
+
+template<typename ContactVector>
+static bool loadContacts(Utilities::BinaryReader &binReader, ContactVector &contacts)
+{
+	unsigned int numContacts = 0;
+	if (!binReader.read(numContacts))
+		return false;
+	contacts.resize(numContacts);
+	for (unsigned int i = 0; i < numContacts; i++)
+	{
+		if (!contacts[i].loadState(binReader))
+			return false;
+	}
+	return true;
+}
+
+void SimulationModel::saveState(Utilities::BinaryWriter &binWriter)
+{
+	// layout of the model which is checked when the state is loaded
+	binWriter.write(m_particles.size());
+	binWriter.write(m_orientations.size());
+	binWriter.write((unsigned int) m_rigidBodies.size());
+	std::vector<int> typeIds(m_constraints.size());
+	for (unsigned int i = 0; i < m_constraints.size(); i++)
+		typeIds[i] = m_constraints[i]->getTypeId();
+	binWriter.writeVector(typeIds);
+
+	m_particles.saveState(binWriter);
+	m_orientations.saveState(binWriter);
+	for (unsigned int i = 0; i < m_rigidBodies.size(); i++)
+		m_rigidBodies[i]->saveState(binWriter);
+	for (unsigned int i = 0; i < m_constraints.size(); i++)
+		m_constraints[i]->saveState(binWriter);
+
+	// the contacts of the last collision detection are used in the next step
+	saveContacts(binWriter, m_rigidBodyContactConstraints);
+	saveContacts(binWriter, m_particleRigidBodyContactConstraints);
+	saveContacts(binWriter, m_particleSolidContactConstraints);
+	saveContacts(binWriter, m_clothContactConstraints);
+}
+
+bool SimulationModel::loadState(Utilities::BinaryReader &binReader)
+{
+	unsigned int numParticles = 0;
+	unsigned int numOrientations = 0;
+	unsigned int numRigidBodies = 0;
+	std::vector<int> typeIds;
+	binReader.read(numParticles);
+	binReader.read(numOrientations);
+	binReader.read(numRigidBodies);
+	binReader.readVector(typeIds);
+	if (binReader.hasError())
+		return false;
+	if ((numParticles != m_particles.size()) || (numOrientations != m_orientations.size()) || (numRigidBodies != m_rigidBodies.size()))
+	{
+		LOG_ERR << "The checkpoint does not match the model (particles: " << numParticles << "/" << m_particles.size()
+			<< ", orientations: " << numOrientations << "/" << m_orientations.size()
+			<< ", rigid bodies: " << numRigidBodies << "/" << m_rigidBodies.size() << ").";
+		return false;
+	}
+	bool sameConstraints = (typeIds.size() == m_constraints.size());
+	for (unsigned int i = 0; sameConstraints && (i < m_constraints.size()); i++)
+		sameConstraints = (typeIds[i] == m_constraints[i]->getTypeId());
+	if (!sameConstraints)
+	{
+		LOG_ERR << "The constraints of the checkpoint do not match the model.";
+		return false;
+	}
+
+	bool res = m_particles.loadState(binReader) && m_orientations.loadState(binReader);
+	for (unsigned int i = 0; res && (i < m_rigidBodies.size()); i++)
+		res = m_rigidBodies[i]->loadState(binReader);
+	for (unsigned int i = 0; res && (i < m_constraints.size()); i++)
+		res = m_constraints[i]->loadState(binReader);
+
+	resetContacts();
+	res = res && loadContacts(binReader, m_rigidBodyContactConstraints);
+	res = res && loadContacts(binReader, m_particleRigidBodyContactConstraints);
+	res = res && loadContacts(binReader, m_particleSolidContactConstraints);
+	res = res && loadContacts(binReader, m_clothContactConstraints);
+	if (!res)
+	{
+		resetContacts();
+		return false;
+	}
+
+	// the islands depend on the contacts
+	determineRigidBodyIslands();
+	return true;
 }
@@ -9,6 +9,7 @@
 #include "TetModel.h"
 #include "LineModel.h"
 #include "ParameterObject.h"
+#include "TimeManager.h"
 
 namespace PBD 
 {	
@@ -64,6 +65,7 @@ namespace PBD
 
 			static int CONTACT_STIFFNESS_RB;
 			static int CONTACT_STIFFNESS_PARTICLE_RB;
+			static int CONTACT_STIFFNESS_CLOTH;
 
 			SimulationModel();
 			SimulationModel(const SimulationModel&) = delete;
@@ -77,12 +79,17 @@ namespace PBD
 			typedef std::vector<RigidBodyContactConstraint> RigidBodyContactConstraintVector;
 			typedef std::vector<ParticleRigidBodyContactConstraint> ParticleRigidBodyContactConstraintVector;
 			typedef std::vector<ParticleTetContactConstraint> ParticleSolidContactConstraintVector;
+			typedef std::vector<ClothContactConstraint> ClothContactConstraintVector;
 			typedef std::vector<RigidBody*> RigidBodyVector;
 			typedef std::vector<TriangleModel*> TriangleModelVector;
 			typedef std::vector<TetModel*> TetModelVector;
 			typedef std::vector<LineModel*> LineModelVector;
 			typedef std::vector<unsigned int> ConstraintGroup;
 			typedef std::vector<ConstraintGroup> ConstraintGroupVector;
+			typedef std::vector<unsigned int> ConstraintIsland;
+			typedef std::vector<ConstraintIsland> ConstraintIslandVector;
+			typedef std::vector<unsigned int> RigidBodyIsland;
+			typedef std::vector<RigidBodyIsland> RigidBodyIslandVector;
 
 
 		protected:
@@ -92,11 +99,27 @@ namespace PBD
 			LineModelVector m_lineModels;
 			ParticleData m_particles;
 			OrientationData m_orientations;
+			/** Time and time step size of the model, the step size is changed during a step for the substeps */
+			TimeManager m_timeManager;
 			ConstraintVector m_constraints;
 			RigidBodyContactConstraintVector m_rigidBodyContactConstraints;
 			ParticleRigidBodyContactConstraintVector m_particleRigidBodyContactConstraints;
 			ParticleSolidContactConstraintVector m_particleSolidContactConstraints;
+			ClothContactConstraintVector m_clothContactConstraints;
+			/** Colored groups of cloth contacts which do not share particles. The group 
+			* MAX_CLOTH_CONTACT_COLORS contains contacts which could not be colored. */
+			ConstraintGroupVector m_clothContactGroups;
+			bool m_clothContactGroupsInitialized;
 			ConstraintGroupVector m_constraintGroups;
+			/** Sum of the costs of the constraints in each group */
+			std::vector<unsigned int> m_constraintGroupCosts;
+			/** Independent islands of constraints which do not share bodies. Each island 
+			* is solved as a single task. The constraints of larger islands are 
+			* distributed to the constraint groups instead. */
+			ConstraintIslandVector m_constraintIslands;
+			std::vector<unsigned int> m_constraintIslandCosts;
+			/** Dynamic rigid bodies which are connected by joints or contacts */
+			RigidBodyIslandVector m_rigidBodyIslands;
 
 			int m_clothSimulationMethod;
 			int m_clothBendingMethod;
@@ -126,6 +149,7 @@ namespace PBD
 
 			Real m_contactStiffnessRigidBody;
 			Real m_contactStiffnessParticleRigidBody;
+			Real m_contactStiffnessCloth;
 
 			std::function<void()> m_clothSimMethodChanged;
 			std::function<void()> m_clothBendingMethodChanged;
@@ -138,6 +162,7 @@ namespace PBD
 			RigidBodyVector &getRigidBodies();
 			ParticleData &getParticles();
 			OrientationData &getOrientations();
+			TimeManager &getTimeManager();
 			TriangleModelVector &getTriangleModels();
 			TetModelVector &getTetModels();
 			LineModelVector &getLineModels();
@@ -145,10 +170,18 @@ namespace PBD
 			RigidBodyContactConstraintVector &getRigidBodyContactConstraints();
 			ParticleRigidBodyContactConstraintVector &getParticleRigidBodyContactConstraints();
 			ParticleSolidContactConstraintVector &getParticleSolidContactConstraints();
+			ClothContactConstraintVector &getClothContactConstraints();
+			ConstraintGroupVector &getClothContactGroups();
 			ConstraintGroupVector &getConstraintGroups();
+			std::vector<unsigned int> &getConstraintGroupCosts();
+			ConstraintIslandVector &getConstraintIslands();
+			std::vector<unsigned int> &getConstraintIslandCosts();
+			RigidBodyIslandVector &getRigidBodyIslands();
 			bool m_groupsInitialized;
 
 			void resetContacts();
+			/** Color the cloth contacts if necessary. */
+			void initClothContactGroups();
 
 			void addTriangleModel(
 				const unsigned int nPoints,
@@ -182,6 +215,17 @@ namespace PBD
 
 			void updateConstraints();
 			void initConstraintGroups();
+			/** Determine the simulation islands of the dynamic rigid bodies using the 
+			* current joints and rigid body contacts. Static bodies do not connect islands. */
+			void determineRigidBodyIslands();
+
+			/** Write the dynamic state of the model (particles, orientations, rigid bodies, 
+			* the state of the constraints and the current contacts). */
+			void saveState(Utilities::BinaryWriter &binWriter);
+			/** Read a state written by saveState. The model must contain the same bodies and 
+			* constraints as the saved model, i.e. it must be created from the same scene. 
+			* Returns false if the state does not match the model. */
+			bool loadState(Utilities::BinaryReader &binReader);
 
 			bool addBallJoint(const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos);
 			bool addBallOnLineJoint(const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Vector3r &dir);
@@ -210,6 +254,10 @@ namespace PBD
 				const Vector3r &cp1, const Vector3r &cp2,
 				const Vector3r &normal, const Real dist,
 				const Real restitutionCoeff, const Real frictionCoeff);
+			bool addClothContactConstraint(const bool edgeEdge, 
+				const unsigned int particleIndex0, const unsigned int particleIndex1,
+				const unsigned int particleIndex2, const unsigned int particleIndex3,
+				const Real thickness);
 
 			bool addDistanceConstraint(const unsigned int particle1, const unsigned int particle2, const Real stiffness);
 			bool addDistanceConstraint_XPBD(const unsigned int particle1, const unsigned int particle2, const Real stiffness);
@@ -240,11 +288,18 @@ namespace PBD
 									const Real stretchStiffness, const Real shearStiffness,
 									const bool normalizeStretch, const bool normalizeShear);
 			bool addShapeMatchingConstraint(const unsigned int numberOfParticles, const unsigned int particleIndices[], const unsigned int numClusters[], const Real stiffness);
+			/** Add a lattice shape matching constraint. cellParticles contains the particle index of each cell 
+			* (index i*height*depth + j*depth + k) or 0xffffffff for an empty cell. */
+			bool addFastLatticeShapeMatchingConstraint(const unsigned int width, const unsigned int height, const unsigned int depth, 
+				const unsigned int cellParticles[], const unsigned int regionWidth, const Real stiffness);
 			bool addStretchShearConstraint(const unsigned int particle1, const unsigned int particle2, 
 				const unsigned int quaternion1, const Real stretchingStiffness,
 				const Real shearingStiffness1, const Real shearingStiffness2);
 			bool addBendTwistConstraint(const unsigned int quaternion1, const unsigned int quaternion2, 
 				const Real twistingStiffness, const Real bendingStiffness1, const Real bendingStiffness2);
+			bool addCosseratRodsConstraint(const std::vector<unsigned int> &lineModelIndices,
+				const Real stretchingStiffness, const Real shearingStiffness1, const Real shearingStiffness2,
+				const Real twistingStiffness, const Real bendingStiffness1, const Real bendingStiffness2);
 			bool addStretchBendingTwistingConstraint(const unsigned int rbIndex1, const unsigned int rbIndex2, const Vector3r &pos, const Real averageRadius, const Real averageSegmentLength, const Real youngsModulus, const Real torsionModulus);
 			bool addDirectPositionBasedSolverForStiffRodsConstraint(const std::vector<std::pair<unsigned int, unsigned int>> & jointSegmentIndices, const std::vector<Vector3r> &jointPositions, const std::vector<Real> &averageRadii, const std::vector<Real> &averageSegmentLengths, const std::vector<Real> &youngsModuli, const std::vector<Real> &torsionModuli);
 
@@ -252,6 +307,8 @@ namespace PBD
 			void setContactStiffnessRigidBody(Real val) { m_contactStiffnessRigidBody = val; }
 			Real getContactStiffnessParticleRigidBody() const { return m_contactStiffnessParticleRigidBody; }
 			void setContactStiffnessParticleRigidBody(Real val) { m_contactStiffnessParticleRigidBody = val; }
+			Real getContactStiffnessCloth() const { return m_contactStiffnessCloth; }
+			void setContactStiffnessCloth(Real val) { m_contactStiffnessCloth = val; }
 		
 			void addClothConstraints(const TriangleModel* tm, const unsigned int clothMethod, 
 				const Real distanceStiffness, const Real xxStiffness, const Real yyStiffness,
@@ -12,7 +12,8 @@ TimeManager::TimeManager ()
 
 TimeManager::~TimeManager () 
 {
-	current = 0;
+	if (current == this)
+		current = 0;
 }
 
 TimeManager* TimeManager::getCurrent ()
@@ -34,7 +35,7 @@ bool TimeManager::hasCurrent()
 	return (current != 0);
 }
 
-Real TimeManager::getTime()
+Real TimeManager::getTime() const
 {
 	return time;
 }
@@ -44,7 +45,7 @@ void TimeManager::setTime(Real t)
 	time = t;
 }
 
-Real TimeManager::getTimeStepSize()
+Real TimeManager::getTimeStepSize() const
 {
 	return h;
 }
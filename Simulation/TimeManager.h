@@ -5,6 +5,11 @@
 
 namespace PBD
 {
+	/** Time and time step size of a simulation. Each SimulationModel has its own 
+	* time manager, so that independent models can be simulated concurrently. 
+	* The current time manager is the one of the model of the current Simulation 
+	* (see Simulation::setModel()).
+	*/
 	class TimeManager
 	{
 	private:
@@ -21,9 +26,9 @@ namespace PBD
 		static void setCurrent (TimeManager* tm);
 		static bool hasCurrent();
 
-		Real getTime();
+		Real getTime() const;
 		void setTime(Real t);
-		Real getTimeStepSize();
+		Real getTimeStepSize() const;
 		void setTimeStepSize(Real tss);
 	};
 }
@@ -7,8 +7,11 @@ using namespace PBD;
 using namespace std;
 using namespace GenParam;
 
+int TimeStep::STATISTICS = -1;
+
 TimeStep::TimeStep()
 {
+	m_collectStatistics = false;
 }
 
 TimeStep::~TimeStep(void)
@@ -23,6 +26,10 @@ void TimeStep::init()
 void TimeStep::initParameters()
 {
 	ParameterObject::initParameters();
+
+	STATISTICS = createBoolParameter("statistics", "Statistics", &m_collectStatistics);
+	setGroup(STATISTICS, "Simulation|Statistics");
+	setDescription(STATISTICS, "Collect the residuals of the constraints, the numbers of contacts and collision tests and the times of the solver phases in each time step.");
 }
 
 void TimeStep::clearAccelerations(SimulationModel &model)
@@ -63,6 +70,7 @@ void TimeStep::clearAccelerations(SimulationModel &model)
 
 void TimeStep::reset()
 {
+	m_statistics = TimeStepStatistics();
 }
 
 void TimeStep::setCollisionDetection(SimulationModel &model, CollisionDetection *cd)
@@ -70,6 +78,7 @@ void TimeStep::setCollisionDetection(SimulationModel &model, CollisionDetection
 	m_collisionDetection = cd;
 	m_collisionDetection->setContactCallback(contactCallbackFunction, &model);
 	m_collisionDetection->setSolidContactCallback(solidContactCallbackFunction, &model);
+	m_collisionDetection->setClothContactCallback(clothContactCallbackFunction, &model);
 }
 
 CollisionDetection *TimeStep::getCollisionDetection()
@@ -98,4 +107,14 @@ void TimeStep::solidContactCallbackFunction(const unsigned int contactType, cons
 	SimulationModel *model = (SimulationModel*)userData;
 	if (contactType == CollisionDetection::ParticleSolidContactType)
 		model->addParticleSolidContactConstraint(bodyIndex1, bodyIndex2, tetIndex, bary, cp1, cp2, normal, dist, restitutionCoeff, frictionCoeff);
-}
\ No newline at end of file
+}
+
+void TimeStep::clothContactCallbackFunction(const unsigned int contactType,
+	const unsigned int particleIndex0, const unsigned int particleIndex1,
+	const unsigned int particleIndex2, const unsigned int particleIndex3,
+	const Real thickness, void *userData)
+{
+	SimulationModel *model = (SimulationModel*)userData;
+	model->addClothContactConstraint(contactType == CollisionDetection::EdgeEdgeContactType,
+		particleIndex0, particleIndex1, particleIndex2, particleIndex3, thickness);
+}
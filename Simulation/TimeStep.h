@@ -4,6 +4,7 @@
 #include "Common/Common.h"
 #include "SimulationModel.h"
 #include "CollisionDetection.h"
+#include "TimeStepStatistics.h"
 #include "ParameterObject.h"
 
 namespace PBD
@@ -12,8 +13,14 @@ namespace PBD
 	*/
 	class TimeStep : public GenParam::ParameterObject
 	{
+	public:
+		static int STATISTICS;
+
 	protected:
 		CollisionDetection *m_collisionDetection;
+		/** Collect the solver statistics in each time step */
+		bool m_collectStatistics;
+		TimeStepStatistics m_statistics;
 
 		/** Clear accelerations and add gravitation.
 		*/
@@ -34,6 +41,11 @@ namespace PBD
 			const Vector3r &normal, const Real dist,
 			const Real restitutionCoeff, const Real frictionCoeff, void *userData);
 
+		static void clothContactCallbackFunction(const unsigned int contactType,
+			const unsigned int particleIndex0, const unsigned int particleIndex1,
+			const unsigned int particleIndex2, const unsigned int particleIndex3,
+			const Real thickness, void *userData);
+
 	public:
 		TimeStep();
 		virtual ~TimeStep(void);
@@ -45,6 +57,11 @@ namespace PBD
 
 		void setCollisionDetection(SimulationModel &model, CollisionDetection *cd);
 		CollisionDetection *getCollisionDetection();
+
+		bool getCollectStatistics() const { return m_collectStatistics; }
+		void setCollectStatistics(const bool val) { m_collectStatistics = val; }
+		/** Statistics of the last time step (see getCollectStatistics()) */
+		const TimeStepStatistics &getStatistics() const { return m_statistics; }
 	};
 }
 
@@ -5,6 +5,7 @@
 #include <iostream>
 #include "PositionBasedDynamics/PositionBasedDynamics.h"
 #include "Utils/Timing.h"
+#include "Utils/ScratchArena.h"
 
 using namespace PBD;
 using namespace std;
@@ -16,6 +17,10 @@ int TimeStepController::NUM_SUB_STEPS = -1;
 int TimeStepController::MAX_ITERATIONS = -1;
 int TimeStepController::MAX_ITERATIONS_V = -1;
 int TimeStepController::VELOCITY_UPDATE_METHOD = -1;
+int TimeStepController::SLEEPING = -1;
+int TimeStepController::SLEEP_LINEAR_VELOCITY = -1;
+int TimeStepController::SLEEP_ANGULAR_VELOCITY = -1;
+int TimeStepController::SLEEP_TIME = -1;
 int TimeStepController::ENUM_VUPDATE_FIRST_ORDER = -1;
 int TimeStepController::ENUM_VUPDATE_SECOND_ORDER = -1;
 
@@ -28,6 +33,10 @@ TimeStepController::TimeStepController()
 	m_maxIterations = 1;
 	m_maxIterationsV = 5;
 	m_subSteps = 5;
+	m_sleeping = false;
+	m_sleepLinearVelocity = static_cast<Real>(0.05);
+	m_sleepAngularVelocity = static_cast<Real>(0.05);
+	m_sleepTime = static_cast<Real>(0.5);
 	m_collisionDetection = NULL;	
 }
 
@@ -70,13 +79,36 @@ void TimeStepController::initParameters()
 	EnumParameter* enumParam = static_cast<EnumParameter*>(getParameter(VELOCITY_UPDATE_METHOD));
 	enumParam->addEnumValue("First Order Update", ENUM_VUPDATE_FIRST_ORDER);
 	enumParam->addEnumValue("Second Order Update", ENUM_VUPDATE_SECOND_ORDER);
+
+	SLEEPING = createBoolParameter("sleeping", "Sleeping", &m_sleeping);
+	setGroup(SLEEPING, "Simulation|Sleeping");
+	setDescription(SLEEPING, "Put islands of rigid bodies which are at rest to sleep.");
+
+	SLEEP_LINEAR_VELOCITY = createNumericParameter("sleepLinearVelocity", "Linear velocity threshold", &m_sleepLinearVelocity);
+	setGroup(SLEEP_LINEAR_VELOCITY, "Simulation|Sleeping");
+	setDescription(SLEEP_LINEAR_VELOCITY, "A body is at rest if its velocity is below this threshold (unless the body defines its own threshold).");
+	static_cast<NumericParameter<Real>*>(getParameter(SLEEP_LINEAR_VELOCITY))->setMinValue(0.0);
+
+	SLEEP_ANGULAR_VELOCITY = createNumericParameter("sleepAngularVelocity", "Angular velocity threshold", &m_sleepAngularVelocity);
+	setGroup(SLEEP_ANGULAR_VELOCITY, "Simulation|Sleeping");
+	setDescription(SLEEP_ANGULAR_VELOCITY, "A body is at rest if its angular velocity is below this threshold (unless the body defines its own threshold).");
+	static_cast<NumericParameter<Real>*>(getParameter(SLEEP_ANGULAR_VELOCITY))->setMinValue(0.0);
+
+	SLEEP_TIME = createNumericParameter("sleepTime", "Sleep time", &m_sleepTime);
+	setGroup(SLEEP_TIME, "Simulation|Sleeping");
+	setDescription(SLEEP_TIME, "Time span in which all bodies of an island must be at rest before the island is put to sleep (unless a body defines its own time).");
+	static_cast<NumericParameter<Real>*>(getParameter(SLEEP_TIME))->setMinValue(0.0);
 }
 
 void TimeStepController::step(SimulationModel &model)
 {
 	START_TIMING("simulation step");
-	TimeManager *tm = TimeManager::getCurrent ();
+	TimeManager *tm = &model.getTimeManager();
 	const Real hOld = tm->getTimeStepSize();
+
+	m_statistics.reset();
+	if (m_collisionDetection)
+		m_collisionDetection->resetStatistics();
  
 	//////////////////////////////////////////////////////////////////////////
 	// rigid body model
@@ -88,6 +120,13 @@ void TimeStepController::step(SimulationModel &model)
 
 	const int numBodies = (int)rb.size();
 
+	wakeUpIslands(model);
+
+	if (m_collisionDetection)
+		m_collisionDetection->initContinuousCollisionDetection(model);
+
+	const bool substepCollisions = m_collisionDetection && m_collisionDetection->getSubstepCollisionDetection();
+
 	Real h = hOld / (Real)m_subSteps;
 	tm->setTimeStepSize(h);
 	for (unsigned int step = 0; step < m_subSteps; step++)
@@ -97,6 +136,8 @@ void TimeStepController::step(SimulationModel &model)
 			#pragma omp for schedule(static) nowait
 			for (int i = 0; i < numBodies; i++)
 			{ 
+				if (rb[i]->isSleeping())
+					continue;
 				rb[i]->getLastPosition() = rb[i]->getOldPosition();
 				rb[i]->getOldPosition() = rb[i]->getPosition();
 				TimeIntegration::semiImplicitEuler(h, rb[i]->getMass(), rb[i]->getPosition(), rb[i]->getVelocity(), rb[i]->getAcceleration());
@@ -131,7 +172,7 @@ void TimeStepController::step(SimulationModel &model)
 
 		START_TIMING("position constraints projection");
 		positionConstraintProjection(model);
-		STOP_TIMING_AVG;
+		m_statistics.m_timePositionProjection += Utilities::Timing::stopTiming(false, true);
 
 		#pragma omp parallel if(numBodies > MIN_PARALLEL_SIZE) default(shared)
 		{
@@ -139,6 +180,8 @@ void TimeStepController::step(SimulationModel &model)
 			#pragma omp for schedule(static) nowait
 			for (int i = 0; i < numBodies; i++)
 			{
+				if (rb[i]->isSleeping())
+					continue;
 				if (m_velocityUpdateMethod == 0)
 				{
 					TimeIntegration::velocityUpdateFirstOrder(h, rb[i]->getMass(), rb[i]->getPosition(), rb[i]->getOldPosition(), rb[i]->getVelocity());
@@ -171,29 +214,27 @@ void TimeStepController::step(SimulationModel &model)
 					TimeIntegration::angularVelocityUpdateSecondOrder(h, od.getMass(i), od.getQuaternion(i), od.getOldQuaternion(i), od.getLastQuaternion(i), od.getVelocity(i));
 			}
 		}
+
+		// In substep mode the contacts are updated after each substep. The 
+		// contacts of the last substep are determined after the continuous 
+		// collision detection. 
+		if (substepCollisions && (step < m_subSteps - 1))
+			collisionHandling(model, true, step == 0, hOld);
 	}
 	h = hOld;
 	tm->setTimeStepSize(hOld);
 
-	#pragma omp parallel default(shared)
+	if (m_collisionDetection && m_collisionDetection->getContinuousCollisionDetection())
 	{
-		#pragma omp for schedule(static) nowait
-		for (int i = 0; i < numBodies; i++)
-		{
-			if (rb[i]->getMass() != 0.0)
-				rb[i]->getGeometry().updateMeshTransformation(rb[i]->getPosition(), rb[i]->getRotationMatrix());
-		}
+		START_TIMING("continuous collision detection");
+		m_collisionDetection->continuousCollisionDetection(model);
+		m_statistics.m_timeContinuousCollisionDetection += Utilities::Timing::stopTiming(false, true);
 	}
 
+	collisionHandling(model, substepCollisions, m_subSteps == 1, hOld);
 
-	if (m_collisionDetection)
-	{
-		START_TIMING("collision detection");
-		m_collisionDetection->collisionDetection(model);
-		STOP_TIMING_AVG;
-	}
-
-	velocityConstraintProjection(model);
+	if (m_sleeping)
+		updateSleepStates(model, h);
 
 	//////////////////////////////////////////////////////////////////////////
 	// update motor joint targets
@@ -207,7 +248,7 @@ void TimeStepController::step(SimulationModel &model)
 			(constraints[i]->getTypeId() == TargetVelocityMotorSliderJoint::TYPE_ID))
 		{
 			MotorJoint *motor = (MotorJoint*)constraints[i];
-			const std::vector<Real> sequence = motor->getTargetSequence();
+			const std::vector<Real> &sequence = motor->getTargetSequence();
 			if (sequence.size() > 0)
 			{
 				Real time = tm->getTime();
@@ -237,11 +278,80 @@ void TimeStepController::step(SimulationModel &model)
 	
 	// compute new time	
 	tm->setTime (tm->getTime () + h);
-	STOP_TIMING_AVG;
+	updateStatistics(model);
+	m_statistics.m_timeStep = Utilities::Timing::stopTiming(false, true);
+}
+
+void TimeStepController::updateStatistics(SimulationModel &model)
+{
+	m_statistics.m_step++;
+	m_statistics.m_time = model.getTimeManager().getTime();
+	m_statistics.m_subSteps = m_subSteps;
+	m_statistics.m_iterations = m_iterations;
+	m_statistics.m_iterationsV = m_iterationsV;
+	m_statistics.m_numConstraints = (unsigned int)model.getConstraints().size();
+	m_statistics.m_numIslands = (unsigned int)model.getConstraintIslands().size();
+	m_statistics.m_numConstraintGroups = (unsigned int)model.getConstraintGroups().size();
+	m_statistics.m_numRigidBodyContacts = (unsigned int)model.getRigidBodyContactConstraints().size();
+	m_statistics.m_numParticleRigidBodyContacts = (unsigned int)model.getParticleRigidBodyContactConstraints().size();
+	m_statistics.m_numParticleSolidContacts = (unsigned int)model.getParticleSolidContactConstraints().size();
+	m_statistics.m_numClothContacts = (unsigned int)model.getClothContactConstraints().size();
+	m_statistics.m_numClothContactGroups = (unsigned int)model.getClothContactGroups().size();
+	if (m_collisionDetection)
+		m_statistics.m_collision = m_collisionDetection->getStatistics();
+
+	m_statistics.m_numSleepingBodies = 0;
+	if (m_sleeping)
+	{
+		const SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
+		for (unsigned int i = 0; i < rb.size(); i++)
+		{
+			if (rb[i]->isSleeping())
+				m_statistics.m_numSleepingBodies++;
+		}
+	}
+}
+
+void TimeStepController::collisionHandling(SimulationModel &model, const bool substep, const bool updatePairs, const Real timeHorizon)
+{
+	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
+	const int numBodies = (int)rb.size();
+
+	#pragma omp parallel default(shared)
+	{
+		#pragma omp for schedule(static) nowait
+		for (int i = 0; i < numBodies; i++)
+		{
+			if ((rb[i]->getMass() != 0.0) && !rb[i]->isSleeping())
+				rb[i]->getGeometry().updateMeshTransformation(rb[i]->getPosition(), rb[i]->getRotationMatrix());
+		}
+	}
+
+	if (m_collisionDetection)
+	{
+		START_TIMING("collision detection");
+		if (substep)
+			m_collisionDetection->substepCollisionDetection(model, updatePairs, timeHorizon);
+		else
+			m_collisionDetection->collisionDetection(model);
+		m_statistics.m_timeCollisionDetection += Utilities::Timing::stopTiming(false, true);
+	}
+
+	if (m_sleeping)
+	{
+		// bodies which got in contact with an awake body are woken up
+		model.determineRigidBodyIslands();
+		wakeUpIslands(model);
+	}
+
+	START_TIMING("velocity constraints projection");
+	velocityConstraintProjection(model);
+	m_statistics.m_timeVelocityProjection += Utilities::Timing::stopTiming(false, true);
 }
 
 void TimeStepController::reset()
 {
+	TimeStep::reset();
 	m_iterations = 0;
 	m_iterationsV = 0;
 	//m_maxIterations = 5;
@@ -258,8 +368,15 @@ void TimeStepController::positionConstraintProjection(SimulationModel &model)
 	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
 	SimulationModel::ConstraintVector &constraints = model.getConstraints();
 	SimulationModel::ConstraintGroupVector &groups = model.getConstraintGroups();
+	std::vector<unsigned int> &groupCosts = model.getConstraintGroupCosts();
+	SimulationModel::ConstraintIslandVector &islands = model.getConstraintIslands();
+	const int numIslands = (int)islands.size();
+	const unsigned int islandsCost = getIslandsCost(model);
 	SimulationModel::RigidBodyContactConstraintVector &contacts = model.getRigidBodyContactConstraints();
 	SimulationModel::ParticleSolidContactConstraintVector &particleTetContacts = model.getParticleSolidContactConstraints();
+	SimulationModel::ClothContactConstraintVector &clothContacts = model.getClothContactConstraints();
+	SimulationModel::ConstraintGroupVector &clothContactGroups = model.getClothContactGroups();
+	model.initClothContactGroups();
 
 	// init constraints for this time step if necessary
 	for (auto & constraint : constraints)
@@ -267,20 +384,66 @@ void TimeStepController::positionConstraintProjection(SimulationModel &model)
 		constraint->initConstraintBeforeProjection(model);
 	}
 
+	if (m_collectStatistics)
+		m_corrections.assign(constraints.size(), static_cast<Real>(0.0));
+
 	while (m_iterations < m_maxIterations)
 	{
+		// the corrections of the last iteration are used as residual
+		const bool measure = m_collectStatistics && (m_iterations + 1 == m_maxIterations);
+
+		// Independent islands are solved in parallel. Each island is solved 
+		// by one thread in Gauss-Seidel order without global barriers.
+		// The zones are measured per thread, so that the trace shows the load balance.
+		#pragma omp parallel if((numIslands > 1) && (islandsCost > MIN_PARALLEL_SIZE)) default(shared)
+		{
+			START_TIMING("solve islands");
+			#pragma omp for schedule(dynamic, 1) nowait
+			for (int j = 0; j < numIslands; j++)
+			{
+				for (unsigned int k = 0; k < islands[j].size(); k++)
+				{
+					const unsigned int constraintIndex = islands[j][k];
+					solveConstraint(model, constraints[constraintIndex], measure ? &m_corrections[constraintIndex] : nullptr);
+				}
+			}
+			STOP_TIMING_AVG;
+		}
+
+		// constraints of large islands
 		for (unsigned int group = 0; group < groups.size(); group++)
 		{
 			const int groupSize = (int)groups[group].size();
-			#pragma omp parallel if(groupSize > MIN_PARALLEL_SIZE) default(shared)
+			const unsigned int groupCost = groupCosts[group];
+			if (groupCost > (unsigned int) groupSize)
 			{
-				#pragma omp for schedule(static) 
-				for (int i = 0; i < groupSize; i++)
+				// The group contains coarse-grained constraints (e.g. whole rods) with
+				// different costs. These are sorted by decreasing cost and distributed 
+				// dynamically to balance the load.
+				#pragma omp parallel if((groupSize > 1) && (groupCost > MIN_PARALLEL_SIZE)) default(shared)
 				{
-					const unsigned int constraintIndex = groups[group][i];
-
-					constraints[constraintIndex]->updateConstraint(model);
-					constraints[constraintIndex]->solvePositionConstraint(model, m_iterations);
+					START_TIMING("solve constraint group");
+					#pragma omp for schedule(dynamic, 1) nowait
+					for (int i = 0; i < groupSize; i++)
+					{
+						const unsigned int constraintIndex = groups[group][i];
+						solveConstraint(model, constraints[constraintIndex], measure ? &m_corrections[constraintIndex] : nullptr);
+					}
+					STOP_TIMING_AVG;
+				}
+			}
+			else
+			{
+				#pragma omp parallel if(groupSize > MIN_PARALLEL_SIZE) default(shared)
+				{
+					START_TIMING("solve constraint group");
+					#pragma omp for schedule(static) nowait
+					for (int i = 0; i < groupSize; i++)
+					{
+						const unsigned int constraintIndex = groups[group][i];
+						solveConstraint(model, constraints[constraintIndex], measure ? &m_corrections[constraintIndex] : nullptr);
+					}
+					STOP_TIMING_AVG;
 				}
 			}
 		}
@@ -290,8 +453,88 @@ void TimeStepController::positionConstraintProjection(SimulationModel &model)
 			particleTetContacts[i].solvePositionConstraint(model, m_iterations);
 		}
 
+		// Cloth contacts of one group share no particles. The last group 
+		// contains the contacts which could not be colored.
+		for (unsigned int group = 0; group < clothContactGroups.size(); group++)
+		{
+			const int groupSize = (int)clothContactGroups[group].size();
+			#pragma omp parallel if((groupSize > MIN_PARALLEL_SIZE) && (group < MAX_CLOTH_CONTACT_COLORS)) default(shared)
+			{
+				START_TIMING("solve cloth contacts");
+				#pragma omp for schedule(static) nowait
+				for (int i = 0; i < groupSize; i++)
+				{
+					clothContacts[clothContactGroups[group][i]].solvePositionConstraint(model, m_iterations);
+				}
+				STOP_TIMING_AVG;
+			}
+		}
+
 		m_iterations++;
 	}
+
+	if (m_collectStatistics)
+		updateResiduals(model);
+}
+
+void TimeStepController::solveConstraint(SimulationModel &model, Constraint *constraint, Real *correction)
+{
+	if (m_sleeping && isSleeping(model, constraint))
+		return;
+
+	if (correction == nullptr)
+	{
+		constraint->updateConstraint(model);
+		constraint->solvePositionConstraint(model, m_iterations);
+		return;
+	}
+
+	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
+	ParticleData &pd = model.getParticles();
+	const unsigned int numRigidBodies = constraint->numberOfRigidBodies();
+	const unsigned int numBodies = numRigidBodies + constraint->numberOfParticles();
+	Utilities::ScratchArena::Scope scope;
+	Utilities::ScratchVector<Vector3r> x(numBodies);
+	for (unsigned int k = 0; k < numBodies; k++)
+	{
+		const unsigned int index = constraint->m_bodies[k];
+		x[k] = (k < numRigidBodies) ? rb[index]->getPosition() : pd.getPosition(index);
+	}
+
+	constraint->updateConstraint(model);
+	constraint->solvePositionConstraint(model, m_iterations);
+
+	Real correction2 = 0.0;
+	for (unsigned int k = 0; k < numBodies; k++)
+	{
+		const unsigned int index = constraint->m_bodies[k];
+		const Vector3r &xNew = (k < numRigidBodies) ? rb[index]->getPosition() : pd.getPosition(index);
+		correction2 += (xNew - x[k]).squaredNorm();
+	}
+	*correction = sqrt(correction2);
+}
+
+void TimeStepController::updateResiduals(SimulationModel &model)
+{
+	SimulationModel::ConstraintVector &constraints = model.getConstraints();
+	std::vector<TimeStepStatistics::ConstraintResidual> &residuals = m_statistics.m_residuals;
+	residuals.clear();
+	for (unsigned int i = 0; i < constraints.size(); i++)
+	{
+		const int typeId = constraints[i]->getTypeId();
+		unsigned int r = 0;
+		while ((r < residuals.size()) && (residuals[r].m_typeId != typeId))
+			r++;
+		if (r == residuals.size())
+			residuals.push_back({ typeId, constraints[i]->getTypeName(), 0u, static_cast<Real>(0.0), static_cast<Real>(0.0) });
+
+		const Real c = m_corrections[i];
+		residuals[r].m_numConstraints++;
+		residuals[r].m_residual += c * c;
+		residuals[r].m_maxCorrection = std::max(residuals[r].m_maxCorrection, c);
+	}
+	for (unsigned int r = 0; r < residuals.size(); r++)
+		residuals[r].m_residual = sqrt(residuals[r].m_residual);
 }
 
 
@@ -305,10 +548,28 @@ void TimeStepController::velocityConstraintProjection(SimulationModel &model)
 	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
 	SimulationModel::ConstraintVector &constraints = model.getConstraints();
 	SimulationModel::ConstraintGroupVector &groups = model.getConstraintGroups();
+	SimulationModel::ConstraintIslandVector &islands = model.getConstraintIslands();
+	const int numIslands = (int)islands.size();
+	const unsigned int islandsCost = getIslandsCost(model);
 	SimulationModel::RigidBodyContactConstraintVector &rigidBodyContacts = model.getRigidBodyContactConstraints();
 	SimulationModel::ParticleRigidBodyContactConstraintVector &particleRigidBodyContacts = model.getParticleRigidBodyContactConstraints();
 	SimulationModel::ParticleSolidContactConstraintVector &particleTetContacts = model.getParticleSolidContactConstraints();
 
+	#pragma omp parallel if((numIslands > 1) && (islandsCost > MIN_PARALLEL_SIZE)) default(shared)
+	{
+		#pragma omp for schedule(dynamic, 1) 
+		for (int j = 0; j < numIslands; j++)
+		{
+			for (unsigned int k = 0; k < islands[j].size(); k++)
+			{
+				const unsigned int constraintIndex = islands[j][k];
+				if (m_sleeping && isSleeping(model, constraints[constraintIndex]))
+					continue;
+				constraints[constraintIndex]->updateConstraint(model);
+			}
+		}
+	}
+
 	for (unsigned int group = 0; group < groups.size(); group++)
 	{
 		const int groupSize = (int)groups[group].size();
@@ -318,6 +579,8 @@ void TimeStepController::velocityConstraintProjection(SimulationModel &model)
 			for (int i = 0; i < groupSize; i++)
 			{
 				const unsigned int constraintIndex = groups[group][i];
+				if (m_sleeping && isSleeping(model, constraints[constraintIndex]))
+					continue;
 				constraints[constraintIndex]->updateConstraint(model);
 			}
 		}
@@ -325,6 +588,21 @@ void TimeStepController::velocityConstraintProjection(SimulationModel &model)
 
 	while (m_iterationsV < m_maxIterationsV)
 	{
+		#pragma omp parallel if((numIslands > 1) && (islandsCost > MIN_PARALLEL_SIZE)) default(shared)
+		{
+			#pragma omp for schedule(dynamic, 1) 
+			for (int j = 0; j < numIslands; j++)
+			{
+				for (unsigned int k = 0; k < islands[j].size(); k++)
+				{
+					const unsigned int constraintIndex = islands[j][k];
+					if (m_sleeping && isSleeping(model, constraints[constraintIndex]))
+						continue;
+					constraints[constraintIndex]->solveVelocityConstraint(model, m_iterationsV);
+				}
+			}
+		}
+
 		for (unsigned int group = 0; group < groups.size(); group++)
 		{
 			const int groupSize = (int)groups[group].size();
@@ -334,6 +612,8 @@ void TimeStepController::velocityConstraintProjection(SimulationModel &model)
 				for (int i = 0; i < groupSize; i++)
 				{
 					const unsigned int constraintIndex = groups[group][i];
+					if (m_sleeping && isSleeping(model, constraints[constraintIndex]))
+						continue;
 					constraints[constraintIndex]->solveVelocityConstraint(model, m_iterationsV);
 				}
 			}
@@ -357,3 +637,130 @@ void TimeStepController::velocityConstraintProjection(SimulationModel &model)
 }
 
 
+
+unsigned int TimeStepController::getIslandsCost(SimulationModel &model) const
+{
+	const std::vector<unsigned int> &islandCosts = model.getConstraintIslandCosts();
+	unsigned int cost = 0;
+	for (unsigned int i = 0; i < islandCosts.size(); i++)
+		cost += islandCosts[i];
+	return cost;
+}
+
+bool TimeStepController::isSleeping(SimulationModel &model, const Constraint *constraint) const
+{
+	const unsigned int numRigidBodies = constraint->numberOfRigidBodies();
+	if ((numRigidBodies == 0) || (numRigidBodies < constraint->numberOfBodies()))
+		return false;
+
+	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
+	for (unsigned int k = 0; k < numRigidBodies; k++)
+	{
+		const RigidBody *body = rb[constraint->m_bodies[k]];
+		if ((body->getMass() != 0.0) && !body->isSleeping())
+			return false;
+	}
+	return true;
+}
+
+void TimeStepController::wakeUpIslands(SimulationModel &model)
+{
+	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
+	if (!m_sleeping)
+	{
+		for (unsigned int i = 0; i < rb.size(); i++)
+		{
+			if (rb[i]->isSleeping())
+				rb[i]->wakeUp();
+		}
+		return;
+	}
+
+	SimulationModel::RigidBodyIslandVector &islands = model.getRigidBodyIslands();
+	for (unsigned int i = 0; i < islands.size(); i++)
+	{
+		const SimulationModel::RigidBodyIsland &island = islands[i];
+		bool awake = false;
+		for (unsigned int j = 0; j < island.size(); j++)
+		{
+			// sleeping bodies have no velocity unless it was set from outside
+			const RigidBody *body = rb[island[j]];
+			if (!body->isSleeping() || (body->getVelocity().squaredNorm() != 0.0) || (body->getAngularVelocity().squaredNorm() != 0.0))
+			{
+				awake = true;
+				break;
+			}
+		}
+		if (awake)
+		{
+			for (unsigned int j = 0; j < island.size(); j++)
+			{
+				if (rb[island[j]]->isSleeping())
+					rb[island[j]]->wakeUp();
+			}
+		}
+	}
+}
+
+void TimeStepController::updateSleepStates(SimulationModel &model, const Real h)
+{
+	SimulationModel::RigidBodyVector &rb = model.getRigidBodies();
+	SimulationModel::ConstraintVector &constraints = model.getConstraints();
+	SimulationModel::ParticleRigidBodyContactConstraintVector &particleRigidBodyContacts = model.getParticleRigidBodyContactConstraints();
+	SimulationModel::RigidBodyIslandVector &islands = model.getRigidBodyIslands();
+
+	// bodies which are coupled to particles are kept awake
+	Utilities::ScratchArena::Scope scope;
+	Utilities::ScratchVector<char> keepAwake(rb.size(), 0);
+	for (unsigned int i = 0; i < constraints.size(); i++)
+	{
+		const unsigned int numRigidBodies = constraints[i]->numberOfRigidBodies();
+		if ((numRigidBodies > 0) && (numRigidBodies < constraints[i]->numberOfBodies()))
+		{
+			for (unsigned int k = 0; k < numRigidBodies; k++)
+				keepAwake[constraints[i]->m_bodies[k]] = 1;
+		}
+	}
+	for (unsigned int i = 0; i < particleRigidBodyContacts.size(); i++)
+		keepAwake[particleRigidBodyContacts[i].m_bodies[1]] = 1;
+
+	for (unsigned int i = 0; i < islands.size(); i++)
+	{
+		const SimulationModel::RigidBodyIsland &island = islands[i];
+		if (rb[island[0]]->isSleeping())
+			continue;
+
+		// Each body is tested with its own thresholds (or the ones of the controller).
+		// An island sleeps when all bodies were at rest for their sleep time.
+		bool atRest = true;
+		for (unsigned int j = 0; j < island.size(); j++)
+		{
+			RigidBody *body = rb[island[j]];
+			const Real linearThreshold = (body->getSleepLinearVelocity() >= 0.0) ? body->getSleepLinearVelocity() : m_sleepLinearVelocity;
+			const Real angularThreshold = (body->getSleepAngularVelocity() >= 0.0) ? body->getSleepAngularVelocity() : m_sleepAngularVelocity;
+			const Real sleepTime = (body->getSleepTime() >= 0.0) ? body->getSleepTime() : m_sleepTime;
+			if (keepAwake[island[j]] ||
+				(body->getVelocity().squaredNorm() > linearThreshold * linearThreshold) ||
+				(body->getAngularVelocity().squaredNorm() > angularThreshold * angularThreshold))
+				body->getSleepTimer() = 0.0;
+			else
+				body->getSleepTimer() += h;
+			atRest = atRest && (body->getSleepTimer() >= sleepTime);
+		}
+
+		if (atRest)
+		{
+			for (unsigned int j = 0; j < island.size(); j++)
+			{
+				RigidBody *body = rb[island[j]];
+				body->setSleeping(true);
+				body->getVelocity().setZero();
+				body->getAngularVelocity().setZero();
+				body->getOldPosition() = body->getPosition();
+				body->getLastPosition() = body->getPosition();
+				body->getOldRotation() = body->getRotation();
+				body->getLastRotation() = body->getRotation();
+			}
+		}
+	}
+}
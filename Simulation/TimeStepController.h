@@ -17,6 +17,10 @@ namespace PBD
 		static int MAX_ITERATIONS;
 		static int MAX_ITERATIONS_V;
 		static int VELOCITY_UPDATE_METHOD;
+		static int SLEEPING;
+		static int SLEEP_LINEAR_VELOCITY;
+		static int SLEEP_ANGULAR_VELOCITY;
+		static int SLEEP_TIME;
 
 		static int ENUM_VUPDATE_FIRST_ORDER;
 		static int ENUM_VUPDATE_SECOND_ORDER;
@@ -28,11 +32,40 @@ namespace PBD
 		unsigned int m_subSteps;
 		unsigned int m_maxIterations;
 		unsigned int m_maxIterationsV;
+		/** Islands of rigid bodies which are at rest are put to sleep */
+		bool m_sleeping;
+		Real m_sleepLinearVelocity;
+		Real m_sleepAngularVelocity;
+		/** time span in which all bodies of an island must be at rest before it is put to sleep */
+		Real m_sleepTime;
+		/** Position corrections of the constraints in the last iteration (see TimeStep::STATISTICS) */
+		std::vector<Real> m_corrections;
 
 		virtual void initParameters();
 		
 		void positionConstraintProjection(SimulationModel &model);
+		/** Solve a position constraint. If correction is not null, the norm of the 
+		* position correction of its particles and rigid bodies is stored. */
+		void solveConstraint(SimulationModel &model, Constraint *constraint, Real *correction);
+		/** Sum up the position corrections of the constraints per constraint type. */
+		void updateResiduals(SimulationModel &model);
+		/** Store the counters of the time step in the statistics. */
+		void updateStatistics(SimulationModel &model);
 		void velocityConstraintProjection(SimulationModel &model);
+		/** Update the meshes of the rigid bodies, detect the contacts and 
+		* resolve them at velocity level. In substep mode the collision pairs 
+		* are only determined if updatePairs is set. */
+		void collisionHandling(SimulationModel &model, const bool substep, const bool updatePairs, const Real timeHorizon);
+
+		/** Return the total cost of the constraint islands which are solved as tasks. */
+		unsigned int getIslandsCost(SimulationModel &model) const;
+		/** Return true if all rigid bodies of the constraint are sleeping or static. */
+		bool isSleeping(SimulationModel &model, const Constraint *constraint) const;
+		/** Wake up all bodies of the islands which contain an awake body 
+		* or a sleeping body which was moved from outside. */
+		void wakeUpIslands(SimulationModel &model);
+		/** Put islands to sleep whose bodies were at rest for the sleep time. */
+		void updateSleepStates(SimulationModel &model, const Real h);
 
 
 	public:
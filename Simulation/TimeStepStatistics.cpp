@@ -0,0 +1,172 @@
+#include "TimeStepStatistics.h"
+#include "Utils/Logger.h"
+#include <cstdint>
+
+using namespace PBD;
+using namespace std;
+
+void TimeStepStatistics::reset()
+{
+	m_time = 0.0;
+	m_subSteps = 0;
+	m_iterations = 0;
+	m_iterationsV = 0;
+	m_numConstraints = 0;
+	m_numIslands = 0;
+	m_numConstraintGroups = 0;
+	m_numSleepingBodies = 0;
+	m_numRigidBodyContacts = 0;
+	m_numParticleRigidBodyContacts = 0;
+	m_numParticleSolidContacts = 0;
+	m_numClothContacts = 0;
+	m_numClothContactGroups = 0;
+	m_collision.reset();
+	m_timeStep = 0.0;
+	m_timePositionProjection = 0.0;
+	m_timeVelocityProjection = 0.0;
+	m_timeCollisionDetection = 0.0;
+	m_timeContinuousCollisionDetection = 0.0;
+	m_residuals.clear();
+}
+
+const TimeStepStatistics::ConstraintResidual *TimeStepStatistics::getResidual(const int typeId) const
+{
+	for (unsigned int i = 0; i < m_residuals.size(); i++)
+	{
+		if (m_residuals[i].m_typeId == typeId)
+			return &m_residuals[i];
+	}
+	return nullptr;
+}
+
+
+TimeStepStatisticsWriter::TimeStepStatisticsWriter()
+{
+	m_binary = false;
+	m_headerWritten = false;
+}
+
+TimeStepStatisticsWriter::~TimeStepStatisticsWriter()
+{
+	close();
+}
+
+bool TimeStepStatisticsWriter::open(const std::string &fileName, const bool binary)
+{
+	close();
+	m_binary = binary;
+	m_headerWritten = false;
+	m_residualTypes.clear();
+	m_names.clear();
+	if (binary)
+		m_file.open(fileName, ios::out | ios::binary);
+	else
+		m_file.open(fileName, ios::out);
+	if (!m_file.is_open())
+	{
+		LOG_WARN << "Cannot open the statistics file " << fileName;
+		return false;
+	}
+	if (!binary)
+		m_file.precision(10);
+	return true;
+}
+
+void TimeStepStatisticsWriter::close()
+{
+	if (m_file.is_open())
+		m_file.close();
+}
+
+void TimeStepStatisticsWriter::getValues(const TimeStepStatistics &stats)
+{
+	const bool addNames = m_names.empty();
+	m_values.clear();
+	auto add = [&](const char *name, const double value)
+	{
+		if (addNames)
+			m_names.push_back(name);
+		m_values.push_back(value);
+	};
+
+	add("step", stats.m_step);
+	add("time", stats.m_time);
+	add("subSteps", stats.m_subSteps);
+	add("iterations", stats.m_iterations);
+	add("iterationsV", stats.m_iterationsV);
+	add("constraints", stats.m_numConstraints);
+	add("islands", stats.m_numIslands);
+	add("constraintGroups", stats.m_numConstraintGroups);
+	add("sleepingBodies", stats.m_numSleepingBodies);
+	add("rigidBodyContacts", stats.m_numRigidBodyContacts);
+	add("particleRigidBodyContacts", stats.m_numParticleRigidBodyContacts);
+	add("particleSolidContacts", stats.m_numParticleSolidContacts);
+	add("clothContacts", stats.m_numClothContacts);
+	add("clothContactGroups", stats.m_numClothContactGroups);
+	add("broadPhasePairs", stats.m_collision.m_numBroadPhasePairs);
+	add("narrowPhaseTests", stats.m_collision.m_numNarrowPhaseTests);
+	add("bvhNodesVisited", (double) stats.m_collision.m_numBVHNodesVisited);
+	add("clothPrimitiveTests", (double) stats.m_collision.m_numClothPrimitiveTests);
+	add("timeStep", stats.m_timeStep);
+	add("timePositionProjection", stats.m_timePositionProjection);
+	add("timeVelocityProjection", stats.m_timeVelocityProjection);
+	add("timeCollisionDetection", stats.m_timeCollisionDetection);
+	add("timeContinuousCollisionDetection", stats.m_timeContinuousCollisionDetection);
+
+	if (addNames)
+	{
+		for (unsigned int i = 0; i < stats.m_residuals.size(); i++)
+		{
+			m_residualTypes.push_back(stats.m_residuals[i].m_typeId);
+			m_names.push_back("residual_" + stats.m_residuals[i].m_typeName);
+			m_names.push_back("maxCorrection_" + stats.m_residuals[i].m_typeName);
+		}
+	}
+	for (unsigned int i = 0; i < m_residualTypes.size(); i++)
+	{
+		const TimeStepStatistics::ConstraintResidual *r = stats.getResidual(m_residualTypes[i]);
+		m_values.push_back(r ? r->m_residual : 0.0);
+		m_values.push_back(r ? r->m_maxCorrection : 0.0);
+	}
+}
+
+void TimeStepStatisticsWriter::write(const TimeStepStatistics &stats)
+{
+	if (!m_file.is_open())
+		return;
+
+	getValues(stats);
+	if (!m_headerWritten)
+	{
+		if (m_binary)
+		{
+			const uint32_t version = 1;
+			const uint32_t numColumns = (uint32_t)m_names.size();
+			m_file.write("PBDSTATS", 8);
+			m_file.write((const char*)&version, sizeof(uint32_t));
+			m_file.write((const char*)&numColumns, sizeof(uint32_t));
+			for (unsigned int i = 0; i < m_names.size(); i++)
+			{
+				const uint32_t length = (uint32_t)m_names[i].size();
+				m_file.write((const char*)&length, sizeof(uint32_t));
+				m_file.write(m_names[i].c_str(), length);
+			}
+		}
+		else
+		{
+			for (unsigned int i = 0; i < m_names.size(); i++)
+				m_file << (i > 0 ? "," : "") << m_names[i];
+			m_file << "\n";
+		}
+		m_headerWritten = true;
+	}
+
+	if (m_binary)
+		m_file.write((const char*)m_values.data(), m_values.size() * sizeof(double));
+	else
+	{
+		for (unsigned int i = 0; i < m_values.size(); i++)
+			m_file << (i > 0 ? "," : "") << m_values[i];
+		m_file << "\n";
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef __TimeStepStatistics_h__
+#define __TimeStepStatistics_h__
+
+#include "Common/Common.h"
+#include "CollisionDetection.h"
+#include <vector>
+#include <string>
+#include <fstream>
+
+namespace PBD
+{
+	/** \brief Statistics of the last time step. They are collected by the time
+	* step method if its parameter "statistics" is enabled.
+	*/
+	struct TimeStepStatistics
+	{
+		/** \brief Position corrections of all constraints of one type in the last
+		* solver iteration of the last substep. The corrections are measured at the
+		* positions of the particles and rigid bodies of the constraints. Since the
+		* corrections vanish when the solver converges, they serve as residual.
+		*/
+		struct ConstraintResidual
+		{
+			int m_typeId;
+			std::string m_typeName;
+			unsigned int m_numConstraints;
+			/** Euclidean norm of the corrections of all constraints of the type */
+			Real m_residual;
+			/** Largest correction of a single constraint */
+			Real m_maxCorrection;
+		};
+
+		/** Number of time steps since the last reset */
+		unsigned int m_step;
+		Real m_time;
+		unsigned int m_subSteps;
+		unsigned int m_iterations;
+		unsigned int m_iterationsV;
+
+		unsigned int m_numConstraints;
+		unsigned int m_numIslands;
+		unsigned int m_numConstraintGroups;
+		unsigned int m_numSleepingBodies;
+
+		unsigned int m_numRigidBodyContacts;
+		unsigned int m_numParticleRigidBodyContacts;
+		unsigned int m_numParticleSolidContacts;
+		unsigned int m_numClothContacts;
+		unsigned int m_numClothContactGroups;
+
+		CollisionDetection::Statistics m_collision;
+
+		/** Times of the phases in ms, summed up over all substeps */
+		double m_timeStep;
+		double m_timePositionProjection;
+		double m_timeVelocityProjection;
+		double m_timeCollisionDetection;
+		double m_timeContinuousCollisionDetection;
+
+		std::vector<ConstraintResidual> m_residuals;
+
+		TimeStepStatistics() { m_step = 0; reset(); }
+
+		/** Reset all values of the current step. */
+		void reset();
+		/** Return the residual of the given constraint type or nullptr. */
+		const ConstraintResidual *getResidual(const int typeId) const;
+	};
+
+	/** \brief Writes the statistics of each time step to a log file.
+	*
+	* The columns are determined by the first written step. The residuals of
+	* constraint types which do not exist in the first step are not written.
+	*
+	* CSV files have a header line with the column names. The binary format starts
+	* with the characters "PBDSTATS", a version number and the number of columns n
+	* (32-bit unsigned integers). Each column name follows as 32-bit length and
+	* characters. Then each time step is written as n doubles.
+	*/
+	class TimeStepStatisticsWriter
+	{
+	protected:
+		std::ofstream m_file;
+		bool m_binary;
+		bool m_headerWritten;
+		std::vector<int> m_residualTypes;
+		std::vector<std::string> m_names;
+		std::vector<double> m_values;
+
+		void getValues(const TimeStepStatistics &stats);
+
+	public:
+		TimeStepStatisticsWriter();
+		~TimeStepStatisticsWriter();
+
+		/** Open the log file. If binary is false, a CSV file is written. */
+		bool open(const std::string &fileName, const bool binary);
+		void close();
+		bool isOpen() const { return m_file.is_open(); }
+		void write(const TimeStepStatistics &stats);
+	};
+}
+
+#endif
@@ -59,7 +59,11 @@ namespace PBD
 		unsigned int entity(unsigned int i) const { return m_lst[i]; }
 
 		void construct();
-		void traverse_depth_first(TraversalPredicate pred, TraversalCallback cb,
+		/** The predicate and the callback are template parameters, so that lambdas 
+		* are called directly without wrapping them in (heap allocating) std::function 
+		* objects. */
+		template <typename Predicate, typename Callback>
+		void traverse_depth_first(Predicate const& pred, Callback const& cb,
 			TraversalPriorityLess const& pless = nullptr) const;
 		void traverse_breadth_first(TraversalPredicate const& pred, TraversalCallback const& cb, unsigned int start_node = 0, TraversalPriorityLess const& pless = nullptr, TraversalQueue& pending = TraversalQueue()) const;
 		void traverse_breadth_first_parallel(TraversalPredicate pred, TraversalCallback cb) const;
@@ -69,8 +73,9 @@ namespace PBD
 
 		void construct(unsigned int node, AlignedBox3r const& box,
 			unsigned int b, unsigned int n);
+		template <typename Predicate, typename Callback>
 		void traverse_depth_first(unsigned int node, unsigned int depth,
-			TraversalPredicate pred, TraversalCallback cb, TraversalPriorityLess const& pless) const;
+			Predicate const& pred, Callback const& cb, TraversalPriorityLess const& pless) const;
 		void traverse_breadth_first(TraversalQueue& pending,
 			TraversalPredicate const& pred, TraversalCallback const& cb, TraversalPriorityLess const& pless = nullptr) const;
 
@@ -69,8 +69,8 @@ KDTree<HullType>::construct(unsigned int node, AlignedBox3r const& box, unsigned
 	construct(m_nodes[node].children[1], r_box, b + hal, n - hal);
 }
 
-template<typename HullType> void
-KDTree<HullType>::traverse_depth_first(TraversalPredicate pred, TraversalCallback cb,
+template<typename HullType> template <typename Predicate, typename Callback> void
+KDTree<HullType>::traverse_depth_first(Predicate const& pred, Callback const& cb,
 	TraversalPriorityLess const& pless) const
 {
 	if (m_nodes.empty())
@@ -80,9 +80,9 @@ KDTree<HullType>::traverse_depth_first(TraversalPredicate pred, TraversalCallbac
 		traverse_depth_first(0, 0, pred, cb, pless);
 }
 
-template<typename HullType> void
+template<typename HullType> template <typename Predicate, typename Callback> void
 KDTree<HullType>::traverse_depth_first(unsigned int node_index, 
-	unsigned int depth, TraversalPredicate pred, TraversalCallback cb,
+	unsigned int depth, Predicate const& pred, Callback const& cb,
 	TraversalPriorityLess const& pless) const
 {
 	Node const& node = m_nodes[node_index];
@@ -0,0 +1,164 @@
+#ifndef __BinaryReaderWriter_h__
+#define __BinaryReaderWriter_h__
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+namespace Utilities
+{
+	/** \brief Writes binary data into a memory buffer.
+	*
+	* Arrays are appended with a single memory copy. This requires that the
+	* elements are stored contiguously without padding, which is the case for
+	* arithmetic types and for the unaligned Eigen types of Common.h.
+	*/
+	class BinaryWriter
+	{
+	protected:
+		std::vector<char> m_buffer;
+
+	public:
+		void writeBuffer(const void *data, const size_t size)
+		{
+			if (size == 0)
+				return;
+			const size_t pos = m_buffer.size();
+			m_buffer.resize(pos + size);
+			memcpy(&m_buffer[pos], data, size);
+		}
+
+		template<typename T>
+		void write(const T &v)
+		{
+			writeBuffer(&v, sizeof(T));
+		}
+
+		void write(const std::string &str)
+		{
+			write((uint32_t) str.size());
+			writeBuffer(str.c_str(), str.size());
+		}
+
+		/** Write the coefficients of a fixed size Eigen matrix or vector. */
+		template<typename T>
+		void writeMatrix(const T &m)
+		{
+			writeBuffer(m.data(), sizeof(typename T::Scalar) * m.size());
+		}
+
+		/** Write the size and the elements of the vector. */
+		template<typename T>
+		void writeVector(const std::vector<T> &v)
+		{
+			write((uint64_t) v.size());
+			if (!v.empty())
+				writeBuffer(v.data(), sizeof(T) * v.size());
+		}
+
+		std::vector<char> &getBuffer() { return m_buffer; }
+		const std::vector<char> &getBuffer() const { return m_buffer; }
+	};
+
+	/** \brief Reads binary data which was written by a BinaryWriter from a
+	* memory buffer.
+	*
+	* If a read exceeds the end of the buffer, the error flag is set, the
+	* value is not changed and all further reads fail.
+	*/
+	class BinaryReader
+	{
+	protected:
+		const char *m_data;
+		size_t m_size;
+		size_t m_pos;
+		bool m_error;
+
+	public:
+		BinaryReader(const char *data, const size_t size)
+		{
+			m_data = data;
+			m_size = size;
+			m_pos = 0;
+			m_error = false;
+		}
+
+		bool readBuffer(void *data, const size_t size)
+		{
+			if (m_error || (size > m_size - m_pos))
+			{
+				m_error = true;
+				return false;
+			}
+			if (size > 0)
+				memcpy(data, &m_data[m_pos], size);
+			m_pos += size;
+			return true;
+		}
+
+		template<typename T>
+		bool read(T &v)
+		{
+			return readBuffer(&v, sizeof(T));
+		}
+
+		bool read(std::string &str)
+		{
+			uint32_t size = 0;
+			if (!read(size) || (size > m_size - m_pos))
+			{
+				m_error = true;
+				return false;
+			}
+			str.assign(&m_data[m_pos], size);
+			m_pos += size;
+			return true;
+		}
+
+		template<typename T>
+		bool readMatrix(T &m)
+		{
+			return readBuffer(m.data(), sizeof(typename T::Scalar) * m.size());
+		}
+
+		/** Read a vector and resize it to the stored size. */
+		template<typename T>
+		bool readVector(std::vector<T> &v)
+		{
+			uint64_t size = 0;
+			if (!read(size) || (size > (m_size - m_pos) / sizeof(T)))
+			{
+				m_error = true;
+				return false;
+			}
+			v.resize((size_t) size);
+			if (size == 0)
+				return true;
+			return readBuffer(v.data(), sizeof(T) * v.size());
+		}
+
+		/** Read a vector whose size must match the given size. Otherwise the
+		* error flag is set and the vector is not changed. */
+		template<typename T>
+		bool readVector(std::vector<T> &v, const size_t expectedSize)
+		{
+			uint64_t size = 0;
+			if (!read(size) || (size != expectedSize) || (size > (m_size - m_pos) / sizeof(T)))
+			{
+				m_error = true;
+				return false;
+			}
+			v.resize((size_t) size);
+			if (size == 0)
+				return true;
+			return readBuffer(v.data(), sizeof(T) * v.size());
+		}
+
+		bool hasError() const { return m_error; }
+		bool atEnd() const { return m_pos == m_size; }
+		size_t getPosition() const { return m_pos; }
+	};
+}
+
+#endif
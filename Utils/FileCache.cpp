@@ -0,0 +1,82 @@
+#include "FileCache.h"
+#include "FileSystem.h"
+#include "MemoryMappedFile.h"
+#include "BinaryReaderWriter.h"
+#include <fstream>
+#include <cstdio>
+
+using namespace Utilities;
+
+const unsigned int FileCache::VERSION = 1;
+static const char magic[8] = { 'P', 'B', 'D', 'C', 'A', 'C', 'H', 'F' };
+
+std::string FileCache::getCacheKey(const std::string &fileName)
+{
+	const std::string path = FileSystem::normalizePath(fileName);
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		hash ^= (unsigned char)path[i];
+		hash *= 1099511628211ull;
+	}
+	char hashStr[17];
+	snprintf(hashStr, sizeof(hashStr), "%016llx", (unsigned long long)hash);
+	return FileSystem::getFileNameWithExt(fileName) + "_" + hashStr;
+}
+
+std::string FileCache::getCacheFileName(const std::string &cachePath, const std::string &fileName)
+{
+	return FileSystem::normalizePath(cachePath + "/" + getCacheKey(fileName) + ".cache");
+}
+
+bool FileCache::read(const std::string &cacheFileName, const std::string &md5, std::vector<char> &data)
+{
+	if ((md5 == "") || !FileSystem::fileExists(cacheFileName))
+		return false;
+
+	MemoryMappedFile file;
+	if (!file.open(cacheFileName))
+		return false;
+
+	BinaryReader reader(file.data(), file.size());
+	char fileMagic[8];
+	uint32_t version = 0;
+	std::string fileMD5;
+	uint64_t size = 0;
+	if (!reader.readBuffer(fileMagic, sizeof(fileMagic)) || (memcmp(fileMagic, magic, sizeof(magic)) != 0) ||
+		!reader.read(version) || (version != VERSION) ||
+		!reader.read(fileMD5) || (fileMD5 != md5) ||
+		!reader.read(size) || (size != file.size() - reader.getPosition()))
+		return false;
+
+	data.resize((size_t)size);
+	return reader.readBuffer(data.data(), data.size());
+}
+
+bool FileCache::write(const std::string &cacheFileName, const std::string &md5, const std::vector<char> &data)
+{
+	if ((md5 == "") || (FileSystem::makeDirs(FileSystem::getFilePath(cacheFileName)) != 0))
+		return false;
+
+	BinaryWriter writer;
+	writer.writeBuffer(magic, sizeof(magic));
+	writer.write((uint32_t)VERSION);
+	writer.write(md5);
+	writer.write((uint64_t)data.size());
+
+	// write to a temporary file first, so that concurrent readers and writers 
+	// of the same cache file never see a partially written file
+	const std::string tmpFileName = FileSystem::getTempFileName(cacheFileName);
+	std::ofstream file(tmpFileName, std::ios::binary);
+	if (!file)
+		return false;
+	file.write(writer.getBuffer().data(), writer.getBuffer().size());
+	file.write(data.data(), data.size());
+	file.close();
+	if (!file.good())
+	{
+		std::remove(tmpFileName.c_str());
+		return false;
+	}
+	return FileSystem::replaceFile(tmpFileName, cacheFileName);
+}
@@ -0,0 +1,40 @@
+#ifndef __FileCache_h__
+#define __FileCache_h__
+
+#include <string>
+#include <vector>
+
+namespace Utilities
+{
+	/** \brief Binary cache of data which is derived from source files, e.g. the
+	* vertices and faces of a mesh file.
+	*
+	* The MD5 hash of the source files is stored in the cache file. The cached
+	* data is only used if the hash matches, i.e. if a source file is changed,
+	* the cache is rebuilt.
+	*
+	* File layout: "PBDCACHF", version (uint32), MD5 hash (string), size of the data (uint64), data
+	*/
+	class FileCache
+	{
+	public:
+		static const unsigned int VERSION;
+
+		/** Key of a source file in a cache directory. It consists of the file name and 
+		* a hash (FNV-1a) of the normalized path, so that files with the same name in 
+		* different directories get different keys. */
+		static std::string getCacheKey(const std::string &fileName);
+		/** Name of the cache file of a source file in the cache directory. */
+		static std::string getCacheFileName(const std::string &cachePath, const std::string &fileName);
+
+		/** Read the data of the cache file. Returns false if the file does not
+		* exist, is invalid or was created for another MD5 hash. */
+		static bool read(const std::string &cacheFileName, const std::string &md5, std::vector<char> &data);
+		/** Write the data and the MD5 hash of the source files to the cache file.
+		* The cache directory is created if it does not exist. The data is written 
+		* to a temporary file which then replaces the cache file. */
+		static bool write(const std::string &cacheFileName, const std::string &md5, const std::vector<char> &data);
+	};
+}
+
+#endif
@@ -4,6 +4,11 @@
 #include "StringTools.h"
 #include "extern/md5/md5.h"
 #include <sys/stat.h>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <functional>
 #ifdef WIN32
 #include <direct.h>
 #define NOMINMAX
@@ -131,8 +136,9 @@ namespace Utilities
 #else
 				status = mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 #endif  
-				if (status != 0 && errno != EEXIST)
-					status = -1;
+				// the directory may have been created by another thread in the meantime
+				if (status != 0 && errno == EEXIST)
+					status = 0;
 			}
 			else if (!(S_IFDIR & st.st_mode))
 			{
@@ -257,6 +263,34 @@ namespace Utilities
 			return true;
 		}
 
+		/** Name of a temporary file next to the given file which is unique for the 
+		* calling process and thread. */
+		static std::string getTempFileName(const std::string &fileName)
+		{
+#ifdef WIN32
+			const unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+			const unsigned long pid = (unsigned long)getpid();
+#endif
+			const size_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+			return fileName + "." + std::to_string(pid) + "_" + std::to_string(tid) + ".tmp";
+		}
+
+		/** Replace the file dest by the file source, e.g. a temporary file which was 
+		* completely written. Other processes either see the old or the new file. */
+		static bool replaceFile(const std::string &source, const std::string &dest)
+		{
+#ifdef WIN32
+			if (MoveFileExA(source.c_str(), dest.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+				return true;
+#else
+			if (std::rename(source.c_str(), dest.c_str()) == 0)
+				return true;
+#endif
+			std::remove(source.c_str());
+			return false;
+		}
+
 		static bool isFile(const std::string &path) 
 		{
 			struct stat st;
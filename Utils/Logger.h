@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <vector>
 #include <memory>
+#include <mutex>
 
 
 namespace Utilities
@@ -143,6 +144,8 @@ namespace Utilities
 	protected:
 		std::vector<std::shared_ptr<LogSink>> m_sinks;
 		bool m_active;
+		/** Serializes the output of multiple threads, e.g. while assets are loaded in parallel. */
+		std::mutex m_mutex;
 
 	public:
 		// Todo: format
@@ -173,6 +176,7 @@ namespace Utilities
 		{
 			if (!m_active)
 				return;
+			std::lock_guard<std::mutex> lock(m_mutex);
 			for (unsigned int i = 0; i < m_sinks.size(); i++)
 				m_sinks[i]->write(level, str);
 		}
@@ -0,0 +1,94 @@
+#include "MemoryMappedFile.h"
+#ifdef WIN32
+#include "windows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Utilities;
+
+MemoryMappedFile::MemoryMappedFile()
+{
+	m_data = nullptr;
+	m_size = 0;
+#ifdef WIN32
+	m_fileHandle = nullptr;
+	m_mappingHandle = nullptr;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	close();
+}
+
+bool MemoryMappedFile::open(const std::string &fileName)
+{
+	close();
+#ifdef WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = (const char*)data;
+	m_size = (size_t)size.QuadPart;
+#else
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size == 0))
+	{
+		::close(fd);
+		return false;
+	}
+	void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the file is closed
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	m_data = (const char*)data;
+	m_size = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+void MemoryMappedFile::close()
+{
+	if (m_data == nullptr)
+		return;
+#ifdef WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE)m_mappingHandle);
+	CloseHandle((HANDLE)m_fileHandle);
+	m_fileHandle = nullptr;
+	m_mappingHandle = nullptr;
+#else
+	munmap((void*)m_data, m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
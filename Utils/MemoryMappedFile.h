@@ -0,0 +1,38 @@
+#ifndef __MemoryMappedFile_h__
+#define __MemoryMappedFile_h__
+
+#include <string>
+#include <cstddef>
+
+namespace Utilities
+{
+	/** \brief Read-only memory mapping of a file.
+	*
+	* The pages of the file are loaded on demand by the operating system, so
+	* large files can be parsed without copying them into a buffer first.
+	*/
+	class MemoryMappedFile
+	{
+	protected:
+		const char *m_data;
+		size_t m_size;
+#ifdef WIN32
+		void *m_fileHandle;
+		void *m_mappingHandle;
+#endif
+
+	public:
+		MemoryMappedFile();
+		~MemoryMappedFile();
+
+		/** Map the file. An empty file cannot be mapped. */
+		bool open(const std::string &fileName);
+		void close();
+		bool isOpen() const { return m_data != nullptr; }
+
+		const char *data() const { return m_data; }
+		size_t size() const { return m_size; }
+	};
+}
+
+#endif
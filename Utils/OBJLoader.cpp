@@ -0,0 +1,139 @@
+#include "OBJLoader.h"
+#include "MemoryMappedFile.h"
+#include "TextParser.h"
+#include "omp.h"
+
+using namespace Utilities;
+using namespace std;
+
+/** Data of a part of the file. The parts are merged in file order. */
+struct OBJChunk
+{
+	std::vector<OBJLoader::Vec3f> m_x;
+	std::vector<OBJLoader::Vec3f> m_normals;
+	std::vector<OBJLoader::Vec2f> m_texcoords;
+	std::vector<MeshFaceIndices> m_faces;
+};
+
+static inline bool isSpace(const char c)
+{
+	return (c == ' ') || (c == '\t');
+}
+
+static void parseOBJChunk(const char *p, const char *end, const OBJLoader::Vec3f &scale, const bool readNormals, const bool readTexCoords, OBJChunk &chunk)
+{
+	while (p < end)
+	{
+		TextParser::skipSpaces(p, end);
+		if ((p + 1 < end) && (p[0] == 'v') && isSpace(p[1]))
+		{
+			p++;
+			OBJLoader::Vec3f pos = { 0.0f, 0.0f, 0.0f };
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				TextParser::parseReal(p, end, pos[i]);
+				pos[i] *= scale[i];
+			}
+			chunk.m_x.push_back(pos);
+		}
+		else if ((p + 2 < end) && (p[0] == 'v') && (p[1] == 't') && isSpace(p[2]))
+		{
+			if (readTexCoords)
+			{
+				p += 2;
+				OBJLoader::Vec2f tex = { 0.0f, 0.0f };
+				for (unsigned int i = 0; i < 2; i++)
+					TextParser::parseReal(p, end, tex[i]);
+				chunk.m_texcoords.push_back(tex);
+			}
+		}
+		else if ((p + 2 < end) && (p[0] == 'v') && (p[1] == 'n') && isSpace(p[2]))
+		{
+			if (readNormals)
+			{
+				p += 2;
+				OBJLoader::Vec3f nor = { 0.0f, 0.0f, 0.0f };
+				for (unsigned int i = 0; i < 3; i++)
+					TextParser::parseReal(p, end, nor[i]);
+				chunk.m_normals.push_back(nor);
+			}
+		}
+		else if ((p + 1 < end) && (p[0] == 'f') && isSpace(p[1]))
+		{
+			p++;
+			// formats: v, v/vt, v//vn, v/vt/vn
+			MeshFaceIndices faceIndex = {};
+			for (int i = 0; i < 3; ++i)
+			{
+				TextParser::parseInt(p, end, faceIndex.posIndices[i]);
+				faceIndex.posIndices[i]--;
+				if ((p < end) && (*p == '/'))
+				{
+					p++;
+					if ((p < end) && (*p != '/'))
+					{
+						TextParser::parseInt(p, end, faceIndex.texIndices[i]);
+						faceIndex.texIndices[i]--;
+					}
+					if ((p < end) && (*p == '/'))
+					{
+						p++;
+						TextParser::parseInt(p, end, faceIndex.normalIndices[i]);
+						faceIndex.normalIndices[i]--;
+					}
+				}
+			}
+			chunk.m_faces.push_back(faceIndex);
+		}
+		TextParser::skipLine(p, end);
+	}
+}
+
+template<typename T>
+static void mergeChunks(std::vector<OBJChunk> &chunks, std::vector<T> OBJChunk::*member, std::vector<T> *result)
+{
+	if (result == nullptr)
+		return;
+	size_t n = result->size();
+	for (size_t i = 0; i < chunks.size(); i++)
+		n += (chunks[i].*member).size();
+	result->reserve(n);
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		result->insert(result->end(), (chunks[i].*member).begin(), (chunks[i].*member).end());
+		std::vector<T>().swap(chunks[i].*member);
+	}
+}
+
+void OBJLoader::loadObj(const std::string &filename, std::vector<Vec3f> *x, std::vector<MeshFaceIndices> *faces, std::vector<Vec3f> *normals, std::vector<Vec2f> *texcoords, const Vec3f &scale)
+{
+	LOG_INFO << "Loading " << filename;
+
+	MemoryMappedFile file;
+	if (!file.open(filename))
+	{
+		LOG_ERR << "Failed to open file: " << filename;
+		return;
+	}
+
+	// small files are parsed by a single thread
+	const size_t minChunkSize = 1 << 20;
+	const unsigned int maxChunks = 4 * omp_get_max_threads();
+	const unsigned int numChunks = (unsigned int) std::max((size_t) 1, std::min((size_t) maxChunks, file.size() / minChunkSize));
+	const std::vector<size_t> offsets = TextParser::splitLines(file.data(), file.size(), numChunks);
+
+	std::vector<OBJChunk> chunks(numChunks);
+	#pragma omp parallel if(numChunks > 1) default(shared)
+	{
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < (int) numChunks; i++)
+		{
+			parseOBJChunk(file.data() + offsets[i], file.data() + offsets[i + 1], scale, normals != nullptr, texcoords != nullptr, chunks[i]);
+		}
+	}
+
+	mergeChunks(chunks, &OBJChunk::m_x, x);
+	mergeChunks(chunks, &OBJChunk::m_faces, faces);
+	mergeChunks(chunks, &OBJChunk::m_normals, normals);
+	mergeChunks(chunks, &OBJChunk::m_texcoords, texcoords);
+}
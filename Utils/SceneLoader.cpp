@@ -222,6 +222,14 @@ void SceneLoader::readRigidBodies(const nlohmann::json &j, const std::string &ke
 			rbd.m_frictionCoeff = 0.2;
 			readValue(rigidBody, "friction", rbd.m_frictionCoeff);
 
+			// sleep thresholds, negative values use the thresholds of the simulation
+			rbd.m_sleepLinearVelocity = -1.0;
+			readValue(rigidBody, "sleepLinearVelocity", rbd.m_sleepLinearVelocity);
+			rbd.m_sleepAngularVelocity = -1.0;
+			readValue(rigidBody, "sleepAngularVelocity", rbd.m_sleepAngularVelocity);
+			rbd.m_sleepTime = -1.0;
+			readValue(rigidBody, "sleepTime", rbd.m_sleepTime);
+
 			// collision object type
 			rbd.m_collisionObjectType = CollisionObjectTypes::No_Collision_Object;
 			readValue(rigidBody, "collisionObjectType", rbd.m_collisionObjectType);
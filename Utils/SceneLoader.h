@@ -32,6 +32,9 @@ namespace Utilities
 			Vector3r m_omega;
 			Real m_restitutionCoeff;
 			Real m_frictionCoeff;
+			Real m_sleepLinearVelocity;
+			Real m_sleepAngularVelocity;
+			Real m_sleepTime;
 			int m_collisionObjectType;
 			std::string m_collisionObjectFileName;
 			bool m_testMesh;
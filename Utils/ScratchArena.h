@@ -0,0 +1,162 @@
+#ifndef __SCRATCHARENA_H__
+#define __SCRATCHARENA_H__
+
+#include "Common/Common.h"
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <algorithm>
+
+namespace Utilities
+{
+	/** \brief Bump allocator for transient buffers.
+	* Memory is handed out linearly from one block. It is released in stack order
+	* by ScratchArena::Scope objects, so that a function which uses the arena does not
+	* leave allocated memory behind. Requests which do not fit into the block are served
+	* from the heap. When the arena is empty again, the block is enlarged to the peak
+	* demand. Hence, if the same computation is repeated (e.g. in each time step), heap
+	* allocations only occur in the first runs.
+	*
+	* Each thread has its own arena (see current()).
+	*/
+	class ScratchArena
+	{
+	public:
+		/** \brief Releases all memory which was allocated from the arena during the
+		* lifetime of the scope object. The containers using the memory must be
+		* destroyed before the scope, i.e., they must be declared after the scope.
+		*/
+		class Scope
+		{
+		protected:
+			ScratchArena &m_arena;
+			std::size_t m_offset;
+			std::size_t m_numOverflow;
+			std::size_t m_overflowSize;
+
+		public:
+			Scope(ScratchArena &arena = ScratchArena::current()) :
+				m_arena(arena), m_offset(arena.m_offset),
+				m_numOverflow(arena.m_overflow.size()), m_overflowSize(arena.m_overflowSize)
+			{
+			}
+
+			~Scope()
+			{
+				m_arena.release(m_offset, m_numOverflow, m_overflowSize);
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+		};
+
+	protected:
+		char *m_block;
+		std::size_t m_size;
+		std::size_t m_offset;
+		/** Heap blocks of the requests which did not fit into m_block */
+		std::vector<void*> m_overflow;
+		std::size_t m_overflowSize;
+		/** Maximum memory demand since the block was allocated */
+		std::size_t m_peak;
+
+		void release(const std::size_t offset, const std::size_t numOverflow, const std::size_t overflowSize)
+		{
+			m_peak = std::max(m_peak, m_offset + m_overflowSize);
+			for (std::size_t i = numOverflow; i < m_overflow.size(); i++)
+				std::free(m_overflow[i]);
+			m_overflow.resize(numOverflow);
+			m_overflowSize = overflowSize;
+			m_offset = offset;
+
+			if ((m_offset == 0) && m_overflow.empty() && (m_peak > m_size))
+			{
+				std::free(m_block);
+				m_size = m_peak + m_peak / 2;
+				m_block = (char*)std::malloc(m_size);
+				if (!m_block)
+					m_size = 0;
+			}
+		}
+
+	public:
+		ScratchArena() :
+			m_block(nullptr), m_size(0), m_offset(0), m_overflowSize(0), m_peak(0)
+		{
+		}
+
+		ScratchArena(const ScratchArena&) = delete;
+		ScratchArena& operator=(const ScratchArena&) = delete;
+
+		~ScratchArena()
+		{
+			for (std::size_t i = 0; i < m_overflow.size(); i++)
+				std::free(m_overflow[i]);
+			std::free(m_block);
+		}
+
+		/** Return a memory block of the given size. The alignment must be a power
+		* of two which is not larger than the one of std::max_align_t. */
+		FORCE_INLINE void *allocate(const std::size_t bytes, const std::size_t alignment = alignof(std::max_align_t))
+		{
+			const std::size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+			if (offset + bytes <= m_size)
+			{
+				m_offset = offset + bytes;
+				return m_block + offset;
+			}
+			void *p = std::malloc(std::max(bytes, (std::size_t) 1));
+			if (!p)
+				throw std::bad_alloc();
+			m_overflow.push_back(p);
+			m_overflowSize += bytes + alignment;
+			return p;
+		}
+
+		std::size_t getCapacity() const { return m_size; }
+		std::size_t getUsedMemory() const { return m_offset + m_overflowSize; }
+
+		/** Arena of the calling thread */
+		static ScratchArena &current()
+		{
+			static thread_local ScratchArena arena;
+			return arena;
+		}
+	};
+
+	/** \brief STL allocator which takes its memory from a scratch arena.
+	* Memory is only released by the enclosing ScratchArena::Scope.
+	*/
+	template <typename T>
+	class ScratchAllocator
+	{
+	public:
+		typedef T value_type;
+
+		ScratchArena *m_arena;
+
+		ScratchAllocator() : m_arena(&ScratchArena::current()) {}
+		explicit ScratchAllocator(ScratchArena &arena) : m_arena(&arena) {}
+		template <typename U>
+		ScratchAllocator(const ScratchAllocator<U> &other) : m_arena(other.m_arena) {}
+
+		T *allocate(const std::size_t n)
+		{
+			return static_cast<T*>(m_arena->allocate(n * sizeof(T), std::min(alignof(T), alignof(std::max_align_t))));
+		}
+
+		void deallocate(T *, const std::size_t) {}
+
+		template <typename U>
+		bool operator==(const ScratchAllocator<U> &other) const { return m_arena == other.m_arena; }
+		template <typename U>
+		bool operator!=(const ScratchAllocator<U> &other) const { return m_arena != other.m_arena; }
+	};
+
+	/** Vector for transient data which uses the scratch arena of the calling thread. */
+	template <typename T>
+	using ScratchVector = std::vector<T, ScratchAllocator<T> >;
+}
+
+#endif
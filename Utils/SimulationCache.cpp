@@ -0,0 +1,407 @@
+#include "SimulationCache.h"
+#include "BinaryReaderWriter.h"
+#include "Logger.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+using namespace Utilities;
+using namespace std;
+
+const unsigned int SimulationCacheWriter::VERSION = 1;
+
+static const char CACHE_ID[8] = { 'P', 'B', 'D', 'C', 'A', 'C', 'H', 'E' };
+static const char INDEX_ID[8] = { 'P', 'B', 'D', 'I', 'N', 'D', 'E', 'X' };
+// payload size, time, key frame flag
+static const size_t CHUNK_HEADER_SIZE = sizeof(uint32_t) + sizeof(double) + sizeof(uint8_t);
+// index offset, number of frames, id
+static const size_t FOOTER_SIZE = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(INDEX_ID);
+
+/** Append a signed integer as zigzag encoded variable length integer (7 bits per byte). */
+static inline void encodeVarint(std::vector<unsigned char> &buffer, const int64_t v)
+{
+	uint64_t z = (((uint64_t)v) << 1) ^ (uint64_t)(v >> 63);
+	while (z >= 0x80)
+	{
+		buffer.push_back((unsigned char)(z | 0x80));
+		z >>= 7;
+	}
+	buffer.push_back((unsigned char)z);
+}
+
+static inline bool decodeVarint(const unsigned char *&p, const unsigned char *end, int64_t &v)
+{
+	uint64_t z = 0;
+	unsigned int shift = 0;
+	while (true)
+	{
+		if ((p >= end) || (shift > 63))
+			return false;
+		const unsigned char b = *p++;
+		z |= ((uint64_t)(b & 0x7f)) << shift;
+		if ((b & 0x80) == 0)
+			break;
+		shift += 7;
+	}
+	v = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+	return true;
+}
+
+SimulationCacheWriter::SimulationCacheWriter()
+{
+	m_precision = 1.0e-5;
+	m_keyframeInterval = 50;
+	m_headerWritten = false;
+	m_offset = 0;
+}
+
+SimulationCacheWriter::~SimulationCacheWriter()
+{
+	close();
+}
+
+bool SimulationCacheWriter::open(const std::string &fileName, const double precision, const unsigned int keyframeInterval)
+{
+	close();
+	m_file.open(fileName, ios::out | ios::binary);
+	if (!m_file.is_open())
+	{
+		LOG_ERR << "Cannot open the cache file " << fileName;
+		return false;
+	}
+	m_precision = (precision > 0.0) ? precision : 1.0e-5;
+	m_keyframeInterval = std::max(keyframeInterval, 1u);
+	m_headerWritten = false;
+	m_offset = 0;
+	return true;
+}
+
+void SimulationCacheWriter::close()
+{
+	if (m_file.is_open())
+	{
+		if (!m_headerWritten)
+			writeHeader();
+
+		// end marker of the frames
+		const uint32_t endMarker = 0;
+		writeData(&endMarker, sizeof(uint32_t));
+
+		BinaryWriter binWriter;
+		const uint64_t indexOffset = m_offset;
+		for (size_t i = 0; i < m_frameOffsets.size(); i++)
+		{
+			binWriter.write(m_frameOffsets[i]);
+			binWriter.write(m_frameTimes[i]);
+		}
+		binWriter.write(indexOffset);
+		binWriter.write((uint32_t)m_frameOffsets.size());
+		binWriter.writeBuffer(INDEX_ID, sizeof(INDEX_ID));
+		writeData(binWriter.getBuffer().data(), binWriter.getBuffer().size());
+		m_file.close();
+	}
+	m_names.clear();
+	m_numVertices.clear();
+	m_faces.clear();
+	m_lastQ.clear();
+	m_frameOffsets.clear();
+	m_frameTimes.clear();
+	m_headerWritten = false;
+}
+
+void SimulationCacheWriter::writeData(const void *data, const size_t size)
+{
+	m_file.write((const char*)data, size);
+	m_offset += size;
+}
+
+void SimulationCacheWriter::addMesh(const std::string &name, const unsigned int nVert, const unsigned int nTri, const unsigned int *faces)
+{
+	if (m_headerWritten)
+	{
+		LOG_ERR << "A mesh cannot be added to a cache after the first frame.";
+		return;
+	}
+	m_names.push_back(name);
+	m_numVertices.push_back(nVert);
+	m_faces.push_back(std::vector<unsigned int>(faces, faces + 3 * nTri));
+}
+
+void SimulationCacheWriter::writeHeader()
+{
+	BinaryWriter binWriter;
+	binWriter.writeBuffer(CACHE_ID, sizeof(CACHE_ID));
+	binWriter.write((uint32_t)VERSION);
+	binWriter.write(m_precision);
+	binWriter.write((uint32_t)m_keyframeInterval);
+	binWriter.write((uint32_t)m_names.size());
+	size_t numValues = 0;
+	for (size_t i = 0; i < m_names.size(); i++)
+	{
+		binWriter.write(m_names[i]);
+		binWriter.write((uint32_t)m_numVertices[i]);
+		binWriter.write((uint32_t)(m_faces[i].size() / 3));
+		binWriter.writeBuffer(m_faces[i].data(), sizeof(unsigned int) * m_faces[i].size());
+		numValues += 3 * (size_t)m_numVertices[i];
+	}
+	writeData(binWriter.getBuffer().data(), binWriter.getBuffer().size());
+	m_lastQ.resize(numValues);
+	m_headerWritten = true;
+}
+
+bool SimulationCacheWriter::writeFrame(const Real time, const std::vector<const Vector3r*> &positions)
+{
+	if (!m_file.is_open())
+		return false;
+	if (positions.size() != m_names.size())
+	{
+		LOG_ERR << "The number of meshes does not match the cache.";
+		return false;
+	}
+	if (!m_headerWritten)
+		writeHeader();
+
+	const bool keyframe = (m_frameOffsets.size() % m_keyframeInterval == 0);
+	const double invPrecision = 1.0 / m_precision;
+	m_chunk.clear();
+	size_t index = 0;
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		const Vector3r *x = positions[i];
+		for (unsigned int j = 0; j < m_numVertices[i]; j++)
+		{
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				const int64_t q = (int64_t) std::llround((double)x[j][k] * invPrecision);
+				encodeVarint(m_chunk, keyframe ? q : q - m_lastQ[index]);
+				m_lastQ[index++] = q;
+			}
+		}
+	}
+
+	m_frameOffsets.push_back(m_offset);
+	m_frameTimes.push_back((double)time);
+	const uint32_t payloadSize = (uint32_t)m_chunk.size();
+	const double t = (double)time;
+	const uint8_t keyframeFlag = keyframe ? 1 : 0;
+	writeData(&payloadSize, sizeof(uint32_t));
+	writeData(&t, sizeof(double));
+	writeData(&keyframeFlag, sizeof(uint8_t));
+	writeData(m_chunk.data(), m_chunk.size());
+	return m_file.good();
+}
+
+
+SimulationCacheReader::SimulationCacheReader()
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_precision = 1.0;
+	m_currentFrame = -1;
+}
+
+SimulationCacheReader::~SimulationCacheReader()
+{
+	close();
+}
+
+bool SimulationCacheReader::open(const std::string &fileName)
+{
+	close();
+	if (!m_file.open(fileName))
+	{
+		LOG_ERR << "Cannot open the cache file " << fileName;
+		return false;
+	}
+	m_data = (const unsigned char*)m_file.data();
+	m_size = m_file.size();
+	size_t headerSize = 0;
+	if (!readHeader(headerSize))
+	{
+		LOG_ERR << "The file " << fileName << " is not a valid simulation cache.";
+		close();
+		return false;
+	}
+	if (!readIndex(headerSize))
+		LOG_WARN << "The cache " << fileName << " has no index. The frames were scanned sequentially.";
+
+	m_positions.resize(m_names.size());
+	size_t numValues = 0;
+	for (size_t i = 0; i < m_names.size(); i++)
+	{
+		m_positions[i].resize(m_numVertices[i]);
+		numValues += 3 * (size_t)m_numVertices[i];
+	}
+	m_q.resize(numValues);
+	return true;
+}
+
+void SimulationCacheReader::close()
+{
+	m_file.close();
+	m_data = nullptr;
+	m_size = 0;
+	m_names.clear();
+	m_numVertices.clear();
+	m_faces.clear();
+	m_frameOffsets.clear();
+	m_frameTimes.clear();
+	m_q.clear();
+	m_positions.clear();
+	m_currentFrame = -1;
+}
+
+bool SimulationCacheReader::readHeader(size_t &headerSize)
+{
+	BinaryReader binReader((const char*)m_data, m_size);
+	char id[sizeof(CACHE_ID)];
+	uint32_t version = 0;
+	uint32_t keyframeInterval = 0;
+	uint32_t numMeshes = 0;
+	binReader.readBuffer(id, sizeof(CACHE_ID));
+	binReader.read(version);
+	binReader.read(m_precision);
+	binReader.read(keyframeInterval);
+	binReader.read(numMeshes);
+	if (binReader.hasError() || (memcmp(id, CACHE_ID, sizeof(CACHE_ID)) != 0) || (version > SimulationCacheWriter::VERSION))
+		return false;
+
+	for (uint32_t i = 0; i < numMeshes; i++)
+	{
+		std::string name;
+		uint32_t nVert = 0;
+		uint32_t nTri = 0;
+		binReader.read(name);
+		binReader.read(nVert);
+		binReader.read(nTri);
+		if (binReader.hasError() || ((size_t)nTri * 3 * sizeof(unsigned int) > m_size))
+			return false;
+		std::vector<unsigned int> faces(3 * (size_t)nTri);
+		if (!binReader.readBuffer(faces.data(), sizeof(unsigned int) * faces.size()))
+			return false;
+		m_names.push_back(name);
+		m_numVertices.push_back(nVert);
+		m_faces.push_back(faces);
+	}
+	headerSize = binReader.getPosition();
+	return true;
+}
+
+bool SimulationCacheReader::readIndex(const size_t headerSize)
+{
+	if (m_size >= headerSize + FOOTER_SIZE)
+	{
+		BinaryReader binReader((const char*)&m_data[m_size - FOOTER_SIZE], FOOTER_SIZE);
+		uint64_t indexOffset = 0;
+		uint32_t numFrames = 0;
+		char id[sizeof(INDEX_ID)];
+		binReader.read(indexOffset);
+		binReader.read(numFrames);
+		binReader.readBuffer(id, sizeof(INDEX_ID));
+		const size_t entrySize = sizeof(uint64_t) + sizeof(double);
+		if ((memcmp(id, INDEX_ID, sizeof(INDEX_ID)) == 0) && (indexOffset + (uint64_t)numFrames * entrySize + FOOTER_SIZE == m_size))
+		{
+			BinaryReader indexReader((const char*)&m_data[indexOffset], (size_t)numFrames * entrySize);
+			m_frameOffsets.resize(numFrames);
+			m_frameTimes.resize(numFrames);
+			for (uint32_t i = 0; i < numFrames; i++)
+			{
+				indexReader.read(m_frameOffsets[i]);
+				indexReader.read(m_frameTimes[i]);
+				if (m_frameOffsets[i] + CHUNK_HEADER_SIZE > indexOffset)
+				{
+					m_frameOffsets.clear();
+					m_frameTimes.clear();
+					break;
+				}
+			}
+			if (m_frameOffsets.size() == numFrames)
+				return true;
+		}
+	}
+
+	// no valid index: scan the frames until the end marker or the end of the file
+	size_t pos = headerSize;
+	while (pos + CHUNK_HEADER_SIZE <= m_size)
+	{
+		uint32_t payloadSize = 0;
+		double time = 0.0;
+		memcpy(&payloadSize, &m_data[pos], sizeof(uint32_t));
+		memcpy(&time, &m_data[pos + sizeof(uint32_t)], sizeof(double));
+		if ((payloadSize == 0) || (pos + CHUNK_HEADER_SIZE + payloadSize > m_size))
+			break;
+		m_frameOffsets.push_back(pos);
+		m_frameTimes.push_back(time);
+		pos += CHUNK_HEADER_SIZE + payloadSize;
+	}
+	return false;
+}
+
+bool SimulationCacheReader::decodeFrame(const unsigned int frame)
+{
+	const size_t offset = (size_t)m_frameOffsets[frame];
+	uint32_t payloadSize = 0;
+	uint8_t keyframe = 0;
+	memcpy(&payloadSize, &m_data[offset], sizeof(uint32_t));
+	memcpy(&keyframe, &m_data[offset + sizeof(uint32_t) + sizeof(double)], sizeof(uint8_t));
+	const unsigned char *p = &m_data[offset + CHUNK_HEADER_SIZE];
+	const unsigned char *end = p + payloadSize;
+	if (end > m_data + m_size)
+		return false;
+	for (size_t i = 0; i < m_q.size(); i++)
+	{
+		int64_t v;
+		if (!decodeVarint(p, end, v))
+			return false;
+		if (keyframe)
+			m_q[i] = v;
+		else
+			m_q[i] += v;
+	}
+	return true;
+}
+
+bool SimulationCacheReader::readFrame(const unsigned int frame)
+{
+	if ((m_data == nullptr) || (frame >= numFrames()))
+		return false;
+
+	if (m_currentFrame != (int)frame)
+	{
+		// search the preceding key frame
+		unsigned int start = frame;
+		while (start > 0)
+		{
+			uint8_t keyframe = 0;
+			memcpy(&keyframe, &m_data[m_frameOffsets[start] + sizeof(uint32_t) + sizeof(double)], sizeof(uint8_t));
+			if (keyframe)
+				break;
+			start--;
+		}
+		// continue from the last decoded frame if possible
+		if ((m_currentFrame >= (int)start) && (m_currentFrame < (int)frame))
+			start = m_currentFrame + 1;
+
+		for (unsigned int f = start; f <= frame; f++)
+		{
+			if (!decodeFrame(f))
+			{
+				LOG_ERR << "Frame " << f << " of the cache is corrupt.";
+				m_currentFrame = -1;
+				return false;
+			}
+			m_currentFrame = f;
+		}
+	}
+
+	size_t index = 0;
+	for (size_t i = 0; i < m_positions.size(); i++)
+	{
+		for (unsigned int j = 0; j < m_numVertices[i]; j++)
+		{
+			for (unsigned int k = 0; k < 3; k++)
+				m_positions[i][j][k] = static_cast<Real>((double)m_q[index++] * m_precision);
+		}
+	}
+	return true;
+}
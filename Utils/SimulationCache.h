@@ -0,0 +1,127 @@
+#ifndef __SimulationCache_h__
+#define __SimulationCache_h__
+
+#include "Common/Common.h"
+#include "MemoryMappedFile.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+namespace Utilities
+{
+	/** \brief Writer of a simulation cache, i.e. a single file which contains
+	* the meshes of all frames of a simulation.
+	*
+	* The topology of the meshes is written once in the header. For each frame
+	* the vertex positions are quantized to a grid with the given precision and
+	* stored as variable length integers: in a key frame the quantized positions
+	* and in the other frames the differences to the previous frame. Since the
+	* positions change only slightly between frames, most differences need one
+	* or two bytes. Every keyframeInterval frames a key frame is written, so a
+	* frame can be decoded without reading the whole file.
+	*
+	* The frames are appended to the file while the simulation runs. close()
+	* writes an index table with the offset and time of each frame. A file
+	* without an index (e.g. after a crash) can still be read sequentially.
+	*
+	* File layout (little endian):
+	* - header: "PBDCACHE", version, precision, key frame interval, meshes (name, vertex count, triangle count, faces)
+	* - frames: payload size (uint32), time (double), key frame flag (uint8), payload
+	* - end marker: payload size 0
+	* - index: offset (uint64) and time (double) of each frame
+	* - footer: offset of the index (uint64), number of frames (uint32), "PBDINDEX"
+	*/
+	class SimulationCacheWriter
+	{
+	protected:
+		std::ofstream m_file;
+		double m_precision;
+		unsigned int m_keyframeInterval;
+		std::vector<std::string> m_names;
+		std::vector<unsigned int> m_numVertices;
+		std::vector<std::vector<unsigned int>> m_faces;
+		bool m_headerWritten;
+		uint64_t m_offset;
+		std::vector<int64_t> m_lastQ;
+		std::vector<unsigned char> m_chunk;
+		std::vector<uint64_t> m_frameOffsets;
+		std::vector<double> m_frameTimes;
+
+		void writeData(const void *data, const size_t size);
+		void writeHeader();
+
+	public:
+		static const unsigned int VERSION;
+
+		SimulationCacheWriter();
+		~SimulationCacheWriter();
+
+		/** Create the cache file. The positions are stored with the given precision
+		* (maximum error precision/2 per coordinate). */
+		bool open(const std::string &fileName, const double precision = 1.0e-5, const unsigned int keyframeInterval = 50);
+		/** Write the index table and close the file. */
+		void close();
+		bool isOpen() const { return m_file.is_open(); }
+
+		/** Add a mesh. All meshes must be added before the first frame is written. */
+		void addMesh(const std::string &name, const unsigned int nVert, const unsigned int nTri, const unsigned int *faces);
+		unsigned int numMeshes() const { return (unsigned int)m_names.size(); }
+		unsigned int numFrames() const { return (unsigned int)m_frameOffsets.size(); }
+
+		/** Write a frame. positions contains the vertex positions for each mesh. */
+		bool writeFrame(const Real time, const std::vector<const Vector3r*> &positions);
+	};
+
+	/** \brief Reader of a simulation cache which was written by a SimulationCacheWriter.
+	*
+	* The file is memory mapped, so opening a cache only parses the header and the
+	* index. readFrame() decodes the frame starting at the preceding key frame or,
+	* for sequential playback, at the last decoded frame.
+	*/
+	class SimulationCacheReader
+	{
+	protected:
+		MemoryMappedFile m_file;
+		const unsigned char *m_data;
+		size_t m_size;
+		double m_precision;
+		std::vector<std::string> m_names;
+		std::vector<unsigned int> m_numVertices;
+		std::vector<std::vector<unsigned int>> m_faces;
+		std::vector<uint64_t> m_frameOffsets;
+		std::vector<double> m_frameTimes;
+		std::vector<int64_t> m_q;
+		int m_currentFrame;
+		std::vector<std::vector<Vector3r>> m_positions;
+
+		bool readHeader(size_t &headerSize);
+		bool readIndex(const size_t headerSize);
+		bool decodeFrame(const unsigned int frame);
+
+	public:
+		SimulationCacheReader();
+		~SimulationCacheReader();
+
+		bool open(const std::string &fileName);
+		void close();
+		bool isOpen() const { return m_data != nullptr; }
+
+		unsigned int numMeshes() const { return (unsigned int)m_names.size(); }
+		const std::string &getMeshName(const unsigned int mesh) const { return m_names[mesh]; }
+		unsigned int numVertices(const unsigned int mesh) const { return m_numVertices[mesh]; }
+		/** Vertex indices of the triangles of the mesh (three per triangle). */
+		const std::vector<unsigned int> &getFaces(const unsigned int mesh) const { return m_faces[mesh]; }
+		double getPrecision() const { return m_precision; }
+
+		unsigned int numFrames() const { return (unsigned int)m_frameOffsets.size(); }
+		Real getFrameTime(const unsigned int frame) const { return static_cast<Real>(m_frameTimes[frame]); }
+
+		/** Decode the positions of all meshes of the given frame. */
+		bool readFrame(const unsigned int frame);
+		/** Positions of the mesh in the frame which was read last. */
+		const std::vector<Vector3r> &getPositions(const unsigned int mesh) const { return m_positions[mesh]; }
+	};
+}
+
+#endif
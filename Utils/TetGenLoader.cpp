@@ -1,261 +1,245 @@
 #include "TetGenLoader.h"
-#include <sstream>
-#include <fstream>
-#include <iostream>
+#include "MemoryMappedFile.h"
+#include "TextParser.h"
 #include "Logger.h"
 
 using namespace Utilities;
 using namespace std;
 
+/** Skip the rest of the current line, empty lines and comment lines. */
+static bool nextLine(const char *&p, const char *end)
+{
+	TextParser::skipLine(p, end);
+	while (p < end)
+	{
+		const char *q = p;
+		TextParser::skipSpaces(q, end);
+		if (!TextParser::isLineEnd(q, end))
+			return true;
+		TextParser::skipLine(p, end);
+	}
+	return false;
+}
+
+/** Move to the first line which is not empty or a comment. */
+static bool firstLine(const char *&p, const char *end)
+{
+	const char *q = p;
+	TextParser::skipSpaces(q, end);
+	if ((q < end) && !TextParser::isLineEnd(q, end))
+		return true;
+	return nextLine(p, end);
+}
+
+/** Parse a line of the form "label value". */
+static size_t parseLabelValue(const char *&p, const char *end)
+{
+	TextParser::skipSpaces(p, end);
+	while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n'))
+		p++;
+	unsigned int value = 0;
+	TextParser::parseUInt(p, end, value);
+	return value;
+}
+
+static bool parseVertex(const char *&p, const char *end, const bool hasIndex, Vector3r &x)
+{
+	if (hasIndex)
+	{
+		unsigned int index;
+		TextParser::parseUInt(p, end, index);
+	}
+	return TextParser::parseReal(p, end, x[0]) && TextParser::parseReal(p, end, x[1]) && TextParser::parseReal(p, end, x[2]);
+}
+
+static bool parseTet(const char *&p, const char *end, const bool hasIndex, unsigned int *tet)
+{
+	if (hasIndex)
+	{
+		unsigned int index;
+		TextParser::parseUInt(p, end, index);
+	}
+	for (int j = 0; j < 4; j++)
+	{
+		if (!TextParser::parseUInt(p, end, tet[j]))
+			return false;
+	}
+	return true;
+}
+
 // Call this function to load a model from a *.tet file
 void TetGenLoader::loadTetFile(const std::string &filename, std::vector<Vector3r>& vertices, std::vector<unsigned int>& tets)
 {
 	LOG_INFO << "Loading " << filename;
 
-	// variables
-	size_t i, num_materials, num_vertices, num_tetras, num_triangles;
-	Real value;
-	string line, label;
-	stringstream sStream;
 	// try to open the file
-	ifstream fin(filename.c_str());
-	if(!fin)
+	MemoryMappedFile file;
+	if (!file.open(filename))
 	{
 		LOG_ERR << "'" + filename + "' file not found.";
 		return;
 	}
-
-	// load tet version 1.2
-	getline(fin, line);
-	sStream << line;
-	sStream >> label; // tet
-	sStream >> label; // version
-	sStream >> value;
-	sStream.clear();
-	// load number of materials
-	getline(fin, line); // num_materials x
-	sStream << line;
-	sStream >> label;
-	sStream >> num_materials;
-	sStream.clear();
-	// load number of vertices
-	getline(fin, line); // num_vertices x
-	sStream << line;
-	sStream >> label;
-	sStream >> num_vertices;
-	sStream.clear();
-	// reverse the order of the vertices
-	vertices.resize(num_vertices);
-	//// read number of tetraeders
-	getline(fin, line); // num_tetras x
-	sStream << line;
-	sStream >> label;
-	sStream >> num_tetras;
-	sStream.clear();
-	tets.resize(4*num_tetras);
-
-	// read number of triangles
-	getline(fin, line); // num_triangles x
-	sStream << line;
-	sStream >> label;
-	sStream >> num_triangles;
-	sStream.clear();
+	const char *p = file.data();
+	const char *end = p + file.size();
+
+	// tet version 1.2
+	TextParser::skipLine(p, end);
+	const size_t num_materials = parseLabelValue(p, end);
+	TextParser::skipLine(p, end);
+	const size_t num_vertices = parseLabelValue(p, end);
+	TextParser::skipLine(p, end);
+	const size_t num_tetras = parseLabelValue(p, end);
+	TextParser::skipLine(p, end);
+	// num_triangles
+	TextParser::skipLine(p, end);
 
 	// skip materials
-	getline(fin, line);
-	for(i = 0; i < num_materials; ++i)
-		getline(fin, line);
+	TextParser::skipLine(p, end);
+	for (size_t i = 0; i < num_materials; ++i)
+		TextParser::skipLine(p, end);
 	// skip the VERTICES label
-	getline(fin, line);
+	TextParser::skipLine(p, end);
 
 	// read the vertices
-	for(i = 0; i < num_vertices; ++i)
+	vertices.resize(num_vertices);
+	for (size_t i = 0; i < num_vertices; ++i)
 	{
-		Real x, y, z;
-		getline(fin, line);
-		sStream << line;
-		sStream >> x >> y >> z;
-		getline(sStream, line);
-		sStream.clear();
-
-		vertices[i] = Vector3r(x, y, z);
+		parseVertex(p, end, false, vertices[i]);
+		TextParser::skipLine(p, end);
 	}
 
 	// skip TETRAS label
-	getline(fin, line);
+	TextParser::skipLine(p, end);
 	// read tets
-	for(i = 0; i < num_tetras; ++i)
+	tets.resize(4 * num_tetras);
+	for (size_t i = 0; i < num_tetras; ++i)
 	{
-		unsigned int tet[4];
-		unsigned int m;
-		getline(fin, line);
-		sStream << line;
-		sStream >> tet[0] >> tet[1] >> tet[2] >> tet[3] >> m;
-
-		//for (unsigned int j = 0; j < 4; j++)
-		//	tet[j]--;
-
-		getline(sStream, line);
-		sStream.clear();
-
-		for (int j = 0; j < 4; j++)
-			tets[4*i +j] = tet[j];
+		parseTet(p, end, false, &tets[4 * i]);
+		TextParser::skipLine(p, end);
 	}
-	// close file
-	fin.close();
 
 	LOG_INFO << "Number of tets: " << num_tetras;
 	LOG_INFO << "Number of vertices: " << num_vertices;
 }
 
+static bool loadNodeFile(const MemoryMappedFile &file, std::vector<Vector3r>& vertices)
+{
+	const char *p = file.data();
+	const char *end = p + file.size();
 
+	// <# of points> <dimension (3)> <# of attributes> <boundary markers (0 or 1)>
+	unsigned int num_vertices = 0;
+	if (!firstLine(p, end) || !TextParser::parseUInt(p, end, num_vertices))
+		return false;
+	vertices.resize(num_vertices);
+	for (unsigned int i = 0; i < num_vertices; ++i)
+	{
+		if (!nextLine(p, end) || !parseVertex(p, end, true, vertices[i]))
+			return false;
+	}
+	return true;
+}
+
+static bool loadEleFile(const MemoryMappedFile &file, std::vector<unsigned int>& tets)
+{
+	const char *p = file.data();
+	const char *end = p + file.size();
+
+	// <# of tetrahedra> <nodes per tet. (4)> <region attribute (0 or 1)>
+	unsigned int num_tetras = 0;
+	if (!firstLine(p, end) || !TextParser::parseUInt(p, end, num_tetras))
+		return false;
+	tets.resize(4u * num_tetras);
+	for (unsigned int i = 0; i < num_tetras; ++i)
+	{
+		if (!nextLine(p, end) || !parseTet(p, end, true, &tets[4 * i]))
+			return false;
+	}
+	return true;
+}
 
 void TetGenLoader::loadTetgenModel(const std::string &nodeFilename, const std::string &eleFilename, std::vector<Vector3r>& vertices, std::vector<unsigned int>& tets)
 {
 	LOG_INFO << "Loading " << nodeFilename;
 	LOG_INFO << "Loading " << eleFilename;
 
-	// variables
-	size_t i, num_vertices, num_tetras;
-	string nodeLine, eleLine, label;
-	stringstream sStream;
 	// try to open the file
-	ifstream finNode(nodeFilename.c_str());
-	ifstream finEle(eleFilename.c_str());
-	if(!finNode)
+	MemoryMappedFile nodeFile;
+	MemoryMappedFile eleFile;
+	if (!nodeFile.open(nodeFilename))
 	{
 		LOG_ERR << "'" + nodeFilename + "' file not found.";
 		return;
 	}
-	if(!finEle)
+	if (!eleFile.open(eleFilename))
 	{
 		LOG_ERR << "'" + eleFilename + "' file not found.";
 		return;
 	}
 
-	// get num vertices
-	getline(finNode, nodeLine);
-	sStream << nodeLine;
-	sStream >> num_vertices;
-	sStream >> label; // 3
-	sStream >> label; // 0
-	sStream >> label; // 0
-	sStream.clear();
-
-	// get num tetras
-	getline(finEle, eleLine);
-	sStream << eleLine;
-	sStream >> num_tetras;
-	sStream >> label; // 4
-	sStream >> label; // 0
-	sStream >> label; // 0
-	sStream.clear();
-
-	vertices.resize(num_vertices);
-	tets.resize(4u*num_tetras);
-
-	// read vertices
-	for(i = 0; i < num_vertices; ++i)
+	// the node and the element file are independent
+	bool nodesOk = true;
+	bool elementsOk = true;
+	#pragma omp parallel sections default(shared)
 	{
-		unsigned nodeInd;
-		Real x, y, z;
-		getline(finNode, nodeLine);
-		sStream << nodeLine;
-		sStream >> nodeInd >> x >> y >> z;
-		getline(sStream, nodeLine);
-		sStream.clear();
-		
-		vertices[i] = Vector3r(x, y, z);
+		#pragma omp section
+		nodesOk = loadNodeFile(nodeFile, vertices);
+		#pragma omp section
+		elementsOk = loadEleFile(eleFile, tets);
 	}
+	if (!nodesOk)
+		LOG_ERR << "'" + nodeFilename + "' is not a valid node file.";
+	if (!elementsOk)
+		LOG_ERR << "'" + eleFilename + "' is not a valid element file.";
 
-	// read tetrahedra
-	for(i = 0; i < num_tetras; ++i)
-	{
-		unsigned eleInd;
-		//unsigned int tet[4];
-		getline(finEle, eleLine);
-		sStream << eleLine	;
-		sStream >> eleInd >> tets[4*i+0] >> tets[4*i+1] >> tets[4*i+2] >> tets[4*i+3];
-
-		getline(sStream, eleLine);
-		sStream.clear();
-	}
-	// close file
-	finNode.close();
-	finEle.close();
-
-	LOG_INFO << "Number of tets: " << num_tetras;
-	LOG_INFO << "Number of vertices: " << num_vertices;
+	LOG_INFO << "Number of tets: " << tets.size() / 4;
+	LOG_INFO << "Number of vertices: " << vertices.size();
 }
 
 void TetGenLoader::loadMSHModel(const std::string &mshFilename, std::vector<Vector3r>& vertices, std::vector<unsigned int>& tets)
 {
 	LOG_INFO << "Loading " << mshFilename;
 
-    // variables
-    size_t i, num_vertices, num_tetras;
-    string line, label;
-    stringstream sStream;
-    // try to open the file
-    ifstream mshStream(mshFilename.c_str());
-    if(!mshStream)
-    {
-        LOG_ERR << "'" << mshFilename << "' file not found.";
-        return;
-    }
-
-    // get num vertices
-    getline(mshStream, line);
-    getline(mshStream, line);
-    sStream << line;
-    sStream >> num_vertices;
-    sStream.clear();
-
-    vertices.resize(num_vertices);
-
-    // read vertices
-    for(i = 0; i < num_vertices; ++i)
-    {
-        unsigned nodeInd;
-		Real x, y, z;
-        getline(mshStream, line);
-        sStream << line;
-        sStream >> nodeInd >> x >> y >> z;
-        getline(sStream, line);
-        sStream.clear();
-
-		vertices[i] = Vector3r(x, y, z);
-    }
-
-    // get num tetras
-    getline(mshStream, line);
-    getline(mshStream, line);
-    getline(mshStream, line);
-    sStream << line;
-    sStream >> num_tetras;
-    sStream.clear();
+	// try to open the file
+	MemoryMappedFile file;
+	if (!file.open(mshFilename))
+	{
+		LOG_ERR << "'" << mshFilename << "' file not found.";
+		return;
+	}
+	const char *p = file.data();
+	const char *end = p + file.size();
 
-    tets.resize(4u*num_tetras);
+	// get num vertices
+	TextParser::skipLine(p, end);
+	unsigned int num_vertices = 0;
+	TextParser::parseUInt(p, end, num_vertices);
+	TextParser::skipLine(p, end);
 
-    // read tetrahedra
-    for(i = 0; i < num_tetras; ++i)
-    {
-        unsigned eleInd;
-        //unsigned int tet[4];
-        getline(mshStream, line);
-        sStream << line	;
-        sStream >> eleInd >> tets[4*i+0] >> tets[4*i+1] >> tets[4*i+2] >> tets[4*i+3];
+	// read vertices
+	vertices.resize(num_vertices);
+	for (unsigned int i = 0; i < num_vertices; ++i)
+	{
+		parseVertex(p, end, true, vertices[i]);
+		TextParser::skipLine(p, end);
+	}
 
-        --tets[4*i+0];
-        --tets[4*i+1];
-        --tets[4*i+2];
-        --tets[4*i+3];
+	// get num tetras
+	TextParser::skipLine(p, end);
+	TextParser::skipLine(p, end);
+	unsigned int num_tetras = 0;
+	TextParser::parseUInt(p, end, num_tetras);
+	TextParser::skipLine(p, end);
 
-        getline(sStream, line);
-        sStream.clear();
-    }
-    // close file
-    mshStream.close();
+	// read tetrahedra
+	tets.resize(4u * num_tetras);
+	for (unsigned int i = 0; i < num_tetras; ++i)
+	{
+		parseTet(p, end, true, &tets[4 * i]);
+		for (int j = 0; j < 4; j++)
+			--tets[4 * i + j];
+		TextParser::skipLine(p, end);
+	}
 
 	LOG_INFO << "Number of tets: " << num_tetras;
 	LOG_INFO << "Number of vertices: " << num_vertices;
@@ -0,0 +1,215 @@
+#ifndef __TextParser_h__
+#define __TextParser_h__
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+namespace Utilities
+{
+	/** \brief Parsing of numbers in a character buffer without streams,
+	* temporary strings or locale lookups.
+	*
+	* The parse functions advance the pointer behind the parsed token and skip
+	* leading spaces and tabs but never a line break. A decimal number is
+	* converted exactly if its significand and power of ten can be represented
+	* without rounding (which covers the usual mesh files); otherwise the token
+	* is converted by strtod/strtof, so the result is always the same as for
+	* stod/stof.
+	*/
+	class TextParser
+	{
+	protected:
+		template<typename T>
+		struct RealTraits
+		{
+		};
+
+		static inline bool isDigit(const char c) { return (c >= '0') && (c <= '9'); }
+
+	public:
+		static inline void skipSpaces(const char *&p, const char *end)
+		{
+			while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r')))
+				p++;
+		}
+
+		/** Move the pointer to the beginning of the next line. */
+		static inline void skipLine(const char *&p, const char *end)
+		{
+			const char *n = (const char*)memchr(p, '\n', end - p);
+			p = (n != nullptr) ? n + 1 : end;
+		}
+
+		static inline bool isLineEnd(const char *p, const char *end)
+		{
+			return (p >= end) || (*p == '\n') || (*p == '\r') || (*p == '#');
+		}
+
+		static inline bool parseInt(const char *&p, const char *end, int &value)
+		{
+			skipSpaces(p, end);
+			bool negative = false;
+			if ((p < end) && ((*p == '-') || (*p == '+')))
+				negative = (*p++ == '-');
+			if ((p >= end) || !isDigit(*p))
+				return false;
+			int64_t v = 0;
+			while ((p < end) && isDigit(*p))
+				v = 10 * v + (*p++ - '0');
+			value = (int)(negative ? -v : v);
+			return true;
+		}
+
+		static inline bool parseUInt(const char *&p, const char *end, unsigned int &value)
+		{
+			int v;
+			if (!parseInt(p, end, v))
+				return false;
+			value = (unsigned int)v;
+			return true;
+		}
+
+		template<typename T>
+		static inline bool parseReal(const char *&p, const char *end, T &value)
+		{
+			skipSpaces(p, end);
+			const char *start = p;
+			bool negative = false;
+			if ((p < end) && ((*p == '-') || (*p == '+')))
+				negative = (*p++ == '-');
+
+			uint64_t significand = 0;
+			int exponent = 0;
+			bool exact = true;
+			bool hasDigits = false;
+			while ((p < end) && isDigit(*p))
+			{
+				hasDigits = true;
+				if (significand < 100000000000000000ull)
+					significand = 10 * significand + (*p - '0');
+				else
+				{
+					exponent++;
+					exact = exact && (*p == '0');
+				}
+				p++;
+			}
+			if ((p < end) && (*p == '.'))
+			{
+				p++;
+				while ((p < end) && isDigit(*p))
+				{
+					hasDigits = true;
+					if (significand < 100000000000000000ull)
+					{
+						significand = 10 * significand + (*p - '0');
+						exponent--;
+					}
+					else
+						exact = exact && (*p == '0');
+					p++;
+				}
+			}
+			if (!hasDigits)
+			{
+				// inf, nan and other special cases
+				p = start;
+				return parseRealFallback(p, end, value);
+			}
+			if ((p < end) && ((*p == 'e') || (*p == 'E')))
+			{
+				const char *e = p + 1;
+				int exp;
+				if ((e < end) && (*e != ' ') && parseInt(e, end, exp))
+				{
+					exponent += exp;
+					p = e;
+				}
+			}
+
+			if (exact && (significand <= RealTraits<T>::maxSignificand()) && (exponent >= -RealTraits<T>::maxExponent()) && (exponent <= RealTraits<T>::maxExponent()))
+			{
+				T v = (T)significand;
+				if (exponent < 0)
+					v /= RealTraits<T>::pow10(-exponent);
+				else if (exponent > 0)
+					v *= RealTraits<T>::pow10(exponent);
+				value = negative ? -v : v;
+				return true;
+			}
+			p = start;
+			return parseRealFallback(p, end, value);
+		}
+
+		template<typename T>
+		static inline bool parseRealFallback(const char *&p, const char *end, T &value)
+		{
+			// copy the token since the buffer is not null-terminated
+			char buffer[64];
+			size_t n = 0;
+			while ((p + n < end) && (n < sizeof(buffer) - 1) && (p[n] != ' ') && (p[n] != '\t') && (p[n] != '\r') && (p[n] != '\n'))
+				n++;
+			memcpy(buffer, p, n);
+			buffer[n] = 0;
+			char *tokenEnd;
+			value = RealTraits<T>::convert(buffer, &tokenEnd);
+			if (tokenEnd == buffer)
+				return false;
+			p += tokenEnd - buffer;
+			return true;
+		}
+
+		/** Split the buffer into the given number of chunks which start at the beginning of a line.
+		* Returns the offsets of the chunk boundaries (numChunks + 1 values). */
+		static std::vector<size_t> splitLines(const char *data, const size_t size, const unsigned int numChunks)
+		{
+			std::vector<size_t> offsets;
+			offsets.push_back(0);
+			for (unsigned int i = 1; i < numChunks; i++)
+			{
+				const char *p = data + std::max(offsets.back(), (size * i) / numChunks);
+				if (p > data)
+				{
+					// a chunk starts after a line break
+					p--;
+					skipLine(p, data + size);
+				}
+				offsets.push_back(p - data);
+			}
+			offsets.push_back(size);
+			return offsets;
+		}
+	};
+
+	template<>
+	struct TextParser::RealTraits<float>
+	{
+		static uint64_t maxSignificand() { return 1ull << 24; }
+		static int maxExponent() { return 10; }
+		static float pow10(const int e)
+		{
+			static const float p[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+			return p[e];
+		}
+		static float convert(const char *str, char **end) { return strtof(str, end); }
+	};
+
+	template<>
+	struct TextParser::RealTraits<double>
+	{
+		static uint64_t maxSignificand() { return 1ull << 53; }
+		static int maxExponent() { return 22; }
+		static double pow10(const int e)
+		{
+			static const double p[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+			return p[e];
+		}
+		static double convert(const char *str, char **end) { return strtod(str, end); }
+	};
+}
+
+#endif
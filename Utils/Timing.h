@@ -2,15 +2,28 @@
 #define __Timing_H__
 
 #include <iostream>
-#include <stack>
+#include <fstream>
+#include <iomanip>
 #include <unordered_map>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <algorithm>
 #include "Logger.h"
 #include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 namespace Utilities
 {
+	/** The zone id of a timer name is determined once per call site. */
 	#define START_TIMING(timerName) \
-	Utilities::Timing::startTiming(timerName);
+	{ \
+	static const int timing_zoneId = Utilities::Timing::getZoneId(timerName); \
+	Utilities::Timing::startTiming(timing_zoneId); \
+	}
 
 	#define STOP_TIMING \
 	Utilities::Timing::stopTiming(false);
@@ -19,24 +32,40 @@ namespace Utilities
 	Utilities::Timing::stopTiming(true);
 
 	#define STOP_TIMING_AVG \
-	{ \
-	static int timing_timerId = -1; \
-	Utilities::Timing::stopTiming(false, timing_timerId); \
-	}
+	Utilities::Timing::stopTiming(false, true);
 
 	#define STOP_TIMING_AVG_PRINT \
-	{ \
-	static int timing_timerId = -1; \
-	Utilities::Timing::stopTiming(true, timing_timerId); \
-	}
+	Utilities::Timing::stopTiming(true, true);
+
+	#define INCREASE_COUNTER(counterName, increaseBy) \
+	Utilities::Timing::increaseCounter(counterName, increaseBy);
 
 	#define INIT_TIMING \
 		int Utilities::IDFactory::id = 0; \
-		std::unordered_map<int, Utilities::AverageTime> Utilities::Timing::m_averageTimes; \
-		std::stack<Utilities::TimingHelper> Utilities::Timing::m_timingStack; \
 		bool Utilities::Timing::m_dontPrintTimes = false; \
-		unsigned int Utilities::Timing::m_startCounter = 0; \
-		unsigned int Utilities::Timing::m_stopCounter = 0;
+		bool Utilities::Timing::m_traceEnabled = false; \
+		unsigned int Utilities::Timing::m_traceBufferSize = 65536; \
+		INIT_ALLOCATION_COUNTER
+
+	/** If USE_ALLOCATION_COUNTER is defined, the global operator new is replaced
+	* by a version which counts the heap allocations. The number of allocations
+	* between START_TIMING and STOP_TIMING_AVG is then shown in the timing report.
+	*/
+#ifdef USE_ALLOCATION_COUNTER
+	#define INIT_ALLOCATION_COUNTER \
+		void *operator new(std::size_t size) \
+		{ \
+			Utilities::Timing::allocationCounter()++; \
+			void *p = std::malloc(size == 0 ? 1 : size); \
+			if (!p) \
+				throw std::bad_alloc(); \
+			return p; \
+		} \
+		void operator delete(void *p) noexcept { std::free(p); } \
+		void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+#else
+	#define INIT_ALLOCATION_COUNTER
+#endif
 
 
 	/** \brief Struct to store a time measurement.
@@ -44,16 +73,64 @@ namespace Utilities
 	struct TimingHelper
 	{
 		std::chrono::time_point<std::chrono::high_resolution_clock> start;
-		std::string name;
+		/** id of the interned timer name */
+		int zone;
+		/** zone of the enclosing measurement or -1 */
+		int parent;
+		/** value of the allocation counter at the start */
+		std::size_t allocations;
 	};
 
-	/** \brief Struct to store the total time and the number of steps in order to compute the average time. 
+	/** \brief Struct to store the total time and the number of steps in order to compute the average time.
 	*/
 	struct AverageTime
 	{
 		double totalTime;
 		unsigned int counter;
 		std::string name;
+		std::size_t totalAllocations;
+		std::size_t lastAllocations;
+		/** number of threads which contributed to the measurements */
+		unsigned int numThreads;
+	};
+
+	/** \brief Struct to store the sum of a counter and the number of increments in order to compute the average count.
+	*/
+	struct AverageCount
+	{
+		double sum;
+		unsigned int numberOfCalls;
+	};
+
+	/** \brief Finished measurement in the trace buffer of a thread.
+	* Times are given in microseconds since the first use of the profiler.
+	*/
+	struct TraceEvent
+	{
+		int zone;
+		int parent;
+		unsigned int depth;
+		double start;
+		double duration;
+	};
+
+	/** \brief Timing data of one thread. Only the owning thread writes to the data,
+	* the mutex is required for the report and the export which are called from
+	* another thread.
+	*/
+	struct ThreadTimingData
+	{
+		unsigned int threadIndex;
+		std::mutex mutex;
+		std::vector<TimingHelper> timingStack;
+		/** averages indexed by the zone id */
+		std::vector<AverageTime> averageTimes;
+		std::unordered_map<std::string, AverageCount> averageCounts;
+		/** ring buffer of the trace, allocated when the first event is recorded */
+		std::vector<TraceEvent> traceEvents;
+		std::size_t numTraceEvents;
+		unsigned int startCounter;
+		unsigned int stopCounter;
 	};
 
 	/** \brief Factory for unique ids.
@@ -69,120 +146,387 @@ namespace Utilities
 	};
 
 	/** \brief Class for time measurements.
+	* Measurements can be nested and may be performed in parallel regions. Each thread
+	* has its own stack of running measurements, its own averages and a ring buffer
+	* of the finished measurements, which can be written as Chrome trace file
+	* (chrome://tracing or https://ui.perfetto.dev) by writeTrace(). Timer names are
+	* interned, the measurements only store the zone id of the name.
 	*/
 	class Timing
 	{
+	protected:
+		/** Data which is shared by all threads */
+		struct GlobalData
+		{
+			std::mutex mutex;
+			std::vector<std::shared_ptr<ThreadTimingData>> threads;
+			/** The deque keeps the names at fixed addresses. */
+			std::deque<std::string> zoneNames;
+			std::unordered_map<std::string, int> zoneIds;
+			std::chrono::time_point<std::chrono::high_resolution_clock> epoch;
+		};
+
+		static GlobalData &globalData()
+		{
+			static GlobalData data;
+			return data;
+		}
+
+		static ThreadTimingData *registerThread()
+		{
+			GlobalData &g = globalData();
+			std::lock_guard<std::mutex> lock(g.mutex);
+			std::shared_ptr<ThreadTimingData> data = std::make_shared<ThreadTimingData>();
+			data->threadIndex = (unsigned int)g.threads.size();
+			data->numTraceEvents = 0;
+			data->startCounter = 0;
+			data->stopCounter = 0;
+			if (g.threads.empty())
+				g.epoch = std::chrono::high_resolution_clock::now();
+			g.threads.push_back(data);
+			return data.get();
+		}
+
+		/** Data of the calling thread. The data is owned by the global data,
+		* so that it remains available after the thread has finished. */
+		FORCE_INLINE static ThreadTimingData &threadData()
+		{
+			static thread_local ThreadTimingData *data = registerThread();
+			return *data;
+		}
+
+		static std::string getZoneName(const int zone)
+		{
+			GlobalData &g = globalData();
+			std::lock_guard<std::mutex> lock(g.mutex);
+			if ((zone >= 0) && (zone < (int)g.zoneNames.size()))
+				return g.zoneNames[zone];
+			return "";
+		}
+
+		/** Averages of all threads */
+		static std::vector<AverageTime> mergeAverageTimes()
+		{
+			std::vector<AverageTime> result;
+			GlobalData &g = globalData();
+			std::lock_guard<std::mutex> lock(g.mutex);
+			for (auto &data : g.threads)
+			{
+				std::lock_guard<std::mutex> threadLock(data->mutex);
+				if (data->averageTimes.size() > result.size())
+					result.resize(data->averageTimes.size(), AverageTime{ 0.0, 0u, "", 0u, 0u, 0u });
+				for (unsigned int zone = 0; zone < data->averageTimes.size(); zone++)
+				{
+					const AverageTime &at = data->averageTimes[zone];
+					if (at.counter == 0)
+						continue;
+					AverageTime &r = result[zone];
+					r.totalTime += at.totalTime;
+					r.counter += at.counter;
+					r.totalAllocations += at.totalAllocations;
+					r.lastAllocations = at.lastAllocations;
+					r.numThreads++;
+				}
+			}
+			for (unsigned int zone = 0; zone < result.size(); zone++)
+				result[zone].name = g.zoneNames[zone];
+			return result;
+		}
+
+		static void checkCounters()
+		{
+			unsigned int startCounter = 0;
+			unsigned int stopCounter = 0;
+			GlobalData &g = globalData();
+			{
+				std::lock_guard<std::mutex> lock(g.mutex);
+				for (auto &data : g.threads)
+				{
+					std::lock_guard<std::mutex> threadLock(data->mutex);
+					startCounter += data->startCounter;
+					stopCounter += data->stopCounter;
+				}
+			}
+			if (startCounter != stopCounter)
+				LOG_INFO << "Problem: " << startCounter << " calls of startTiming and " << stopCounter << " calls of stopTiming. ";
+		}
+
+		static void writeJSONString(std::ostream &out, const std::string &str)
+		{
+			out << "\"";
+			for (const char c : str)
+			{
+				if ((c == '"') || (c == '\\'))
+					out << '\\' << c;
+				else if ((unsigned char)c < 0x20)
+					out << ' ';
+				else
+					out << c;
+			}
+			out << "\"";
+		}
+
 	public:
 		static bool m_dontPrintTimes;
-		static unsigned int m_startCounter;
-		static unsigned int m_stopCounter;
-		static std::stack<TimingHelper> m_timingStack;
-		static std::unordered_map<int, AverageTime> m_averageTimes;
+		/** If true, the finished measurements are stored for writeTrace(). */
+		static bool m_traceEnabled;
+		/** Number of events which are kept per thread */
+		static unsigned int m_traceBufferSize;
 
+		/** Reset all measurements. This must not be called while measurements are running in other threads. */
 		static void reset()
 		{
-			while (!m_timingStack.empty())
-				m_timingStack.pop();
-			m_averageTimes.clear();
-			m_startCounter = 0;
-			m_stopCounter = 0;
+			GlobalData &g = globalData();
+			std::lock_guard<std::mutex> lock(g.mutex);
+			for (auto &data : g.threads)
+			{
+				std::lock_guard<std::mutex> threadLock(data->mutex);
+				data->timingStack.clear();
+				data->averageTimes.clear();
+				data->averageCounts.clear();
+				data->numTraceEvents = 0;
+				data->startCounter = 0;
+				data->stopCounter = 0;
+			}
 		}
 
-		FORCE_INLINE static void startTiming(const std::string& name = std::string(""))
+		static void enableTrace(const bool enable) { m_traceEnabled = enable; }
+
+		/** Number of heap allocations (see INIT_ALLOCATION_COUNTER) */
+		FORCE_INLINE static std::atomic<std::size_t> &allocationCounter()
 		{
+			static std::atomic<std::size_t> counter(0);
+			return counter;
+		}
+
+		/** Return the id of a timer name. New names are added to the table. */
+		static int getZoneId(const char *name)
+		{
+			GlobalData &g = globalData();
+			std::lock_guard<std::mutex> lock(g.mutex);
+			auto iter = g.zoneIds.find(name);
+			if (iter != g.zoneIds.end())
+				return iter->second;
+			const int id = (int)g.zoneNames.size();
+			g.zoneNames.push_back(name);
+			g.zoneIds[g.zoneNames.back()] = id;
+			return id;
+		}
+
+		FORCE_INLINE static void startTiming(const int zone)
+		{
+			ThreadTimingData &data = threadData();
 			TimingHelper h;
-			h.start = std::chrono::high_resolution_clock::now();
-			h.name = name;
-			Timing::m_timingStack.push(h);
-			Timing::m_startCounter++;
+			h.zone = zone;
+			h.parent = data.timingStack.empty() ? -1 : data.timingStack.back().zone;
+			data.timingStack.push_back(h);
+			data.startCounter++;
+			data.timingStack.back().allocations = allocationCounter();
+			data.timingStack.back().start = std::chrono::high_resolution_clock::now();
 		}
 
-		FORCE_INLINE static double stopTiming(bool print = true)
+		/** Start a time measurement. The name is interned on each call,
+		* START_TIMING does this only once per call site. */
+		static void startTiming(const char *name)
 		{
-			if (!Timing::m_timingStack.empty())
-			{
-				Timing::m_stopCounter++;
-				std::chrono::time_point<std::chrono::high_resolution_clock> stop = std::chrono::high_resolution_clock::now();
-				TimingHelper h = Timing::m_timingStack.top();
-				Timing::m_timingStack.pop();
-				std::chrono::duration<double> elapsed_seconds = stop - h.start;
-				double t = elapsed_seconds.count() * 1000.0;
-
-				if (print)
-					LOG_INFO << "time " << h.name.c_str() << ": " << t << " ms";
-				return t;
-			}
-			return 0;
+			startTiming(getZoneId(name));
 		}
 
-		FORCE_INLINE static double stopTiming(bool print, int &id)
+		/** Stop the last measurement of the calling thread and return the time in ms.
+		* If average is true, the time is added to the average of the zone. */
+		FORCE_INLINE static double stopTiming(bool print = true, bool average = false)
 		{
-			if (id == -1)
-				id = IDFactory::getId();
-			if (!Timing::m_timingStack.empty())
-			{
-				Timing::m_stopCounter++;
-				std::chrono::time_point<std::chrono::high_resolution_clock> stop = std::chrono::high_resolution_clock::now();
-				TimingHelper h = Timing::m_timingStack.top();
-				Timing::m_timingStack.pop();
+			ThreadTimingData &data = threadData();
+			if (data.timingStack.empty())
+				return 0;
+
+			std::chrono::time_point<std::chrono::high_resolution_clock> stop = std::chrono::high_resolution_clock::now();
+			const std::size_t allocations = allocationCounter() - data.timingStack.back().allocations;
+			const TimingHelper h = data.timingStack.back();
+			data.timingStack.pop_back();
 
-				std::chrono::duration<double> elapsed_seconds = stop - h.start;
-				double t = elapsed_seconds.count() * 1000.0;
+			std::chrono::duration<double> elapsed_seconds = stop - h.start;
+			double t = elapsed_seconds.count() * 1000.0;
 
-				if (print && !Timing::m_dontPrintTimes)
-					LOG_INFO << "time " << h.name.c_str() << ": " << t << " ms";
+			if (print && !Timing::m_dontPrintTimes)
+				LOG_INFO << "time " << getZoneName(h.zone) << ": " << t << " ms";
 
-				if (id >= 0)
+			if (average || m_traceEnabled)
+			{
+				std::lock_guard<std::mutex> lock(data.mutex);
+				data.stopCounter++;
+				if (average)
 				{
-					std::unordered_map<int, AverageTime>::iterator iter;
-					iter = Timing::m_averageTimes.find(id);
-					if (iter != Timing::m_averageTimes.end())
-					{
-						Timing::m_averageTimes[id].totalTime += t;
-						Timing::m_averageTimes[id].counter++;
-					}
-					else
+					if (h.zone >= (int)data.averageTimes.size())
+						data.averageTimes.resize(h.zone + 1, AverageTime{ 0.0, 0u, "", 0u, 0u, 1u });
+					AverageTime &at = data.averageTimes[h.zone];
+					at.totalTime += t;
+					at.counter++;
+					at.totalAllocations += allocations;
+					at.lastAllocations = allocations;
+				}
+				if (m_traceEnabled && (m_traceBufferSize > 0))
+				{
+					if (data.traceEvents.size() != m_traceBufferSize)
 					{
-						AverageTime at;
-						at.counter = 1;
-						at.totalTime = t;
-						at.name = h.name;
-						Timing::m_averageTimes[id] = at;
+						data.traceEvents.resize(m_traceBufferSize);
+						data.numTraceEvents = 0;
 					}
+					TraceEvent &e = data.traceEvents[data.numTraceEvents % m_traceBufferSize];
+					e.zone = h.zone;
+					e.parent = h.parent;
+					e.depth = (unsigned int)data.timingStack.size();
+					e.start = std::chrono::duration<double, std::micro>(h.start - globalData().epoch).count();
+					e.duration = t * 1000.0;
+					data.numTraceEvents++;
 				}
-				return t;
 			}
-			return 0;
+			else
+				data.stopCounter++;
+			return t;
+		}
+
+		/** Add a value to a named counter (e.g. the number of solver iterations of a step).
+		 * The average over all calls is printed by printAverageTimes().
+		 */
+		static void increaseCounter(const std::string& name, const double increaseBy)
+		{
+			ThreadTimingData &data = threadData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+			std::unordered_map<std::string, AverageCount>::iterator iter;
+			iter = data.averageCounts.find(name);
+			if (iter != data.averageCounts.end())
+			{
+				iter->second.sum += increaseBy;
+				iter->second.numberOfCalls++;
+			}
+			else
+			{
+				AverageCount ac;
+				ac.sum = increaseBy;
+				ac.numberOfCalls = 1;
+				data.averageCounts[name] = ac;
+			}
 		}
 
-		FORCE_INLINE static void printAverageTimes()
+		/** Averages of all zones, merged over all threads */
+		static std::unordered_map<int, AverageTime> getAverageTimes()
 		{
-			std::unordered_map<int, AverageTime>::iterator iter;
-			for (iter = Timing::m_averageTimes.begin(); iter != Timing::m_averageTimes.end(); iter++)
+			std::vector<AverageTime> averageTimes = mergeAverageTimes();
+			std::unordered_map<int, AverageTime> result;
+			for (unsigned int zone = 0; zone < averageTimes.size(); zone++)
+				if (averageTimes[zone].counter > 0)
+					result[zone] = averageTimes[zone];
+			return result;
+		}
+
+		static void printAverageTimes()
+		{
+			const std::vector<AverageTime> averageTimes = mergeAverageTimes();
+			for (const AverageTime &at : averageTimes)
 			{
-				AverageTime &at = iter->second;
+				if (at.counter == 0)
+					continue;
 				const double avgTime = at.totalTime / at.counter;
-				LOG_INFO << "Average time " << at.name.c_str() << ": " << avgTime << " ms";
+				std::string threads;
+				if (at.numThreads > 1)
+					threads = ", threads: " + std::to_string(at.numThreads);
+				if (allocationCounter() > 0)
+					LOG_INFO << "Average time " << at.name.c_str() << ": " << avgTime << " ms" << threads << ", allocations: " << (double)at.totalAllocations / at.counter << " (last: " << at.lastAllocations << ")";
+				else
+					LOG_INFO << "Average time " << at.name.c_str() << ": " << avgTime << " ms" << threads;
+			}
+
+			std::unordered_map<std::string, AverageCount> averageCounts;
+			{
+				GlobalData &g = globalData();
+				std::lock_guard<std::mutex> lock(g.mutex);
+				for (auto &data : g.threads)
+				{
+					std::lock_guard<std::mutex> threadLock(data->mutex);
+					for (auto &citer : data->averageCounts)
+					{
+						AverageCount &ac = averageCounts[citer.first];
+						ac.sum += citer.second.sum;
+						ac.numberOfCalls += citer.second.numberOfCalls;
+					}
+				}
+			}
+			std::unordered_map<std::string, AverageCount>::iterator citer;
+			for (citer = averageCounts.begin(); citer != averageCounts.end(); citer++)
+			{
+				AverageCount &ac = citer->second;
+				const double avgCount = ac.sum / ac.numberOfCalls;
+				LOG_INFO << "Average number " << citer->first.c_str() << ": " << avgCount;
 			}
-			if (Timing::m_startCounter != Timing::m_stopCounter)
-				LOG_INFO << "Problem: " << Timing::m_startCounter << " calls of startTiming and " << Timing::m_stopCounter << " calls of stopTiming. ";
+			checkCounters();
 			LOG_INFO << "---------------------------------------------------------------------------\n";
 		}
 
-		FORCE_INLINE static void printTimeSums()
+		static void printTimeSums()
 		{
-			std::unordered_map<int, AverageTime>::iterator iter;
-			for (iter = Timing::m_averageTimes.begin(); iter != Timing::m_averageTimes.end(); iter++)
+			const std::vector<AverageTime> averageTimes = mergeAverageTimes();
+			for (const AverageTime &at : averageTimes)
 			{
-				AverageTime &at = iter->second;
+				if (at.counter == 0)
+					continue;
 				const double timeSum = at.totalTime;
 				LOG_INFO << "Time sum " << at.name.c_str() << ": " << timeSum << " ms";
 			}
-			if (Timing::m_startCounter != Timing::m_stopCounter)
-				LOG_INFO << "Problem: " << Timing::m_startCounter << " calls of startTiming and " << Timing::m_stopCounter << " calls of stopTiming. ";
+			checkCounters();
 			LOG_INFO << "---------------------------------------------------------------------------\n";
 		}
+
+		/** Write the recorded measurements of all threads in the Chrome trace event format.
+		* Each thread is shown in its own row, nested zones are stacked. If the trace buffer
+		* of a thread overflowed, only its latest events are written.
+		*/
+		static bool writeTrace(const std::string &fileName)
+		{
+			std::ofstream out(fileName);
+			if (!out)
+			{
+				LOG_WARN << "Cannot open the trace file " << fileName;
+				return false;
+			}
+
+			GlobalData &g = globalData();
+			std::lock_guard<std::mutex> lock(g.mutex);
+			// the time stamps are given in microseconds
+			out << std::fixed << std::setprecision(3);
+			out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			bool first = true;
+			for (auto &data : g.threads)
+			{
+				std::lock_guard<std::mutex> threadLock(data->mutex);
+				if (!first)
+					out << ",\n";
+				first = false;
+				out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << data->threadIndex
+					<< ",\"args\":{\"name\":\"Thread " << data->threadIndex << "\"}}";
+
+				const std::size_t bufferSize = data->traceEvents.size();
+				const std::size_t numEvents = std::min(data->numTraceEvents, bufferSize);
+				const std::size_t firstEvent = data->numTraceEvents - numEvents;
+				for (std::size_t i = firstEvent; i < data->numTraceEvents; i++)
+				{
+					const TraceEvent &e = data->traceEvents[i % bufferSize];
+					out << ",\n{\"name\":";
+					writeJSONString(out, g.zoneNames[e.zone]);
+					out << ",\"cat\":\"PBD\",\"ph\":\"X\",\"pid\":0,\"tid\":" << data->threadIndex
+						<< ",\"ts\":" << e.start << ",\"dur\":" << e.duration
+						<< ",\"args\":{\"depth\":" << e.depth << ",\"parent\":";
+					if (e.parent >= 0)
+						writeJSONString(out, g.zoneNames[e.parent]);
+					else
+						out << "null";
+					out << "}}";
+				}
+			}
+			out << "\n]}\n";
+			return true;
+		}
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -26,21 +26,52 @@ void CollisionDetectionModule(py::module m_sub)
         .def_readwrite_static("TYPE_ID", &PBD::CollisionDetection::CollisionObjectWithoutGeometry::TYPE_ID)
         .def("getTypeId", &PBD::CollisionDetection::CollisionObjectWithoutGeometry::getTypeId);
 
+    py::class_<PBD::CollisionDetection::Statistics>(m_sub, "CollisionDetectionStatistics")
+        .def(py::init<>())
+        .def_readwrite("numBroadPhasePairs", &PBD::CollisionDetection::Statistics::m_numBroadPhasePairs)
+        .def_readwrite("numNarrowPhaseTests", &PBD::CollisionDetection::Statistics::m_numNarrowPhaseTests)
+        .def_readwrite("numBVHNodesVisited", &PBD::CollisionDetection::Statistics::m_numBVHNodesVisited)
+        .def_readwrite("numClothPrimitiveTests", &PBD::CollisionDetection::Statistics::m_numClothPrimitiveTests)
+        .def("reset", &PBD::CollisionDetection::Statistics::reset);
+
     py::class_<PBD::CollisionDetection>(m_sub, "CollisionDetection")
         .def_readonly_static("RigidBodyContactType", &PBD::CollisionDetection::RigidBodyContactType)
         .def_readonly_static("ParticleContactType", &PBD::CollisionDetection::ParticleContactType)
         .def_readonly_static("ParticleRigidBodyContactType", &PBD::CollisionDetection::ParticleRigidBodyContactType)
         .def_readonly_static("ParticleSolidContactType", &PBD::CollisionDetection::ParticleSolidContactType)
+        .def_readonly_static("TrianglePointContactType", &PBD::CollisionDetection::TrianglePointContactType)
+        .def_readonly_static("EdgeEdgeContactType", &PBD::CollisionDetection::EdgeEdgeContactType)
 
         .def("cleanup", &PBD::CollisionDetection::cleanup)
         .def("getTolerance", &PBD::CollisionDetection::getTolerance)
         .def("setTolerance", &PBD::CollisionDetection::setTolerance)
+        .def_readwrite_static("CONTINUOUS_COLLISION_DETECTION", &PBD::CollisionDetection::CONTINUOUS_COLLISION_DETECTION)
+        .def_readwrite_static("CCD_MOTION_THRESHOLD", &PBD::CollisionDetection::CCD_MOTION_THRESHOLD)
+        .def("getContinuousCollisionDetection", &PBD::CollisionDetection::getContinuousCollisionDetection)
+        .def("setContinuousCollisionDetection", &PBD::CollisionDetection::setContinuousCollisionDetection)
+        .def("getCCDMotionThreshold", &PBD::CollisionDetection::getCCDMotionThreshold)
+        .def("setCCDMotionThreshold", &PBD::CollisionDetection::setCCDMotionThreshold)
+        .def_readwrite_static("CLOTH_COLLISIONS", &PBD::CollisionDetection::CLOTH_COLLISIONS)
+        .def_readwrite_static("CLOTH_THICKNESS", &PBD::CollisionDetection::CLOTH_THICKNESS)
+        .def("getClothCollisions", &PBD::CollisionDetection::getClothCollisions)
+        .def("setClothCollisions", &PBD::CollisionDetection::setClothCollisions)
+        .def("getClothThickness", &PBD::CollisionDetection::getClothThickness)
+        .def("setClothThickness", &PBD::CollisionDetection::setClothThickness)
+        .def_readwrite_static("SUBSTEP_COLLISION_DETECTION", &PBD::CollisionDetection::SUBSTEP_COLLISION_DETECTION)
+        .def("getSubstepCollisionDetection", &PBD::CollisionDetection::getSubstepCollisionDetection)
+        .def("setSubstepCollisionDetection", &PBD::CollisionDetection::setSubstepCollisionDetection)
+        .def("getStatistics", &PBD::CollisionDetection::getStatistics, py::return_value_policy::reference_internal)
+        .def("resetStatistics", &PBD::CollisionDetection::resetStatistics)
         .def("addRigidBodyContact", &PBD::CollisionDetection::addRigidBodyContact)
         .def("addParticleRigidBodyContact", &PBD::CollisionDetection::addParticleRigidBodyContact)
         .def("addParticleSolidContact", &PBD::CollisionDetection::addParticleSolidContact)
+        .def("addClothContact", &PBD::CollisionDetection::addClothContact)
         .def("addCollisionObject", &PBD::CollisionDetection::addCollisionObject)
         .def("getCollisionObjects", &PBD::CollisionDetection::getCollisionObjects)
         .def("collisionDetection", &PBD::CollisionDetection::collisionDetection)
+        .def("substepCollisionDetection", &PBD::CollisionDetection::substepCollisionDetection)
+        .def("initContinuousCollisionDetection", &PBD::CollisionDetection::initContinuousCollisionDetection)
+        .def("continuousCollisionDetection", &PBD::CollisionDetection::continuousCollisionDetection)
         //.def("setContactCallback", &PBD::CollisionDetection::setContactCallback)
         //.def("setSolidContactCallback", &PBD::CollisionDetection::setSolidContactCallback)
         .def("updateAABBs", &PBD::CollisionDetection::updateAABBs)
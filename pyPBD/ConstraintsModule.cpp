@@ -25,10 +25,13 @@ void ConstraintsModule(py::module m_sub)
     py::class_<PBD::Constraint>(m_sub, "Constraint")
         .def_readwrite("bodies", &PBD::Constraint::m_bodies)
         .def("getTypeId", &PBD::Constraint::getTypeId)
+        .def("getTypeName", &PBD::Constraint::getTypeName)
+        .def("numberOfParticles", &PBD::Constraint::numberOfParticles)
         .def("initConstraintBeforeProjection", &PBD::Constraint::initConstraintBeforeProjection)
         .def("updateConstraint", &PBD::Constraint::updateConstraint)
         .def("solvePositionConstraint", &PBD::Constraint::solvePositionConstraint)
-        .def("solveVelocityConstraint", &PBD::Constraint::solveVelocityConstraint);
+        .def("solveVelocityConstraint", &PBD::Constraint::solveVelocityConstraint)
+        .def("getCost", &PBD::Constraint::getCost);
 
     CONSTRAINT_JOINTINFO(BallJoint, Constraint);
     CONSTRAINT_JOINTINFO(BallOnLineJoint, Constraint);
@@ -114,6 +117,10 @@ void ConstraintsModule(py::module m_sub)
         .def_readwrite("stiffness", &PBD::ShapeMatchingConstraint::m_stiffness)
         .def_readwrite_static("TYPE_ID", &PBD::ShapeMatchingConstraint::TYPE_ID)
         .def_readwrite("restCm", &PBD::ShapeMatchingConstraint::m_restCm);
+    CONSTRAINT(FastLatticeShapeMatchingConstraint, Constraint)
+        .def_readwrite("stiffness", &PBD::FastLatticeShapeMatchingConstraint::m_stiffness)
+        .def_readonly("regionWidth", &PBD::FastLatticeShapeMatchingConstraint::m_regionWidth)
+        .def_readonly("cellParticles", &PBD::FastLatticeShapeMatchingConstraint::m_cellParticles);
     CONSTRAINT(StretchShearConstraint, Constraint)
         .def_readwrite("stretchingStiffness", &PBD::StretchShearConstraint::m_stretchingStiffness)
         .def_readwrite("shearingStiffness1", &PBD::StretchShearConstraint::m_shearingStiffness1)
@@ -124,6 +131,16 @@ void ConstraintsModule(py::module m_sub)
         .def_readwrite("bendingStiffness1", &PBD::BendTwistConstraint::m_bendingStiffness1)
         .def_readwrite("bendingStiffness2", &PBD::BendTwistConstraint::m_bendingStiffness2)
         .def_readwrite("restDarbouxVector", &PBD::BendTwistConstraint::m_restDarbouxVector);
+    CONSTRAINT(CosseratRodsConstraint, Constraint)
+        .def_readwrite("stretchingStiffness", &PBD::CosseratRodsConstraint::m_stretchingStiffness)
+        .def_readwrite("shearingStiffness1", &PBD::CosseratRodsConstraint::m_shearingStiffness1)
+        .def_readwrite("shearingStiffness2", &PBD::CosseratRodsConstraint::m_shearingStiffness2)
+        .def_readwrite("twistingStiffness", &PBD::CosseratRodsConstraint::m_twistingStiffness)
+        .def_readwrite("bendingStiffness1", &PBD::CosseratRodsConstraint::m_bendingStiffness1)
+        .def_readwrite("bendingStiffness2", &PBD::CosseratRodsConstraint::m_bendingStiffness2)
+        .def_readwrite("restLengths", &PBD::CosseratRodsConstraint::m_restLengths)
+        .def_readwrite("directSolver", &PBD::CosseratRodsConstraint::m_directSolver)
+        .def_readonly("isChain", &PBD::CosseratRodsConstraint::m_isChain);
     CONSTRAINT(StretchBendingTwistingConstraint, Constraint)
         .def_readwrite("averageRadius", &PBD::StretchBendingTwistingConstraint::m_averageRadius)
         .def_readwrite("averageSegmentLength", &PBD::StretchBendingTwistingConstraint::m_averageSegmentLength)
@@ -133,6 +150,7 @@ void ConstraintsModule(py::module m_sub)
         .def_readwrite("bendingAndTorsionCompliance", &PBD::StretchBendingTwistingConstraint::m_bendingAndTorsionCompliance)
         .def_readwrite("lambdaSum", &PBD::StretchBendingTwistingConstraint::m_lambdaSum);
     CONSTRAINT(DirectPositionBasedSolverForStiffRodsConstraint, Constraint)
+        .def_readwrite("refactorizationTolerance", &PBD::DirectPositionBasedSolverForStiffRodsConstraint::m_refactorizationTolerance)
         .def("initConstraint", &PBD::DirectPositionBasedSolverForStiffRodsConstraint::initConstraint);
 
     py::class_<PBD::RigidBodyContactConstraint>(m_sub, "RigidBodyContactConstraint")
@@ -167,4 +185,12 @@ void ConstraintsModule(py::module m_sub)
         .def("initConstraint", &PBD::ParticleTetContactConstraint::initConstraint)
         .def("solvePositionConstraint", &PBD::ParticleTetContactConstraint::solvePositionConstraint)
         .def("solveVelocityConstraint", &PBD::ParticleTetContactConstraint::solveVelocityConstraint);
+
+    py::class_<PBD::ClothContactConstraint>(m_sub, "ClothContactConstraint")
+        .def_readwrite("bodies", &PBD::ClothContactConstraint::m_bodies)
+        .def_readwrite("edgeEdge", &PBD::ClothContactConstraint::m_edgeEdge)
+        .def_readwrite("thickness", &PBD::ClothContactConstraint::m_thickness)
+        .def_readwrite("stiffness", &PBD::ClothContactConstraint::m_stiffness)
+        .def("initConstraint", &PBD::ClothContactConstraint::initConstraint)
+        .def("solvePositionConstraint", &PBD::ClothContactConstraint::solvePositionConstraint);
 }
\ No newline at end of file
@@ -12,6 +12,24 @@
 
 namespace py = pybind11;
 
+/** Writable n x 3 array which shares the memory of a particle array. The array keeps
+ * the Python object of the particle data alive. */
+static py::array_t<Real> vector3View(py::object self, Vector3r &(PBD::ParticleData::*get)(const unsigned int))
+{
+    PBD::ParticleData &pd = self.cast<PBD::ParticleData&>();
+    const unsigned int n = pd.size();
+    Real *data = (n > 0) ? (pd.*get)(0).data() : nullptr;
+    return py::array_t<Real>({ (py::ssize_t) n, (py::ssize_t) 3 }, { sizeof(Vector3r), sizeof(Real) }, data, self);
+}
+
+/** Writable array of length n which shares the memory of a particle array. */
+static py::array_t<Real> scalarView(py::object self, Real &(PBD::ParticleData::*get)(const unsigned int))
+{
+    PBD::ParticleData &pd = self.cast<PBD::ParticleData&>();
+    const unsigned int n = pd.size();
+    Real *data = (n > 0) ? &(pd.*get)(0) : nullptr;
+    return py::array_t<Real>({ (py::ssize_t) n }, { sizeof(Real) }, data, self);
+}
 
 void ParticleDataModule(py::module m_sub) 
 {
@@ -39,7 +57,7 @@ void ParticleDataModule(py::module m_sub)
         .def("getPosition0", (const Vector3r & (PBD::ParticleData::*)(const unsigned int)const)(&PBD::ParticleData::getPosition0))
         .def("setPosition0", &PBD::ParticleData::setPosition0)
         .def("getMass", (const Real(PBD::ParticleData::*)(const unsigned int)const)(&PBD::ParticleData::getMass))
-        .def("getInvMass", &PBD::ParticleData::getInvMass)
+        .def("getInvMass", (const Real(PBD::ParticleData::*)(const unsigned int)const)(&PBD::ParticleData::getInvMass))
         .def("setMass", &PBD::ParticleData::setMass)
         .def("getVelocity", (const Vector3r & (PBD::ParticleData::*)(const unsigned int)const)(&PBD::ParticleData::getVelocity))
         .def("setVelocity", &PBD::ParticleData::setVelocity)
@@ -55,5 +73,17 @@ void ParticleDataModule(py::module m_sub)
             void* base_ptr = const_cast<Real*>(&(pd.getVertices())[0][0]);
             int num_vert = pd.getNumberOfParticles();
             return py::memoryview::from_buffer((Real*)base_ptr, { num_vert, 3 }, { sizeof(Real) * 3, sizeof(Real) }, true);
-            });
+            })
+        // Zero-copy views of the particle arrays. Writing to a view changes the simulation state
+        // directly. A view is only valid as long as the simulation model exists and the number of
+        // particles does not change (addVertex, resize, reserve, release or adding a model
+        // invalidates all views). Masses and inverse masses are not synchronized: either write both
+        // or use setMass.
+        .def("getPositions", [](py::object self) { return vector3View(self, &PBD::ParticleData::getPosition); })
+        .def("getPositions0", [](py::object self) { return vector3View(self, &PBD::ParticleData::getPosition0); })
+        .def("getOldPositions", [](py::object self) { return vector3View(self, &PBD::ParticleData::getOldPosition); })
+        .def("getVelocities", [](py::object self) { return vector3View(self, &PBD::ParticleData::getVelocity); })
+        .def("getAccelerations", [](py::object self) { return vector3View(self, &PBD::ParticleData::getAcceleration); })
+        .def("getMasses", [](py::object self) { return scalarView(self, &PBD::ParticleData::getMass); })
+        .def("getInvMasses", [](py::object self) { return scalarView(self, &PBD::ParticleData::getInvMass); });
 }
\ No newline at end of file
@@ -27,11 +27,20 @@ void RigidBodyModule(py::module m_sub)
     py::class_<PBD::RigidBodyGeometry>(m_sub, "RigidBodyGeometry")
         .def(py::init<>())
         .def("getMesh", &PBD::RigidBodyGeometry::getMesh)
-        .def("getVertexData", (const PBD::VertexData & (PBD::RigidBodyGeometry::*)()const)(&PBD::RigidBodyGeometry::getVertexData))
+        .def("getVertexData", &PBD::RigidBodyGeometry::getVertexData)
+        .def("updateVertexData", &PBD::RigidBodyGeometry::updateVertexData)
         .def("getVertexDataLocal", (const PBD::VertexData & (PBD::RigidBodyGeometry::*)()const)(&PBD::RigidBodyGeometry::getVertexDataLocal))
         .def("initMesh", &PBD::RigidBodyGeometry::initMesh)
         .def("updateMeshTransformation", &PBD::RigidBodyGeometry::updateMeshTransformation)
         .def("updateMeshNormals", &PBD::RigidBodyGeometry::updateMeshNormals)
+        .def("updateLocalBounds", &PBD::RigidBodyGeometry::updateLocalBounds)
+        .def("getWorldBounds", [](const PBD::RigidBodyGeometry& obj) {
+            Vector3r minX, maxX;
+            obj.getWorldBounds(minX, maxX);
+            return py::make_tuple(minX, maxX);
+        })
+        .def_static("getUpdateVertexData", &PBD::RigidBodyGeometry::getUpdateVertexData)
+        .def_static("setUpdateVertexData", &PBD::RigidBodyGeometry::setUpdateVertexData)
         ;
 
     py::class_<PBD::RigidBody>(m_sub, "RigidBody")
@@ -112,6 +121,14 @@ void RigidBodyModule(py::module m_sub)
         .def("setRestitutionCoeff", &PBD::RigidBody::setRestitutionCoeff)
         .def("getFrictionCoeff", &PBD::RigidBody::getFrictionCoeff)
         .def("setFrictionCoeff", &PBD::RigidBody::setFrictionCoeff)
+        .def("isSleeping", &PBD::RigidBody::isSleeping)
+        .def("getSleepLinearVelocity", &PBD::RigidBody::getSleepLinearVelocity)
+        .def("setSleepLinearVelocity", &PBD::RigidBody::setSleepLinearVelocity)
+        .def("getSleepAngularVelocity", &PBD::RigidBody::getSleepAngularVelocity)
+        .def("setSleepAngularVelocity", &PBD::RigidBody::setSleepAngularVelocity)
+        .def("getSleepTime", &PBD::RigidBody::getSleepTime)
+        .def("setSleepTime", &PBD::RigidBody::setSleepTime)
+        .def("wakeUp", &PBD::RigidBody::wakeUp)
         .def("getGeometry", &PBD::RigidBody::getGeometry)
     ;
 
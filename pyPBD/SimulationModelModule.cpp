@@ -44,6 +44,45 @@ PBD::CubicSDFCollisionDetection::GridPtr generateSDF(const std::vector<Vector3r>
     return sdf;
 }
 
+typedef py::array_t<Real, py::array::c_style> RealArray;
+
+/** Copy a state vector of all rigid bodies to an n x dim array. If out is given, it must be a
+ * C-contiguous, writable array of Real with the right shape which is filled without allocation. */
+template<int dim, typename Getter>
+static RealArray gatherRigidBodyState(PBD::SimulationModel &model, py::object out, Getter get)
+{
+    const PBD::SimulationModel::RigidBodyVector &rbs = model.getRigidBodies();
+    const py::ssize_t n = (py::ssize_t) rbs.size();
+    RealArray result;
+    if (out.is_none())
+        result = RealArray({ n, (py::ssize_t) dim });
+    else
+    {
+        if (!RealArray::check_(out))
+            throw std::invalid_argument("out must be a C-contiguous array with the floating point type of the simulation");
+        result = out.cast<RealArray>();
+    }
+    if ((result.ndim() != 2) || (result.shape(0) != n) || (result.shape(1) != dim))
+        throw std::invalid_argument("out must have the shape (" + std::to_string(n) + ", " + std::to_string(dim) + ")");
+    Real *data = result.mutable_data();
+    for (py::ssize_t i = 0; i < n; i++)
+        get(*rbs[i], &data[dim * i]);
+    return result;
+}
+
+/** Set a state vector of all rigid bodies from an n x dim array. */
+template<int dim, typename Setter>
+static void scatterRigidBodyState(PBD::SimulationModel &model, const py::array_t<Real, py::array::c_style | py::array::forcecast> &values, Setter set)
+{
+    PBD::SimulationModel::RigidBodyVector &rbs = model.getRigidBodies();
+    const py::ssize_t n = (py::ssize_t) rbs.size();
+    if ((values.ndim() != 2) || (values.shape(0) != n) || (values.shape(1) != dim))
+        throw std::invalid_argument("values must have the shape (" + std::to_string(n) + ", " + std::to_string(dim) + ")");
+    const Real *data = values.data();
+    for (py::ssize_t i = 0; i < n; i++)
+        set(*rbs[i], &data[dim * i]);
+}
+
 void SimulationModelModule(py::module m_sub) 
 {
     py::class_<PBD::TriangleModel>(m_sub, "TriangleModel")
@@ -254,6 +293,7 @@ void SimulationModelModule(py::module m_sub)
         .def("addRigidBodyContactConstraint", &PBD::SimulationModel::addRigidBodyContactConstraint)
         .def("addParticleRigidBodyContactConstraint", &PBD::SimulationModel::addParticleRigidBodyContactConstraint)
         .def("addParticleSolidContactConstraint", &PBD::SimulationModel::addParticleSolidContactConstraint)
+        .def("addClothContactConstraint", &PBD::SimulationModel::addClothContactConstraint)
         .def("addDistanceConstraint", &PBD::SimulationModel::addDistanceConstraint)
         .def("addDistanceConstraint_XPBD", &PBD::SimulationModel::addDistanceConstraint_XPBD)
         .def("addDihedralConstraint", &PBD::SimulationModel::addDihedralConstraint)
@@ -274,24 +314,74 @@ void SimulationModelModule(py::module m_sub)
             {
                 model.addShapeMatchingConstraint(numberOfParticles, particleIndices.data(), numClusters.data(), stiffness);
             })
+        .def("addFastLatticeShapeMatchingConstraint", [](
+            PBD::SimulationModel& model,
+            const unsigned int width, const unsigned int height, const unsigned int depth,
+            const std::vector<unsigned int>& cellParticles,
+            const unsigned int regionWidth,
+            const Real stiffness)
+            {
+                return model.addFastLatticeShapeMatchingConstraint(width, height, depth, cellParticles.data(), regionWidth, stiffness);
+            })
 
 
         .def("addStretchShearConstraint", &PBD::SimulationModel::addStretchShearConstraint)
         .def("addBendTwistConstraint", &PBD::SimulationModel::addBendTwistConstraint)
+        .def("addCosseratRodsConstraint", &PBD::SimulationModel::addCosseratRodsConstraint)
         .def("addStretchBendingTwistingConstraint", &PBD::SimulationModel::addStretchBendingTwistingConstraint)
         .def("addDirectPositionBasedSolverForStiffRodsConstraint", &PBD::SimulationModel::addDirectPositionBasedSolverForStiffRodsConstraint)
         
         .def("getParticles", &PBD::SimulationModel::getParticles, py::return_value_policy::reference)
         .def("getRigidBodies", &PBD::SimulationModel::getRigidBodies, py::return_value_policy::reference)
+        // Bulk access to the state of all rigid bodies as arrays with one row per body. Rotations are
+        // quaternions in the order (x, y, z, w). The rigid bodies are stored individually, so the
+        // data is copied, but the whole array is transferred in a single call.
+        .def("getRigidBodyPositions", [](PBD::SimulationModel &model, py::object out) {
+            return gatherRigidBodyState<3>(model, out, [](const PBD::RigidBody &rb, Real *v) { Eigen::Map<Vector3r> x(v); x = rb.getPosition(); });
+            }, py::arg("out") = py::none())
+        .def("getRigidBodyRotations", [](PBD::SimulationModel &model, py::object out) {
+            return gatherRigidBodyState<4>(model, out, [](const PBD::RigidBody &rb, Real *v) { Eigen::Map<Vector4r> x(v); x = rb.getRotation().coeffs(); });
+            }, py::arg("out") = py::none())
+        .def("getRigidBodyVelocities", [](PBD::SimulationModel &model, py::object out) {
+            return gatherRigidBodyState<3>(model, out, [](const PBD::RigidBody &rb, Real *v) { Eigen::Map<Vector3r> x(v); x = rb.getVelocity(); });
+            }, py::arg("out") = py::none())
+        .def("getRigidBodyAngularVelocities", [](PBD::SimulationModel &model, py::object out) {
+            return gatherRigidBodyState<3>(model, out, [](const PBD::RigidBody &rb, Real *v) { Eigen::Map<Vector3r> x(v); x = rb.getAngularVelocity(); });
+            }, py::arg("out") = py::none())
+        .def("setRigidBodyPositions", [](PBD::SimulationModel &model, const py::array_t<Real, py::array::c_style | py::array::forcecast> &values) {
+            scatterRigidBodyState<3>(model, values, [](PBD::RigidBody &rb, const Real *v) { rb.setPosition(Eigen::Map<const Vector3r>(v)); });
+            })
+        .def("setRigidBodyRotations", [](PBD::SimulationModel &model, const py::array_t<Real, py::array::c_style | py::array::forcecast> &values) {
+            scatterRigidBodyState<4>(model, values, [](PBD::RigidBody &rb, const Real *v)
+                {
+                    rb.getRotation().coeffs() = Eigen::Map<const Vector4r>(v);
+                    rb.rotationUpdated();
+                });
+            })
+        .def("setRigidBodyVelocities", [](PBD::SimulationModel &model, const py::array_t<Real, py::array::c_style | py::array::forcecast> &values) {
+            scatterRigidBodyState<3>(model, values, [](PBD::RigidBody &rb, const Real *v) { rb.setVelocity(Eigen::Map<const Vector3r>(v)); });
+            })
+        .def("setRigidBodyAngularVelocities", [](PBD::SimulationModel &model, const py::array_t<Real, py::array::c_style | py::array::forcecast> &values) {
+            scatterRigidBodyState<3>(model, values, [](PBD::RigidBody &rb, const Real *v) { rb.setAngularVelocity(Eigen::Map<const Vector3r>(v)); });
+            })
         .def("getTriangleModels", &PBD::SimulationModel::getTriangleModels, py::return_value_policy::reference)
         .def("getTetModels", &PBD::SimulationModel::getTetModels, py::return_value_policy::reference)
         .def("getLineModels", &PBD::SimulationModel::getLineModels, py::return_value_policy::reference)
         .def("getConstraints", &PBD::SimulationModel::getConstraints, py::return_value_policy::reference)
         .def("getOrientations", &PBD::SimulationModel::getOrientations, py::return_value_policy::reference)
+        .def("getTimeManager", &PBD::SimulationModel::getTimeManager, py::return_value_policy::reference_internal)
         .def("getRigidBodyContactConstraints", &PBD::SimulationModel::getRigidBodyContactConstraints, py::return_value_policy::reference)
         .def("getParticleRigidBodyContactConstraints", &PBD::SimulationModel::getParticleRigidBodyContactConstraints, py::return_value_policy::reference)
         .def("getParticleSolidContactConstraints", &PBD::SimulationModel::getParticleSolidContactConstraints, py::return_value_policy::reference)
+        .def("getClothContactConstraints", &PBD::SimulationModel::getClothContactConstraints, py::return_value_policy::reference)
+        .def("getClothContactGroups", &PBD::SimulationModel::getClothContactGroups, py::return_value_policy::reference)
+        .def("initClothContactGroups", &PBD::SimulationModel::initClothContactGroups)
         .def("getConstraintGroups", &PBD::SimulationModel::getConstraintGroups, py::return_value_policy::reference)
+        .def("getConstraintGroupCosts", &PBD::SimulationModel::getConstraintGroupCosts, py::return_value_policy::reference)
+        .def("getConstraintIslands", &PBD::SimulationModel::getConstraintIslands, py::return_value_policy::reference)
+        .def("getConstraintIslandCosts", &PBD::SimulationModel::getConstraintIslandCosts, py::return_value_policy::reference)
+        .def("getRigidBodyIslands", &PBD::SimulationModel::getRigidBodyIslands, py::return_value_policy::reference)
+        .def("determineRigidBodyIslands", &PBD::SimulationModel::determineRigidBodyIslands)
         .def("resetContacts", &PBD::SimulationModel::resetContacts)
 
         .def("addClothConstraints", &PBD::SimulationModel::addClothConstraints)
@@ -302,6 +392,8 @@ void SimulationModelModule(py::module m_sub)
         .def("setContactStiffnessRigidBody", &PBD::SimulationModel::setContactStiffnessRigidBody)
         .def("getContactStiffnessParticleRigidBody", &PBD::SimulationModel::getContactStiffnessParticleRigidBody)
         .def("setContactStiffnessParticleRigidBody", &PBD::SimulationModel::setContactStiffnessParticleRigidBody)
+        .def("getContactStiffnessCloth", &PBD::SimulationModel::getContactStiffnessCloth)
+        .def("setContactStiffnessCloth", &PBD::SimulationModel::setContactStiffnessCloth)
 
         .def("addRigidBody", [](PBD::SimulationModel &model, const Real density, 
             const PBD::VertexData& vertices, 
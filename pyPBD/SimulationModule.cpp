@@ -2,6 +2,7 @@
 
 #include <Simulation/Simulation.h>
 #include <Simulation/CubicSDFCollisionDetection.h>
+#include <Simulation/Checkpoint.h>
 
 #include <pybind11/pybind11.h>
 
@@ -31,4 +32,13 @@ void SimulationModule(py::module m_sub) {
                 sim.getTimeStep()->setCollisionDetection(*sim.getModel(), cd);
             })
         ;
+
+    // ---------------------------------------
+    // Class Checkpoint
+    // ---------------------------------------
+    py::class_<PBD::Checkpoint>(m_sub, "Checkpoint")
+        .def_readonly_static("VERSION", &PBD::Checkpoint::VERSION)
+        .def_static("save", &PBD::Checkpoint::save, py::arg("fileName"), py::arg("model"), py::arg("compressData") = false)
+        .def_static("load", &PBD::Checkpoint::load, py::arg("fileName"), py::arg("model"))
+        ;
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "common.h"
 
+#include <Simulation/Simulation.h>
 #include <Simulation/TimeStep.h>
 #include <Simulation/TimeStepController.h>
+#include <Simulation/TimeStepStatistics.h>
 
 #include <pybind11/pybind11.h>
 #include <pybind11/functional.h>
@@ -10,15 +12,147 @@
 
 namespace py = pybind11;
 
+typedef py::array_t<Real, py::array::c_style> RealArray;
+
+/** The time and the time step size are stored in the model, so independent models can be 
+ * simulated concurrently by several threads. The gravitation is read from the current 
+ * simulation during a step, so it is created before the GIL is released. */
+static void initCurrentSimulation()
+{
+    PBD::Simulation::getCurrent();
+}
+
+/** Perform a single simulation step without holding the GIL. */
+static void step(PBD::TimeStep &timeStep, PBD::SimulationModel &model)
+{
+    initCurrentSimulation();
+    py::gil_scoped_release release;
+    timeStep.step(model);
+}
+
+/** Check that a trajectory buffer is a C-contiguous, writable array of Real with the
+ * shape (numFrames, n, dim) and return its data. */
+static Real *getTrajectoryData(py::object buffer, const char *name, const py::ssize_t numFrames, const py::ssize_t n, const py::ssize_t dim)
+{
+    if (buffer.is_none())
+        return nullptr;
+    if (!RealArray::check_(buffer))
+        throw std::invalid_argument(std::string(name) + " must be a C-contiguous array with the floating point type of the simulation");
+    RealArray a = buffer.cast<RealArray>();
+    if ((a.ndim() != 3) || (a.shape(0) != numFrames) || (a.shape(1) != n) || (a.shape(2) != dim))
+        throw std::invalid_argument(std::string(name) + " must have the shape (" + std::to_string(numFrames) + ", " + std::to_string(n) + ", " + std::to_string(dim) + ")");
+    return a.mutable_data();
+}
+
+/** Perform nSteps simulation steps without holding the GIL. After every callbackEvery steps,
+ * the particle positions and the rigid body poses are written to the next frame of the
+ * trajectory buffers (if given) and the callback is called with the number of performed steps. */
+static void simulate(PBD::TimeStep &timeStep, PBD::SimulationModel &model, const unsigned int nSteps,
+    py::object callback, const unsigned int callbackEvery, py::object trajectory, py::object rigidBodyTrajectory)
+{
+    if (callbackEvery == 0)
+        throw std::invalid_argument("callbackEvery must be greater than zero");
+    const unsigned int numFrames = nSteps / callbackEvery;
+    const unsigned int nParticles = model.getParticles().size();
+    const unsigned int nBodies = (unsigned int)model.getRigidBodies().size();
+    Real *x = getTrajectoryData(trajectory, "trajectory", numFrames, nParticles, 3);
+    Real *poses = getTrajectoryData(rigidBodyTrajectory, "rigidBodyTrajectory", numFrames, nBodies, 7);
+
+    initCurrentSimulation();
+    py::gil_scoped_release release;
+    unsigned int frame = 0;
+    for (unsigned int i = 1; i <= nSteps; i++)
+    {
+        timeStep.step(model);
+        if ((i % callbackEvery) != 0)
+            continue;
+
+        // the callback may add particles or bodies
+        if ((model.getParticles().size() != nParticles) || (model.getRigidBodies().size() != nBodies))
+            throw std::runtime_error("the number of particles or rigid bodies changed during the simulation");
+        if (x != nullptr)
+        {
+            if (nParticles > 0)
+                memcpy(&x[3 * nParticles * frame], &model.getParticles().getPosition(0), 3 * nParticles * sizeof(Real));
+        }
+        if (poses != nullptr)
+        {
+            const PBD::SimulationModel::RigidBodyVector &rbs = model.getRigidBodies();
+            for (unsigned int j = 0; j < nBodies; j++)
+            {
+                Real *pose = &poses[7 * (nBodies * frame + j)];
+                Eigen::Map<Vector3r> position(pose);
+                Eigen::Map<Vector4r> rotation(&pose[3]);
+                position = rbs[j]->getPosition();
+                rotation = rbs[j]->getRotation().coeffs();
+            }
+        }
+        frame++;
+
+        if (!callback.is_none())
+        {
+            py::gil_scoped_acquire acquire;
+            callback(i);
+        }
+    }
+}
+
 void TimeStepModule(py::module m_sub)
 {
+    py::class_<PBD::TimeStepStatistics::ConstraintResidual>(m_sub, "ConstraintResidual")
+        .def(py::init<>())
+        .def_readwrite("typeId", &PBD::TimeStepStatistics::ConstraintResidual::m_typeId)
+        .def_readwrite("typeName", &PBD::TimeStepStatistics::ConstraintResidual::m_typeName)
+        .def_readwrite("numConstraints", &PBD::TimeStepStatistics::ConstraintResidual::m_numConstraints)
+        .def_readwrite("residual", &PBD::TimeStepStatistics::ConstraintResidual::m_residual)
+        .def_readwrite("maxCorrection", &PBD::TimeStepStatistics::ConstraintResidual::m_maxCorrection);
+
+    py::class_<PBD::TimeStepStatistics>(m_sub, "TimeStepStatistics")
+        .def(py::init<>())
+        .def_readwrite("step", &PBD::TimeStepStatistics::m_step)
+        .def_readwrite("time", &PBD::TimeStepStatistics::m_time)
+        .def_readwrite("subSteps", &PBD::TimeStepStatistics::m_subSteps)
+        .def_readwrite("iterations", &PBD::TimeStepStatistics::m_iterations)
+        .def_readwrite("iterationsV", &PBD::TimeStepStatistics::m_iterationsV)
+        .def_readwrite("numConstraints", &PBD::TimeStepStatistics::m_numConstraints)
+        .def_readwrite("numIslands", &PBD::TimeStepStatistics::m_numIslands)
+        .def_readwrite("numConstraintGroups", &PBD::TimeStepStatistics::m_numConstraintGroups)
+        .def_readwrite("numSleepingBodies", &PBD::TimeStepStatistics::m_numSleepingBodies)
+        .def_readwrite("numRigidBodyContacts", &PBD::TimeStepStatistics::m_numRigidBodyContacts)
+        .def_readwrite("numParticleRigidBodyContacts", &PBD::TimeStepStatistics::m_numParticleRigidBodyContacts)
+        .def_readwrite("numParticleSolidContacts", &PBD::TimeStepStatistics::m_numParticleSolidContacts)
+        .def_readwrite("numClothContacts", &PBD::TimeStepStatistics::m_numClothContacts)
+        .def_readwrite("numClothContactGroups", &PBD::TimeStepStatistics::m_numClothContactGroups)
+        .def_readwrite("collision", &PBD::TimeStepStatistics::m_collision)
+        .def_readwrite("timeStep", &PBD::TimeStepStatistics::m_timeStep)
+        .def_readwrite("timePositionProjection", &PBD::TimeStepStatistics::m_timePositionProjection)
+        .def_readwrite("timeVelocityProjection", &PBD::TimeStepStatistics::m_timeVelocityProjection)
+        .def_readwrite("timeCollisionDetection", &PBD::TimeStepStatistics::m_timeCollisionDetection)
+        .def_readwrite("timeContinuousCollisionDetection", &PBD::TimeStepStatistics::m_timeContinuousCollisionDetection)
+        .def_readwrite("residuals", &PBD::TimeStepStatistics::m_residuals)
+        .def("reset", &PBD::TimeStepStatistics::reset)
+        .def("getResidual", &PBD::TimeStepStatistics::getResidual, py::return_value_policy::reference_internal);
+
+    py::class_<PBD::TimeStepStatisticsWriter>(m_sub, "TimeStepStatisticsWriter")
+        .def(py::init<>())
+        .def("open", &PBD::TimeStepStatisticsWriter::open, py::arg("fileName"), py::arg("binary") = false)
+        .def("close", &PBD::TimeStepStatisticsWriter::close)
+        .def("isOpen", &PBD::TimeStepStatisticsWriter::isOpen)
+        .def("write", &PBD::TimeStepStatisticsWriter::write);
+
     py::class_<PBD::TimeStep, GenParam::ParameterObject>(m_sub, "TimeStep")
         //.def(py::init<>())
-        .def("step", &PBD::TimeStep::step)
+        .def("step", &step)
+        .def("simulate", &simulate, py::arg("model"), py::arg("nSteps"), py::arg("callback") = py::none(), py::arg("callbackEvery") = 1,
+            py::arg("trajectory") = py::none(), py::arg("rigidBodyTrajectory") = py::none())
         .def("reset", &PBD::TimeStep::reset)
         .def("init", &PBD::TimeStep::init)
         .def("setCollisionDetection", &PBD::TimeStep::setCollisionDetection)
-        .def("getCollisionDetection", &PBD::TimeStep::getCollisionDetection, py::return_value_policy::reference_internal);
+        .def("getCollisionDetection", &PBD::TimeStep::getCollisionDetection, py::return_value_policy::reference_internal)
+        .def_readwrite_static("STATISTICS", &PBD::TimeStep::STATISTICS)
+        .def("getCollectStatistics", &PBD::TimeStep::getCollectStatistics)
+        .def("setCollectStatistics", &PBD::TimeStep::setCollectStatistics)
+        .def("getStatistics", &PBD::TimeStep::getStatistics, py::return_value_policy::reference_internal);
 
     py::class_<PBD::TimeStepController, PBD::TimeStep>(m_sub, "TimeStepController")
         .def_readwrite_static("NUM_SUB_STEPS", &PBD::TimeStepController::NUM_SUB_STEPS)
@@ -27,6 +161,10 @@ void TimeStepModule(py::module m_sub)
         .def_readwrite_static("VELOCITY_UPDATE_METHOD", &PBD::TimeStepController::VELOCITY_UPDATE_METHOD)
         .def_readwrite_static("ENUM_VUPDATE_FIRST_ORDER", &PBD::TimeStepController::ENUM_VUPDATE_FIRST_ORDER)
         .def_readwrite_static("ENUM_VUPDATE_SECOND_ORDER", &PBD::TimeStepController::ENUM_VUPDATE_SECOND_ORDER)
+        .def_readwrite_static("SLEEPING", &PBD::TimeStepController::SLEEPING)
+        .def_readwrite_static("SLEEP_LINEAR_VELOCITY", &PBD::TimeStepController::SLEEP_LINEAR_VELOCITY)
+        .def_readwrite_static("SLEEP_ANGULAR_VELOCITY", &PBD::TimeStepController::SLEEP_ANGULAR_VELOCITY)
+        .def_readwrite_static("SLEEP_TIME", &PBD::TimeStepController::SLEEP_TIME)
 
         .def(py::init<>());
 }
\ No newline at end of file
@@ -7,12 +7,20 @@
 #include <Utils/TetGenLoader.h>
 #include <Utils/Timing.h>
 #include <Utils/Logger.h>
+#include <Utils/SimulationCache.h>
 
 namespace py = pybind11;
 
 template <typename... Args>
 using overload_cast_ = pybind11::detail::overload_cast_impl<Args...>;
 
+/** Raise an IndexError in Python if the index is not smaller than the size. */
+static void checkIndex(const char *name, const unsigned int index, const unsigned int size)
+{
+    if (index >= size)
+        throw py::index_error(std::string(name) + " index " + std::to_string(index) + " out of range (size " + std::to_string(size) + ")");
+}
+
 void UtilitiesModule(py::module m_sub) 
 {
     using Faces = Utilities::IndexedFaceMesh::Faces;
@@ -248,13 +256,18 @@ void UtilitiesModule(py::module m_sub)
     py::class_<Utilities::TimingHelper>(m_sub, "TimingHelper")
         .def(py::init<>())
         .def_readwrite("start", &Utilities::TimingHelper::start)
-        .def_readwrite("name", &Utilities::TimingHelper::name);
+        .def_readwrite("zone", &Utilities::TimingHelper::zone)
+        .def_readwrite("parent", &Utilities::TimingHelper::parent)
+        .def_readwrite("allocations", &Utilities::TimingHelper::allocations);
 
     py::class_<Utilities::AverageTime>(m_sub, "AverageTime")
         .def(py::init<>())
         .def_readwrite("totalTime", &Utilities::AverageTime::totalTime)
         .def_readwrite("counter", &Utilities::AverageTime::counter)
-        .def_readwrite("name", &Utilities::AverageTime::name);
+        .def_readwrite("name", &Utilities::AverageTime::name)
+        .def_readwrite("totalAllocations", &Utilities::AverageTime::totalAllocations)
+        .def_readwrite("lastAllocations", &Utilities::AverageTime::lastAllocations)
+        .def_readwrite("numThreads", &Utilities::AverageTime::numThreads);
 
     py::class_<Utilities::IDFactory>(m_sub, "IDFactory")
         .def(py::init<>())
@@ -263,28 +276,65 @@ void UtilitiesModule(py::module m_sub)
     py::class_<Utilities::Timing>(m_sub, "Timing")
         .def(py::init<>())
         .def_readwrite_static("m_dontPrintTimes", &Utilities::Timing::m_dontPrintTimes)
-        .def_readwrite_static("m_startCounter", &Utilities::Timing::m_startCounter)
-        .def_readwrite_static("m_stopCounter", &Utilities::Timing::m_stopCounter)
-        .def_readwrite_static("m_timingStack", &Utilities::Timing::m_timingStack)
-        .def_readwrite_static("m_averageTimes", &Utilities::Timing::m_averageTimes)
+        .def_readwrite_static("m_traceEnabled", &Utilities::Timing::m_traceEnabled)
+        .def_readwrite_static("m_traceBufferSize", &Utilities::Timing::m_traceBufferSize)
         .def_static("reset", &Utilities::Timing::reset)
-        .def_static("startTiming", &Utilities::Timing::startTiming)
+        .def_static("enableTrace", &Utilities::Timing::enableTrace)
+        .def_static("getZoneId", [](const std::string &name) { return Utilities::Timing::getZoneId(name.c_str()); })
+        .def_static("startTiming", [](const std::string &name)
+            {
+                Utilities::Timing::startTiming(name.c_str());
+            }, py::arg("name") = "")
+        .def_static("getAllocationCount", []() { return (std::size_t) Utilities::Timing::allocationCounter(); })
+        .def_static("getAverageTimes", &Utilities::Timing::getAverageTimes)
         .def_static("stopTimingPrint", []()
             {
-                static int timing_timerId = -1;
-                Utilities::Timing::stopTiming(true);
+                return Utilities::Timing::stopTiming(true);
             })
         .def_static("stopTimingAvgPrint", []()
             {
-                static int timing_timerId = -1; 
-                Utilities::Timing::stopTiming(true, timing_timerId); 
+                return Utilities::Timing::stopTiming(true, true);
             })
         .def_static("stopTimingAvg", []()
             {
-                static int timing_timerId = -1;
-                Utilities::Timing::stopTiming(false, timing_timerId);
+                return Utilities::Timing::stopTiming(false, true);
             })
+        .def_static("writeTrace", &Utilities::Timing::writeTrace)
         .def_static("printAverageTimes", &Utilities::Timing::printAverageTimes)
         .def_static("printTimeSums", &Utilities::Timing::printTimeSums);
 
+    py::class_<Utilities::SimulationCacheReader>(m_sub, "SimulationCacheReader")
+        .def(py::init<>())
+        .def("open", &Utilities::SimulationCacheReader::open)
+        .def("close", &Utilities::SimulationCacheReader::close)
+        .def("isOpen", &Utilities::SimulationCacheReader::isOpen)
+        .def("numMeshes", &Utilities::SimulationCacheReader::numMeshes)
+        .def("getMeshName", [](Utilities::SimulationCacheReader& reader, const unsigned int mesh) {
+            checkIndex("mesh", mesh, reader.numMeshes());
+            return reader.getMeshName(mesh);
+        })
+        .def("numVertices", [](Utilities::SimulationCacheReader& reader, const unsigned int mesh) {
+            checkIndex("mesh", mesh, reader.numMeshes());
+            return reader.numVertices(mesh);
+        })
+        .def("getFaces", [](Utilities::SimulationCacheReader& reader, const unsigned int mesh) -> py::memoryview {
+            checkIndex("mesh", mesh, reader.numMeshes());
+            const std::vector<unsigned int>& faces = reader.getFaces(mesh);
+            unsigned int* base_ptr = const_cast<unsigned int*>(faces.data());
+            return py::memoryview::from_buffer(base_ptr, { (int) faces.size() / 3, 3 }, { sizeof(unsigned int) * 3, sizeof(unsigned int) }, true);
+        })
+        .def("getPrecision", &Utilities::SimulationCacheReader::getPrecision)
+        .def("numFrames", &Utilities::SimulationCacheReader::numFrames)
+        .def("getFrameTime", [](Utilities::SimulationCacheReader& reader, const unsigned int frame) {
+            checkIndex("frame", frame, reader.numFrames());
+            return reader.getFrameTime(frame);
+        })
+        .def("readFrame", &Utilities::SimulationCacheReader::readFrame)
+        .def("getPositions", [](Utilities::SimulationCacheReader& reader, const unsigned int mesh) -> py::memoryview {
+            checkIndex("mesh", mesh, reader.numMeshes());
+            // the view is valid until the next frame is read
+            const std::vector<Vector3r>& x = reader.getPositions(mesh);
+            Real* base_ptr = reinterpret_cast<Real*>(const_cast<Vector3r*>(x.data()));
+            return py::memoryview::from_buffer(base_ptr, { (int) x.size(), 3 }, { sizeof(Real) * 3, sizeof(Real) }, true);
+        });
 }